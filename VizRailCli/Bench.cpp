@@ -0,0 +1,593 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Exceptions.h"
+#include "QueryProtocol.h"
+#include "QueryServer.h"
+#include "QueryService.h"
+#include "Text.h"
+#include "UnixSocket.h"
+
+using namespace VizRailCli;
+using namespace VizRailCli::QueryProtocol;
+using namespace VizRailCore;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	constexpr const char* Usage =
+		"用法: vizrail-bench (--socket <套接字路径> | --load <方案名>=<交点表.csv>...) [选项]\n"
+		"\n"
+		"向查询服务并发发送批量请求，统计吞吐量和请求延迟。\n"
+		"\n"
+		"  --socket <路径>        连接已运行的vizrail-daemon\n"
+		"  --load <方案名>=<csv>  在进程内启动服务，可重复\n"
+		"  --scheme <序号>        查询的方案，默认为0\n"
+		"  --op frame|station     frame为里程转坐标，station为坐标反算里程，默认为station\n"
+		"  --connections <数量>   并发连接数，默认为4\n"
+		"  --batch <条数>         每个请求的记录数，默认为256\n"
+		"  --pipeline <深度>      每个连接未收到响应的请求数上限，默认为8\n"
+		"  --seconds <秒>         持续时间，默认为3\n"
+		"  --verify               测试前校验反算与里程转坐标往返一致，不一致时退出码为1\n";
+
+	// 预先生成的请求数，发送时轮流使用
+	constexpr size_t RequestPoolSize = 16;
+	// 反算测试点到线路的最大距离
+	constexpr double MaxOffset = 50.0;
+	// 往返校验允许的坐标误差（米）
+	constexpr double VerifyTolerance = 1e-3;
+	constexpr size_t VerifyCount = 2000;
+
+	enum class Operation
+	{
+		Frame,
+		Station,
+	};
+
+	struct Options
+	{
+		std::string SocketPath;
+		std::vector<SchemeSource> Sources;
+		uint16_t Scheme = 0;
+		Operation Op = Operation::Station;
+		size_t Connections = 4;
+		size_t Batch = 256;
+		size_t Pipeline = 8;
+		double Seconds = 3.0;
+		bool Verify = false;
+	};
+
+	struct SchemeRange
+	{
+		std::string Name;
+		double Start = 0.0;
+		double End = 0.0;
+	};
+
+	void Print(const std::string& text)
+	{
+		std::fwrite(text.data(), 1, text.size(), stdout);
+		std::fflush(stdout);
+	}
+
+	void PrintError(const std::string& text)
+	{
+		std::fwrite(text.data(), 1, text.size(), stderr);
+	}
+
+	template <typename T>
+	bool ParseNumber(const std::string& text, T& value)
+	{
+		const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+		return error == std::errc() && end == text.data() + text.size();
+	}
+
+	/// 请求帧，RequestId在发送前填写
+	template <typename Record>
+	std::vector<std::byte> MakeFrame(const Opcode code, const uint16_t scheme, const std::vector<Record>& records)
+	{
+		const FrameHeader header{
+			static_cast<uint32_t>(records.size() * sizeof(Record)), 0, code, scheme,
+			static_cast<uint32_t>(records.size())
+		};
+		std::vector<std::byte> frame(sizeof(FrameHeader) + header.Length);
+		std::memcpy(frame.data(), &header, sizeof(FrameHeader));
+		if (!records.empty())
+		{
+			std::memcpy(frame.data() + sizeof(FrameHeader), records.data(), header.Length);
+		}
+		return frame;
+	}
+
+	/// 查询服务的客户端连接
+	class Client
+	{
+	public:
+		explicit Client(const std::filesystem::path& socketPath) : _socket(UnixSocket::Connect(socketPath))
+		{
+		}
+
+		Client(const Client&) = delete;
+		Client& operator=(const Client&) = delete;
+
+		~Client()
+		{
+			UnixSocket::Close(_socket);
+		}
+
+		void Send(std::vector<std::byte>& frame, const uint32_t requestId) const
+		{
+			std::memcpy(frame.data() + offsetof(FrameHeader, RequestId), &requestId, sizeof(requestId));
+			UnixSocket::SendAll(_socket, frame);
+		}
+
+		/// \brief 接收一帧响应，不检查帧状态
+		/// \return 服务在帧边界关闭连接时返回std::nullopt
+		std::optional<FrameHeader> ReceiveFrame(std::vector<std::byte>& payload) const
+		{
+			std::byte buffer[sizeof(FrameHeader)];
+			if (!UnixSocket::ReceiveAll(_socket, buffer))
+			{
+				return std::nullopt;
+			}
+			const auto header = Read<FrameHeader>(buffer);
+			payload.resize(header.Length);
+			if (!UnixSocket::ReceiveAll(_socket, payload))
+			{
+				throw VizRailCoreException(L"查询服务在响应中途断开连接");
+			}
+			return header;
+		}
+
+		/// \return 服务在帧边界关闭连接时返回std::nullopt
+		/// \exception VizRailCoreException 帧状态不是Ok
+		std::optional<FrameHeader> Receive(std::vector<std::byte>& payload) const
+		{
+			const auto header = ReceiveFrame(payload);
+			if (header && static_cast<FrameStatus>(header->SchemeOrStatus) != FrameStatus::Ok)
+			{
+				throw VizRailCoreException(std::format(L"请求{}失败，状态{}", header->RequestId, header->SchemeOrStatus));
+			}
+			return header;
+		}
+
+		/// 不再发送请求，服务处理完已收到的请求后关闭连接
+		void FinishSending() const
+		{
+			shutdown(_socket, SHUT_WR);
+		}
+
+		/// 发送一个请求并等待响应
+		template <typename Response, typename Record>
+		std::vector<Response> Call(const Opcode code, const uint16_t scheme, const std::vector<Record>& records)
+		{
+			auto frame = MakeFrame(code, scheme, records);
+			const uint32_t requestId = _nextRequestId++;
+			Send(frame, requestId);
+			std::vector<std::byte> payload;
+			const auto header = Receive(payload);
+			if (!header || header->RequestId != requestId || payload.size() != header->Count * sizeof(Response))
+			{
+				throw VizRailCoreException(L"查询服务的响应与请求不符");
+			}
+			std::vector<Response> responses(header->Count);
+			std::memcpy(responses.data(), payload.data(), payload.size());
+			return responses;
+		}
+
+		/// \brief 发送一个请求，返回响应的帧状态
+		template <typename Record>
+		FrameStatus CallStatus(const Opcode code, const uint16_t scheme, const std::vector<Record>& records)
+		{
+			auto frame = MakeFrame(code, scheme, records);
+			const uint32_t requestId = _nextRequestId++;
+			Send(frame, requestId);
+			std::vector<std::byte> payload;
+			const auto header = ReceiveFrame(payload);
+			if (!header || header->RequestId != requestId)
+			{
+				throw VizRailCoreException(L"查询服务的响应与请求不符");
+			}
+			return static_cast<FrameStatus>(header->SchemeOrStatus);
+		}
+
+		std::vector<SchemeRange> ListSchemes()
+		{
+			auto frame = MakeFrame(Opcode::ListSchemes, 0, std::vector<MileageRequest>());
+			Send(frame, _nextRequestId++);
+			std::vector<std::byte> payload;
+			const auto header = Receive(payload);
+			if (!header)
+			{
+				throw VizRailCoreException(L"查询服务关闭了连接");
+			}
+			std::vector<SchemeRange> schemes;
+			size_t position = 0;
+			for (uint32_t i = 0; i < header->Count; ++i)
+			{
+				const auto info = Read<SchemeInfo>(payload.data() + position);
+				position += sizeof(SchemeInfo);
+				const auto name = reinterpret_cast<const char*>(payload.data() + position);
+				position += info.NameLength;
+				schemes.push_back({{name, info.NameLength}, info.StartMileage, info.EndMileage});
+			}
+			return schemes;
+		}
+
+	private:
+		int _socket;
+		uint32_t _nextRequestId = 0;
+	};
+
+	std::vector<MileageRequest> RandomMileages(const SchemeRange& range, const size_t count, std::mt19937_64& random)
+	{
+		std::uniform_real_distribution mileage(range.Start, range.End);
+		std::vector<MileageRequest> requests(count);
+		for (auto& request : requests)
+		{
+			request.Mileage = mileage(random);
+		}
+		return requests;
+	}
+
+	/// 沿线路法线方向随机偏移的点
+	std::vector<PointRequest> RandomPoints(Client& client, const uint16_t scheme, const SchemeRange& range,
+	                                       const size_t count, std::mt19937_64& random)
+	{
+		std::uniform_real_distribution offset(-MaxOffset, MaxOffset);
+		std::vector<PointRequest> points;
+		while (points.size() < count)
+		{
+			const auto frames = client.Call<FrameResponse>(Opcode::MileageToFrame, scheme,
+			                                               RandomMileages(range, count - points.size(), random));
+			for (const auto& frame : frames)
+			{
+				if (frame.Status != RecordStatus::Ok)
+				{
+					continue;
+				}
+				// 偏距以前进方向右侧为正
+				const double d = offset(random);
+				points.push_back({frame.N - d * std::cos(frame.Azimuth), frame.E + d * std::sin(frame.Azimuth)});
+			}
+		}
+		return points;
+	}
+
+	/// 反算得到的里程和偏距再转回坐标，应与原来的点重合
+	bool Verify(Client& client, const uint16_t scheme, const SchemeRange& range)
+	{
+		std::mt19937_64 random(42);
+		const auto mileages = RandomMileages(range, VerifyCount, random);
+		const auto frames = client.Call<FrameResponse>(Opcode::MileageToFrame, scheme, mileages);
+		size_t failures = 0;
+		for (size_t i = 0; i < frames.size(); ++i)
+		{
+			failures += frames[i].Mileage == mileages[i].Mileage ? 0 : 1;
+		}
+
+		const auto requests = RandomPoints(client, scheme, range, VerifyCount, random);
+		const auto stations = client.Call<StationResponse>(Opcode::PointToStation, scheme, requests);
+		std::vector<MileageRequest> stationMileages;
+		for (const auto& station : stations)
+		{
+			stationMileages.push_back({station.Mileage});
+		}
+		const auto back = client.Call<FrameResponse>(Opcode::MileageToFrame, scheme, stationMileages);
+		double maxError = 0.0;
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			if (stations[i].Status != RecordStatus::Ok || back[i].Status != RecordStatus::Ok)
+			{
+				++failures;
+				continue;
+			}
+			const double e = back[i].E + stations[i].Offset * std::sin(back[i].Azimuth);
+			const double n = back[i].N - stations[i].Offset * std::cos(back[i].Azimuth);
+			const double error = std::hypot(e - requests[i].E, n - requests[i].N);
+			maxError = std::max(maxError, error);
+			failures += error <= VerifyTolerance ? 0 : 1;
+		}
+
+		// 区间请求的桩数应与区间内的整百米数相同
+		const double interval = 100.0;
+		const auto rangeStations = client.Call<FrameResponse>(Opcode::RangeStations, scheme,
+		                                                      std::vector{RangeRequest{range.Start, range.End, interval}});
+		const auto expected = static_cast<size_t>(std::floor(range.End / interval) - std::ceil(range.Start / interval) + 1);
+		failures += rangeStations.size() == expected ? 0 : 1;
+		// 间距极小时首末桩号溢出为无穷，桩数为无穷或NaN，服务应按桩数过多拒绝，而不是把非有限的桩数转为整数。
+		// 起点为0时只有末桩号溢出，只含终点的区间首末桩号都溢出
+		for (const auto& tiny : {RangeRequest{range.Start, range.End, 1e-320}, RangeRequest{range.End, range.End, 1e-320}})
+		{
+			const auto status = client.CallStatus(Opcode::RangeStations, scheme, std::vector{tiny});
+			failures += status == FrameStatus::TooLarge ? 0 : 1;
+		}
+
+		Print(std::format("校验：{}条里程，{}个点往返最大误差{:.3e}m，{}个区间桩，{}处不一致\n",
+		                  mileages.size(), requests.size(), maxError, rangeStations.size(), failures));
+		return failures == 0;
+	}
+
+	struct ConnectionResult
+	{
+		size_t Requests = 0;
+		size_t Records = 0;
+		/// 每个请求从发送到收到响应的时间（微秒）
+		std::vector<float> Latencies;
+		std::string Error;
+	};
+
+	/// 在一个连接上流水线发送请求直到deadline。写线程最多保持pipeline个请求未收到响应，读线程接收响应
+	void RunConnection(const std::filesystem::path& socketPath, std::vector<std::vector<std::byte>> pool,
+	                   const size_t pipeline, const Clock::time_point deadline, ConnectionResult& result)
+	{
+		try
+		{
+			Client client(socketPath);
+			std::counting_semaphore<> slots(static_cast<std::ptrdiff_t>(pipeline));
+			std::vector<std::atomic<Clock::rep>> sentAt(pipeline);
+			std::atomic<bool> failed = false;
+			std::string readError;
+
+			std::thread reader([&]
+			{
+				try
+				{
+					std::vector<std::byte> payload;
+					while (const auto header = client.Receive(payload))
+					{
+						const auto elapsed = Clock::now().time_since_epoch().count() - sentAt[header->RequestId % pipeline].
+							load(std::memory_order_relaxed);
+						result.Latencies.push_back(static_cast<float>(
+							std::chrono::duration<double, std::micro>(Clock::duration(elapsed)).count()));
+						result.Records += header->Count;
+						++result.Requests;
+						slots.release();
+					}
+				}
+				catch (const VizRailCoreException& e)
+				{
+					readError = ToUtf8(e.GetMsg());
+					failed = true;
+					slots.release(static_cast<std::ptrdiff_t>(pipeline));
+				}
+			});
+
+			try
+			{
+				for (uint32_t id = 0; Clock::now() < deadline && !failed; ++id)
+				{
+					slots.acquire();
+					if (failed)
+					{
+						break;
+					}
+					sentAt[id % pipeline].store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+					client.Send(pool[id % pool.size()], id);
+				}
+			}
+			catch (const VizRailCoreException& e)
+			{
+				result.Error = ToUtf8(e.GetMsg());
+			}
+			client.FinishSending();
+			reader.join();
+			if (result.Error.empty())
+			{
+				result.Error = readError;
+			}
+		}
+		catch (const VizRailCoreException& e)
+		{
+			result.Error = ToUtf8(e.GetMsg());
+		}
+	}
+
+	int RunBenchmark(const Options& options, const std::filesystem::path& socketPath)
+	{
+		Client setup(socketPath);
+		const auto schemes = setup.ListSchemes();
+		if (options.Scheme >= schemes.size())
+		{
+			PrintError(std::format("方案序号{}超出范围，服务上有{}个方案\n", options.Scheme, schemes.size()));
+			return 1;
+		}
+		const SchemeRange& range = schemes[options.Scheme];
+		Print(std::format("方案{}：{}，里程{:.3f}至{:.3f}\n", options.Scheme, range.Name, range.Start, range.End));
+
+		if (options.Verify && !Verify(setup, options.Scheme, range))
+		{
+			return 1;
+		}
+
+		std::mt19937_64 random(7);
+		std::vector<std::vector<std::byte>> pool;
+		for (size_t i = 0; i < RequestPoolSize; ++i)
+		{
+			if (options.Op == Operation::Frame)
+			{
+				pool.push_back(MakeFrame(Opcode::MileageToFrame, options.Scheme,
+				                         RandomMileages(range, options.Batch, random)));
+				continue;
+			}
+			pool.push_back(MakeFrame(Opcode::PointToStation, options.Scheme,
+			                         RandomPoints(setup, options.Scheme, range, options.Batch, random)));
+		}
+
+		std::vector<ConnectionResult> results(options.Connections);
+		const auto start = Clock::now();
+		const auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double>(options.Seconds));
+		std::vector<std::thread> threads;
+		for (auto& result : results)
+		{
+			threads.emplace_back(RunConnection, socketPath, pool, options.Pipeline, deadline, std::ref(result));
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		size_t requests = 0;
+		size_t records = 0;
+		std::vector<float> latencies;
+		bool failed = false;
+		for (const auto& result : results)
+		{
+			requests += result.Requests;
+			records += result.Records;
+			latencies.insert(latencies.end(), result.Latencies.begin(), result.Latencies.end());
+			if (!result.Error.empty())
+			{
+				PrintError(result.Error + "\n");
+				failed = true;
+			}
+		}
+		const auto percentile = [&](const double p)
+		{
+			if (latencies.empty())
+			{
+				return 0.0;
+			}
+			const auto nth = latencies.begin() + static_cast<ptrdiff_t>(p * static_cast<double>(latencies.size() - 1));
+			std::ranges::nth_element(latencies, nth);
+			return static_cast<double>(*nth) / 1000.0;
+		};
+		Print(std::format("{}：{}个连接，流水线深度{}，每批{}条，{:.2f}s\n",
+		                  options.Op == Operation::Frame ? "frame" : "station", options.Connections, options.Pipeline,
+		                  options.Batch, seconds));
+		Print(std::format("请求{}（{:.0f}/s），记录{}（{:.0f}/s），延迟p50 {:.3f}ms，p99 {:.3f}ms\n",
+		                  requests, requests / seconds, records, records / seconds, percentile(0.5),
+		                  percentile(0.99)));
+		return failed || requests == 0 ? 1 : 0;
+	}
+
+	int Run(const std::vector<std::string>& args)
+	{
+		Options options;
+		for (size_t i = 1; i < args.size(); ++i)
+		{
+			const std::string& arg = args[i];
+			if (arg == "-h" || arg == "--help")
+			{
+				Print(Usage);
+				return 0;
+			}
+			if (arg == "--verify")
+			{
+				options.Verify = true;
+				continue;
+			}
+			if (i + 1 >= args.size())
+			{
+				PrintError(std::format("无法识别的参数: {}\n\n{}", arg, Usage));
+				return 1;
+			}
+			const std::string& value = args[++i];
+			bool valid = true;
+			if (arg == "--socket")
+			{
+				options.SocketPath = value;
+			}
+			else if (arg == "--load")
+			{
+				try
+				{
+					options.Sources.push_back(ParseSchemeArgument(value));
+				}
+				catch (const VizRailCoreException& e)
+				{
+					PrintError(ToUtf8(e.GetMsg()) + "\n");
+					return 1;
+				}
+			}
+			else if (arg == "--scheme")
+			{
+				valid = ParseNumber(value, options.Scheme);
+			}
+			else if (arg == "--op")
+			{
+				valid = value == "frame" || value == "station";
+				options.Op = value == "frame" ? Operation::Frame : Operation::Station;
+			}
+			else if (arg == "--connections")
+			{
+				valid = ParseNumber(value, options.Connections) && options.Connections > 0;
+			}
+			else if (arg == "--batch")
+			{
+				valid = ParseNumber(value, options.Batch) && options.Batch > 0 &&
+					options.Batch * sizeof(PointRequest) <= MaxFrameLength;
+			}
+			else if (arg == "--pipeline")
+			{
+				valid = ParseNumber(value, options.Pipeline) && options.Pipeline > 0;
+			}
+			else if (arg == "--seconds")
+			{
+				valid = TryParseDouble(value, options.Seconds) && options.Seconds > 0.0;
+			}
+			else
+			{
+				PrintError(std::format("无法识别的参数: {}\n\n{}", arg, Usage));
+				return 1;
+			}
+			if (!valid)
+			{
+				PrintError(std::format("参数{}的值{}无效\n", arg, value));
+				return 1;
+			}
+		}
+		if (options.SocketPath.empty() == options.Sources.empty())
+		{
+			PrintError(Usage);
+			return 1;
+		}
+
+		std::signal(SIGPIPE, SIG_IGN);
+		try
+		{
+			if (!options.SocketPath.empty())
+			{
+				return RunBenchmark(options, PathFromUtf8(options.SocketPath));
+			}
+			// 进程内启动服务，测试结束后停止
+			const QueryService service(LoadSchemes(options.Sources));
+			QueryServer server(service, std::filesystem::temp_directory_path() /
+			                   std::format("vizrail-bench-{}.sock", getpid()));
+			server.Start();
+			return RunBenchmark(options, server.SocketPath());
+		}
+		catch (const VizRailCoreException& e)
+		{
+			PrintError(ToUtf8(e.GetMsg()) + "\n");
+			return 1;
+		}
+	}
+}
+
+int main(const int argc, char* argv[])
+{
+	return Run({argv, argv + argc});
+}
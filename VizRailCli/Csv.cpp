@@ -0,0 +1,206 @@
+#include "Csv.h"
+
+#include <algorithm>
+#include <format>
+#include <iterator>
+
+#include "Exceptions.h"
+#include "Text.h"
+
+using namespace VizRailCli;
+
+namespace
+{
+	constexpr std::string_view Bom = "\xEF\xBB\xBF";
+
+	bool EqualsIgnoreCase(const std::string_view a, const std::string_view b)
+	{
+		return std::ranges::equal(a, b, [](const char x, const char y)
+		{
+			const auto lower = [](const char c)
+			{
+				return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+			};
+			return lower(x) == lower(y);
+		});
+	}
+
+	std::wstring FileError(const std::filesystem::path& path, const std::wstring& message)
+	{
+		return std::format(L"{}：{}", FromUtf8(PathToUtf8(path)), message);
+	}
+}
+
+int CsvTable::FindColumn(const std::initializer_list<std::string_view> names) const
+{
+	for (size_t i = 0; i < Header.size(); ++i)
+	{
+		for (const auto name : names)
+		{
+			if (EqualsIgnoreCase(Trim(Header[i]), name))
+			{
+				return static_cast<int>(i);
+			}
+		}
+	}
+	return -1;
+}
+
+CsvTable VizRailCli::ReadCsv(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		throw VizRailCoreException(FileError(path, L"无法打开文件"));
+	}
+	std::string text(std::istreambuf_iterator<char>(file), {});
+	if (text.starts_with(Bom))
+	{
+		text.erase(0, Bom.size());
+	}
+
+	std::vector<CsvRow> rows;
+	CsvRow row;
+	std::string field;
+	bool quoted = false;
+	// 当前行是否有内容，用于跳过空行
+	bool hasContent = false;
+	const auto endRow = [&]
+	{
+		if (hasContent)
+		{
+			row.push_back(std::move(field));
+			rows.push_back(std::move(row));
+		}
+		row.clear();
+		field.clear();
+		hasContent = false;
+	};
+	for (size_t i = 0; i < text.size(); ++i)
+	{
+		const char c = text[i];
+		if (quoted)
+		{
+			if (c != '"')
+			{
+				field += c;
+			}
+			else if (i + 1 < text.size() && text[i + 1] == '"')
+			{
+				field += '"';
+				++i;
+			}
+			else
+			{
+				quoted = false;
+			}
+			continue;
+		}
+		switch (c)
+		{
+		case '"':
+			quoted = true;
+			hasContent = true;
+			break;
+		case ',':
+			row.push_back(std::move(field));
+			field.clear();
+			hasContent = true;
+			break;
+		case '\r':
+			break;
+		case '\n':
+			endRow();
+			break;
+		default:
+			field += c;
+			hasContent = true;
+			break;
+		}
+	}
+	if (quoted)
+	{
+		throw VizRailCoreException(FileError(path, L"引号不匹配"));
+	}
+	endRow();
+
+	if (rows.empty())
+	{
+		throw VizRailCoreException(FileError(path, L"缺少表头"));
+	}
+	CsvTable table;
+	table.Header = std::move(rows.front());
+	table.Rows.assign(std::make_move_iterator(rows.begin() + 1), std::make_move_iterator(rows.end()));
+	return table;
+}
+
+CsvWriter::CsvWriter(const std::filesystem::path& path) : _path(path)
+{
+	if (path.has_parent_path())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(path.parent_path(), error);
+	}
+	_file.open(path, std::ios::binary);
+	if (!_file)
+	{
+		throw VizRailCoreException(FileError(path, L"无法创建文件"));
+	}
+	_file << Bom;
+}
+
+void CsvWriter::WriteRow(const CsvRow& row)
+{
+	for (size_t i = 0; i < row.size(); ++i)
+	{
+		if (i > 0)
+		{
+			_file << ',';
+		}
+		WriteField(row[i]);
+	}
+	_file << "\r\n";
+}
+
+void CsvWriter::WriteRow(const std::initializer_list<std::string_view> row)
+{
+	bool first = true;
+	for (const auto field : row)
+	{
+		if (!first)
+		{
+			_file << ',';
+		}
+		first = false;
+		WriteField(field);
+	}
+	_file << "\r\n";
+}
+
+void CsvWriter::Close()
+{
+	_file.close();
+	if (!_file)
+	{
+		throw VizRailCoreException(FileError(_path, L"写入文件失败"));
+	}
+}
+
+void CsvWriter::WriteField(const std::string_view field)
+{
+	if (field.find_first_of(",\"\r\n") == std::string_view::npos)
+	{
+		_file << field;
+		return;
+	}
+	_file << '"';
+	for (const char c : field)
+	{
+		if (c == '"')
+		{
+			_file << '"';
+		}
+		_file << c;
+	}
+	_file << '"';
+}
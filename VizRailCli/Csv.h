@@ -0,0 +1,47 @@
+#pragma once
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace VizRailCli
+{
+	using CsvRow = std::vector<std::string>;
+
+	/// CSV表格，第一行为表头
+	struct CsvTable
+	{
+		CsvRow Header;
+		std::vector<CsvRow> Rows;
+
+		/// \brief 按候选列名查找列，不区分英文大小写
+		/// \return 列序号，不存在时为-1
+		[[nodiscard]] int FindColumn(std::initializer_list<std::string_view> names) const;
+	};
+
+	/// \brief 读取UTF-8编码（可带BOM）的CSV文件，支持双引号包围的字段，跳过空行
+	CsvTable ReadCsv(const std::filesystem::path& path);
+
+	/// 逐行写出UTF-8 CSV文件，文件开头写BOM，Excel打开时中文不乱码
+	class CsvWriter
+	{
+	public:
+		/// \brief 创建文件，所在目录不存在时一并创建
+		explicit CsvWriter(const std::filesystem::path& path);
+
+		void WriteRow(const CsvRow& row);
+
+		void WriteRow(std::initializer_list<std::string_view> row);
+
+		/// \brief 写完后调用，写入失败时抛出异常
+		void Close();
+
+	private:
+		void WriteField(std::string_view field);
+
+		std::filesystem::path _path;
+		std::ofstream _file;
+	};
+}
@@ -0,0 +1,123 @@
+#include <charconv>
+#include <csignal>
+#include <cstdio>
+#include <format>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+
+#include "Exceptions.h"
+#include "QueryServer.h"
+#include "QueryService.h"
+#include "TaskScheduler.h"
+#include "Text.h"
+
+using namespace VizRailCli;
+using namespace VizRailCore;
+
+namespace
+{
+	constexpr const char* Usage =
+		"用法: vizrail-daemon --socket <套接字路径> [-j <线程数>] <方案名>=<交点表.csv>...\n"
+		"\n"
+		"加载方案后在Unix域套接字上提供里程与坐标的批量查询，收到SIGINT或SIGTERM时退出。\n"
+		"协议见QueryProtocol.h，可用vizrail-bench测试\n"
+		"\n"
+		"  --socket <路径>       监听的套接字路径，已有的套接字文件会被替换\n"
+		"  -j, --jobs <线程数>   加载方案和计算大批量请求使用的线程数，默认为全部硬件线程\n";
+
+	void Print(const std::string& text)
+	{
+		std::fwrite(text.data(), 1, text.size(), stdout);
+		std::fflush(stdout);
+	}
+
+	void PrintError(const std::string& text)
+	{
+		std::fwrite(text.data(), 1, text.size(), stderr);
+	}
+
+	int Run(const std::vector<std::string>& args)
+	{
+		std::string socketPath;
+		std::vector<SchemeSource> sources;
+		size_t threads = 0;
+		try
+		{
+			for (size_t i = 1; i < args.size(); ++i)
+			{
+				const std::string& arg = args[i];
+				if (arg == "-h" || arg == "--help")
+				{
+					Print(Usage);
+					return 0;
+				}
+				const bool hasValue = i + 1 < args.size();
+				if ((arg == "-j" || arg == "--jobs") && hasValue)
+				{
+					const std::string& value = args[++i];
+					const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), threads);
+					if (error != std::errc() || end != value.data() + value.size() || threads == 0)
+					{
+						PrintError("线程数必须为正整数\n");
+						return 1;
+					}
+				}
+				else if (arg == "--socket" && hasValue)
+				{
+					socketPath = args[++i];
+				}
+				else if (!arg.starts_with('-'))
+				{
+					sources.push_back(ParseSchemeArgument(arg));
+				}
+				else
+				{
+					PrintError(std::format("无法识别的参数: {}\n\n{}", arg, Usage));
+					return 1;
+				}
+			}
+			if (socketPath.empty() || sources.empty())
+			{
+				PrintError(Usage);
+				return 1;
+			}
+			if (threads > 0)
+			{
+				TaskScheduler::SetDefaultWorkerCount(threads - 1);
+			}
+
+			// 在创建任何线程之前屏蔽退出信号，由主线程用sigwait等待，其他线程都不会被信号打断
+			sigset_t signals;
+			sigemptyset(&signals);
+			sigaddset(&signals, SIGINT);
+			sigaddset(&signals, SIGTERM);
+			pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+			std::signal(SIGPIPE, SIG_IGN);
+
+			const QueryService service(LoadSchemes(sources));
+			QueryServer server(service, PathFromUtf8(socketPath));
+			server.Start();
+			Print(std::format("已加载{}个方案，在{}上监听\n", service.Schemes().size(), socketPath));
+
+			int received = 0;
+			sigwait(&signals, &received);
+			Print("正在停止\n");
+			server.Stop();
+			Print(std::format("共处理{}个连接\n", server.ConnectionCount()));
+		}
+		catch (const VizRailCoreException& e)
+		{
+			PrintError(ToUtf8(e.GetMsg()) + "\n");
+			return 1;
+		}
+		TaskScheduler::ShutdownDefault();
+		return 0;
+	}
+}
+
+int main(const int argc, char* argv[])
+{
+	return Run({argv, argv + argc});
+}
@@ -0,0 +1,45 @@
+#include "JdTable.h"
+
+#include <format>
+
+#include "Csv.h"
+#include "Exceptions.h"
+#include "LandXml.h"
+#include "TextImport.h"
+
+using namespace VizRailCli;
+using namespace VizRailCore;
+
+std::vector<Jd> VizRailCli::ReadJdTable(const std::filesystem::path& path)
+{
+	if (path.extension() == ".xml" || path.extension() == ".XML")
+	{
+		const auto alignments = ReadLandXml(path);
+		if (alignments.empty())
+		{
+			throw VizRailCoreException(std::format(L"{}：没有线路", path.wstring()));
+		}
+		return alignments.front().Jds.ToJds();
+	}
+	return ImportJdTable(path).ToJds();
+}
+
+void VizRailCli::WriteJdTable(const std::filesystem::path& path, const HorizontalAlignment& alignment)
+{
+	CsvWriter writer(path);
+	writer.WriteRow({
+		"交点号", "坐标N", "坐标E", "偏角", "曲线半径", "前缓和曲线", "后缓和曲线", "前切线长", "后切线长", "曲线长",
+		"夹直线长", "起点里程", "终点里程"
+	});
+	// 数值按能精确还原的最短形式输出，读回后线路完全相同
+	for (const auto& jd : alignment.GetJds())
+	{
+		writer.WriteRow({
+			std::to_string(jd.JdH), std::format("{}", jd.N), std::format("{}", jd.E), std::format("{}", jd.Angle),
+			std::format("{}", jd.R), std::format("{}", jd.Ls), std::format("{}", jd.Ls), std::format("{}", jd.TH),
+			std::format("{}", jd.TH), std::format("{}", jd.LH), std::format("{}", jd.LJzx),
+			std::format("{}", jd.StartMileage), std::format("{}", jd.EndMileage)
+		});
+	}
+	writer.Close();
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <filesystem>
+#include <vector>
+
+#include "HorizontalAlignment.h"
+#include "Jd.h"
+
+namespace VizRailCli
+{
+	/// \brief 读取CSV或TXT格式的交点表，列名和缺省值见VizRailCore::ImportJdTable。
+	/// 切线长、曲线长等派生列即使存在也会被忽略，由线路刷新时重新计算。
+	/// 扩展名为.xml时按LandXML读取第一条线路，见VizRailCore::ReadLandXml
+	std::vector<Jd> ReadJdTable(const std::filesystem::path& path);
+
+	/// \brief 按曲线表的列写出线路刷新后的交点，写出的文件可以再由ReadJdTable读入
+	void WriteJdTable(const std::filesystem::path& path, const VizRailCore::HorizontalAlignment& alignment);
+}
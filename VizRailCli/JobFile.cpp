@@ -0,0 +1,313 @@
+#include "JobFile.h"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <set>
+
+#include "Exceptions.h"
+#include "Text.h"
+
+using namespace VizRailCli;
+
+namespace
+{
+	struct CommandInfo
+	{
+		const char* Name;
+		JobKind Kind;
+		/// 除input和output外允许的选项
+		std::set<std::string> Options;
+		bool NeedsInput;
+	};
+
+	const std::vector<CommandInfo>& Commands()
+	{
+		static const std::vector<CommandInfo> commands = {
+			{"station", JobKind::Station, {"interval", "from", "to", "format"}, false},
+			{"project", JobKind::Project, {}, true},
+			{"validate", JobKind::Validate, {"min-radius", "min-transition", "min-circular", "min-tangent"}, false},
+			{"export", JobKind::Export, {"format"}, false},
+		};
+		return commands;
+	}
+
+	class LineError
+	{
+	public:
+		LineError(const std::filesystem::path& path, const size_t line) : _path(FromUtf8(PathToUtf8(path))), _line(line)
+		{
+		}
+
+		[[nodiscard]] VizRailCoreException operator()(const std::wstring& message) const
+		{
+			return VizRailCoreException(std::format(L"{}第{}行：{}", _path, _line, message));
+		}
+
+	private:
+		std::wstring _path;
+		size_t _line;
+	};
+
+	/// 按空白拆分一行，双引号包围的部分可以含空白，#之后的内容忽略
+	std::vector<std::string> Tokenize(const std::string_view line, const LineError& error)
+	{
+		std::vector<std::string> tokens;
+		std::string token;
+		bool inToken = false;
+		bool quoted = false;
+		for (const char c : line)
+		{
+			if (quoted)
+			{
+				if (c == '"')
+				{
+					quoted = false;
+				}
+				else
+				{
+					token += c;
+				}
+			}
+			else if (c == '"')
+			{
+				quoted = true;
+				inToken = true;
+			}
+			else if (c == '#')
+			{
+				break;
+			}
+			else if (c == ' ' || c == '\t' || c == '\r')
+			{
+				if (inToken)
+				{
+					tokens.push_back(std::move(token));
+					token.clear();
+					inToken = false;
+				}
+			}
+			else
+			{
+				token += c;
+				inToken = true;
+			}
+		}
+		if (quoted)
+		{
+			throw error(L"引号不匹配");
+		}
+		if (inToken)
+		{
+			tokens.push_back(std::move(token));
+		}
+		return tokens;
+	}
+
+	void ReplaceAll(std::string& text, const std::string_view from, const std::string_view to)
+	{
+		for (size_t position = text.find(from); position != std::string::npos; position = text.find(from, position))
+		{
+			text.replace(position, from.size(), to);
+			position += to.size();
+		}
+	}
+
+	/// 未展开的作业，路径尚未解析
+	struct PendingJob
+	{
+		Job Value;
+		std::string Input;
+		std::string Output;
+	};
+}
+
+double Job::Number(const std::string& name, const double fallback) const
+{
+	const auto it = Options.find(name);
+	double value;
+	return it != Options.end() && TryParseDouble(it->second, value) ? value : fallback;
+}
+
+std::string Job::Describe() const
+{
+	const auto& commands = Commands();
+	const auto command = std::ranges::find(commands, Kind, &CommandInfo::Kind);
+	return std::string(command->Name) + " " + Scheme;
+}
+
+JobFile VizRailCli::ReadJobFile(const std::filesystem::path& path, const std::filesystem::path& outputDirectory)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		throw VizRailCoreException(std::format(L"{}：无法打开作业文件", FromUtf8(PathToUtf8(path))));
+	}
+	const std::filesystem::path baseDirectory = path.parent_path();
+	const std::filesystem::path outputBase = outputDirectory.empty() ? baseDirectory : outputDirectory;
+
+	JobFile result;
+	std::vector<PendingJob> pending;
+	std::string text;
+	for (size_t lineNumber = 1; std::getline(file, text); ++lineNumber)
+	{
+		if (lineNumber == 1 && text.starts_with("\xEF\xBB\xBF"))
+		{
+			text.erase(0, 3);
+		}
+		const LineError error(path, lineNumber);
+		const auto tokens = Tokenize(text, error);
+		if (tokens.empty())
+		{
+			continue;
+		}
+		if (tokens.size() < 2)
+		{
+			throw error(L"缺少方案名");
+		}
+
+		if (tokens[0] == "scheme")
+		{
+			if (tokens.size() != 3)
+			{
+				throw error(L"格式应为 scheme <方案名> <交点表.csv>");
+			}
+			if (tokens[1] == "*")
+			{
+				throw error(L"方案名不能为*");
+			}
+			if (std::ranges::find(result.Schemes, tokens[1], &SchemeSource::Name) != result.Schemes.end())
+			{
+				throw error(std::format(L"方案{}重复", FromUtf8(tokens[1])));
+			}
+			result.Schemes.push_back({tokens[1], baseDirectory / PathFromUtf8(tokens[2]), lineNumber});
+			continue;
+		}
+
+		const auto& commands = Commands();
+		const auto command = std::ranges::find(commands, tokens[0], &CommandInfo::Name);
+		if (command == commands.end())
+		{
+			throw error(std::format(L"未知指令{}", FromUtf8(tokens[0])));
+		}
+		PendingJob job;
+		job.Value.Kind = command->Kind;
+		job.Value.Scheme = tokens[1];
+		job.Value.Line = lineNumber;
+		for (size_t i = 2; i < tokens.size(); ++i)
+		{
+			const size_t equal = tokens[i].find('=');
+			if (equal == std::string::npos || equal == 0)
+			{
+				throw error(std::format(L"选项{}应为 名称=值", FromUtf8(tokens[i])));
+			}
+			std::string name = tokens[i].substr(0, equal);
+			std::string value = tokens[i].substr(equal + 1);
+			if (name == "output")
+			{
+				job.Output = std::move(value);
+			}
+			else if (name == "input" && command->NeedsInput)
+			{
+				job.Input = std::move(value);
+			}
+			else if (command->Options.contains(name))
+			{
+				if (name != "format")
+				{
+					double number;
+					if (!TryParseDouble(value, number))
+					{
+						throw error(std::format(L"选项{}不是数值", FromUtf8(name)));
+					}
+				}
+				job.Value.Options[std::move(name)] = std::move(value);
+			}
+			else
+			{
+				throw error(std::format(L"{}不支持选项{}", FromUtf8(tokens[0]), FromUtf8(name)));
+			}
+		}
+
+		if (job.Output.empty())
+		{
+			throw error(L"缺少output");
+		}
+		if (command->NeedsInput && job.Input.empty())
+		{
+			throw error(L"缺少input");
+		}
+		if (command->Kind == JobKind::Station && !(job.Value.Number("interval", 0.0) > 0.0))
+		{
+			throw error(L"interval必须大于0");
+		}
+		if (command->Kind == JobKind::Station)
+		{
+			const auto format = job.Value.Options.find("format");
+			if (format != job.Value.Options.end() && format->second != "csv" && format->second != "raw" &&
+				format->second != "compressed" && format->second != "xor")
+			{
+				throw error(L"format应为csv、raw、compressed或xor");
+			}
+		}
+		if (command->Kind == JobKind::Export)
+		{
+			const auto format = job.Value.Options.find("format");
+			if (format == job.Value.Options.end() || (format->second != "jds" && format->second != "elements" &&
+				format->second != "image" && format->second != "dxf" && format->second != "landxml" &&
+				format->second != "ifc"))
+			{
+				throw error(L"format应为jds、elements、image、dxf、landxml或ifc");
+			}
+		}
+		pending.push_back(std::move(job));
+	}
+
+	// 方案可以在引用它的作业之后声明，读完整个文件后再检查方案名并展开*
+	for (const auto& job : pending)
+	{
+		std::vector<std::string> schemes;
+		if (job.Value.Scheme == "*")
+		{
+			for (const auto& scheme : result.Schemes)
+			{
+				schemes.push_back(scheme.Name);
+			}
+		}
+		else if (std::ranges::find(result.Schemes, job.Value.Scheme, &SchemeSource::Name) != result.Schemes.end())
+		{
+			schemes.push_back(job.Value.Scheme);
+		}
+		else
+		{
+			throw LineError(path, job.Value.Line)(std::format(L"方案{}未声明", FromUtf8(job.Value.Scheme)));
+		}
+
+		for (const auto& scheme : schemes)
+		{
+			Job expanded = job.Value;
+			expanded.Scheme = scheme;
+			std::string input = job.Input;
+			std::string output = job.Output;
+			ReplaceAll(input, "{scheme}", scheme);
+			ReplaceAll(output, "{scheme}", scheme);
+			if (!input.empty())
+			{
+				expanded.Input = baseDirectory / PathFromUtf8(input);
+			}
+			expanded.Output = outputBase / PathFromUtf8(output);
+			result.Jobs.push_back(std::move(expanded));
+		}
+	}
+
+	// 多个作业写同一个文件时结果取决于执行顺序，直接报错
+	std::set<std::filesystem::path> outputs;
+	for (const auto& job : result.Jobs)
+	{
+		if (!outputs.insert(job.Output.lexically_normal()).second)
+		{
+			throw LineError(path, job.Line)(std::format(L"输出文件{}与其他作业重复", FromUtf8(PathToUtf8(job.Output))));
+		}
+	}
+	return result;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace VizRailCli
+{
+	enum class JobKind
+	{
+		/// 逐桩坐标：按间距和曲线特征点计算里程和坐标
+		Station,
+		/// 反算：由点的坐标计算里程和偏距
+		Project,
+		/// 按设计标准检查线路
+		Validate,
+		/// 导出交点表或线元表
+		Export,
+	};
+
+	/// 作业文件中声明的方案
+	struct SchemeSource
+	{
+		/// 方案名，UTF-8
+		std::string Name;
+		/// 交点表CSV
+		std::filesystem::path Path;
+		size_t Line = 0;
+	};
+
+	/// 作业文件中的一个作业，方案名为*的作业已展开为每个方案一个
+	struct Job
+	{
+		JobKind Kind = JobKind::Station;
+		std::string Scheme;
+		/// 除input和output外的选项
+		std::map<std::string, std::string> Options;
+		/// 反算作业的输入点表
+		std::filesystem::path Input;
+		std::filesystem::path Output;
+		size_t Line = 0;
+
+		/// \brief 读取数值选项
+		/// \param fallback 未给出该选项时的值
+		[[nodiscard]] double Number(const std::string& name, double fallback) const;
+
+		/// 用于输出的作业说明，如“station 方案1”
+		[[nodiscard]] std::string Describe() const;
+	};
+
+	struct JobFile
+	{
+		std::vector<SchemeSource> Schemes;
+		std::vector<Job> Jobs;
+	};
+
+	/// \brief 读取作业文件。每行一条指令，#之后为注释，含空格的值用双引号包围：
+	///
+	///     scheme <方案名> <交点表.csv>
+	///     station <方案名> interval=<桩距> [from=<起点里程>] [to=<终点里程>] [format=csv|raw|compressed|xor] output=<文件>
+	///     project <方案名> input=<点表.csv> output=<文件>
+	///     validate <方案名> [min-radius=] [min-transition=] [min-circular=] [min-tangent=] output=<文件>
+	///     export <方案名> format=jds|elements output=<文件>
+	///
+	/// 方案名为*时对所有方案各执行一次，选项中的{scheme}替换为方案名。
+	/// 交点表和input相对作业文件所在目录，output相对outputDirectory
+	/// \param outputDirectory 为空时与作业文件所在目录相同
+	JobFile ReadJobFile(const std::filesystem::path& path, const std::filesystem::path& outputDirectory = {});
+}
@@ -0,0 +1,389 @@
+#include "JobRunner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <optional>
+
+#include "AlignmentImage.h"
+#include "AlignmentScheme.h"
+#include "Csv.h"
+#include "Curve.h"
+#include "Dxf.h"
+#include "Exceptions.h"
+#include "Ifc.h"
+#include "IntermediateLine.h"
+#include "JdTable.h"
+#include "LandXml.h"
+#include "ProjectCache.h"
+#include "Stationing.h"
+#include "StationTableFile.h"
+#include "Text.h"
+#include "Validation.h"
+
+using namespace VizRailCli;
+using namespace VizRailCore;
+
+namespace
+{
+	// 反算时每块的点数
+	constexpr size_t ProjectGrain = 256;
+
+	/// 在catch块中调用，返回当前异常的说明
+	std::string CurrentErrorMessage()
+	{
+		try
+		{
+			throw;
+		}
+		catch (const VizRailCoreException& e)
+		{
+			return ToUtf8(e.GetMsg());
+		}
+		catch (const std::exception& e)
+		{
+			return e.what();
+		}
+		catch (...)
+		{
+			return "未知错误";
+		}
+	}
+
+	std::string Fixed(const double value)
+	{
+		return std::format("{:.4f}", value);
+	}
+
+	std::string StationName(const double mileage)
+	{
+		return ToUtf8(Mileage(mileage).GetString());
+	}
+
+	const char* StationNote(const StationPoint point)
+	{
+		switch (point)
+		{
+		case StationPoint::Start:
+			return "起点";
+		case StationPoint::End:
+			return "终点";
+		case StationPoint::ZH:
+			return "ZH";
+		case StationPoint::HY:
+			return "HY";
+		case StationPoint::QZ:
+			return "QZ";
+		case StationPoint::YH:
+			return "YH";
+		case StationPoint::HZ:
+			return "HZ";
+		default:
+			return "";
+		}
+	}
+
+	void RunStation(const HorizontalAlignment& alignment, const Job& job, ProjectCache* cache, JobResult& result)
+	{
+		// 全线逐桩表与起终点无关，有缓存时重新运行未修改的方案只需映射缓存文件
+		const double interval = job.Number("interval", 0.0);
+		std::vector<StationRecord> built;
+		CachedArray<StationRecord> cached;
+		std::span<const StationRecord> table;
+		if (cache != nullptr)
+		{
+			cached = cache->Stations(alignment, interval);
+			table = cached.Items;
+		}
+		else
+		{
+			built = BuildStationTable(alignment, interval);
+			table = built;
+		}
+		if (table.empty())
+		{
+			throw VizRailCoreException(L"线路没有线元");
+		}
+		const double from = std::max(job.Number("from", table.front().Mileage), table.front().Mileage);
+		const double to = std::min(job.Number("to", table.back().Mileage), table.back().Mileage);
+		if (from > to)
+		{
+			throw VizRailCoreException(L"起点里程大于终点里程");
+		}
+
+		// 二进制逐桩表只含表中的桩，不补算起终点
+		const auto format = job.Options.find("format");
+		if (format != job.Options.end() && format->second != "csv")
+		{
+			const auto first = std::ranges::lower_bound(table, from - StationTolerance, {}, &StationRecord::Mileage);
+			const auto last = std::ranges::upper_bound(table, to + StationTolerance, {}, &StationRecord::Mileage);
+			StationTableOptions options;
+			options.Encoding = format->second == "raw"
+				                   ? StationTableFile::Encoding::Raw
+				                   : format->second == "xor"
+				                   ? StationTableFile::Encoding::Xor
+				                   : StationTableFile::Encoding::Compressed;
+			SaveStationTable(job.Output, alignment, {first, last}, {}, options);
+			result.Rows = static_cast<size_t>(last - first);
+			return;
+		}
+
+		CsvWriter writer(job.Output);
+		writer.WriteRow({"桩号", "里程", "坐标N", "坐标E", "特征点"});
+		const auto write = [&](const double mileage, const double north, const double east, const char* note)
+		{
+			writer.WriteRow({StationName(mileage), Fixed(mileage), Fixed(north), Fixed(east), note});
+			++result.Rows;
+		};
+		// 起终点不在表中时按里程补算坐标，与表中的桩重合时只输出表中的桩
+		const auto writeEndpoint = [&](const double mileage)
+		{
+			const Point2D point = alignment.MileageToCoordinate(Mileage(mileage));
+			write(mileage, point.Y(), point.X(), "");
+		};
+		auto it = std::ranges::lower_bound(table, from - StationTolerance, {}, &StationRecord::Mileage);
+		if (it == table.end() || it->Mileage - from >= StationTolerance)
+		{
+			writeEndpoint(from);
+		}
+		double previous = from;
+		for (; it != table.end() && it->Mileage <= to + StationTolerance; ++it)
+		{
+			write(it->Mileage, it->N, it->E, StationNote(it->Point));
+			previous = it->Mileage;
+		}
+		if (to - previous >= StationTolerance)
+		{
+			writeEndpoint(to);
+		}
+		writer.Close();
+	}
+
+	void RunProject(const HorizontalAlignment& alignment, const Job& job, JobResult& result)
+	{
+		const CsvTable table = ReadCsv(job.Input);
+		const int n = table.FindColumn({"坐标N", "N"});
+		const int e = table.FindColumn({"坐标E", "E"});
+		if (n < 0 || e < 0)
+		{
+			throw VizRailCoreException(std::format(L"{}：缺少坐标N或坐标E列", FromUtf8(PathToUtf8(job.Input))));
+		}
+
+		const auto& xys = alignment.GetXys();
+		std::vector<CsvRow> rows(table.Rows.size());
+		std::atomic<size_t> outside = 0;
+		ParallelFor(0, rows.size(), ProjectGrain, [&](const size_t i)
+		{
+			CsvRow row = table.Rows[i];
+			row.resize(table.Header.size());
+			double north;
+			double east;
+			if (!TryParseDouble(row[n], north) || !TryParseDouble(row[e], east))
+			{
+				throw VizRailCoreException(std::format(L"{}第{}行：坐标不是数值", FromUtf8(PathToUtf8(job.Input)), i + 2));
+			}
+			try
+			{
+				const StationOffset projection = alignment.CoordinateToMileage({east, north});
+				const double mileage = projection.Station.Value();
+				row.insert(row.end(), {
+					           StationName(mileage), Fixed(mileage), Fixed(projection.Offset),
+					           ToUtf8(xys[projection.Element].Key)
+				           });
+			}
+			catch (const NotInLineException&)
+			{
+				row.resize(row.size() + 4);
+				outside.fetch_add(1, std::memory_order_relaxed);
+			}
+			rows[i] = std::move(row);
+		});
+
+		CsvWriter writer(job.Output);
+		CsvRow header = table.Header;
+		header.insert(header.end(), {"桩号", "里程", "偏距", "线元"});
+		writer.WriteRow(header);
+		for (const auto& row : rows)
+		{
+			writer.WriteRow(row);
+		}
+		writer.Close();
+		result.Rows = rows.size();
+		if (outside > 0)
+		{
+			result.Message = std::format("{}个点不在线路范围内", outside.load());
+		}
+	}
+
+	void RunValidate(const HorizontalAlignment& alignment, const Job& job, JobResult& result)
+	{
+		DesignRules rules;
+		rules.MinRadius = job.Number("min-radius", 0.0);
+		rules.MinTransitionLength = job.Number("min-transition", 0.0);
+		rules.MinCircularLength = job.Number("min-circular", 0.0);
+		rules.MinIntermediateLength = job.Number("min-tangent", 0.0);
+		const auto issues = Validate(alignment, rules);
+
+		CsvWriter writer(job.Output);
+		writer.WriteRow({"线元", "问题"});
+		for (const auto& issue : issues)
+		{
+			writer.WriteRow({ToUtf8(issue.Element), ToUtf8(issue.Message)});
+		}
+		writer.Close();
+		result.Rows = issues.size();
+		result.Issues = issues.size();
+	}
+
+	void WriteElementTable(const HorizontalAlignment& alignment, const Job& job, JobResult& result)
+	{
+		CsvWriter writer(job.Output);
+		writer.WriteRow({
+			"线元", "类型", "起点桩号", "起点里程", "终点里程", "长度", "曲线半径", "缓和曲线长", "起点N", "起点E", "终点N",
+			"终点E"
+		});
+		for (const size_t index : ElementsByMileage(alignment))
+		{
+			const auto& xy = alignment.GetXys()[index];
+			const LineElement& element = *xy.Element;
+			Point2D start;
+			Point2D end;
+			std::string type;
+			std::string radius;
+			std::string transition;
+			if (const auto curve = dynamic_cast<const Curve*>(&element))
+			{
+				type = "曲线";
+				start = curve->SpecialPointCoordinate(SpecialPoint::ZH);
+				end = curve->SpecialPointCoordinate(SpecialPoint::HZ);
+				radius = Fixed(curve->R());
+				transition = Fixed(curve->Ls());
+			}
+			else if (const auto line = dynamic_cast<const IntermediateLine*>(&element))
+			{
+				type = "夹直线";
+				start = line->StartPoint();
+				end = line->EndPoint();
+			}
+			const double startMileage = element.StartMileage().Value();
+			writer.WriteRow({
+				ToUtf8(xy.Key), type, StationName(startMileage), Fixed(startMileage), Fixed(element.EndMileage().Value()),
+				Fixed(element.Length()), radius, transition, Fixed(start.Y()), Fixed(start.X()), Fixed(end.Y()),
+				Fixed(end.X())
+			});
+			++result.Rows;
+		}
+		writer.Close();
+	}
+
+	void RunExport(const HorizontalAlignment& alignment, const Job& job, JobResult& result)
+	{
+		if (job.Options.at("format") == "jds")
+		{
+			WriteJdTable(job.Output, alignment);
+			result.Rows = alignment.GetJds().Size();
+		}
+		else if (job.Options.at("format") == "image")
+		{
+			SaveAlignmentImage(alignment, job.Output);
+			result.Rows = alignment.GetXys().Size();
+		}
+		else if (job.Options.at("format") == "dxf")
+		{
+			const DxfAlignment drawing{FromUtf8(job.Scheme), &alignment};
+			SaveDxf(job.Output, {&drawing, 1});
+			result.Rows = alignment.GetXys().Size();
+		}
+		else if (job.Options.at("format") == "landxml")
+		{
+			const LandXmlAlignment exported{FromUtf8(job.Scheme), &alignment};
+			SaveLandXml(job.Output, {&exported, 1});
+			result.Rows = alignment.GetXys().Size();
+		}
+		else if (job.Options.at("format") == "ifc")
+		{
+			const IfcAlignmentSource exported{FromUtf8(job.Scheme), &alignment, {}};
+			SaveIfc(job.Output, {&exported, 1});
+			result.Rows = alignment.GetXys().Size();
+		}
+		else
+		{
+			WriteElementTable(alignment, job, result);
+		}
+	}
+
+	void RunJob(const AlignmentScheme& scheme, const Job& job, ProjectCache* cache, JobResult& result)
+	{
+		switch (job.Kind)
+		{
+		case JobKind::Station:
+			RunStation(scheme.Alignment(), job, cache, result);
+			break;
+		case JobKind::Project:
+			RunProject(scheme.Alignment(), job, result);
+			break;
+		case JobKind::Validate:
+			RunValidate(scheme.Alignment(), job, result);
+			break;
+		case JobKind::Export:
+			RunExport(scheme.Alignment(), job, result);
+			break;
+		}
+	}
+}
+
+std::vector<JobResult> VizRailCli::RunJobs(const JobFile& jobs, const std::filesystem::path& cacheDirectory,
+                                           const CancellationToken& token)
+{
+	std::optional<ProjectCache> cache;
+	if (!cacheDirectory.empty())
+	{
+		cache.emplace(cacheDirectory);
+	}
+
+	// 方案之间相互独立，并行读入交点表并刷新线路
+	const size_t schemeCount = jobs.Schemes.size();
+	std::vector<std::optional<AlignmentScheme>> schemes(schemeCount);
+	std::vector<std::string> errors(schemeCount);
+	ParallelFor(0, schemeCount, 1, [&](const size_t i)
+	{
+		const auto& source = jobs.Schemes[i];
+		try
+		{
+			schemes[i].emplace(FromUtf8(source.Name), HorizontalAlignment(ReadJdTable(source.Path)));
+		}
+		catch (...)
+		{
+			errors[i] = CurrentErrorMessage();
+		}
+	}, token);
+
+	std::vector<JobResult> results(jobs.Jobs.size());
+	ParallelFor(0, jobs.Jobs.size(), 1, [&](const size_t i)
+	{
+		const Job& job = jobs.Jobs[i];
+		JobResult& result = results[i];
+		result.Description = job.Describe();
+		result.Output = job.Output;
+		const auto start = std::chrono::steady_clock::now();
+		const size_t index = std::ranges::find(jobs.Schemes, job.Scheme, &SchemeSource::Name) - jobs.Schemes.begin();
+		if (!schemes[index])
+		{
+			result.Message = "方案读取失败：" + errors[index];
+			return;
+		}
+		try
+		{
+			RunJob(*schemes[index], job, cache ? &*cache : nullptr, result);
+			result.Succeeded = true;
+		}
+		catch (...)
+		{
+			result.Message = CurrentErrorMessage();
+		}
+		result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}, token);
+	return results;
+}
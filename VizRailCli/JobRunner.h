@@ -0,0 +1,32 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "JobFile.h"
+#include "TaskScheduler.h"
+
+namespace VizRailCli
+{
+	/// 一个作业的执行结果
+	struct JobResult
+	{
+		std::string Description;
+		std::filesystem::path Output;
+		bool Succeeded = false;
+		/// 写出的数据行数
+		size_t Rows = 0;
+		/// 检查作业发现的问题数
+		size_t Issues = 0;
+		/// 失败原因或附加说明，UTF-8
+		std::string Message;
+		double Seconds = 0.0;
+	};
+
+	/// \brief 并行读入所有方案，再并行执行所有作业。某个方案或作业出错只影响其自身，其余作业照常执行。
+	/// 所有并行都在VizRailCore的共用调度器上进行，作业内部的并行（如大量点的反算）与作业之间的并行不会超额订阅
+	/// \param cacheDirectory 派生数据缓存目录（见ProjectCache），为空时不使用缓存
+	/// \return 按作业文件中的顺序排列的结果
+	std::vector<JobResult> RunJobs(const JobFile& jobs, const std::filesystem::path& cacheDirectory = {},
+	                               const VizRailCore::CancellationToken& token = {});
+}
@@ -0,0 +1,202 @@
+#include <charconv>
+#include <cstdio>
+#include <format>
+#include <string>
+#include <vector>
+
+#include "Exceptions.h"
+#include "JobFile.h"
+#include "JobRunner.h"
+#include "TaskScheduler.h"
+#include "Text.h"
+#include "Trace.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+using namespace VizRailCli;
+using namespace VizRailCore;
+
+namespace
+{
+	/// 进程退出码
+	enum ExitCode
+	{
+		Success = 0,
+		/// 参数错误、作业文件错误或有作业失败
+		Failure = 1,
+		/// 全部作业成功，但检查作业发现了不满足设计标准的问题
+		IssuesFound = 2,
+	};
+
+	constexpr const char* Usage =
+		"用法: vizrail-cli <作业文件> [-j <线程数>] [--output-dir <目录>] [--cache-dir <目录>] [--trace <跟踪文件.json>]\n"
+		"\n"
+		"  -j, --jobs <线程数>   使用的线程数，默认为全部硬件线程\n"
+		"  --output-dir <目录>   输出文件的根目录，默认为作业文件所在目录\n"
+		"  --cache-dir <目录>    派生数据缓存目录，交点表未修改的方案直接读取缓存的逐桩表\n"
+		"  --trace <文件>        以Chrome跟踪事件格式保存计时事件和计数器\n"
+		"\n"
+		"作业文件每行一条指令，#之后为注释:\n"
+		"  scheme <方案名> <交点表.csv|线路.xml>\n"
+		"  station <方案名> interval=<桩距> [from=<起点里程>] [to=<终点里程>] [format=csv|raw|compressed|xor] output=<文件>\n"
+		"  project <方案名> input=<点表.csv> output=<文件>\n"
+		"  validate <方案名> [min-radius=] [min-transition=] [min-circular=] [min-tangent=] output=<文件>\n"
+		"  export <方案名> format=jds|elements|image|dxf|landxml|ifc output=<文件>\n"
+		"station的format=raw、compressed或xor写出按列分块的二进制逐桩表（见StationTableFile.h），含方位角和曲率，\n"
+		"compressed按分辨率量化（有损），xor逐位无损\n"
+		"format=image导出可由其他进程直接映射查询的线路映像（见AlignmentImage.h）\n"
+		"format=dxf导出DXF R2000图形，方案名为图层名，交点线可由VizRailCore::ReadDxfJdPolylines读回\n"
+		"format=landxml导出LandXML 1.2，扩展名为.xml的交点表按LandXML读取其中的第一条线路\n"
+		"format=ifc导出IFC 4.3的IfcAlignment（平面线形和中线折线，不含超高）\n"
+		"方案名为*时对所有方案各执行一次，选项中的{scheme}替换为方案名\n"
+		"\n"
+		"退出码: 0 全部成功，1 有作业失败，2 检查发现问题\n";
+
+	void Print(const std::string& text)
+	{
+		std::fwrite(text.data(), 1, text.size(), stdout);
+	}
+
+	void PrintError(const std::string& text)
+	{
+		std::fwrite(text.data(), 1, text.size(), stderr);
+	}
+
+	int Run(const std::vector<std::string>& args)
+	{
+		std::string jobPath;
+		std::string outputDirectory;
+		std::string cacheDirectory;
+		std::string tracePath;
+		size_t threads = 0;
+		for (size_t i = 1; i < args.size(); ++i)
+		{
+			const std::string& arg = args[i];
+			if (arg == "-h" || arg == "--help")
+			{
+				Print(Usage);
+				return Success;
+			}
+			const bool hasValue = i + 1 < args.size();
+			if ((arg == "-j" || arg == "--jobs") && hasValue)
+			{
+				const std::string& value = args[++i];
+				const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), threads);
+				if (error != std::errc() || end != value.data() + value.size() || threads == 0)
+				{
+					PrintError("线程数必须为正整数\n");
+					return Failure;
+				}
+			}
+			else if (arg == "--output-dir" && hasValue)
+			{
+				outputDirectory = args[++i];
+			}
+			else if (arg == "--cache-dir" && hasValue)
+			{
+				cacheDirectory = args[++i];
+			}
+			else if (arg == "--trace" && hasValue)
+			{
+				tracePath = args[++i];
+			}
+			else if (jobPath.empty() && !arg.starts_with('-'))
+			{
+				jobPath = arg;
+			}
+			else
+			{
+				PrintError(std::format("无法识别的参数: {}\n\n{}", arg, Usage));
+				return Failure;
+			}
+		}
+		if (jobPath.empty())
+		{
+			PrintError(Usage);
+			return Failure;
+		}
+		if (threads > 0)
+		{
+			// 调用线程也参与执行，工作线程数比总线程数少1
+			TaskScheduler::SetDefaultWorkerCount(threads - 1);
+		}
+
+		JobFile jobs;
+		try
+		{
+			jobs = ReadJobFile(PathFromUtf8(jobPath), PathFromUtf8(outputDirectory));
+		}
+		catch (const VizRailCoreException& e)
+		{
+			PrintError(ToUtf8(e.GetMsg()) + "\n");
+			return Failure;
+		}
+
+		if (!tracePath.empty())
+		{
+			Trace::StartRecording();
+		}
+		const auto results = RunJobs(jobs, PathFromUtf8(cacheDirectory));
+		Trace::StopRecording();
+
+		size_t failed = 0;
+		size_t issues = 0;
+		for (const auto& result : results)
+		{
+			std::string line = std::format("[{}] {} -> {}", result.Succeeded ? "完成" : "失败", result.Description,
+			                               PathToUtf8(result.Output));
+			if (result.Succeeded)
+			{
+				line += std::format("（{}行，{:.3f}s）", result.Rows, result.Seconds);
+			}
+			if (!result.Message.empty())
+			{
+				line += "：" + result.Message;
+			}
+			Print(line + "\n");
+			failed += result.Succeeded ? 0 : 1;
+			issues += result.Issues;
+		}
+		Print(std::format("共{}个作业，{}个失败，检查发现{}个问题\n", results.size(), failed, issues));
+
+		if (!tracePath.empty())
+		{
+			try
+			{
+				Trace::SaveChromeTrace(PathFromUtf8(tracePath));
+			}
+			catch (const VizRailCoreException& e)
+			{
+				PrintError(ToUtf8(e.GetMsg()) + "\n");
+				return Failure;
+			}
+		}
+		TaskScheduler::ShutdownDefault();
+		if (failed > 0)
+		{
+			return Failure;
+		}
+		return issues > 0 ? IssuesFound : Success;
+	}
+}
+
+#ifdef _WIN32
+// Windows上窄字符参数按系统代码页编码，改用宽字符入口取得原始参数
+int wmain(const int argc, wchar_t* argv[])
+{
+	SetConsoleOutputCP(CP_UTF8);
+	std::vector<std::string> args;
+	for (int i = 0; i < argc; ++i)
+	{
+		args.push_back(ToUtf8(argv[i]));
+	}
+	return Run(args);
+}
+#else
+int main(const int argc, char* argv[])
+{
+	return Run({argv, argv + argc});
+}
+#endif
@@ -0,0 +1,133 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace VizRailCli
+{
+	/// 查询服务的二进制协议。客户端与服务在同一台机器上通过Unix域套接字通信，所有字段按本机字节序存放。
+	///
+	/// 每个请求帧为FrameHeader加Count条请求记录，响应帧为FrameHeader加Count条响应记录，
+	/// Length为帧头之后的字节数。客户端可以连续发送多个请求而不等待响应（流水线），
+	/// 服务按请求顺序返回响应，响应的RequestId与请求相同
+	namespace QueryProtocol
+	{
+		enum class Opcode : uint16_t
+		{
+			/// 列出已加载的方案，请求无记录，响应为Count个SchemeInfo，每个后跟NameLength字节的UTF-8方案名
+			ListSchemes = 0,
+			/// 里程转坐标和切线方位角，请求记录为MileageRequest，响应记录为FrameResponse
+			MileageToFrame = 1,
+			/// 坐标反算里程和偏距，请求记录为PointRequest，响应记录为StationResponse
+			PointToStation = 2,
+			/// 区间内的整桩坐标，请求为一条RangeRequest，响应记录为FrameResponse
+			RangeStations = 3,
+		};
+
+		/// 整帧的处理结果，记录在响应帧头的Status中
+		enum class FrameStatus : uint16_t
+		{
+			Ok = 0,
+			UnknownOpcode = 1,
+			UnknownScheme = 2,
+			/// 记录长度与Count不符或参数非法
+			BadRequest = 3,
+			/// 区间桩数超过MaxRangeStations
+			TooLarge = 4,
+		};
+
+		/// 单条记录的处理结果
+		enum class RecordStatus : uint32_t
+		{
+			Ok = 0,
+			/// 里程不在线路上或点没有垂足
+			NotInLine = 1,
+		};
+
+		struct FrameHeader
+		{
+			uint32_t Length;
+			uint32_t RequestId;
+			Opcode Code;
+			/// 请求中为方案序号（ListSchemes的顺序），响应中为FrameStatus
+			uint16_t SchemeOrStatus;
+			uint32_t Count;
+		};
+
+		struct SchemeInfo
+		{
+			/// 线路起点和终点里程
+			double StartMileage;
+			double EndMileage;
+			uint32_t NameLength;
+			uint32_t Reserved;
+		};
+
+		struct MileageRequest
+		{
+			double Mileage;
+		};
+
+		struct PointRequest
+		{
+			double N;
+			double E;
+		};
+
+		struct RangeRequest
+		{
+			double From;
+			double To;
+			double Interval;
+		};
+
+		struct FrameResponse
+		{
+			double Mileage;
+			double N;
+			double E;
+			/// 切线方位角（弧度），与VizRailCore的Angle相同
+			double Azimuth;
+			uint32_t Element;
+			RecordStatus Status;
+		};
+
+		struct StationResponse
+		{
+			double Mileage;
+			/// 偏距，位于线路前进方向右侧为正
+			double Offset;
+			uint32_t Element;
+			RecordStatus Status;
+		};
+
+		static_assert(sizeof(FrameHeader) == 16);
+		static_assert(sizeof(SchemeInfo) == 24);
+		static_assert(sizeof(PointRequest) == 16);
+		static_assert(sizeof(RangeRequest) == 24);
+		static_assert(sizeof(FrameResponse) == 40);
+		static_assert(sizeof(StationResponse) == 24);
+
+		/// 单帧最大长度，超过时服务断开连接
+		constexpr uint32_t MaxFrameLength = 64u << 20;
+		/// 单个区间请求最多返回的桩数
+		constexpr uint32_t MaxRangeStations = 1u << 20;
+
+		/// 按字节读取记录，缓冲区不必按记录对齐
+		template <typename T>
+		T Read(const std::byte* data)
+		{
+			T value;
+			std::memcpy(&value, data, sizeof(T));
+			return value;
+		}
+
+		template <typename T>
+		void Append(std::vector<std::byte>& buffer, const T& value)
+		{
+			const auto bytes = std::as_bytes(std::span(&value, 1));
+			buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+		}
+	}
+}
@@ -0,0 +1,183 @@
+#include "QueryServer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Exceptions.h"
+#include "UnixSocket.h"
+
+using namespace VizRailCli;
+
+namespace
+{
+	// 每次至少读取的字节数，流水线客户端的多个请求帧通常一次读到
+	constexpr size_t ReadChunk = 64 * 1024;
+}
+
+QueryServer::QueryServer(const QueryService& service, std::filesystem::path socketPath) :
+	_service(service), _socketPath(std::move(socketPath))
+{
+}
+
+QueryServer::~QueryServer()
+{
+	Stop();
+}
+
+void QueryServer::Start()
+{
+	_listenSocket = UnixSocket::Listen(_socketPath);
+	int wake[2];
+	if (pipe(wake) < 0)
+	{
+		UnixSocket::Close(_listenSocket);
+		_listenSocket = -1;
+		throw VizRailCoreException(L"创建管道失败");
+	}
+	_wakeRead = wake[0];
+	_wakeWrite = wake[1];
+	_stopping = false;
+	_acceptThread = std::thread(&QueryServer::AcceptLoop, this);
+}
+
+void QueryServer::Stop()
+{
+	{
+		std::lock_guard lock(_mutex);
+		if (_listenSocket < 0 || _stopping)
+		{
+			return;
+		}
+		_stopping = true;
+	}
+
+	constexpr char signal = 0;
+	(void)write(_wakeWrite, &signal, 1);
+	_acceptThread.join();
+
+	// AcceptLoop已退出，不会再添加连接；关闭读写使阻塞在recv上的连接线程返回
+	for (const auto& connection : _connections)
+	{
+		shutdown(connection->Socket, SHUT_RDWR);
+	}
+	for (const auto& connection : _connections)
+	{
+		connection->Thread.join();
+		UnixSocket::Close(connection->Socket);
+	}
+	_connections.clear();
+
+	UnixSocket::Close(_listenSocket);
+	UnixSocket::Close(_wakeRead);
+	UnixSocket::Close(_wakeWrite);
+	_listenSocket = _wakeRead = _wakeWrite = -1;
+	std::filesystem::remove(_socketPath);
+}
+
+void QueryServer::AcceptLoop()
+{
+	while (true)
+	{
+		pollfd fds[2] = {{_listenSocket, POLLIN, 0}, {_wakeRead, POLLIN, 0}};
+		if (poll(fds, 2, -1) < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return;
+		}
+		if (fds[1].revents != 0)
+		{
+			return;
+		}
+		if ((fds[0].revents & POLLIN) == 0)
+		{
+			continue;
+		}
+
+		const int socket = accept(_listenSocket, nullptr, nullptr);
+		if (socket < 0)
+		{
+			continue;
+		}
+		std::lock_guard lock(_mutex);
+		ReapFinished();
+		auto& connection = *_connections.emplace_back(std::make_unique<Connection>());
+		connection.Socket = socket;
+		connection.Thread = std::thread([this, &connection]
+		{
+			Serve(connection);
+			connection.Finished.store(true, std::memory_order_release);
+		});
+		_connectionCount.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void QueryServer::ReapFinished()
+{
+	for (auto it = _connections.begin(); it != _connections.end();)
+	{
+		if ((*it)->Finished.load(std::memory_order_acquire))
+		{
+			(*it)->Thread.join();
+			UnixSocket::Close((*it)->Socket);
+			it = _connections.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void QueryServer::Serve(Connection& connection) const
+{
+	std::vector<std::byte> input(ReadChunk);
+	std::vector<std::byte> output;
+	size_t used = 0;
+	try
+	{
+		while (true)
+		{
+			const ssize_t received = recv(connection.Socket, input.data() + used, input.size() - used, 0);
+			if (received == 0)
+			{
+				break;
+			}
+			if (received < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				break;
+			}
+			used += static_cast<size_t>(received);
+
+			output.clear();
+			const size_t processed = _service.Process({input.data(), used}, output);
+			UnixSocket::SendAll(connection.Socket, output);
+
+			// 未收全的帧移到缓冲区开头，缓冲区扩大到能容纳整帧
+			std::memmove(input.data(), input.data() + processed, used - processed);
+			used -= processed;
+			const size_t required = std::max(QueryService::PendingFrameSize({input.data(), used}), used + ReadChunk);
+			if (input.size() < required)
+			{
+				input.resize(required);
+			}
+		}
+	}
+	catch (const std::exception&)
+	{
+		// 非法请求、对端已断开或帧过大无法分配，关闭连接
+	}
+	shutdown(connection.Socket, SHUT_RDWR);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "QueryService.h"
+
+namespace VizRailCli
+{
+	/// Unix域套接字上的查询服务（仅POSIX）。每个连接一个线程，连接内的请求按到达顺序处理，
+	/// 一次读到的所有请求帧一起处理、响应一次写出，客户端流水线发送时系统调用次数与请求数无关
+	class QueryServer
+	{
+	public:
+		/// \param service 服务运行期间必须保持有效
+		QueryServer(const QueryService& service, std::filesystem::path socketPath);
+
+		QueryServer(const QueryServer&) = delete;
+		QueryServer& operator=(const QueryServer&) = delete;
+
+		~QueryServer();
+
+		/// \brief 创建套接字并开始接受连接。路径上已有的套接字文件会被替换
+		/// \exception VizRailCoreException 无法创建或绑定套接字
+		void Start();
+
+		/// 停止接受连接，断开所有连接并等待连接线程退出，删除套接字文件
+		void Stop();
+
+		[[nodiscard]] const std::filesystem::path& SocketPath() const
+		{
+			return _socketPath;
+		}
+
+		/// 累计处理的连接数
+		[[nodiscard]] size_t ConnectionCount() const
+		{
+			return _connectionCount.load(std::memory_order_relaxed);
+		}
+
+	private:
+		struct Connection
+		{
+			int Socket = -1;
+			std::thread Thread;
+			std::atomic<bool> Finished = false;
+		};
+
+		void AcceptLoop();
+		void Serve(Connection& connection) const;
+		void ReapFinished();
+
+		const QueryService& _service;
+		std::filesystem::path _socketPath;
+		int _listenSocket = -1;
+		// 用于唤醒AcceptLoop的管道
+		int _wakeRead = -1;
+		int _wakeWrite = -1;
+		std::thread _acceptThread;
+		std::mutex _mutex;
+		std::list<std::unique_ptr<Connection>> _connections;
+		std::atomic<size_t> _connectionCount = 0;
+		bool _stopping = false;
+	};
+}
@@ -0,0 +1,282 @@
+#include "QueryService.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <optional>
+
+#include "Exceptions.h"
+#include "JdTable.h"
+#include "TaskScheduler.h"
+#include "Text.h"
+
+using namespace VizRailCli;
+using namespace VizRailCli::QueryProtocol;
+using namespace VizRailCore;
+
+namespace
+{
+	// 记录数不少于此值时并行计算，较少的记录分块后调度开销大于计算量
+	constexpr size_t ParallelThreshold = 2048;
+	constexpr size_t ParallelGrain = 512;
+
+	constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+	/// 线路起点和终点里程
+	std::pair<double, double> MileageRange(const HorizontalAlignment& alignment)
+	{
+		double start = std::numeric_limits<double>::infinity();
+		double end = -std::numeric_limits<double>::infinity();
+		for (const auto& xy : alignment.GetXys())
+		{
+			start = std::min(start, xy.Element->StartMileage().Value());
+			end = std::max(end, xy.Element->EndMileage().Value());
+		}
+		return {start, end};
+	}
+
+	FrameResponse Frame(const HorizontalAlignment& alignment, const double mileage)
+	{
+		try
+		{
+			const StationFrame frame = alignment.MileageToFrame(Mileage(mileage));
+			return {
+				mileage, frame.Point.Y(), frame.Point.X(), frame.Azimuth.Radian(),
+				static_cast<uint32_t>(frame.Element), RecordStatus::Ok
+			};
+		}
+		catch (const VizRailCoreException&)
+		{
+			return {mileage, NaN, NaN, NaN, 0, RecordStatus::NotInLine};
+		}
+	}
+
+	StationResponse Station(const HorizontalAlignment& alignment, const PointRequest& point)
+	{
+		try
+		{
+			const StationOffset projection = alignment.CoordinateToMileage({point.E, point.N});
+			return {
+				projection.Station.Value(), projection.Offset, static_cast<uint32_t>(projection.Element),
+				RecordStatus::Ok
+			};
+		}
+		catch (const VizRailCoreException&)
+		{
+			return {NaN, NaN, 0, RecordStatus::NotInLine};
+		}
+	}
+
+	/// 在output末尾预留count条响应记录，对每条记录调用compute(i)并写入，记录较多时并行计算
+	template <typename Response, typename Compute>
+	void AppendRecords(std::vector<std::byte>& output, const size_t count, const Compute& compute)
+	{
+		const size_t offset = output.size();
+		output.resize(offset + count * sizeof(Response));
+		std::byte* records = output.data() + offset;
+		const auto body = [&](const size_t i)
+		{
+			const Response response = compute(i);
+			std::memcpy(records + i * sizeof(Response), &response, sizeof(Response));
+		};
+		if (count >= ParallelThreshold)
+		{
+			ParallelFor(0, count, ParallelGrain, body);
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				body(i);
+			}
+		}
+	}
+
+	void AppendHeader(std::vector<std::byte>& output, const FrameHeader& request, const FrameStatus status,
+	                  const size_t length, const uint32_t count)
+	{
+		Append(output, FrameHeader{
+			       static_cast<uint32_t>(length), request.RequestId, request.Code, static_cast<uint16_t>(status), count
+		       });
+	}
+}
+
+QueryService::QueryService(std::vector<AlignmentScheme> schemes) : _schemes(std::move(schemes))
+{
+	for (const auto& scheme : _schemes)
+	{
+		_ranges.push_back(MileageRange(scheme.Alignment()));
+	}
+}
+
+size_t QueryService::PendingFrameSize(const std::span<const std::byte> input)
+{
+	if (input.size() < sizeof(FrameHeader))
+	{
+		return sizeof(FrameHeader);
+	}
+	return sizeof(FrameHeader) + Read<FrameHeader>(input.data()).Length;
+}
+
+size_t QueryService::Process(const std::span<const std::byte> input, std::vector<std::byte>& output) const
+{
+	size_t position = 0;
+	while (input.size() - position >= sizeof(FrameHeader))
+	{
+		const auto header = Read<FrameHeader>(input.data() + position);
+		if (header.Length > MaxFrameLength)
+		{
+			throw VizRailCoreException(std::format(L"请求帧长度{}超过上限", header.Length));
+		}
+		if (input.size() - position - sizeof(FrameHeader) < header.Length)
+		{
+			break;
+		}
+		ProcessFrame(header, input.data() + position + sizeof(FrameHeader), output);
+		position += sizeof(FrameHeader) + header.Length;
+	}
+	return position;
+}
+
+void QueryService::ProcessFrame(const FrameHeader& header, const std::byte* payload,
+                                std::vector<std::byte>& output) const
+{
+	if (header.Code == Opcode::ListSchemes)
+	{
+		const size_t headerOffset = output.size();
+		AppendHeader(output, header, FrameStatus::Ok, 0, static_cast<uint32_t>(_schemes.size()));
+		for (size_t i = 0; i < _schemes.size(); ++i)
+		{
+			const std::string name = ToUtf8(_schemes[i].Name());
+			const auto [start, end] = _ranges[i];
+			Append(output, SchemeInfo{start, end, static_cast<uint32_t>(name.size()), 0});
+			const auto bytes = std::as_bytes(std::span(name));
+			output.insert(output.end(), bytes.begin(), bytes.end());
+		}
+		// 方案名长度不定，写完后回填帧长度
+		const auto length = static_cast<uint32_t>(output.size() - headerOffset - sizeof(FrameHeader));
+		std::memcpy(output.data() + headerOffset, &length, sizeof(length));
+		return;
+	}
+
+	const auto fail = [&](const FrameStatus status)
+	{
+		AppendHeader(output, header, status, 0, 0);
+	};
+	if (header.SchemeOrStatus >= _schemes.size())
+	{
+		fail(FrameStatus::UnknownScheme);
+		return;
+	}
+	const HorizontalAlignment& alignment = _schemes[header.SchemeOrStatus].Alignment();
+
+	switch (header.Code)
+	{
+	case Opcode::MileageToFrame:
+		if (header.Length != static_cast<uint64_t>(header.Count) * sizeof(MileageRequest))
+		{
+			fail(FrameStatus::BadRequest);
+			return;
+		}
+		AppendHeader(output, header, FrameStatus::Ok, header.Count * sizeof(FrameResponse), header.Count);
+		AppendRecords<FrameResponse>(output, header.Count, [&](const size_t i)
+		{
+			return Frame(alignment, Read<MileageRequest>(payload + i * sizeof(MileageRequest)).Mileage);
+		});
+		return;
+	case Opcode::PointToStation:
+		if (header.Length != static_cast<uint64_t>(header.Count) * sizeof(PointRequest))
+		{
+			fail(FrameStatus::BadRequest);
+			return;
+		}
+		AppendHeader(output, header, FrameStatus::Ok, header.Count * sizeof(StationResponse), header.Count);
+		AppendRecords<StationResponse>(output, header.Count, [&](const size_t i)
+		{
+			return Station(alignment, Read<PointRequest>(payload + i * sizeof(PointRequest)));
+		});
+		return;
+	case Opcode::RangeStations:
+		{
+			if (header.Length != sizeof(RangeRequest) || header.Count != 1)
+			{
+				fail(FrameStatus::BadRequest);
+				return;
+			}
+			const auto range = Read<RangeRequest>(payload);
+			const auto [start, end] = _ranges[header.SchemeOrStatus];
+			const double from = std::max(range.From, start);
+			const double to = std::min(range.To, end);
+			if (!std::isfinite(range.Interval) || !(range.Interval > 0.0) || std::isnan(from) || std::isnan(to))
+			{
+				fail(FrameStatus::BadRequest);
+				return;
+			}
+			// 区间内interval的整倍数里程。interval极小时商会溢出为无穷，桩数为无穷或NaN，按桩数过多处理
+			const double first = std::ceil(from / range.Interval);
+			const double last = std::floor(to / range.Interval);
+			const double stations = last >= first ? last - first + 1 : 0;
+			if (!std::isfinite(first) || !std::isfinite(last) || !std::isfinite(stations) ||
+				stations > MaxRangeStations)
+			{
+				fail(FrameStatus::TooLarge);
+				return;
+			}
+			const auto count = static_cast<uint32_t>(stations);
+			AppendHeader(output, header, FrameStatus::Ok, count * sizeof(FrameResponse), count);
+			AppendRecords<FrameResponse>(output, count, [&](const size_t i)
+			{
+				return Frame(alignment, (first + static_cast<double>(i)) * range.Interval);
+			});
+			return;
+		}
+	default:
+		fail(FrameStatus::UnknownOpcode);
+		return;
+	}
+}
+
+SchemeSource VizRailCli::ParseSchemeArgument(const std::string& argument)
+{
+	const size_t separator = argument.find('=');
+	if (separator == std::string::npos || separator == 0)
+	{
+		throw VizRailCoreException(std::format(L"方案参数{}应为 方案名=交点表.csv", FromUtf8(argument)));
+	}
+	return {argument.substr(0, separator), PathFromUtf8(argument.substr(separator + 1))};
+}
+
+std::vector<AlignmentScheme> VizRailCli::LoadSchemes(const std::vector<SchemeSource>& sources)
+{
+	std::vector<std::optional<AlignmentScheme>> loaded(sources.size());
+	std::vector<std::wstring> errors(sources.size());
+	ParallelFor(0, sources.size(), 1, [&](const size_t i)
+	{
+		const std::wstring name = FromUtf8(sources[i].Name);
+		try
+		{
+			loaded[i].emplace(name, HorizontalAlignment(ReadJdTable(sources[i].Path)));
+		}
+		catch (const VizRailCoreException& e)
+		{
+			errors[i] = std::format(L"方案{}读取失败：{}", name, e.GetMsg());
+		}
+		catch (const std::exception& e)
+		{
+			errors[i] = std::format(L"方案{}读取失败：{}", name, FromUtf8(e.what()));
+		}
+	});
+
+	std::vector<AlignmentScheme> schemes;
+	for (size_t i = 0; i < sources.size(); ++i)
+	{
+		if (!loaded[i])
+		{
+			throw VizRailCoreException(errors[i]);
+		}
+		schemes.push_back(std::move(*loaded[i]));
+	}
+	return schemes;
+}
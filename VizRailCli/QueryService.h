@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AlignmentScheme.h"
+#include "JobFile.h"
+#include "QueryProtocol.h"
+
+namespace VizRailCli
+{
+	/// 查询服务的请求处理，与传输方式无关。方案加载后不再修改，可由多个连接线程同时调用
+	class QueryService
+	{
+	public:
+		explicit QueryService(std::vector<VizRailCore::AlignmentScheme> schemes);
+
+		[[nodiscard]] const std::vector<VizRailCore::AlignmentScheme>& Schemes() const
+		{
+			return _schemes;
+		}
+
+		/// \brief 处理input开头所有完整的请求帧，响应按请求顺序追加到output。
+		/// 一次收到的多个请求一起处理，响应一次写出；单帧记录较多时在共用调度器上并行计算
+		/// \return 已处理的字节数，其后为尚未收全的帧
+		/// \exception VizRailCoreException 帧长度超过MaxFrameLength，连接应当断开
+		size_t Process(std::span<const std::byte> input, std::vector<std::byte>& output) const;
+
+		/// \brief input开头的帧收全所需的字节数，帧头不完整时为帧头长度
+		[[nodiscard]] static size_t PendingFrameSize(std::span<const std::byte> input);
+
+	private:
+		void ProcessFrame(const QueryProtocol::FrameHeader& header, const std::byte* payload,
+		                  std::vector<std::byte>& output) const;
+
+		std::vector<VizRailCore::AlignmentScheme> _schemes;
+		/// 各方案的起点和终点里程
+		std::vector<std::pair<double, double>> _ranges;
+	};
+
+	/// \brief 解析命令行参数中的“方案名=交点表.csv”
+	/// \exception VizRailCoreException 参数中没有=或方案名为空
+	SchemeSource ParseSchemeArgument(const std::string& argument);
+
+	/// \brief 并行读入交点表并刷新线路，方案顺序与sources相同
+	/// \exception VizRailCoreException 有方案读取失败，消息中包含方案名
+	std::vector<VizRailCore::AlignmentScheme> LoadSchemes(const std::vector<SchemeSource>& sources);
+}
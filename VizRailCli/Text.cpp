@@ -0,0 +1,42 @@
+#include "Text.h"
+
+#include <charconv>
+
+using namespace VizRailCli;
+
+std::filesystem::path VizRailCli::PathFromUtf8(const std::string_view text)
+{
+	return {std::u8string(reinterpret_cast<const char8_t*>(text.data()), text.size())};
+}
+
+std::string VizRailCli::PathToUtf8(const std::filesystem::path& path)
+{
+	const std::u8string text = path.u8string();
+	return {reinterpret_cast<const char*>(text.data()), text.size()};
+}
+
+bool VizRailCli::TryParseDouble(std::string_view text, double& value)
+{
+	text = Trim(text);
+	if (!text.empty() && text.front() == '+')
+	{
+		text.remove_prefix(1);
+	}
+	if (text.empty())
+	{
+		return false;
+	}
+	const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+	return error == std::errc() && end == text.data() + text.size();
+}
+
+std::string_view VizRailCli::Trim(std::string_view text)
+{
+	constexpr std::string_view whitespace = " \t\r\n";
+	const size_t first = text.find_first_not_of(whitespace);
+	if (first == std::string_view::npos)
+	{
+		return {};
+	}
+	return text.substr(first, text.find_last_not_of(whitespace) - first + 1);
+}
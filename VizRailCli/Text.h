@@ -0,0 +1,25 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "Utf8.h"
+
+namespace VizRailCli
+{
+	/// 命令行工具内部的文本均为UTF-8，与VizRailCore交换时由Utf8.h中的函数转换为宽字符串
+	using VizRailCore::FromUtf8;
+	using VizRailCore::ToUtf8;
+
+	/// 由UTF-8路径构造path，不依赖系统代码页
+	std::filesystem::path PathFromUtf8(std::string_view text);
+
+	std::string PathToUtf8(const std::filesystem::path& path);
+
+	/// \brief 解析数值，允许首尾空白
+	/// \return 不是完整的数值时返回false
+	bool TryParseDouble(std::string_view text, double& value);
+
+	/// 去掉首尾空白
+	std::string_view Trim(std::string_view text);
+}
@@ -0,0 +1,144 @@
+#include "UnixSocket.h"
+
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Exceptions.h"
+#include "Text.h"
+
+using namespace VizRailCli;
+
+namespace
+{
+#ifdef MSG_NOSIGNAL
+	constexpr int SendFlags = MSG_NOSIGNAL;
+#else
+	constexpr int SendFlags = 0;
+#endif
+
+	[[noreturn]] void ThrowSystemError(const wchar_t* operation)
+	{
+		throw VizRailCoreException(std::format(L"{}失败：{}", operation, FromUtf8(std::strerror(errno))));
+	}
+
+	sockaddr_un Address(const std::filesystem::path& path)
+	{
+		sockaddr_un address{};
+		address.sun_family = AF_UNIX;
+		const std::string text = path.string();
+		if (text.size() >= sizeof(address.sun_path))
+		{
+			throw VizRailCoreException(std::format(L"套接字路径{}过长", FromUtf8(text)));
+		}
+		std::memcpy(address.sun_path, text.c_str(), text.size() + 1);
+		return address;
+	}
+
+	int CreateSocket()
+	{
+		const int result = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (result < 0)
+		{
+			ThrowSystemError(L"创建套接字");
+		}
+#ifdef SO_NOSIGPIPE
+		constexpr int enable = 1;
+		setsockopt(result, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+		return result;
+	}
+}
+
+int UnixSocket::Listen(const std::filesystem::path& path)
+{
+	const sockaddr_un address = Address(path);
+	// 只替换上次运行留下的套接字文件，不删除同名的普通文件
+	struct stat status{};
+	if (lstat(address.sun_path, &status) == 0)
+	{
+		if (!S_ISSOCK(status.st_mode))
+		{
+			throw VizRailCoreException(std::format(L"{}已存在且不是套接字", FromUtf8(path.string())));
+		}
+		unlink(address.sun_path);
+	}
+
+	const int result = CreateSocket();
+	if (bind(result, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 ||
+		listen(result, SOMAXCONN) < 0)
+	{
+		const int error = errno;
+		close(result);
+		errno = error;
+		ThrowSystemError(L"监听套接字");
+	}
+	return result;
+}
+
+int UnixSocket::Connect(const std::filesystem::path& path)
+{
+	const sockaddr_un address = Address(path);
+	const int result = CreateSocket();
+	if (connect(result, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0)
+	{
+		const int error = errno;
+		close(result);
+		errno = error;
+		ThrowSystemError(L"连接查询服务");
+	}
+	return result;
+}
+
+void UnixSocket::SendAll(const int socket, std::span<const std::byte> data)
+{
+	while (!data.empty())
+	{
+		const ssize_t sent = send(socket, data.data(), data.size(), SendFlags);
+		if (sent < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			ThrowSystemError(L"发送");
+		}
+		data = data.subspan(static_cast<size_t>(sent));
+	}
+}
+
+bool UnixSocket::ReceiveAll(const int socket, std::span<std::byte> data)
+{
+	while (!data.empty())
+	{
+		const ssize_t received = recv(socket, data.data(), data.size(), 0);
+		if (received == 0)
+		{
+			return false;
+		}
+		if (received < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			ThrowSystemError(L"接收");
+		}
+		data = data.subspan(static_cast<size_t>(received));
+	}
+	return true;
+}
+
+void UnixSocket::Close(const int socket)
+{
+	if (socket >= 0)
+	{
+		close(socket);
+	}
+}
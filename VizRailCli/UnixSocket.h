@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace VizRailCli
+{
+	/// POSIX套接字的简单封装，出错时抛出VizRailCoreException
+	namespace UnixSocket
+	{
+		/// \brief 创建监听套接字，路径上已有的套接字文件会被替换
+		int Listen(const std::filesystem::path& path);
+
+		/// \brief 连接到监听中的套接字
+		int Connect(const std::filesystem::path& path);
+
+		/// \brief 写出全部数据，对端关闭时不产生SIGPIPE
+		void SendAll(int socket, std::span<const std::byte> data);
+
+		/// \brief 读满data
+		/// \return 对端在读满之前关闭时返回false
+		bool ReceiveAll(int socket, std::span<std::byte> data);
+
+		void Close(int socket);
+	}
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "BoundingBox.h"
+
+namespace VizRailCore
+{
+	/// 静态AABB树，由一组包围盒一次性构建，用于线元的视口裁剪和拾取查询。
+	/// 节点按深度优先顺序存储在连续数组中，查询结果为构建时传入的包围盒下标
+	class AabbTree
+	{
+	public:
+		AabbTree() = default;
+		explicit AabbTree(const std::vector<BoundingBox>& boxes);
+
+		void Build(const std::vector<BoundingBox>& boxes);
+
+		void Clear();
+
+		[[nodiscard]] bool IsEmpty() const
+		{
+			return _nodes.empty();
+		}
+
+		[[nodiscard]] size_t Size() const
+		{
+			return _items.size();
+		}
+
+		/// 节点、下标和包围盒数组占用的内存
+		[[nodiscard]] size_t MemoryUsage() const
+		{
+			return _nodes.capacity() * sizeof(Node) + _items.capacity() * sizeof(uint32_t) +
+				_boxes.capacity() * sizeof(BoundingBox);
+		}
+
+		/// 所有包围盒的并集，O(1)
+		[[nodiscard]] BoundingBox Bounds() const
+		{
+			return _nodes.empty() ? BoundingBox() : _nodes.front().Box;
+		}
+
+		/// \brief 查询与矩形相交的包围盒
+		/// \param box 查询矩形
+		/// \param result 输出相交包围盒的下标（按下标升序）
+		void Query(const BoundingBox& box, std::vector<size_t>& result) const;
+
+		/// \brief 查询与射线相交的包围盒
+		/// \param ray 射线
+		/// \param result 输出相交包围盒的下标（按射线进入包围盒的先后排序）
+		void Query(const Ray2D& ray, std::vector<size_t>& result) const;
+
+		/// \brief 最近对象查询。按包围盒到point的距离由近及远调用visit(i)，visit返回点到第i个对象的实际距离，
+		/// 包围盒距离大于已返回的最小距离的子树和包围盒被跳过。距离相等的对象都会被访问，由调用方决定取舍
+		template <typename Visit>
+		void VisitNearest(const Point2D& point, const Visit& visit) const
+		{
+			if (_nodes.empty())
+			{
+				return;
+			}
+			double best = std::numeric_limits<double>::infinity();
+			// 每层压入两个子节点、弹出一个，栈深不超过树深加1
+			std::pair<double, uint32_t> stack[MaxDepth];
+			size_t top = 0;
+			stack[top++] = {_nodes.front().Box.DistanceTo(point), 0};
+			while (top > 0)
+			{
+				const auto [bound, current] = stack[--top];
+				if (bound > best)
+				{
+					continue;
+				}
+				const Node& node = _nodes[current];
+				if (node.Count > 0)
+				{
+					for (uint32_t i = node.Offset; i < node.Offset + node.Count; ++i)
+					{
+						if (_boxes[_items[i]].DistanceTo(point) <= best)
+						{
+							best = std::min(best, static_cast<double>(visit(static_cast<size_t>(_items[i]))));
+						}
+					}
+					continue;
+				}
+				const double left = _nodes[current + 1].Box.DistanceTo(point);
+				const double right = _nodes[node.Offset].Box.DistanceTo(point);
+				// 较近的子节点后压入、先访问，尽早得到较小的最小距离
+				if (left <= right)
+				{
+					stack[top++] = {right, node.Offset};
+					stack[top++] = {left, current + 1};
+				}
+				else
+				{
+					stack[top++] = {left, current + 1};
+					stack[top++] = {right, node.Offset};
+				}
+			}
+		}
+
+	private:
+		// 中位数划分保证树深不超过log2(n)，64层足以容纳任何规模的输入
+		static constexpr size_t MaxDepth = 64;
+
+		struct Node
+		{
+			BoundingBox Box;
+			// 叶节点为_items中的起始位置，内部节点为右子节点下标（左子节点紧随当前节点）
+			uint32_t Offset = 0;
+			// 叶节点包含的包围盒数量，内部节点为0
+			uint32_t Count = 0;
+		};
+
+		std::vector<Node> _nodes;
+		std::vector<uint32_t> _items;
+		std::vector<BoundingBox> _boxes;
+
+		uint32_t BuildNode(std::vector<Point2D>& centers, uint32_t begin, uint32_t end);
+	};
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "AlignmentImageLayout.h"
+#include "HorizontalAlignment.h"
+#include "MappedFile.h"
+
+namespace VizRailCore
+{
+	namespace AlignmentImage
+	{
+		/// \brief 线元的记录，方位角和曲线要素均已预先算好
+		[[nodiscard]] ElementRecord MakeElementRecord(const LineElement& element);
+
+		/// \brief 按Curve和IntermediateLine的公式计算线元上里程处的点位和切线方位角，结果的Element为0
+		[[nodiscard]] StationFrame EvaluateElement(const ElementRecord& element, double mileage);
+	}
+
+	/// \brief 线路映像的字节数
+	[[nodiscard]] size_t AlignmentImageSize(const HorizontalAlignment& alignment);
+
+	/// \brief 将线路映像写入destination，例如直接写入已创建的共享内存
+	/// \param destination 长度不小于AlignmentImageSize(alignment)，起点按8字节对齐
+	/// \exception VizRailCoreException destination过短或未对齐
+	void WriteAlignmentImage(const HorizontalAlignment& alignment, std::span<std::byte> destination);
+
+	/// \brief 生成线路映像
+	[[nodiscard]] std::vector<std::byte> BuildAlignmentImage(const HorizontalAlignment& alignment);
+
+	/// \brief 将线路映像保存到文件，用ReplaceFile替换已有文件
+	/// \exception VizRailCoreException 无法写入文件
+	void SaveAlignmentImage(const HorizontalAlignment& alignment, const std::filesystem::path& path);
+
+	/// 线路映像的只读视图，直接在映像所在的内存上查询，不复制也不反序列化。
+	/// 构造时只检查映像头和各段边界，不访问线元数据，打开映射的文件只产生查询所触及页面的缺页。
+	/// 视图不拥有内存，映像须在视图使用期间保持有效且不被修改
+	class AlignmentImageView
+	{
+	public:
+		/// \exception VizRailCoreException 数据不是线路映像、版本不符、未按8字节对齐或段越界
+		explicit AlignmentImageView(std::span<const std::byte> image);
+
+		[[nodiscard]] uint64_t Revision() const
+		{
+			return _header->Revision;
+		}
+
+		[[nodiscard]] std::span<const AlignmentImage::JdRecord> Jds() const
+		{
+			return _jds;
+		}
+
+		[[nodiscard]] std::span<const AlignmentImage::ElementRecord> Elements() const
+		{
+			return _elements;
+		}
+
+		[[nodiscard]] BoundingBox Extents() const;
+
+		/// \brief 复制交点表，用于在本进程中重建可编辑的HorizontalAlignment
+		[[nodiscard]] std::vector<Jd> CopyJds() const;
+
+		/// \brief 里程转坐标，结果与HorizontalAlignment::MileageToCoordinate相同。O(log n)，不分配内存
+		/// \exception NotInLineException 里程不在线路上
+		[[nodiscard]] Point2D MileageToCoordinate(const Mileage& mileage) const;
+
+		/// \brief 里程处的点位和切线方位角，结果与HorizontalAlignment::MileageToFrame相同
+		/// \exception NotInLineException 里程不在线路上
+		[[nodiscard]] StationFrame MileageToFrame(const Mileage& mileage) const;
+
+	private:
+		[[nodiscard]] size_t FindElement(double mileage) const;
+
+		const AlignmentImage::Header* _header;
+		std::span<const AlignmentImage::JdRecord> _jds;
+		std::span<const AlignmentImage::ElementRecord> _elements;
+		std::span<const AlignmentImage::MileageIndexEntry> _mileageIndex;
+	};
+
+	/// 以只读方式映射到内存的线路映像文件
+	class MappedAlignmentFile
+	{
+	public:
+		/// \exception VizRailCoreException 无法打开或映射文件，或文件不是有效的线路映像
+		explicit MappedAlignmentFile(const std::filesystem::path& path);
+
+		[[nodiscard]] const AlignmentImageView& View() const
+		{
+			return _view;
+		}
+
+	private:
+		MappedFile _file;
+		AlignmentImageView _view;
+	};
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "Jd.h"
+
+namespace VizRailCore
+{
+	/// 线路映像的二进制布局。映像是一块连续内存，各段以相对映像起点的偏移定位，不含指针，
+	/// 可以原样写入文件或共享内存，由其他进程映射到任意地址后直接读取。
+	/// 数值按本机字节序存放，只在同一台机器上的进程之间共享
+	namespace AlignmentImage
+	{
+		constexpr uint32_t Magic = 0x4C415256; // "VRAL"
+		constexpr uint32_t Version = 1;
+		/// 各段起点的对齐字节数
+		constexpr size_t SectionAlignment = 64;
+
+		struct Section
+		{
+			/// 相对映像起点的字节偏移
+			uint64_t Offset;
+			uint64_t Count;
+		};
+
+		struct Header
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			/// 映像总字节数
+			uint64_t Size;
+			/// 生成映像时线路的修订号
+			uint64_t Revision;
+			/// JdRecord数组
+			Section Jds;
+			/// ElementRecord数组，顺序与HorizontalAlignment::GetXys()相同
+			Section Elements;
+			/// MileageIndexEntry数组，按起点里程排序
+			Section MileageIndex;
+			double MinX;
+			double MinY;
+			double MaxX;
+			double MaxY;
+		};
+
+		/// 与Jd相同的字段，显式填充使布局与编译器无关
+		struct JdRecord
+		{
+			uint32_t JdH;
+			uint32_t Reserved;
+			double N;
+			double E;
+			double Angle;
+			double R;
+			double Ls;
+			double TH;
+			double LH;
+			double LJzx;
+			double StartMileage;
+			double EndMileage;
+		};
+
+		enum class ElementKind : uint32_t
+		{
+			Line = 0,
+			Curve = 1,
+		};
+
+		/// 线元及其预先计算的常量，查询时不再求方位角和曲线要素。
+		/// 曲线前半段在ZH点局部坐标系中计算，后半段在HZ点局部坐标系中计算，与Curve相同
+		struct ElementRecord
+		{
+			ElementKind Kind;
+			uint32_t Reserved;
+			double StartMileage;
+			double EndMileage;
+			/// 直线起点或ZH点
+			double StartX;
+			double StartY;
+			/// 直线方向或ZH点局部坐标系x轴的单位向量
+			double StartCos;
+			double StartSin;
+			/// 起点切线方位角（弧度）
+			double StartAzimuth;
+
+			// 以下字段只用于曲线
+
+			/// HZ点
+			double EndX;
+			double EndY;
+			/// HZ点局部坐标系x轴（由HZ点指向交点）的单位向量
+			double EndCos;
+			double EndSin;
+			/// 终点切线方位角（弧度）
+			double EndAzimuth;
+			double R;
+			double Ls;
+			/// 右转为1，左转为-1
+			double Turn;
+			/// 切垂距和内移距
+			double M;
+			double P;
+			double HyMileage;
+			double QzMileage;
+			double YhMileage;
+			/// 缓和曲线局部坐标x = l - l⁵·SpiralX，y = l³·SpiralY，切线角为l²·SpiralAngle
+			double SpiralX;
+			double SpiralY;
+			double SpiralAngle;
+
+			double MinX;
+			double MinY;
+			double MaxX;
+			double MaxY;
+		};
+
+		struct MileageIndexEntry
+		{
+			double StartMileage;
+			uint32_t Element;
+			uint32_t Reserved;
+		};
+
+		/// \brief 交点的记录，未用字段填0
+		[[nodiscard]] JdRecord MakeJdRecord(const Jd& jd);
+
+		static_assert(sizeof(Header) == 104);
+		static_assert(sizeof(JdRecord) == 88);
+		static_assert(sizeof(ElementRecord) == 224);
+		static_assert(sizeof(MileageIndexEntry) == 16);
+	}
+}
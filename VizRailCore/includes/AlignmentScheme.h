@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <utility>
+
+#include "HorizontalAlignment.h"
+
+namespace VizRailCore
+{
+	/// 线路方案，由方案名和平面线路组成。同一项目中的多个比较方案通常只在少数交点上不同，
+	/// 变体与原方案共享交点分块和线元，修改后只复制发生变化的部分
+	class AlignmentScheme
+	{
+	public:
+		AlignmentScheme() = default;
+
+		AlignmentScheme(std::wstring name, HorizontalAlignment alignment) : _name(std::move(name)),
+		                                                                    _alignment(std::move(alignment))
+		{
+		}
+
+		[[nodiscard]] const std::wstring& Name() const
+		{
+			return _name;
+		}
+
+		void SetName(std::wstring name)
+		{
+			_name = std::move(name);
+		}
+
+		[[nodiscard]] const HorizontalAlignment& Alignment() const
+		{
+			return _alignment;
+		}
+
+		[[nodiscard]] HorizontalAlignment& Alignment()
+		{
+			return _alignment;
+		}
+
+		/// \brief 按类别统计方案名和线路占用的内存并累加到report，已在visited中的对象不重复计算
+		void MemoryUsage(MemoryReport& report, std::unordered_set<const void*>& visited) const
+		{
+			report.Inputs += StringHeapBytes(_name);
+			_alignment.MemoryUsage(report, visited);
+		}
+
+		/// \brief 以当前方案为基础创建变体，O(1)，不复制交点和线元
+		/// \param name 变体的方案名
+		[[nodiscard]] AlignmentScheme CreateVariant(std::wstring name) const
+		{
+			return {std::move(name), _alignment};
+		}
+
+	private:
+		std::wstring _name;
+		HorizontalAlignment _alignment;
+	};
+}
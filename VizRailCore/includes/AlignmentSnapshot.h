@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <memory>
+
+#include "HorizontalAlignment.h"
+
+namespace VizRailCore
+{
+	/// 线路的不可变快照。交点和线元与线路共享，复制为O(1)，任意多个线程可以同时读取
+	using AlignmentSnapshot = std::shared_ptr<const HorizontalAlignment>;
+
+	/// 线路快照的发布点（RCU）。编辑线程每次提交修改后原子地替换当前快照，
+	/// 导出、比较、校验等后台线程随时取得一致的快照并在其上读取，不需要对线路加锁，
+	/// 已取得的快照不受之后修改的影响，最后一个读者释放后自动回收
+	class AlignmentSnapshotPublisher
+	{
+	public:
+		/// \brief 发布alignment的当前状态，并在其每次提交修改后自动发布新快照
+		/// \param alignment 由编辑线程独占修改的线路，生存期须长于发布点
+		explicit AlignmentSnapshotPublisher(HorizontalAlignment& alignment);
+
+		AlignmentSnapshotPublisher(const AlignmentSnapshotPublisher&) = delete;
+		AlignmentSnapshotPublisher& operator=(const AlignmentSnapshotPublisher&) = delete;
+
+		~AlignmentSnapshotPublisher();
+
+		/// 当前快照，可在任意线程调用
+		[[nodiscard]] AlignmentSnapshot Current() const
+		{
+			return _current.load(std::memory_order_acquire);
+		}
+
+		/// \brief 发布线路的当前状态，O(1)。只能在修改线路的线程中调用，编辑事务中不能调用
+		void Publish();
+
+		/// \brief 统计当前快照占用的内存并累加到report。快照与线路共享的交点和线元已在visited中时不重复计算，
+		/// 先统计线路再统计发布点即得到快照额外占用的内存
+		void MemoryUsage(MemoryReport& report, std::unordered_set<const void*>& visited) const;
+
+	private:
+		HorizontalAlignment& _alignment;
+		size_t _observer = 0;
+		std::atomic<AlignmentSnapshot> _current;
+	};
+}
@@ -0,0 +1,197 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Coordinate.h"
+
+namespace VizRailCore
+{
+	/// 二维射线，用于拾取等沿方向的空间查询，方向向量无需单位化，参数t的有效范围为[0, MaxT]
+	class Ray2D
+	{
+	public:
+		Ray2D(const Point2D& origin, const double dx, const double dy,
+		      const double maxT = std::numeric_limits<double>::infinity()) : _origin(origin), _dx(dx), _dy(dy),
+		                                                                    _maxT(maxT)
+		{
+		}
+
+		[[nodiscard]] Point2D Origin() const
+		{
+			return _origin;
+		}
+
+		[[nodiscard]] double Dx() const
+		{
+			return _dx;
+		}
+
+		[[nodiscard]] double Dy() const
+		{
+			return _dy;
+		}
+
+		[[nodiscard]] double MaxT() const
+		{
+			return _maxT;
+		}
+
+		[[nodiscard]] Point2D At(const double t) const
+		{
+			return {_origin.X() + _dx * t, _origin.Y() + _dy * t};
+		}
+
+	private:
+		Point2D _origin;
+		double _dx;
+		double _dy;
+		double _maxT;
+	};
+
+	/// 轴对齐包围盒，X对应E坐标，Y对应N坐标，默认构造的包围盒为空
+	class BoundingBox
+	{
+	public:
+		BoundingBox() = default;
+
+		BoundingBox(const Point2D& p1, const Point2D& p2) : _minX(std::min(p1.X(), p2.X())),
+		                                                    _minY(std::min(p1.Y(), p2.Y())),
+		                                                    _maxX(std::max(p1.X(), p2.X())),
+		                                                    _maxY(std::max(p1.Y(), p2.Y()))
+		{
+		}
+
+		[[nodiscard]] bool IsEmpty() const
+		{
+			return _minX > _maxX || _minY > _maxY;
+		}
+
+		[[nodiscard]] Point2D Min() const
+		{
+			return {_minX, _minY};
+		}
+
+		[[nodiscard]] Point2D Max() const
+		{
+			return {_maxX, _maxY};
+		}
+
+		[[nodiscard]] Point2D Center() const
+		{
+			return {(_minX + _maxX) / 2, (_minY + _maxY) / 2};
+		}
+
+		[[nodiscard]] double Width() const
+		{
+			return IsEmpty() ? 0.0 : _maxX - _minX;
+		}
+
+		[[nodiscard]] double Height() const
+		{
+			return IsEmpty() ? 0.0 : _maxY - _minY;
+		}
+
+		void Extend(const Point2D& point)
+		{
+			_minX = std::min(_minX, point.X());
+			_minY = std::min(_minY, point.Y());
+			_maxX = std::max(_maxX, point.X());
+			_maxY = std::max(_maxY, point.Y());
+		}
+
+		void Extend(const BoundingBox& other)
+		{
+			if (other.IsEmpty())
+			{
+				return;
+			}
+			_minX = std::min(_minX, other._minX);
+			_minY = std::min(_minY, other._minY);
+			_maxX = std::max(_maxX, other._maxX);
+			_maxY = std::max(_maxY, other._maxY);
+		}
+
+		[[nodiscard]] BoundingBox Inflated(const double margin) const
+		{
+			if (IsEmpty())
+			{
+				return *this;
+			}
+			return {{_minX - margin, _minY - margin}, {_maxX + margin, _maxY + margin}};
+		}
+
+		[[nodiscard]] bool Contains(const Point2D& point) const
+		{
+			return point.X() >= _minX && point.X() <= _maxX && point.Y() >= _minY && point.Y() <= _maxY;
+		}
+
+		[[nodiscard]] bool Contains(const BoundingBox& other) const
+		{
+			return !other.IsEmpty() && other._minX >= _minX && other._maxX <= _maxX && other._minY >= _minY &&
+				other._maxY <= _maxY;
+		}
+
+		/// 点到包围盒的距离，点在包围盒内时为0，包围盒为空时为无穷大
+		[[nodiscard]] double DistanceTo(const Point2D& point) const
+		{
+			if (IsEmpty())
+			{
+				return std::numeric_limits<double>::infinity();
+			}
+			const double dx = std::max({_minX - point.X(), 0.0, point.X() - _maxX});
+			const double dy = std::max({_minY - point.Y(), 0.0, point.Y() - _maxY});
+			return std::sqrt(dx * dx + dy * dy);
+		}
+
+		[[nodiscard]] bool Intersects(const BoundingBox& other) const
+		{
+			return _minX <= other._maxX && other._minX <= _maxX && _minY <= other._maxY && other._minY <= _maxY;
+		}
+
+		/// \brief 射线与包围盒求交（slab法）
+		/// \param ray 射线
+		/// \param tEnter 输出射线进入包围盒时的参数t，射线起点在盒内时为0
+		/// \return 射线在[0, MaxT]范围内是否与包围盒相交
+		bool Intersects(const Ray2D& ray, double& tEnter) const
+		{
+			if (IsEmpty())
+			{
+				return false;
+			}
+			double tMin = 0.0;
+			double tMax = ray.MaxT();
+			if (!ClipSlab(ray.Origin().X(), ray.Dx(), _minX, _maxX, tMin, tMax) ||
+				!ClipSlab(ray.Origin().Y(), ray.Dy(), _minY, _maxY, tMin, tMax))
+			{
+				return false;
+			}
+			tEnter = tMin;
+			return true;
+		}
+
+	private:
+		double _minX = std::numeric_limits<double>::infinity();
+		double _minY = std::numeric_limits<double>::infinity();
+		double _maxX = -std::numeric_limits<double>::infinity();
+		double _maxY = -std::numeric_limits<double>::infinity();
+
+		static bool ClipSlab(const double origin, const double direction, const double min, const double max,
+		                     double& tMin, double& tMax)
+		{
+			if (direction == 0.0)
+			{
+				return origin >= min && origin <= max;
+			}
+			double t1 = (min - origin) / direction;
+			double t2 = (max - origin) / direction;
+			if (t1 > t2)
+			{
+				std::swap(t1, t2);
+			}
+			tMin = std::max(tMin, t1);
+			tMax = std::min(tMax, t2);
+			return tMin <= tMax;
+		}
+	};
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace VizRailCore
+{
+	/// 各导出格式（DXF、LandXML、IFC）输出流的基类。格式化的文本先追加到缓冲区，
+	/// 缓冲区超过FlushSize时整块写入文件，内存占用与文件大小无关
+	class BufferedFileWriter
+	{
+	public:
+		static constexpr size_t FlushSize = size_t{1} << 20;
+
+		/// \exception VizRailCoreException 无法创建文件
+		explicit BufferedFileWriter(const std::filesystem::path& path);
+
+		BufferedFileWriter(const BufferedFileWriter&) = delete;
+		BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+		/// \brief 追加文本，缓冲区超过FlushSize时写入文件
+		void Raw(std::string_view text);
+
+		/// \brief 写出缓冲区并关闭文件
+		/// \exception VizRailCoreException 写入失败
+		void Close();
+
+	protected:
+		/// 派生类追加完一条记录后调用，缓冲区超过FlushSize时写入文件
+		void FlushIfFull()
+		{
+			if (_buffer.size() >= FlushSize)
+			{
+				Flush();
+			}
+		}
+
+		/// 按能精确还原的最短定点形式追加，非有限值写为0
+		void AppendReal(double value);
+
+		void AppendInteger(int64_t value);
+
+		void AppendInteger(uint64_t value);
+
+		/// 下一个追加的字节在文件中的偏移
+		[[nodiscard]] size_t Offset() const
+		{
+			return _written + _buffer.size();
+		}
+
+		/// \brief 写出缓冲区后覆盖文件中offset处已写出的内容，用于回填写出时还未确定的占位值
+		void Overwrite(size_t offset, std::string_view text);
+
+		std::string _buffer;
+
+	private:
+		void Flush();
+
+		std::filesystem::path _path;
+		std::ofstream _stream;
+		size_t _written = 0;
+	};
+}
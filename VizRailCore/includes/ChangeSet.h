@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VizRailCore
+{
+	/// 一次编辑事务提交后对线路的改动描述
+	struct ChangeSet
+	{
+		/// 提交后的线路修订号，事务内没有任何改动时为提交前的修订号
+		uint64_t Revision = 0;
+		/// 被移动、修改或新插入的交点下标（按提交后的交点序列），升序
+		std::vector<size_t> TouchedJds;
+		/// 插入的交点数量
+		size_t InsertedJds = 0;
+		/// 删除的交点数量
+		size_t RemovedJds = 0;
+
+		/// 几何形状发生变化的线元名（提交后的线元），按里程顺序排列。
+		/// 只有里程平移而形状不变的下游线元不在其中
+		std::vector<std::wstring> AffectedElements;
+		/// 几何变化区间的起点里程（提交后的里程）
+		double StartMileage = 0.0;
+		/// 几何变化区间的终点里程（提交后的里程），无几何变化时与StartMileage相等
+		double EndMileage = 0.0;
+		/// 变化区间下游线元的里程平移量（提交后减提交前），下游没有线元时为0
+		double MileageShift = 0.0;
+
+		[[nodiscard]] bool IsEmpty() const
+		{
+			return TouchedJds.empty() && InsertedJds == 0 && RemovedJds == 0;
+		}
+
+		/// 是否有线元的形状或里程发生变化
+		[[nodiscard]] bool HasGeometryChange() const
+		{
+			return !AffectedElements.empty() || StartMileage != EndMileage || MileageShift != 0.0;
+		}
+	};
+}
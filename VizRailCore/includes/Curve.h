@@ -102,6 +102,16 @@ namespace VizRailCore
 			return L_H();
 		}
 
+		[[nodiscard]] Mileage StartMileage() const override
+		{
+			return K(SpecialPoint::ZH);
+		}
+
+		[[nodiscard]] Mileage EndMileage() const override
+		{
+			return K(SpecialPoint::HZ);
+		}
+
 		/// \brief 特殊点（直缓点，缓圆点，曲中点，圆缓点，缓直点）转里程
 		/// \param specialPoint 特殊点类型
 		/// \param Kjd2 交点2里程
@@ -118,6 +128,16 @@ namespace VizRailCore
 
 		Point2D SpecialPointCoordinate(SpecialPoint specialPoint) const;
 
+		/// 由缓和曲线局部坐标的包络三角形和圆曲线经过的坐标轴极值方向解析计算包围盒
+		BoundingBox Bounds() const override;
+
+		/// 圆曲线部分的圆心坐标
+		Point2D ArcCenter() const;
+
+		bool Equals(const LineElement& other) const override;
+
+		bool SameShape(const LineElement& other) const override;
+
 	private:
 		Point2D _jd1;
 		Point2D _jd2;
@@ -144,5 +164,7 @@ namespace VizRailCore
 		Mileage CalculateDistance(const Mileage& mileage,
 		                          PointLocation pointLocation) const;
 		Point2D CalculateLocalCoordinate(const Mileage& li, PointLocation pointLocation) const;
+		Point2D ZHFrameToGlobal(double lx, double ly) const;
+		Point2D HZFrameToGlobal(double lx, double ly) const;
 	};
 }
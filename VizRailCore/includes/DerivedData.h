@@ -0,0 +1,198 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace VizRailCore
+{
+	struct DerivedDataStatistics
+	{
+		/// 使用时数据已驻留的次数
+		size_t Hits = 0;
+		/// 使用时数据不存在（首次使用或已被淘汰）而重新建立的次数
+		size_t Misses = 0;
+		/// 因超出预算被淘汰的次数
+		size_t Evictions = 0;
+		/// 当前驻留的项数
+		size_t Entries = 0;
+		/// 当前驻留的字节数
+		size_t Bytes = 0;
+		/// 预算字节数，0表示不限
+		size_t Budget = 0;
+
+		[[nodiscard]] double HitRate() const
+		{
+			const size_t total = Hits + Misses;
+			return total == 0 ? 0.0 : static_cast<double>(Hits) / static_cast<double>(total);
+		}
+	};
+
+	class DerivedDataManager;
+
+	/// 登记在DerivedDataManager中的一项派生数据。派生类实现Release释放数据，并在自身析构函数中调用Withdraw，
+	/// 保证管理器不会在派生部分析构后调用Release
+	class DerivedDataEntry
+	{
+	public:
+		DerivedDataEntry() = default;
+
+		/// 复制得到的项未登记，数据由使用方重新建立
+		DerivedDataEntry(const DerivedDataEntry&)
+		{
+		}
+
+		DerivedDataEntry& operator=(const DerivedDataEntry&)
+		{
+			return *this;
+		}
+
+		virtual ~DerivedDataEntry();
+
+	protected:
+		/// \brief 数据建立后登记其字节数并移到表头，超出预算时从表尾淘汰其他项。
+		/// 本项自身超出预算时仍然保留
+		void Admit(size_t bytes);
+
+		/// \brief 使用驻留的数据时调用，标记为最近使用并计入命中，不取管理器的锁也不分配内存
+		void Touch();
+
+		/// \brief 撤销登记，未登记时什么也不做
+		void Withdraw();
+
+		/// \brief 释放数据。在管理器持有锁时调用，不得再调用管理器
+		virtual void Release() = 0;
+
+	private:
+		friend class DerivedDataManager;
+
+		// 以下各项由管理器的锁保护
+		DerivedDataEntry* _previous = nullptr;
+		DerivedDataEntry* _next = nullptr;
+		size_t _bytes = 0;
+		/// 登记或移到表头时的_lastUse，之后_lastUse不同说明被使用过
+		uint64_t _linkedAt = 0;
+		bool _linked = false;
+
+		std::atomic<uint64_t> _lastUse = 0;
+		std::atomic<size_t> _hits = 0;
+	};
+
+	/// 进程内所有线路共用的派生数据（查询索引、显示列表等）管理器。派生数据都可以由交点重新计算，
+	/// 驻留总量超过预算时淘汰近似最久未使用的项，下次使用时重新建立；交点和线元不受预算限制。
+	/// 各项按登记顺序组成链表，淘汰时从表尾扫描（second chance）：自移到表头后被使用过的项移回表头，
+	/// 其余的淘汰，不排序也不分配内存。使用时间由全局时钟记录，命中时不取管理器的锁，
+	/// 同一项被连续使用时不推进时钟
+	class DerivedDataManager
+	{
+	public:
+		/// 进程内唯一的实例，进程退出时不析构，静态对象析构时仍可撤销登记
+		static DerivedDataManager& Instance();
+
+		DerivedDataManager(const DerivedDataManager&) = delete;
+		DerivedDataManager& operator=(const DerivedDataManager&) = delete;
+
+		/// \brief 设置预算，调低时立即淘汰到预算以内
+		/// \param bytes 预算字节数，0表示不限（默认）
+		void SetBudget(size_t bytes);
+
+		[[nodiscard]] size_t Budget() const;
+
+		[[nodiscard]] DerivedDataStatistics Stats() const;
+
+		/// \brief 命中、未命中和淘汰计数清零
+		void ResetStats();
+
+		/// \brief 淘汰全部驻留的派生数据，例如系统内存不足时
+		void EvictAll();
+
+	private:
+		friend class DerivedDataEntry;
+
+		DerivedDataManager() = default;
+
+		void Admit(DerivedDataEntry& entry, size_t bytes);
+		void Withdraw(DerivedDataEntry& entry);
+		void PushFront(DerivedDataEntry& entry);
+		/// 从链表中取下，不改变登记状态和字节数
+		void Detach(DerivedDataEntry& entry);
+		void Unlink(DerivedDataEntry& entry);
+		/// 从表尾淘汰，直到驻留字节数不超过budget，keep不被淘汰。budget为0时不给第二次机会
+		void EvictTo(size_t budget, const DerivedDataEntry* keep);
+
+		mutable std::mutex _mutex;
+		DerivedDataEntry* _head = nullptr;
+		DerivedDataEntry* _tail = nullptr;
+		size_t _entries = 0;
+		size_t _bytes = 0;
+		size_t _budget = 0;
+		size_t _hits = 0;
+		size_t _misses = 0;
+		size_t _evictions = 0;
+		std::atomic<uint64_t> _clock = 1;
+	};
+
+	/// 可被淘汰的一项派生数据，多个线程可以同时使用
+	template <typename T>
+	class DerivedData final : public DerivedDataEntry
+	{
+	public:
+		DerivedData() = default;
+
+		DerivedData(const DerivedData&) : DerivedDataEntry()
+		{
+		}
+
+		DerivedData& operator=(const DerivedData&) = delete;
+
+		~DerivedData() override
+		{
+			Withdraw();
+		}
+
+		/// \brief 取数据，不存在时调用build()建立并登记size(数据)字节。
+		/// 返回的指针保持数据有效，期间即使被淘汰也只是不再驻留。命中时不分配内存
+		template <typename Build, typename Size>
+		std::shared_ptr<const T> Get(const Build& build, const Size& size)
+		{
+			if (auto value = Current())
+			{
+				Touch();
+				return value;
+			}
+			// 同一项只由一个线程建立，其他线程等待后直接使用
+			std::lock_guard building(_buildMutex);
+			if (auto value = Current())
+			{
+				Touch();
+				return value;
+			}
+			auto value = std::make_shared<const T>(build());
+			{
+				std::lock_guard lock(_mutex);
+				_value = value;
+			}
+			Admit(size(*value));
+			return value;
+		}
+
+		/// 当前驻留的数据，不存在时为空。不建立数据，也不计入命中
+		[[nodiscard]] std::shared_ptr<const T> Current() const
+		{
+			std::lock_guard lock(_mutex);
+			return _value;
+		}
+
+	private:
+		void Release() override
+		{
+			std::lock_guard lock(_mutex);
+			_value.reset();
+		}
+
+		mutable std::mutex _mutex;
+		std::mutex _buildMutex;
+		std::shared_ptr<const T> _value;
+	};
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Coordinate.h"
+#include "LabelPlacer.h"
+#include "MemoryReport.h"
+
+namespace VizRailCore
+{
+	/// 显示样式，Color为AutoCAD颜色索引，LineWeight以0.01mm为单位（与AcDb::LineWeight取值一致）
+	struct DisplayStyle
+	{
+		short Color = 7;
+		short LineWeight = 25;
+	};
+
+	struct DisplayPolyline
+	{
+		DisplayStyle Style;
+		std::vector<Point2D> Points;
+	};
+
+	/// 圆弧，StartAngle为起点相对圆心的方向角，Sweep为扫过的角度，正值为逆时针（均为弧度）
+	struct DisplayArc
+	{
+		DisplayStyle Style;
+		Point2D Center;
+		double Radius = 0.0;
+		double StartAngle = 0.0;
+		double Sweep = 0.0;
+	};
+
+	struct DisplayCircle
+	{
+		DisplayStyle Style;
+		Point2D Center;
+		double Radius = 0.0;
+	};
+
+	/// 单行文字，(DirectionX, DirectionY)为文字基线方向
+	struct DisplayText
+	{
+		DisplayStyle Style;
+		Point2D Position;
+		double DirectionX = 1.0;
+		double DirectionY = 0.0;
+		double Height = 0.0;
+		std::wstring Text;
+	};
+
+	/// 待避让的标注，Lines为逐行文字，自上而下排列，行距为1.5倍字高。
+	/// 文字框覆盖全部行，放置后按选中的候选位置展开为DisplayText
+	struct DisplayLabel
+	{
+		DisplayStyle Style;
+		double TextHeight = 0.0;
+		std::vector<std::wstring> Lines;
+		LabelRequest Request;
+	};
+
+	/// 与绘图平台无关的显示列表，实体绘制时按顺序回放其中的图元即可，无需再做几何计算
+	struct DisplayList
+	{
+		std::vector<DisplayPolyline> Polylines;
+		std::vector<DisplayArc> Arcs;
+		std::vector<DisplayCircle> Circles;
+		std::vector<DisplayText> Texts;
+		/// 尚未放置的标注，由DisplayListBuilder统一避让后输出到标注片段
+		std::vector<DisplayLabel> Labels;
+
+		[[nodiscard]] size_t PrimitiveCount() const
+		{
+			return Polylines.size() + Arcs.size() + Circles.size() + Texts.size();
+		}
+
+		void Clear()
+		{
+			Polylines.clear();
+			Arcs.clear();
+			Circles.clear();
+			Texts.clear();
+		}
+
+		/// 图元数组及其中的点列、文字另行分配的堆内存，不含DisplayList对象自身
+		[[nodiscard]] size_t MemoryUsage() const
+		{
+			size_t bytes = Polylines.capacity() * sizeof(DisplayPolyline) + Arcs.capacity() * sizeof(DisplayArc) +
+				Circles.capacity() * sizeof(DisplayCircle) + Texts.capacity() * sizeof(DisplayText) +
+				Labels.capacity() * sizeof(DisplayLabel);
+			for (const auto& polyline : Polylines)
+			{
+				bytes += polyline.Points.capacity() * sizeof(Point2D);
+			}
+			for (const auto& text : Texts)
+			{
+				bytes += StringHeapBytes(text.Text);
+			}
+			for (const auto& label : Labels)
+			{
+				bytes += label.Lines.capacity() * sizeof(std::wstring) +
+					label.Request.Candidates.capacity() * sizeof(LabelCandidate);
+				for (const auto& line : label.Lines)
+				{
+					bytes += StringHeapBytes(line);
+				}
+			}
+			return bytes;
+		}
+	};
+}
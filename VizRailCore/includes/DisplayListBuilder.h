@@ -0,0 +1,208 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "DerivedData.h"
+#include "DisplayList.h"
+#include "HorizontalAlignment.h"
+#include "Stationing.h"
+
+namespace VizRailCore
+{
+	class Curve;
+	class IntermediateLine;
+
+	/// 显示细节层级，由视口中每像素对应的世界单位长度（比例尺）确定
+	struct DisplayDetail
+	{
+		/// 缓和曲线离散的弦高容差，为0时按1m步长离散（原始精度）
+		double ChordTolerance = 0.0;
+		/// 里程刻度间隔（m），100为百米标，1000为仅公里标，0为不绘制刻度
+		int TickInterval = 100;
+		/// 是否绘制里程刻度的文字
+		bool TickLabels = true;
+		/// 是否绘制特征点（ZH/HY/YH/HZ）的刻度线与交点圆圈
+		bool SpecialPointMarks = true;
+		/// 是否绘制特征点里程、曲线要素及交点号文字
+		bool SpecialPointLabels = true;
+
+		/// 完整细节，用于不依赖视口的绘制（如分解、代理图形）
+		static DisplayDetail Full()
+		{
+			return {};
+		}
+
+		/// \brief 按比例尺计算细节层级
+		/// \param unitsPerPixel 每像素对应的世界单位长度
+		static DisplayDetail FromUnitsPerPixel(double unitsPerPixel);
+
+		/// \brief 将比例尺量化为层级编号，层级编号相同的比例尺共用同一份显示列表缓存
+		/// \return 满足2^level >= unitsPerPixel的最小整数level
+		static int LevelOf(double unitsPerPixel);
+
+		/// 层级编号对应的比例尺上限
+		static double UnitsPerPixelOf(int level);
+	};
+
+	/// 平面线路显示列表生成器，按线元缓存显示列表片段。
+	/// 每次Update只重建修订号发生变化的线元，线路未变化时不做任何几何计算
+	class DisplayListBuilder
+	{
+	public:
+		/// \brief 将完整细节的缓存更新到线路的当前修订号
+		/// \return 本次重建的线元数量
+		size_t Update(const HorizontalAlignment& alignment);
+
+		/// \brief 将指定比例尺所在层级的缓存更新到线路的当前修订号，各层级的缓存相互独立
+		/// \param unitsPerPixel 每像素对应的世界单位长度
+		/// \return 本次重建的线元数量
+		size_t Update(const HorizontalAlignment& alignment, double unitsPerPixel);
+
+		/// 最近一次Update所用层级的各线元显示列表片段，按线路顺序排列，最后一个片段为交点及交点连线
+		[[nodiscard]] const std::vector<std::shared_ptr<const DisplayList>>& Fragments() const
+		{
+			return Current().Fragments;
+		}
+
+		/// 最近一次Update所用层级中经过避让放置的全部标注文字，无法避让的标注被舍弃
+		[[nodiscard]] const std::shared_ptr<const DisplayList>& Labels() const
+		{
+			return Current().Labels;
+		}
+
+		/// 最近一次Update所用层级的缓存对应的线路修订号，从未生成时为0
+		[[nodiscard]] uint64_t Revision() const
+		{
+			return Current().Revision;
+		}
+
+		/// 最近一次Update所用层级的细节参数
+		[[nodiscard]] const DisplayDetail& Detail() const
+		{
+			return Current().Detail;
+		}
+
+		void Clear();
+
+		/// \brief 统计各层级缓存的显示列表占用的内存，计入report.DisplayCaches，已在visited中的显示列表不重复计算
+		void MemoryUsage(MemoryReport& report, std::unordered_set<const void*>& visited) const;
+
+		static std::shared_ptr<const DisplayList> BuildElement(const std::shared_ptr<LineElement>& element,
+		                                                       const DisplayDetail& detail = DisplayDetail::Full());
+		static std::shared_ptr<const DisplayList> BuildJds(const PersistentVector<Jd>& jds,
+		                                                   const DisplayDetail& detail = DisplayDetail::Full());
+		/// \brief 由BuildCenterline（或ProjectCache::Centerline）得到的中线折线生成只有一条折线的显示列表，
+		/// 按夹直线的样式绘制，不区分线元，用于代理图形等只需示意线位的场合
+		static std::shared_ptr<const DisplayList> BuildCenterline(std::span<const CenterlinePoint> points);
+
+	private:
+		struct Entry
+		{
+			uint64_t Revision = 0;
+			std::shared_ptr<const DisplayList> List;
+		};
+
+		/// 一个层级的显示列表缓存
+		struct LevelData
+		{
+			DisplayDetail Detail;
+			std::map<std::wstring, Entry> Entries;
+			std::vector<std::shared_ptr<const DisplayList>> Fragments;
+			std::shared_ptr<const DisplayList> Labels = std::make_shared<DisplayList>();
+			uint64_t Revision = 0;
+		};
+
+		/// 层级缓存在DerivedDataManager中的登记项，持有层级的数据。管理器可能在其他线程上淘汰，
+		/// 此时立即释放持有的引用，没有其他持有者的数据随之释放
+		class LevelEntry final : public DerivedDataEntry
+		{
+		public:
+			LevelEntry() = default;
+
+			LevelEntry(const LevelEntry&) : DerivedDataEntry()
+			{
+			}
+
+			LevelEntry& operator=(const LevelEntry&)
+			{
+				Withdraw();
+				Store(nullptr);
+				return *this;
+			}
+
+			~LevelEntry() override
+			{
+				Withdraw();
+			}
+
+			using DerivedDataEntry::Admit;
+			using DerivedDataEntry::Touch;
+
+			/// 驻留的数据，已被淘汰时为空
+			[[nodiscard]] std::shared_ptr<LevelData> Data() const
+			{
+				std::lock_guard lock(_mutex);
+				return _data;
+			}
+
+			void Store(std::shared_ptr<LevelData> data)
+			{
+				std::lock_guard lock(_mutex);
+				_data = std::move(data);
+			}
+
+		private:
+			void Release() override
+			{
+				// 在释放锁之后析构数据
+				std::shared_ptr<LevelData> released;
+				std::lock_guard lock(_mutex);
+				released.swap(_data);
+			}
+
+			mutable std::mutex _mutex;
+			std::shared_ptr<LevelData> _data;
+		};
+
+		struct Level
+		{
+			DisplayDetail Detail;
+			LevelEntry Cache;
+		};
+
+		// 完整细节缓存的层级编号，不与任何比例尺层级重合
+		static constexpr int FullDetailLevel = std::numeric_limits<int>::min();
+
+		std::map<int, Level> _levels;
+		// 最近一次Update所用层级的数据。该层级被淘汰后仍由此持有到下一次Update，
+		// 保证Fragments()等返回的引用在两次Update之间有效
+		std::shared_ptr<const LevelData> _current;
+
+		[[nodiscard]] const LevelData& Current() const;
+		/// 丢弃已被DerivedDataManager淘汰的层级
+		void DropEvicted();
+		size_t Update(const HorizontalAlignment& alignment, Level& level);
+		[[nodiscard]] static size_t MemoryUsage(const LevelData& data, std::unordered_set<const void*>& visited);
+		static std::shared_ptr<const DisplayList> PlaceLabels(
+			const std::vector<std::shared_ptr<const DisplayList>>& fragments);
+
+		static void AddIntermediateLine(DisplayList& list, const IntermediateLine& jzx, const DisplayDetail& detail);
+		static void AddCurve(DisplayList& list, const Curve& qx, const DisplayDetail& detail);
+		static void AddTransition(DisplayPolyline& polyline, const Curve& qx, double startMileage, double endMileage,
+		                          const DisplayDetail& detail);
+		static void AddHectoMeter(DisplayList& list, const LineElement& line, double startMileage, double endMileage,
+		                          const DisplayDetail& detail);
+		static void AddMileageMark(DisplayList& list, const Point2D& point, const Angle& azimuthAngle,
+		                           const std::wstring& text, const DisplayDetail& detail);
+		static void AddJdMark(DisplayList& list, const Curve& qx);
+		static void AddLabel(DisplayList& list, const DisplayStyle& style, LabelPriority priority,
+		                     std::vector<std::wstring> lines, const std::vector<LabelCandidate>& baselines);
+	};
+}
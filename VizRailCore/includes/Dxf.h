@@ -0,0 +1,51 @@
+#pragma once
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "HorizontalAlignment.h"
+#include "TextImport.h"
+
+namespace VizRailCore
+{
+	/// 写入DXF的一条线路
+	struct DxfAlignment
+	{
+		/// 线路名，同时作为图层名，图层名中不允许的字符替换为下划线
+		std::wstring Name;
+		const HorizontalAlignment* Alignment = nullptr;
+	};
+
+	/// 交点线上保存曲线参数的扩展数据所用的应用名
+	constexpr const char* DxfApplicationName = "VIZRAIL";
+
+	/// 交点超过此数量时交点线不附带曲线参数，避免超出AutoCAD每个实体16KB的扩展数据上限
+	constexpr size_t DxfMaxCurveDataJds = 600;
+
+	/// \brief 写出DXF R2000（AC1015）图形，不依赖AutoCAD。每条线路一个图层，图元与插件中实体的完整细节绘制相同：
+	/// 夹直线、缓和曲线、刻度线和交点线为LWPOLYLINE，圆曲线为精确的ARC，交点为CIRCLE，里程和曲线要素为TEXT。
+	/// 交点线附带交点号、曲线半径、缓和曲线长和起点里程的扩展数据，可由ReadDxfJdPolylines读回。
+	/// 线路逐条生成显示列表后直接格式化写出，不在内存中保留整张图；中文写为\U+XXXX转义，与代码页无关
+	/// \exception VizRailCoreException 无法写入文件
+	void SaveDxf(const std::filesystem::path& path, std::span<const DxfAlignment> alignments);
+
+	/// 从DXF读出的一条交点线
+	struct DxfJdPolyline
+	{
+		/// 扩展数据中的线路名，没有扩展数据时为图层名
+		std::wstring Name;
+		std::wstring Layer;
+		/// 没有曲线参数时曲线半径和缓和曲线长为0，交点号为顶点序号，需另行给出曲线参数才能构造线路
+		JdColumns Jds;
+		/// 是否由扩展数据给出了交点号、曲线半径、缓和曲线长和起点里程
+		bool HasCurveData = false;
+	};
+
+	/// \brief 读取ASCII格式DXF模型空间中的交点线：带VIZRAIL扩展数据的LWPOLYLINE，
+	/// 以及layer不为空时该图层（不区分大小写）上的其他LWPOLYLINE，顶点的X、Y分别为坐标E、N，凸度被忽略。
+	/// 文字按UTF-8（R2007及以上）或GBK（R2000中文版）解码，并还原\U+XXXX转义
+	/// \exception TextImportException 文件无法读取、是二进制DXF或组码有误，错误信息含行号
+	[[nodiscard]] std::vector<DxfJdPolyline> ReadDxfJdPolylines(const std::filesystem::path& path,
+	                                                            const std::wstring& layer = {});
+}
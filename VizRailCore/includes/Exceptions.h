@@ -32,3 +32,35 @@ public:
 	{
 	}
 };
+
+class OperationCancelledException final : public VizRailCoreException
+{
+public:
+	explicit OperationCancelledException(const std::wstring& message) : VizRailCoreException(message)
+	{
+	}
+};
+
+/// 文本导入错误，行号和列号从1开始，为0表示与具体位置无关
+class TextImportException final : public VizRailCoreException
+{
+public:
+	TextImportException(const std::wstring& message, const size_t line, const size_t column) :
+		VizRailCoreException(message), _line(line), _column(column)
+	{
+	}
+
+	[[nodiscard]] size_t Line() const
+	{
+		return _line;
+	}
+
+	[[nodiscard]] size_t Column() const
+	{
+		return _column;
+	}
+
+private:
+	size_t _line;
+	size_t _column;
+};
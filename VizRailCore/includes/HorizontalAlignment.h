@@ -1,14 +1,59 @@
 #pragma once
-#include <map>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
+#include "AabbTree.h"
+#include "AlignmentImageLayout.h"
+#include "BoundingBox.h"
+#include "ChangeSet.h"
+#include "DerivedData.h"
 #include "Jd.h"
 #include "LineElement.h"
+#include "MemoryReport.h"
+#include "PersistentVector.h"
 
 namespace VizRailCore
 {
+	/// 线元及其名称和修订号
+	struct XyEntry
+	{
+		std::wstring Key;
+		std::shared_ptr<LineElement> Element;
+		/// 线元刷新后几何参数和里程均未变化时保留原修订号
+		uint64_t Revision = 0;
+	};
+
+	/// 点在线路上的投影
+	struct StationOffset
+	{
+		/// 垂足里程
+		Mileage Station = Mileage(0.0);
+		/// 偏距，位于线路前进方向右侧为正
+		double Offset = 0.0;
+		/// 垂足所在线元在GetXys()中的下标
+		size_t Element = 0;
+	};
+
+	/// 里程处的点位和切线方向
+	struct StationFrame
+	{
+		Point2D Point;
+		/// 切线方位角，与LineElement::MileageToAzimuthAngle相同
+		Angle Azimuth;
+		/// 点所在线元在GetXys()中的下标
+		size_t Element = 0;
+	};
+
+	/// 平面线路。交点和线元都按分块存放在持久化向量中，复制线路为O(1)，
+	/// 副本修改后只复制发生变化的分块，未变化的交点和线元仍与原线路共享
 	class HorizontalAlignment
 	{
 	public:
@@ -24,39 +69,282 @@ namespace VizRailCore
 
 		void UpdateJd(size_t index, const Jd& jd);
 
-		void MoveJd(const size_t index, const double offsetN, const double offsetE)
+		void MoveJd(size_t index, double offsetN, double offsetE);
+
+		/// \brief 开始编辑事务，事务内的交点增删改只记录不刷新线元，可以嵌套
+		void BeginEdit();
+
+		/// \brief 提交最近一次BeginEdit开启的事务。最外层事务提交时统一刷新一次线元，
+		/// 刷新失败时恢复到事务开始前的交点并抛出异常
+		/// \return 最外层提交时返回整个事务的改动，内层提交返回空改动
+		ChangeSet CommitEdit();
+
+		/// \brief 放弃最近一次BeginEdit开启的事务，交点恢复到该事务开始前的状态
+		void CancelEdit();
+
+		/// 改动通知回调，参数为刷新后的线路和本次提交的改动
+		using ChangeObserver = std::function<void(const HorizontalAlignment&, const ChangeSet&)>;
+
+		/// \brief 注册改动通知，每次交点修改（或最外层事务）提交并刷新线元后调用
+		/// \return 用于注销的编号
+		size_t AddObserver(ChangeObserver observer);
+
+		void RemoveObserver(size_t id);
+
+		/// \brief 撤销最近一次提交的交点修改并通知观察者。该步的线元仍在缓存中时直接恢复，否则重新计算
+		/// \return 没有可撤销的修改时返回false
+		bool Undo();
+
+		/// \brief 重做最近一次撤销的修改
+		/// \return 没有可重做的修改时返回false
+		bool Redo();
+
+		[[nodiscard]] size_t UndoCount() const
+		{
+			return _history.Undo.size();
+		}
+
+		[[nodiscard]] size_t RedoCount() const
+		{
+			return _history.Redo.size();
+		}
+
+		/// \brief 设置历史记录上限，历史记录不随线路复制
+		/// \param steps 最多保留的撤销步数，超出时丢弃最早的一步
+		/// \param cachedStates 撤销和重做方向各自缓存线元的步数，更早的步骤只保留交点（每步O(log n)），
+		/// 撤销到这些步骤时重新计算线元
+		void SetHistoryLimit(size_t steps, size_t cachedStates);
+
+		void ClearHistory();
+
+		/// 是否处于编辑事务中，此时GetJds()为编辑中的交点，其里程等派生字段以及线元尚未刷新
+		[[nodiscard]] bool InEdit() const
 		{
-			_jds[index].N += offsetN;
-			_jds[index].E += offsetE;
-			RefreshXys();
+			return !_editStack.empty();
 		}
 
-		[[nodiscard]] const std::vector<Jd>& GetJds() const
+		/// 刷新后的交点（含里程等派生字段），编辑事务中为编辑中的交点
+		[[nodiscard]] const PersistentVector<Jd>& GetJds() const
 		{
-			return _jds;
+			return InEdit() ? _jds : _state->Jds;
 		}
 
-		[[nodiscard]] const std::map<std::wstring, std::shared_ptr<LineElement>>& GetXys() const
+		/// 所有线元，依次为曲线1、夹直线1、曲线2、夹直线2……最后一条夹直线
+		[[nodiscard]] const PersistentVector<XyEntry>& GetXys() const
 		{
-			return _xys;
+			return _state->Xys;
 		}
 
-		[[nodiscard]] const std::vector<std::wstring>& GetXysOrder() const
+		/// \brief 按名称查找线元，O(log n)
+		/// \param key 线元名，如“曲线3”“夹直线4”
+		[[nodiscard]] const std::shared_ptr<LineElement>& GetXy(const std::wstring& key) const;
+
+		/// 线路修订号，每次刷新线元后递增，不同线路对象之间也不会重复
+		[[nodiscard]] uint64_t Revision() const
 		{
-			return _xysOrder;
+			return _state->Revision;
 		}
 
 		void Refresh();
 
+		/// \brief 里程转坐标，按里程索引二分查找线元，O(log n)。里程索引与空间索引一起在首次查询时建立
+		/// \exception NotInLineException 里程不在线路范围内
 		[[nodiscard]] Point2D MileageToCoordinate(const Mileage& mileage) const;
 
+		/// \brief 同上，同时求切线方位角和所在线元
+		[[nodiscard]] StationFrame MileageToFrame(const Mileage& mileage) const;
+
+		/// \brief 求点在线路上的投影（反算里程和偏距），取距离最近的垂足。由空间索引按包围盒由近及远检查线元
+		/// \exception NotInLineException 点位于线路起点之前或终点之后，不存在垂足
+		[[nodiscard]] StationOffset CoordinateToMileage(const Point2D& point) const;
+
 		[[nodiscard]] double GetTotalMileage() const;
 
+		/// 线路所有线元及交点的包围盒，随线元一起刷新，O(1)获取
+		[[nodiscard]] const BoundingBox& Extents() const
+		{
+			return _state->Extents;
+		}
+
+		/// \brief 查询包围盒与矩形相交的线元，用于视口裁剪。空间索引在首次查询时建立
+		/// \return 线元在GetXys()中的下标，按线路顺序排列
+		[[nodiscard]] std::vector<size_t> QueryElements(const BoundingBox& box) const;
+
+		/// \brief 同上，结果写入result。视口变化时反复查询可复用result的容量，不再分配内存
+		void QueryElements(const BoundingBox& box, std::vector<size_t>& result) const;
+
+		/// \brief 查询包围盒与射线相交的线元，用于拾取
+		/// \return 线元在GetXys()中的下标，按射线到达的先后排列
+		[[nodiscard]] std::vector<size_t> QueryElements(const Ray2D& ray) const;
+
+		/// 是否与另一线路共享同一份线元（由同一线路复制而来且均未修改）
+		[[nodiscard]] bool SharesElementsWith(const HorizontalAlignment& other) const
+		{
+			return _state == other._state;
+		}
+
+		/// \brief 按类别统计交点、线元、空间索引及历史记录占用的内存
+		[[nodiscard]] MemoryReport MemoryUsage() const;
+
+		/// \brief 按类别统计内存并累加到report，已在visited中的对象不重复计算，
+		/// 依次统计多个线路即得到共享后的总内存（见MemoryAccounting）
+		void MemoryUsage(MemoryReport& report, std::unordered_set<const void*>& visited) const;
+
+		/// \brief 同上，只返回合计
+		/// \return 本次新统计的字节数
+		size_t MemoryUsage(std::unordered_set<const void*>& visited) const;
+
 	private:
-		std::vector<Jd> _jds;
-		std::map<std::wstring, std::shared_ptr<LineElement>> _xys;
-		std::vector<std::wstring> _xysOrder;
+		struct QueryIndex
+		{
+			AabbTree Tree;
+			// 按起点里程排序的线元起点里程及线元下标。GetXys()中第一条夹直线排在曲线1之后，不是里程顺序
+			std::vector<double> StartMileages;
+			std::vector<uint32_t> MileageOrder;
+			// 与GetXys()顺序相同的线元常量，坐标转里程时直接由这些常量求垂足。
+			// 夹直线的终点里程限制在几何长度以内，超出部分不是线路上的点
+			std::vector<AlignmentImage::ElementRecord> Records;
+
+			[[nodiscard]] size_t MemoryUsage() const
+			{
+				return Tree.MemoryUsage() + StartMileages.capacity() * sizeof(double) +
+					MileageOrder.capacity() * sizeof(uint32_t) +
+					Records.capacity() * sizeof(AlignmentImage::ElementRecord);
+			}
+		};
+
+		// 一次刷新得到的线元，刷新后不再修改，在线路副本之间共享
+		struct ElementState
+		{
+			// 写入了里程等派生字段的交点
+			PersistentVector<Jd> Jds;
+			PersistentVector<XyEntry> Xys;
+			uint64_t Revision = 0;
+			BoundingBox Extents;
+			// 空间索引和里程索引只在需要查询时建立，不显示的方案不占用索引内存，
+			// 超出DerivedDataManager的预算时被淘汰，下次查询时重新建立
+			mutable DerivedData<QueryIndex> Index;
+		};
+
+		// 编辑事务开始时的状态，用于放弃事务时恢复
+		struct EditState
+		{
+			PersistentVector<Jd> Jds;
+			std::vector<uint8_t> Touched;
+			size_t Inserted = 0;
+			size_t Removed = 0;
+		};
+
+		// 输入交点，不写回派生字段，撤销历史的每一步只多出一条分块路径
+		PersistentVector<Jd> _jds;
+		std::shared_ptr<const ElementState> _state = EmptyState();
+		// 通知列表不随线路复制，副本的改动不会通知原线路的观察者
+		struct ObserverList
+		{
+			std::vector<std::pair<size_t, ChangeObserver>> Items;
+			size_t NextId = 1;
+
+			ObserverList() = default;
+
+			ObserverList(const ObserverList&)
+			{
+			}
+
+			ObserverList& operator=(const ObserverList&)
+			{
+				return *this;
+			}
+		};
+
+		// 撤销或重做一步所需的交点和线元，线元被淘汰出缓存后为空
+		struct HistoryEntry
+		{
+			PersistentVector<Jd> Jds;
+			std::shared_ptr<const ElementState> State;
+		};
+
+		// 历史记录不随线路复制，副本（如方案变体）从空历史开始，只沿用上限设置
+		struct History
+		{
+			std::deque<HistoryEntry> Undo;
+			std::deque<HistoryEntry> Redo;
+			size_t Steps = 1000;
+			size_t CachedStates = 16;
+
+			History() = default;
+
+			History(const History& other) : Steps(other.Steps), CachedStates(other.CachedStates)
+			{
+			}
+
+			History& operator=(const History& other)
+			{
+				Undo.clear();
+				Redo.clear();
+				Steps = other.Steps;
+				CachedStates = other.CachedStates;
+				return *this;
+			}
+
+			void Push(std::deque<HistoryEntry>& stack, HistoryEntry entry);
+		};
 
-		void RefreshXys();
+		std::vector<EditState> _editStack;
+		// 与_jds一一对应，标记事务内被修改或插入的交点
+		std::vector<uint8_t> _editTouched;
+		size_t _editInserted = 0;
+		size_t _editRemoved = 0;
+		ObserverList _observers;
+		History _history;
+
+		static const std::shared_ptr<const ElementState>& EmptyState();
+
+		template <typename Operation>
+		void Edit(Operation&& operation);
+
+		[[nodiscard]] std::shared_ptr<const QueryIndex> Index() const;
+		[[nodiscard]] size_t FindElement(const Mileage& mileage) const;
+
+		ChangeSet RefreshXys();
+		ChangeSet Restore(const HistoryEntry& entry);
+		static void MemoryUsage(const ElementState& state, MemoryReport& report,
+		                        std::unordered_set<const void*>& visited);
+		/// 刷新时在分配区中构造的交点和线元
+		struct BuiltElements;
+		void BuildXys(BuiltElements& built) const;
+		[[nodiscard]] static ChangeSet DiffElements(const ElementState& previous, const ElementState& state,
+		                                            std::pmr::memory_resource* resource);
+		void Notify(const ChangeSet& changes) const;
+	};
+
+	/// 编辑事务的RAII封装，析构时若未提交则放弃事务
+	class EditTransaction
+	{
+	public:
+		explicit EditTransaction(HorizontalAlignment& alignment) : _alignment(alignment)
+		{
+			_alignment.BeginEdit();
+		}
+
+		EditTransaction(const EditTransaction&) = delete;
+		EditTransaction& operator=(const EditTransaction&) = delete;
+
+		~EditTransaction()
+		{
+			if (!_finished)
+			{
+				_alignment.CancelEdit();
+			}
+		}
+
+		ChangeSet Commit()
+		{
+			_finished = true;
+			return _alignment.CommitEdit();
+		}
+
+	private:
+		HorizontalAlignment& _alignment;
+		bool _finished = false;
 	};
 }
@@ -0,0 +1,38 @@
+#pragma once
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "HorizontalAlignment.h"
+
+namespace VizRailCore
+{
+	/// 写入IFC的一条线路
+	struct IfcAlignmentSource
+	{
+		std::wstring Name;
+		const HorizontalAlignment* Alignment = nullptr;
+		/// 各交点处曲线的超高（米），与GetJds()一一对应，首末交点的值不使用。
+		/// 超高在圆曲线上不变，在缓和曲线上线性过渡，外轨抬高、内轨不变。为空时不写出IfcAlignmentCant
+		std::vector<double> Cant;
+	};
+
+	struct IfcExportOptions
+	{
+		/// IfcProject的名称
+		std::wstring ProjectName = L"VizRail";
+		/// 中线折线表示的弦高容差（米），曲线的离散步长与BuildCenterline相同
+		double ChordTolerance = 0.01;
+		/// 两轨轨头中心距（米），标准轨距1435mm时为1.5
+		double RailHeadDistance = 1.5;
+	};
+
+	/// \brief 写出IFC 4.3（IFC4X3_ADD2）的STEP物理文件。每条线路为一个IfcAlignment，
+	/// 平面线形按线元顺序写为IfcAlignmentHorizontalSegment（LINE、CLOTHOID、CIRCULARARC），
+	/// 以零长度线段结尾，给出超高时同时写出IfcAlignmentCant；几何表示为按弦高容差离散的IfcPolyline。
+	/// 按里程顺序逐个线元计算并立即写出实体，只保留各集合关系所需的实体编号
+	/// \exception VizRailCoreException 无法写入文件、弦高容差不大于0，或超高数与交点数不符
+	void SaveIfc(const std::filesystem::path& path, std::span<const IfcAlignmentSource> alignments,
+	             const IfcExportOptions& options = {});
+}
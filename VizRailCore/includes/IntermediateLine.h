@@ -33,7 +33,7 @@ namespace VizRailCore
 			_endPoint = endPoint;
 		}
 
-		[[nodiscard]] Mileage StartMileage() const
+		[[nodiscard]] Mileage StartMileage() const override
 		{
 			return _startMileage;
 		}
@@ -43,7 +43,7 @@ namespace VizRailCore
 			_startMileage = startMileage;
 		}
 
-		[[nodiscard]] Mileage EndMileage() const
+		[[nodiscard]] Mileage EndMileage() const override
 		{
 			return _endMileage;
 		}
@@ -64,6 +64,22 @@ namespace VizRailCore
 
 		Angle MileageToAzimuthAngle(const Mileage& mileage) const override;
 
+		BoundingBox Bounds() const override
+		{
+			return {_startPoint, _endPoint};
+		}
+
+		bool Equals(const LineElement& other) const override
+		{
+			return SameShape(other) && other.StartMileage() == _startMileage && other.EndMileage() == _endMileage;
+		}
+
+		bool SameShape(const LineElement& other) const override
+		{
+			const auto* line = dynamic_cast<const IntermediateLine*>(&other);
+			return line != nullptr && line->_startPoint == _startPoint && line->_endPoint == _endPoint;
+		}
+
 	private:
 		Point2D _startPoint;
 		Mileage _startMileage;
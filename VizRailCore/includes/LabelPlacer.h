@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Coordinate.h"
+
+namespace VizRailCore
+{
+	/// 标注优先级，数值越小越先放置
+	enum class LabelPriority : uint8_t
+	{
+		Kilometre,
+		SpecialPoint,
+		Jd,
+		Hectometre,
+	};
+
+	/// 标注的一个候选位置，Position为文字框左下角，(DirectionX, DirectionY)为文字基线方向（单位向量）
+	struct LabelCandidate
+	{
+		Point2D Position;
+		double DirectionX = 1.0;
+		double DirectionY = 0.0;
+	};
+
+	/// 待放置的标注，文字框沿基线方向长Width，沿基线左侧法向高Height
+	struct LabelRequest
+	{
+		LabelPriority Priority = LabelPriority::Hectometre;
+		double Width = 0.0;
+		double Height = 0.0;
+		/// 按偏好顺序排列的候选位置
+		std::vector<LabelCandidate> Candidates;
+	};
+
+	/// 标注避让引擎。按优先级贪心地为每个标注选择第一个不与已放置标注重叠的候选位置，
+	/// 已放置的文字框登记在均匀网格中，每次检测只与所在网格内的文字框比较，整体接近线性时间
+	class LabelPlacer
+	{
+	public:
+		/// \param cellSize 网格边长，取与常见文字框尺寸相当的值效率最高
+		explicit LabelPlacer(double cellSize);
+
+		/// \brief 按优先级放置所有标注，同一优先级按传入顺序放置
+		/// \return 每个标注选中的候选位置序号，无法避让的标注为-1
+		std::vector<int> Place(const std::vector<LabelRequest>& labels);
+
+		/// \brief 放置单个标注
+		/// \return 选中的候选位置序号，所有候选位置均与已放置标注重叠时为-1
+		int TryPlace(double width, double height, const std::vector<LabelCandidate>& candidates);
+
+		/// 已放置的标注数量
+		[[nodiscard]] size_t Size() const
+		{
+			return _boxes.size();
+		}
+
+		void Clear();
+
+		/// \brief 估算单行文字的宽度，半角字符按0.8倍字高、全角字符按1倍字高计
+		static double EstimateWidth(const std::wstring& text, double height);
+
+	private:
+		// 有向矩形，以中心、两个单位轴向和半边长表示
+		struct Box
+		{
+			double CenterX;
+			double CenterY;
+			double UX;
+			double UY;
+			double HalfWidth;
+			double HalfHeight;
+		};
+
+		double _cellSize;
+		std::vector<Box> _boxes;
+		std::unordered_map<uint64_t, std::vector<uint32_t>> _grid;
+
+		static Box MakeBox(const LabelCandidate& candidate, double width, double height);
+		static bool Overlaps(const Box& a, const Box& b);
+		[[nodiscard]] bool Collides(const Box& box) const;
+		void Insert(const Box& box);
+
+		template <typename Visitor>
+		void ForEachCell(const Box& box, Visitor&& visitor) const;
+	};
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "HorizontalAlignment.h"
+#include "TextImport.h"
+
+namespace VizRailCore
+{
+	/// 写入LandXML的一条线路
+	struct LandXmlAlignment
+	{
+		std::wstring Name;
+		const HorizontalAlignment* Alignment = nullptr;
+	};
+
+	/// \brief 写出LandXML 1.2，每条线路一个Alignment，CoordGeom按里程顺序依次为Line、Spiral（回旋线）、Curve（圆弧）。
+	/// 逐个线元格式化后直接写出，不在内存中构造文档。坐标按LandXML的约定为“北 东”顺序
+	/// \exception VizRailCoreException 无法写入文件
+	void SaveLandXml(const std::filesystem::path& path, std::span<const LandXmlAlignment> alignments);
+
+	/// 从LandXML读出的一条线路
+	struct LandXmlJdAlignment
+	{
+		std::wstring Name;
+		/// 交点号为交点序号，起点和终点各为一个交点，曲线的交点为进出切线的交点
+		JdColumns Jds;
+	};
+
+	/// \brief 流式读取LandXML中Alignment的CoordGeom并逐条回调，每读完一条线路调用一次。
+	/// 文件以只读方式映射到内存，边扫描边将几何元素换算为交点，不构造DOM，
+	/// Profile、Cant等其他元素直接跳过，内存占用与文件大小无关。
+	/// Line之间的每组Spiral、Curve、Spiral换算为一个交点：交点为进出切线的交点，曲线半径取圆弧半径，
+	/// 缓和曲线长取前缓和曲线长，缓和曲线均按回旋线处理
+	/// \exception TextImportException 文件无法读取、不是合法的XML、几何元素不连续，
+	/// 或出现线路模型无法表示的几何（复曲线、前后缓和曲线长不同、直线间无曲线的转折），错误信息含行号
+	void ReadLandXml(const std::filesystem::path& path, const std::function<void(LandXmlJdAlignment&&)>& sink);
+
+	/// \brief 同上，返回文件中的全部线路
+	[[nodiscard]] std::vector<LandXmlJdAlignment> ReadLandXml(const std::filesystem::path& path);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "Angle.h"
+#include "BoundingBox.h"
 #include "Coordinate.h"
 #include "Mileage.h"
 
@@ -14,10 +15,25 @@ namespace VizRailCore
 
 		virtual double Length() const = 0;
 
+		/// 线元起点里程
+		virtual Mileage StartMileage() const = 0;
+
+		/// 线元终点里程
+		virtual Mileage EndMileage() const = 0;
+
 		virtual bool IsOnIt(const Mileage& mileage) const = 0;
 
 		virtual Point2D MileageToCoordinate(const Mileage& mileage) const = 0;
 
 		virtual Angle MileageToAzimuthAngle(const Mileage& mileage) const = 0;
+
+		/// 线元的轴对齐包围盒（解析计算，不做离散采样）
+		virtual BoundingBox Bounds() const = 0;
+
+		/// 两个线元的类型、几何参数和里程是否完全相同，用于判断刷新后线元是否发生变化
+		virtual bool Equals(const LineElement& other) const = 0;
+
+		/// 两个线元的类型和几何形状是否相同（不比较里程），用于定位编辑前后真正发生几何变化的线元
+		virtual bool SameShape(const LineElement& other) const = 0;
 	};
 }
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace VizRailCore
+{
+	/// 以只读方式映射到内存的文件。映射建立后文件句柄即关闭，映射在对象存在期间保持有效
+	class MappedFile
+	{
+	public:
+		/// \exception VizRailCoreException 无法打开或映射文件，或文件为空
+		explicit MappedFile(const std::filesystem::path& path);
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile();
+
+		/// 映射的内容，起点按页对齐
+		[[nodiscard]] std::span<const std::byte> Bytes() const
+		{
+			return {static_cast<const std::byte*>(_address), _size};
+		}
+
+	private:
+		const void* _address = nullptr;
+		size_t _size = 0;
+	};
+
+	/// \brief 将内容写入文件。先写入同目录下的临时文件再替换，读者只会看到完整的旧文件或新文件；
+	/// POSIX上已映射旧文件的读者不受影响，Windows上旧文件仍被映射时替换失败
+	/// \exception VizRailCoreException 无法写入或替换文件
+	void ReplaceFile(const std::filesystem::path& path, std::span<const std::byte> content);
+}
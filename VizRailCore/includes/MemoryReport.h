@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+
+namespace VizRailCore
+{
+	/// 按类别统计的内存字节数
+	struct MemoryReport
+	{
+		/// 输入数据：交点表、方案名等
+		size_t Inputs = 0;
+		/// 由交点计算出的线元：线元对象、线元名、写入了里程的交点副本
+		size_t Elements = 0;
+		/// 空间索引
+		size_t Indices = 0;
+		/// 撤销和重做记录，包括其中缓存的线元和空间索引
+		size_t History = 0;
+		/// 显示列表缓存
+		size_t DisplayCaches = 0;
+
+		[[nodiscard]] size_t Total() const
+		{
+			return Inputs + Elements + Indices + History + DisplayCaches;
+		}
+
+		MemoryReport& operator+=(const MemoryReport& other)
+		{
+			Inputs += other.Inputs;
+			Elements += other.Elements;
+			Indices += other.Indices;
+			History += other.History;
+			DisplayCaches += other.DisplayCaches;
+			return *this;
+		}
+	};
+
+	/// 多个对象的内存汇总，如一张图中的所有线路实体。对象之间共享的交点分块、线元和显示列表只计入第一个统计到它的对象，
+	/// 各对象的报告之和等于Total()
+	class MemoryAccounting
+	{
+	public:
+		/// \brief 统计一个对象，对象需提供MemoryUsage(MemoryReport&, std::unordered_set<const void*>&)
+		/// \return 该对象新增的内存
+		template <typename T>
+		MemoryReport Add(const T& item)
+		{
+			MemoryReport report;
+			item.MemoryUsage(report, _visited);
+			_total += report;
+			return report;
+		}
+
+		[[nodiscard]] const MemoryReport& Total() const
+		{
+			return _total;
+		}
+
+	private:
+		std::unordered_set<const void*> _visited;
+		MemoryReport _total;
+	};
+
+	/// 字符串另行分配的堆内存，短字符串存放在对象内部时为0
+	template <typename Char>
+	size_t StringHeapBytes(const std::basic_string<Char>& text)
+	{
+		const auto data = reinterpret_cast<uintptr_t>(text.data());
+		const auto object = reinterpret_cast<uintptr_t>(&text);
+		if (data >= object && data < object + sizeof(text))
+		{
+			return 0;
+		}
+		return (text.capacity() + 1) * sizeof(Char);
+	}
+}
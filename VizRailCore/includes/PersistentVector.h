@@ -0,0 +1,556 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace VizRailCore
+{
+	/// 持久化（不可变）向量。元素按ChunkSize分块存放在B+树的叶节点中，所有修改操作都返回新向量，
+	/// 只复制从根到被修改叶节点的一条路径，其余节点与原向量共享。
+	/// 复制为O(1)，按下标读写、插入、删除均为O(log n)。删除后不合并未满的节点，树高只取决于历史最大长度
+	template <typename T, size_t ChunkSize = 8>
+	class PersistentVector
+	{
+		static_assert(ChunkSize >= 2, "ChunkSize must be at least 2");
+
+		struct Node
+		{
+			bool IsLeaf = true;
+			// 叶节点为元素个数，内部节点为子节点个数
+			uint32_t Count = 0;
+		};
+
+		struct Leaf : Node
+		{
+			std::array<T, ChunkSize> Items{};
+		};
+
+		struct Branch : Node
+		{
+			std::array<std::shared_ptr<const Node>, ChunkSize> Children;
+			// 各子树的元素个数
+			std::array<size_t, ChunkSize> Sizes{};
+		};
+
+		using NodePtr = std::shared_ptr<const Node>;
+
+	public:
+		class ConstIterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const T*;
+			using reference = const T&;
+
+			ConstIterator() = default;
+
+			reference operator*() const
+			{
+				return _leaf->Items[_index - _leafStart];
+			}
+
+			pointer operator->() const
+			{
+				return &**this;
+			}
+
+			ConstIterator& operator++()
+			{
+				++_index;
+				if (_index < _vector->_size && _index >= _leafStart + _leaf->Count)
+				{
+					Locate();
+				}
+				return *this;
+			}
+
+			ConstIterator operator++(int)
+			{
+				ConstIterator previous = *this;
+				++*this;
+				return previous;
+			}
+
+			bool operator==(const ConstIterator& other) const
+			{
+				return _index == other._index;
+			}
+
+		private:
+			friend class PersistentVector;
+
+			ConstIterator(const PersistentVector* vector, const size_t index) : _vector(vector), _index(index)
+			{
+				if (_index < _vector->_size)
+				{
+					Locate();
+				}
+			}
+
+			// 逐个访问同一叶节点内的元素不需要重新自根查找，整体遍历为O(n)
+			void Locate()
+			{
+				size_t local = _index;
+				_leaf = FindLeaf(_vector->_root, local);
+				_leafStart = _index - local;
+			}
+
+			const PersistentVector* _vector = nullptr;
+			size_t _index = 0;
+			const Leaf* _leaf = nullptr;
+			size_t _leafStart = 0;
+		};
+
+		PersistentVector() = default;
+
+		PersistentVector(const std::initializer_list<T> items) : PersistentVector(std::vector<T>(items))
+		{
+		}
+
+		explicit PersistentVector(const std::span<const T> items) :
+			PersistentVector(items.size(), [items](const size_t i) -> const T& { return items[i]; })
+		{
+		}
+
+		explicit PersistentVector(const std::vector<T>& items) : PersistentVector(std::span<const T>(items))
+		{
+		}
+
+		/// \brief 由size个元素构建，第i个元素为get(i)
+		template <typename Get>
+		PersistentVector(const size_t size, Get&& get)
+		{
+			if (size == 0)
+			{
+				return;
+			}
+			// 自底向上逐层构建满节点
+			std::vector<NodePtr> level;
+			for (size_t i = 0; i < size; i += ChunkSize)
+			{
+				auto leaf = std::make_shared<Leaf>();
+				leaf->Count = static_cast<uint32_t>(std::min(ChunkSize, size - i));
+				for (uint32_t j = 0; j < leaf->Count; ++j)
+				{
+					leaf->Items[j] = get(i + j);
+				}
+				level.push_back(std::move(leaf));
+			}
+			while (level.size() > 1)
+			{
+				std::vector<NodePtr> parents;
+				for (size_t i = 0; i < level.size(); i += ChunkSize)
+				{
+					auto branch = std::make_shared<Branch>();
+					branch->IsLeaf = false;
+					branch->Count = static_cast<uint32_t>(std::min(ChunkSize, level.size() - i));
+					for (uint32_t j = 0; j < branch->Count; ++j)
+					{
+						branch->Children[j] = level[i + j];
+						branch->Sizes[j] = SizeOf(level[i + j]);
+					}
+					parents.push_back(std::move(branch));
+				}
+				level.swap(parents);
+			}
+			_root = level.front();
+			_size = size;
+		}
+
+		[[nodiscard]] size_t Size() const
+		{
+			return _size;
+		}
+
+		[[nodiscard]] bool IsEmpty() const
+		{
+			return _size == 0;
+		}
+
+		const T& operator[](const size_t index) const
+		{
+			size_t local = index;
+			return FindLeaf(_root, local)->Items[local];
+		}
+
+		[[nodiscard]] const T& At(const size_t index) const
+		{
+			if (index >= _size)
+			{
+				throw std::out_of_range("PersistentVector index out of range");
+			}
+			return (*this)[index];
+		}
+
+		[[nodiscard]] PersistentVector Set(const size_t index, T value) const
+		{
+			if (index >= _size)
+			{
+				throw std::out_of_range("PersistentVector index out of range");
+			}
+			return {SetIn(_root, index, std::move(value)), _size};
+		}
+
+		[[nodiscard]] PersistentVector Insert(const size_t index, T value) const
+		{
+			if (index > _size)
+			{
+				throw std::out_of_range("PersistentVector index out of range");
+			}
+			if (_root == nullptr)
+			{
+				auto leaf = std::make_shared<Leaf>();
+				leaf->Count = 1;
+				leaf->Items[0] = std::move(value);
+				return {std::move(leaf), 1};
+			}
+
+			auto [left, right] = InsertIn(_root, index, std::move(value));
+			if (right == nullptr)
+			{
+				return {std::move(left), _size + 1};
+			}
+			// 根节点分裂，树高加一
+			auto root = std::make_shared<Branch>();
+			root->IsLeaf = false;
+			root->Count = 2;
+			root->Sizes[0] = SizeOf(left);
+			root->Sizes[1] = SizeOf(right);
+			root->Children[0] = std::move(left);
+			root->Children[1] = std::move(right);
+			return {std::move(root), _size + 1};
+		}
+
+		[[nodiscard]] PersistentVector PushBack(T value) const
+		{
+			return Insert(_size, std::move(value));
+		}
+
+		[[nodiscard]] PersistentVector Erase(const size_t index) const
+		{
+			if (index >= _size)
+			{
+				throw std::out_of_range("PersistentVector index out of range");
+			}
+			NodePtr root = EraseIn(_root, index);
+			// 根节点只剩一个子节点时降低树高
+			while (root != nullptr && !root->IsLeaf && root->Count == 1)
+			{
+				root = static_cast<const Branch&>(*root).Children[0];
+			}
+			return {std::move(root), _size - 1};
+		}
+
+		/// \brief 返回内容为items的向量。长度相同时逐块比较，内容全部相同的分块与当前向量共享，
+		/// 用于把整体重新计算的结果写回而只复制实际变化的部分
+		/// \param equal 判断两个元素是否相同
+		template <typename Equal>
+		[[nodiscard]] PersistentVector Assign(const std::span<const T> items, Equal&& equal) const
+		{
+			return Assign(items.size(), [items](const size_t i) -> const T&
+			{
+				return items[i];
+			}, equal);
+		}
+
+		/// \brief 同上，第i个元素为get(i)，不需要先把结果放进连续的数组
+		template <typename Get, typename Equal>
+		[[nodiscard]] PersistentVector Assign(const size_t size, Get&& get, Equal&& equal) const
+		{
+			if (size != _size)
+			{
+				return PersistentVector(size, get);
+			}
+			if (_root == nullptr)
+			{
+				return *this;
+			}
+			size_t offset = 0;
+			return {AssignIn(_root, get, offset, equal), _size};
+		}
+
+		[[nodiscard]] std::vector<T> ToVector() const
+		{
+			return std::vector<T>(begin(), end());
+		}
+
+		[[nodiscard]] ConstIterator begin() const
+		{
+			return {this, 0};
+		}
+
+		[[nodiscard]] ConstIterator end() const
+		{
+			return {this, _size};
+		}
+
+		/// 两个向量是否共享同一份存储（由同一向量复制而来且均未修改）
+		[[nodiscard]] bool SharesStorageWith(const PersistentVector& other) const
+		{
+			return _root == other._root;
+		}
+
+		/// \brief 统计节点占用的内存，已在visited中的节点不重复计算，用于统计多个版本共享后的总内存
+		/// \param itemUsage 元素自身另外占用的堆内存，只对新统计的节点中的元素调用
+		/// \return 本次新统计的字节数
+		template <typename ItemUsage>
+		size_t MemoryUsage(std::unordered_set<const void*>& visited, ItemUsage&& itemUsage) const
+		{
+			return MemoryUsageOf(_root, visited, itemUsage);
+		}
+
+		size_t MemoryUsage(std::unordered_set<const void*>& visited) const
+		{
+			return MemoryUsage(visited, [](const T&) { return size_t{0}; });
+		}
+
+	private:
+		NodePtr _root;
+		size_t _size = 0;
+
+		PersistentVector(NodePtr root, const size_t size) : _root(std::move(root)), _size(size)
+		{
+		}
+
+		static size_t SizeOf(const NodePtr& node)
+		{
+			if (node->IsLeaf)
+			{
+				return node->Count;
+			}
+			const auto& branch = static_cast<const Branch&>(*node);
+			size_t size = 0;
+			for (uint32_t i = 0; i < branch.Count; ++i)
+			{
+				size += branch.Sizes[i];
+			}
+			return size;
+		}
+
+		/// 在内部节点中查找下标所在的子节点，index被改写为子节点内的下标。
+		/// 下标等于子树总长时（末尾插入）返回最后一个子节点
+		static uint32_t ChildOf(const Branch& branch, size_t& index)
+		{
+			uint32_t child = 0;
+			while (child + 1 < branch.Count && index >= branch.Sizes[child])
+			{
+				index -= branch.Sizes[child];
+				++child;
+			}
+			return child;
+		}
+
+		static const Leaf* FindLeaf(const NodePtr& root, size_t& index)
+		{
+			const Node* node = root.get();
+			while (!node->IsLeaf)
+			{
+				const auto& branch = static_cast<const Branch&>(*node);
+				node = branch.Children[ChildOf(branch, index)].get();
+			}
+			return static_cast<const Leaf*>(node);
+		}
+
+		static NodePtr SetIn(const NodePtr& node, size_t index, T&& value)
+		{
+			if (node->IsLeaf)
+			{
+				auto leaf = std::make_shared<Leaf>(static_cast<const Leaf&>(*node));
+				leaf->Items[index] = std::move(value);
+				return leaf;
+			}
+			auto branch = std::make_shared<Branch>(static_cast<const Branch&>(*node));
+			const uint32_t child = ChildOf(*branch, index);
+			branch->Children[child] = SetIn(branch->Children[child], index, std::move(value));
+			return branch;
+		}
+
+		/// 插入后节点超出ChunkSize时一分为二，返回的第二个节点非空
+		static std::pair<NodePtr, NodePtr> InsertIn(const NodePtr& node, size_t index, T&& value)
+		{
+			if (node->IsLeaf)
+			{
+				const auto& source = static_cast<const Leaf&>(*node);
+				std::vector<T> items(source.Items.begin(), source.Items.begin() + source.Count);
+				items.insert(items.begin() + static_cast<std::ptrdiff_t>(index), std::move(value));
+				return SplitLeaf(items);
+			}
+
+			const auto& source = static_cast<const Branch&>(*node);
+			const uint32_t child = ChildOf(source, index);
+			auto [left, right] = InsertIn(source.Children[child], index, std::move(value));
+
+			std::vector<NodePtr> children(source.Children.begin(), source.Children.begin() + source.Count);
+			std::vector<size_t> sizes(source.Sizes.begin(), source.Sizes.begin() + source.Count);
+			sizes[child] = SizeOf(left);
+			children[child] = std::move(left);
+			if (right != nullptr)
+			{
+				sizes.insert(sizes.begin() + child + 1, SizeOf(right));
+				children.insert(children.begin() + child + 1, std::move(right));
+			}
+			return SplitBranch(children, sizes);
+		}
+
+		static std::pair<NodePtr, NodePtr> SplitLeaf(std::vector<T>& items)
+		{
+			const size_t leftCount = items.size() <= ChunkSize ? items.size() : items.size() / 2;
+			auto left = std::make_shared<Leaf>();
+			left->Count = static_cast<uint32_t>(leftCount);
+			std::move(items.begin(), items.begin() + static_cast<std::ptrdiff_t>(leftCount), left->Items.begin());
+			if (leftCount == items.size())
+			{
+				return {std::move(left), nullptr};
+			}
+			auto right = std::make_shared<Leaf>();
+			right->Count = static_cast<uint32_t>(items.size() - leftCount);
+			std::move(items.begin() + static_cast<std::ptrdiff_t>(leftCount), items.end(), right->Items.begin());
+			return {std::move(left), std::move(right)};
+		}
+
+		static std::pair<NodePtr, NodePtr> SplitBranch(std::vector<NodePtr>& children, const std::vector<size_t>& sizes)
+		{
+			const size_t leftCount = children.size() <= ChunkSize ? children.size() : children.size() / 2;
+			const auto makeBranch = [&children, &sizes](const size_t begin, const size_t end)
+			{
+				auto branch = std::make_shared<Branch>();
+				branch->IsLeaf = false;
+				branch->Count = static_cast<uint32_t>(end - begin);
+				for (size_t i = begin; i < end; ++i)
+				{
+					branch->Children[i - begin] = std::move(children[i]);
+					branch->Sizes[i - begin] = sizes[i];
+				}
+				return branch;
+			};
+			NodePtr left = makeBranch(0, leftCount);
+			if (leftCount == children.size())
+			{
+				return {std::move(left), nullptr};
+			}
+			return {std::move(left), makeBranch(leftCount, children.size())};
+		}
+
+		/// 删除后节点为空时返回空指针
+		static NodePtr EraseIn(const NodePtr& node, size_t index)
+		{
+			if (node->Count == 1 && node->IsLeaf)
+			{
+				return nullptr;
+			}
+			if (node->IsLeaf)
+			{
+				auto leaf = std::make_shared<Leaf>(static_cast<const Leaf&>(*node));
+				std::move(leaf->Items.begin() + static_cast<std::ptrdiff_t>(index) + 1,
+				          leaf->Items.begin() + leaf->Count, leaf->Items.begin() + static_cast<std::ptrdiff_t>(index));
+				--leaf->Count;
+				leaf->Items[leaf->Count] = T{};
+				return leaf;
+			}
+
+			auto branch = std::make_shared<Branch>(static_cast<const Branch&>(*node));
+			const uint32_t child = ChildOf(*branch, index);
+			NodePtr replaced = EraseIn(branch->Children[child], index);
+			if (replaced != nullptr)
+			{
+				branch->Children[child] = std::move(replaced);
+				--branch->Sizes[child];
+				return branch;
+			}
+			if (branch->Count == 1)
+			{
+				return nullptr;
+			}
+			for (uint32_t i = child; i + 1 < branch->Count; ++i)
+			{
+				branch->Children[i] = std::move(branch->Children[i + 1]);
+				branch->Sizes[i] = branch->Sizes[i + 1];
+			}
+			--branch->Count;
+			branch->Children[branch->Count].reset();
+			branch->Sizes[branch->Count] = 0;
+			return branch;
+		}
+
+		template <typename Get, typename Equal>
+		static NodePtr AssignIn(const NodePtr& node, Get& get, size_t& offset, Equal& equal)
+		{
+			if (node->IsLeaf)
+			{
+				const auto& source = static_cast<const Leaf&>(*node);
+				const size_t first = offset;
+				offset += source.Count;
+				uint32_t same = 0;
+				while (same < source.Count && equal(source.Items[same], get(first + same)))
+				{
+					++same;
+				}
+				if (same == source.Count)
+				{
+					return node;
+				}
+				auto leaf = std::make_shared<Leaf>();
+				leaf->Count = source.Count;
+				for (uint32_t j = 0; j < source.Count; ++j)
+				{
+					leaf->Items[j] = get(first + j);
+				}
+				return leaf;
+			}
+
+			const auto& source = static_cast<const Branch&>(*node);
+			std::shared_ptr<Branch> branch;
+			for (uint32_t i = 0; i < source.Count; ++i)
+			{
+				NodePtr child = AssignIn(source.Children[i], get, offset, equal);
+				if (child == source.Children[i])
+				{
+					continue;
+				}
+				if (branch == nullptr)
+				{
+					branch = std::make_shared<Branch>(source);
+				}
+				branch->Children[i] = std::move(child);
+			}
+			return branch != nullptr ? NodePtr(std::move(branch)) : node;
+		}
+
+		template <typename ItemUsage>
+		static size_t MemoryUsageOf(const NodePtr& node, std::unordered_set<const void*>& visited, ItemUsage& itemUsage)
+		{
+			if (node == nullptr || !visited.insert(node.get()).second)
+			{
+				return 0;
+			}
+			// make_shared的控制块与对象一起分配，按两个指针估算控制块大小
+			constexpr size_t ControlBlock = 2 * sizeof(void*);
+			if (node->IsLeaf)
+			{
+				const auto& leaf = static_cast<const Leaf&>(*node);
+				size_t bytes = sizeof(Leaf) + ControlBlock;
+				for (uint32_t i = 0; i < leaf.Count; ++i)
+				{
+					bytes += itemUsage(leaf.Items[i]);
+				}
+				return bytes;
+			}
+			const auto& branch = static_cast<const Branch&>(*node);
+			size_t bytes = sizeof(Branch) + ControlBlock;
+			for (uint32_t i = 0; i < branch.Count; ++i)
+			{
+				bytes += MemoryUsageOf(branch.Children[i], visited, itemUsage);
+			}
+			return bytes;
+		}
+	};
+}
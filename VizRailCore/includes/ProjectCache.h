@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "AlignmentImage.h"
+#include "HorizontalAlignment.h"
+#include "Stationing.h"
+
+namespace VizRailCore
+{
+	/// 派生数据算法的版本。线元计算、逐桩、中线离散或线路映像的结果改变时递增，旧版本的缓存不再使用
+	constexpr uint32_t DerivedDataVersion = 1;
+
+	/// \brief 交点表与DerivedDataVersion的内容哈希（64位FNV-1a）。
+	/// 按各字段的小端字节计算，与线路修订号、进程和平台无关，交点表不变时重新打开项目得到相同的值
+	[[nodiscard]] uint64_t JdContentHash(const HorizontalAlignment& alignment);
+
+	/// 缓存中的数组。Owner保持数据所在的文件映射（或无法写入缓存时的内存副本）有效
+	template <typename T>
+	struct CachedArray
+	{
+		std::shared_ptr<const void> Owner;
+		std::span<const T> Items;
+	};
+
+	/// 缓存中的线路映像。映像头中的修订号是生成缓存时线路的修订号，不一定与当前线路相同
+	struct CachedAlignmentImage
+	{
+		std::shared_ptr<const void> Owner;
+		AlignmentImageView View;
+	};
+
+	/// 项目级的派生数据磁盘缓存。每个缓存文件以交点表的内容哈希、算法版本和计算参数命名，
+	/// 文件中保存完整的交点表，读取时逐项校验，哈希冲突、版本不符或文件损坏时重新计算并替换。
+	/// 命中时只映射文件，不做几何计算。多个线程或进程可以同时使用同一目录
+	class ProjectCache
+	{
+	public:
+		struct Statistics
+		{
+			/// 直接使用缓存文件的次数
+			size_t Hits = 0;
+			/// 没有缓存文件而重新计算的次数
+			size_t Misses = 0;
+			/// 缓存文件校验失败而重新计算的次数
+			size_t Rejected = 0;
+			/// 重新计算后无法写入缓存目录的次数，此时结果只保存在内存中
+			size_t WriteFailures = 0;
+		};
+
+		/// \param directory 缓存目录，第一次写入时创建
+		explicit ProjectCache(std::filesystem::path directory);
+
+		[[nodiscard]] const std::filesystem::path& Directory() const
+		{
+			return _directory;
+		}
+
+		/// \brief 线路映像，见BuildAlignmentImage
+		[[nodiscard]] CachedAlignmentImage Image(const HorizontalAlignment& alignment);
+
+		/// \brief 全线逐桩表，见BuildStationTable
+		/// \exception VizRailCoreException 桩距不大于0
+		[[nodiscard]] CachedArray<StationRecord> Stations(const HorizontalAlignment& alignment, double interval);
+
+		/// \brief 中线折线，见BuildCenterline
+		/// \exception VizRailCoreException 弦高容差不大于0
+		[[nodiscard]] CachedArray<CenterlinePoint> Centerline(const HorizontalAlignment& alignment,
+		                                                      double chordTolerance);
+
+		[[nodiscard]] Statistics Stats() const;
+
+	private:
+		enum class Kind : uint32_t;
+
+		struct Payload
+		{
+			std::shared_ptr<const void> Owner;
+			std::span<const std::byte> Bytes;
+		};
+
+		/// \brief 读取并校验缓存文件，不可用时调用build重新计算并写入缓存
+		/// \param validate 检查负载内容，不可用时抛出VizRailCoreException
+		Payload Load(Kind kind, const HorizontalAlignment& alignment, double parameter,
+		             const std::function<std::vector<std::byte>()>& build,
+		             const std::function<void(std::span<const std::byte>)>& validate);
+
+		template <typename T>
+		CachedArray<T> LoadArray(Kind kind, const HorizontalAlignment& alignment, double parameter,
+		                         const std::function<std::vector<T>()>& build);
+
+		std::filesystem::path _directory;
+		std::atomic<size_t> _hits = 0;
+		std::atomic<size_t> _misses = 0;
+		std::atomic<size_t> _rejected = 0;
+		std::atomic<size_t> _writeFailures = 0;
+	};
+}
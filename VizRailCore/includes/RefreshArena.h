@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace VizRailCore
+{
+	/// 线路刷新期间临时数据的单调分配区。刷新中的交点副本、里程、线元候选和排序缓冲都从同一块缓冲区顺序分配，
+	/// 刷新结束时整体释放。缓冲区不够时向堆申请，释放时按本次用量扩大缓冲区，稳定状态下刷新不再为临时数据访问堆。
+	/// 每个线程一个分配区而不是每条线路一个，O(1)复制出的大量方案变体不必各自保留一块缓冲区
+	class RefreshArena
+	{
+	public:
+		/// 在当前线程的分配区上进行一次刷新，最外层的Scope析构时整体释放
+		class Scope
+		{
+		public:
+			Scope();
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+			~Scope();
+
+			[[nodiscard]] std::pmr::memory_resource* Resource() const;
+
+		private:
+			RefreshArena& _arena;
+		};
+
+		RefreshArena();
+
+		RefreshArena(const RefreshArena&) = delete;
+		RefreshArena& operator=(const RefreshArena&) = delete;
+
+		/// 保留的缓冲区字节数
+		[[nodiscard]] size_t Capacity() const
+		{
+			return _capacity;
+		}
+
+		/// 当前线程的分配区
+		static RefreshArena& ForCurrentThread();
+
+	private:
+		/// 缓冲区用完后的后备资源，记录向堆申请的字节数
+		class Overflow final : public std::pmr::memory_resource
+		{
+		public:
+			size_t Bytes = 0;
+
+		private:
+			void* do_allocate(size_t bytes, size_t alignment) override;
+			void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+			[[nodiscard]] bool do_is_equal(const memory_resource& other) const noexcept override;
+		};
+
+		void Release();
+
+		std::unique_ptr<std::byte[]> _buffer;
+		size_t _capacity = 0;
+		Overflow _overflow;
+		std::optional<std::pmr::monotonic_buffer_resource> _resource;
+		size_t _depth = 0;
+	};
+}
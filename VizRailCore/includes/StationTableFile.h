@@ -0,0 +1,171 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Stationing.h"
+
+namespace VizRailCore
+{
+	/// 逐桩表二进制文件的布局。文件由文件头、按行数分块的数据块和文件末尾的块索引组成，
+	/// 每块内按列存放里程、坐标N、坐标E、方位角、曲率和可选的高程。数值均为小端序。
+	/// Raw编码的每列是连续的float64数组，块起点按64字节对齐，映射文件后可以直接当作double数组读取；
+	/// Compressed编码将每列按分辨率量化为相对局部原点的整数，依次存放首值、一阶差分和二阶差分的变长整数，
+	/// 等桩距的里程和直线上的坐标的二阶差分为0，各只占1字节，还原值有量化误差（见Resolution）；
+	/// Xor编码逐位无损，每个值与由前两个值线性外推的预测值按位异或，只存放异或结果中非零的字节，
+	/// 预测准确时只占1字节，体积介于Raw和Compressed之间
+	namespace StationTableFile
+	{
+		constexpr uint32_t Magic = 0x54535256; // "VRST"
+		constexpr uint32_t Version = 1;
+		/// 各块起点的对齐字节数
+		constexpr size_t ChunkAlignment = 64;
+		/// Compressed编码中里程（米）、方位角（弧度）和曲率（1/米）的量化分辨率，
+		/// 坐标和高程的分辨率由StationTableOptions::CoordinateResolution给出
+		constexpr double MileageResolution = 1e-6;
+		constexpr double AzimuthResolution = 1e-9;
+		constexpr double CurvatureResolution = 1e-12;
+
+		enum class Encoding : uint32_t
+		{
+			Raw = 0,
+			/// 有损，各列误差见Header::Resolution
+			Compressed = 1,
+			/// 无损
+			Xor = 2,
+		};
+
+		/// 列在块内的顺序，没有高程时只有前5列
+		enum Column : uint32_t
+		{
+			MileageColumn = 0,
+			NColumn,
+			EColumn,
+			AzimuthColumn,
+			CurvatureColumn,
+			ZColumn,
+			MaxColumns,
+		};
+
+		struct Header
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			StationTableFile::Encoding Encoding;
+			/// 5或6，为6时有高程列
+			uint32_t ColumnCount;
+			uint64_t RowCount;
+			uint64_t ChunkCount;
+			/// ChunkEntry数组的字节偏移
+			uint64_t ChunkIndexOffset;
+			/// Compressed编码中坐标N、E的局部原点，各块的里程以块的首桩里程为原点，其余列以0为原点
+			double OriginN;
+			double OriginE;
+			/// Compressed编码中各列的量化分辨率，还原值与原值之差不超过分辨率的一半（另有量化和还原时的
+			/// 浮点舍入，约为数值的1e-16倍）：里程±0.5e-6米，坐标N、E和高程±CoordinateResolution/2
+			/// （默认±0.5e-4米），方位角±0.5e-9弧度，曲率±0.5e-12/米。Raw和Xor编码不量化，该项仅作记录
+			double Resolution[MaxColumns];
+		};
+
+		/// 块索引的一项，按里程排序，用于按里程范围定位块
+		struct ChunkEntry
+		{
+			double FirstMileage;
+			double LastMileage;
+			/// 块的首行在全表中的行号
+			uint64_t FirstRow;
+			/// 块的字节偏移和字节数
+			uint64_t Offset;
+			uint64_t Size;
+			uint32_t Rows;
+			uint32_t Reserved;
+		};
+
+		static_assert(sizeof(Header) == 104);
+		static_assert(sizeof(ChunkEntry) == 48);
+	}
+
+	struct StationTableOptions
+	{
+		StationTableFile::Encoding Encoding = StationTableFile::Encoding::Raw;
+		/// 每块的行数
+		uint32_t ChunkRows = 65536;
+		/// Compressed编码中坐标和高程的量化分辨率（米），还原误差不超过其一半
+		double CoordinateResolution = 1e-4;
+	};
+
+	/// 按列存放的逐桩表
+	struct StationColumns
+	{
+		std::vector<double> Mileage;
+		std::vector<double> N;
+		std::vector<double> E;
+		/// 切线方位角（弧度）
+		std::vector<double> Azimuth;
+		/// 曲率（1/米），右转为正，见StationCurvature
+		std::vector<double> Curvature;
+		/// 高程，文件中没有高程列时为空
+		std::vector<double> Z;
+
+		[[nodiscard]] size_t Size() const
+		{
+			return Mileage.size();
+		}
+	};
+
+	/// \brief 将BuildStationTable得到的逐桩表写为二进制文件，曲率由StationCurvature计算。
+	/// 按块逐块编码写出，除块索引外不保留已写出的数据
+	/// \param stations 按里程排序的桩
+	/// \param elevations 各桩的高程，为空时不写高程列
+	/// \exception VizRailCoreException 无法写入文件、桩未按里程排序、高程数与桩数不符、块行数为0、
+	/// 分辨率不大于0，或Compressed编码时有非有限值或量化后超出范围
+	void SaveStationTable(const std::filesystem::path& path, const HorizontalAlignment& alignment,
+	                      std::span<const StationRecord> stations, std::span<const double> elevations = {},
+	                      const StationTableOptions& options = {});
+
+	/// 以只读方式映射的逐桩表二进制文件。打开时只检查文件头和块索引，读取时只解码与里程范围相交的块
+	class StationTableReader
+	{
+	public:
+		/// \exception VizRailCoreException 无法打开文件，或文件不是有效的逐桩表文件
+		explicit StationTableReader(const std::filesystem::path& path);
+
+		[[nodiscard]] const StationTableFile::Header& GetHeader() const
+		{
+			return _header;
+		}
+
+		[[nodiscard]] bool HasZ() const
+		{
+			return _header.ColumnCount > StationTableFile::ZColumn;
+		}
+
+		[[nodiscard]] std::span<const StationTableFile::ChunkEntry> Chunks() const
+		{
+			return _chunks;
+		}
+
+		/// \brief Raw编码的块中一列的数据，直接指向映射的文件，不复制
+		/// \exception VizRailCoreException 文件不是Raw编码，或块、列不存在
+		[[nodiscard]] std::span<const double> RawColumn(size_t chunk, StationTableFile::Column column) const;
+
+		/// \brief 解码一块
+		[[nodiscard]] StationColumns ReadChunk(size_t chunk) const;
+
+		/// \brief 里程在[from, to]内的桩。由块索引二分查找相交的块，只解码这些块
+		[[nodiscard]] StationColumns ReadRange(double from, double to) const;
+
+		/// \brief 全表
+		[[nodiscard]] StationColumns ReadAll() const;
+
+	private:
+		void DecodeChunk(size_t chunk, StationColumns& columns, double from, double to) const;
+
+		MappedFile _file;
+		StationTableFile::Header _header{};
+		std::span<const StationTableFile::ChunkEntry> _chunks;
+	};
+}
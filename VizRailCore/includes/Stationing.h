@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "HorizontalAlignment.h"
+
+namespace VizRailCore
+{
+	/// 逐桩表中桩的类型
+	enum class StationPoint : uint32_t
+	{
+		/// 桩距整倍数的里程桩
+		Interval = 0,
+		/// 线路起点
+		Start,
+		/// 线路终点
+		End,
+		ZH,
+		HY,
+		QZ,
+		YH,
+		HZ,
+	};
+
+	/// 逐桩表的一行，布局固定，可以原样写入缓存文件
+	struct StationRecord
+	{
+		double Mileage;
+		/// 坐标N（Point2D::Y）
+		double N;
+		/// 坐标E（Point2D::X）
+		double E;
+		/// 切线方位角（弧度）
+		double Azimuth;
+		/// 所在线元在GetXys()中的下标
+		uint32_t Element;
+		StationPoint Point;
+	};
+
+	static_assert(sizeof(StationRecord) == 40);
+
+	/// 中线折线的顶点
+	struct CenterlinePoint
+	{
+		double Mileage;
+		double X;
+		double Y;
+	};
+
+	static_assert(sizeof(CenterlinePoint) == 24);
+
+	/// 里程比较的容差，整桩与特征点里程相差小于此值时视为同一桩
+	constexpr double StationTolerance = 1e-6;
+
+	/// \brief 线元下标按起点里程排序。GetXys()中第一条夹直线排在曲线1之后，不是里程顺序
+	[[nodiscard]] std::vector<size_t> ElementsByMileage(const HorizontalAlignment& alignment);
+
+	/// \brief 全线逐桩表：桩距整倍数的里程桩、线路起终点和各曲线的ZH/HY/QZ/YH/HZ点，按里程排序。
+	/// 里程相差小于StationTolerance的桩只保留一个，类型取特征点
+	/// \param interval 桩距，大于0
+	/// \exception VizRailCoreException 桩距不大于0
+	[[nodiscard]] std::vector<StationRecord> BuildStationTable(const HorizontalAlignment& alignment, double interval);
+
+	/// \brief 桩处中线的曲率（1/米），即切线方位角对里程的变化率，右转为正。
+	/// 直线上为0，缓和曲线上由0线性变化到1/R，圆曲线上为1/R
+	[[nodiscard]] double StationCurvature(const HorizontalAlignment& alignment, const StationRecord& station);
+
+	/// \brief 将线路中线离散为按里程排序的折线。直线只取端点，曲线按弦高不超过chordTolerance的等里程步长离散
+	/// \param chordTolerance 弦高容差，大于0
+	/// \exception VizRailCoreException 弦高容差不大于0
+	[[nodiscard]] std::vector<CenterlinePoint> BuildCenterline(const HorizontalAlignment& alignment,
+	                                                          double chordTolerance);
+}
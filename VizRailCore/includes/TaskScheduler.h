@@ -0,0 +1,313 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Exceptions.h"
+
+namespace VizRailCore
+{
+	/// 取消令牌。复制后的令牌共享同一取消状态，任一副本调用Cancel后所有副本都变为已取消
+	class CancellationToken
+	{
+	public:
+		CancellationToken() : _cancelled(std::make_shared<std::atomic<bool>>(false))
+		{
+		}
+
+		void Cancel() const
+		{
+			_cancelled->store(true, std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] bool IsCancelled() const
+		{
+			return _cancelled->load(std::memory_order_relaxed);
+		}
+
+		/// \brief 已取消时抛出OperationCancelledException
+		void ThrowIfCancelled() const
+		{
+			if (IsCancelled())
+			{
+				throw OperationCancelledException(L"操作已取消");
+			}
+		}
+
+	private:
+		std::shared_ptr<std::atomic<bool>> _cancelled;
+	};
+
+	/// 工作窃取任务调度器。每个工作线程有自己的任务队列，从队尾取自己提交的任务，
+	/// 空闲时从其他线程的队首窃取；非工作线程提交的任务进入公共队列。
+	/// 等待任务完成的线程（包括工作线程自身）会帮忙执行任务，因此嵌套并行不会死锁。
+	/// VizRailCore的所有并行算法共用Default()返回的调度器，避免各自创建线程造成超额订阅
+	class TaskScheduler
+	{
+	public:
+		using Task = std::function<void()>;
+
+		/// \brief 创建调度器并启动工作线程
+		/// \param workerCount 工作线程数。为0时所有任务都由等待的线程自己执行
+		explicit TaskScheduler(size_t workerCount);
+
+		TaskScheduler(const TaskScheduler&) = delete;
+		TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+		/// 停止并等待所有工作线程。调用前必须没有进行中的并行操作
+		~TaskScheduler();
+
+		[[nodiscard]] size_t WorkerCount() const
+		{
+			return _workers.size();
+		}
+
+		/// 提交任务，由任意工作线程或等待中的线程执行
+		void Submit(Task task);
+
+		/// \brief 执行一个排队中的任务
+		/// \return 没有可执行的任务时返回false
+		bool RunOne();
+
+		/// 唤醒计数的当前值，在尝试取任务之前读取，再传给WaitForSignal
+		[[nodiscard]] uint32_t Signal() const
+		{
+			return _signal.load(std::memory_order_acquire);
+		}
+
+		/// \brief 阻塞到有新任务提交或有任务组完成，即唤醒计数不再等于signal
+		void WaitForSignal(const uint32_t signal) const
+		{
+			_signal.wait(signal, std::memory_order_acquire);
+		}
+
+		/// 唤醒所有在WaitForSignal中等待的线程
+		void NotifyWaiters()
+		{
+			_signal.fetch_add(1, std::memory_order_release);
+			_signal.notify_all();
+		}
+
+		/// 进程共用的调度器，首次使用时按SetDefaultWorkerCount的设置创建，未设置时为硬件线程数减1
+		static TaskScheduler& Default();
+
+		/// \brief 设置共用调度器的工作线程数，已创建的共用调度器会被停止，下次使用时按新设置重新创建。
+		/// 调用时不能有进行中的并行操作
+		static void SetDefaultWorkerCount(size_t workerCount);
+
+		/// 停止共用调度器的工作线程。DLL卸载前应调用，避免在卸载过程中等待线程退出
+		static void ShutdownDefault();
+
+	private:
+		struct Worker
+		{
+			std::mutex Mutex;
+			std::deque<Task> Tasks;
+			std::thread Thread;
+		};
+
+		void WorkerLoop(size_t index);
+		bool TakeTask(Task& task);
+
+		std::vector<std::unique_ptr<Worker>> _workers;
+		std::mutex _mutex;
+		std::condition_variable _wake;
+		std::deque<Task> _injected;
+		std::atomic<size_t> _queued = 0;
+		/// 等待任务组的线程的唤醒计数，提交任务和任务组的最后一个任务完成时递增
+		std::atomic<uint32_t> _signal = 0;
+		bool _stopping = false;
+	};
+
+	/// 一组一起等待的任务。任务抛出的第一个异常在Wait中重新抛出，出错后尚未开始的任务不再执行
+	class TaskGroup
+	{
+	public:
+		explicit TaskGroup(TaskScheduler& scheduler = TaskScheduler::Default()) : _scheduler(scheduler)
+		{
+		}
+
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator=(const TaskGroup&) = delete;
+
+		~TaskGroup()
+		{
+			WaitAll();
+		}
+
+		void Run(TaskScheduler::Task task)
+		{
+			_running.fetch_add(1, std::memory_order_relaxed);
+			_scheduler.Submit([this, task = std::move(task)]
+			{
+				if (!_failed.load(std::memory_order_relaxed))
+				{
+					try
+					{
+						task();
+					}
+					catch (...)
+					{
+						std::lock_guard lock(_errorMutex);
+						if (!_error)
+						{
+							_error = std::current_exception();
+						}
+						_failed.store(true, std::memory_order_relaxed);
+					}
+				}
+				// 最后一个任务完成后TaskGroup可能立即被销毁，先取出调度器
+				TaskScheduler& scheduler = _scheduler;
+				if (_running.fetch_sub(1, std::memory_order_release) == 1)
+				{
+					scheduler.NotifyWaiters();
+				}
+			});
+		}
+
+		/// \brief 等待所有任务完成，等待期间帮忙执行排队中的任务。有任务出错时重新抛出其异常
+		void Wait()
+		{
+			WaitAll();
+			if (_error)
+			{
+				std::rethrow_exception(std::exchange(_error, nullptr));
+			}
+		}
+
+	private:
+		void WaitAll()
+		{
+			while (_running.load(std::memory_order_acquire) > 0)
+			{
+				// 先读唤醒计数再取任务：取不到任务之后提交的任务或完成的任务组都会改变计数，不会丢失唤醒
+				const uint32_t signal = _scheduler.Signal();
+				if (_scheduler.RunOne())
+				{
+					continue;
+				}
+				if (_running.load(std::memory_order_acquire) == 0)
+				{
+					break;
+				}
+				// 其余任务正在其他线程上执行，阻塞而不是空转，不占用调用线程所在的核
+				_scheduler.WaitForSignal(signal);
+			}
+		}
+
+		TaskScheduler& _scheduler;
+		std::atomic<size_t> _running = 0;
+		std::atomic<bool> _failed = false;
+		std::mutex _errorMutex;
+		std::exception_ptr _error;
+	};
+
+	/// \brief 对[begin, end)中的每个下标调用body，按grain个下标一块拆分后并行执行，调用线程也参与执行。
+	/// body只能写入与下标对应的位置。多个下标出错时抛出下标最小的那个异常，与串行执行一致
+	/// \param token 取消后尚未开始的块不再执行，全部结束后抛出OperationCancelledException
+	template <typename Body>
+	void ParallelFor(const size_t begin, const size_t end, const size_t grain, const Body& body,
+	                 const CancellationToken& token = {}, TaskScheduler& scheduler = TaskScheduler::Default())
+	{
+		const size_t step = std::max<size_t>(grain, 1);
+		if (scheduler.WorkerCount() == 0 || end <= begin + step)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				if ((i - begin) % step == 0)
+				{
+					token.ThrowIfCancelled();
+				}
+				body(i);
+			}
+			return;
+		}
+
+		// 出错的块中最小的起始下标，之后的块不再执行
+		std::atomic<size_t> failedAt = end;
+		std::mutex errorMutex;
+		std::exception_ptr error;
+
+		TaskGroup group(scheduler);
+		std::function<void(size_t, size_t)> run = [&](size_t first, size_t last)
+		{
+			// 把后一半交给其他线程，自己继续拆分前一半，空闲线程窃取到的总是较大的块
+			while (last - first > step)
+			{
+				const size_t middle = first + std::max(step, (last - first) / 2 / step * step);
+				group.Run([&run, middle, last]
+				{
+					run(middle, last);
+				});
+				last = middle;
+			}
+			if (token.IsCancelled() || failedAt.load(std::memory_order_relaxed) < first)
+			{
+				return;
+			}
+			try
+			{
+				for (size_t i = first; i < last; ++i)
+				{
+					body(i);
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard lock(errorMutex);
+				if (first < failedAt.load(std::memory_order_relaxed))
+				{
+					failedAt.store(first, std::memory_order_relaxed);
+					error = std::current_exception();
+				}
+			}
+		};
+		run(begin, end);
+		group.Wait();
+
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+		token.ThrowIfCancelled();
+	}
+
+	/// \brief 把[begin, end)按grain个下标一块，每块从identity开始依次用combine累积map(i)，
+	/// 再按块的顺序合并各块结果。结合顺序只取决于grain，与线程数无关，浮点结果可复现
+	template <typename T, typename Map, typename Combine>
+	[[nodiscard]] T ParallelReduce(const size_t begin, const size_t end, const size_t grain, const T& identity,
+	                               const Map& map, const Combine& combine, const CancellationToken& token = {},
+	                               TaskScheduler& scheduler = TaskScheduler::Default())
+	{
+		const size_t step = std::max<size_t>(grain, 1);
+		const size_t blocks = end > begin ? (end - begin + step - 1) / step : 0;
+		std::vector<T> partials(blocks, identity);
+		ParallelFor(0, blocks, 1, [&](const size_t block)
+		{
+			const size_t first = begin + block * step;
+			const size_t last = std::min(end, first + step);
+			T value = identity;
+			for (size_t i = first; i < last; ++i)
+			{
+				value = combine(value, map(i));
+			}
+			partials[block] = std::move(value);
+		}, token, scheduler);
+
+		T result = identity;
+		for (const auto& partial : partials)
+		{
+			result = combine(result, partial);
+		}
+		return result;
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Jd.h"
+
+namespace VizRailCore
+{
+	/// 文本表格的编码，只影响表头中文列名的识别，数值列与编码无关
+	enum class TextEncoding
+	{
+		/// 表头是合法的UTF-8（可带BOM）时按UTF-8，否则按GBK
+		Auto,
+		Utf8,
+		/// 简体中文Windows的默认编码（代码页936），Access和Excel导出的TXT/CSV多为此编码
+		Gbk,
+	};
+
+	/// \brief 按指定编码将文本解码为宽字符串，Auto时合法的UTF-8按UTF-8，否则按GBK
+	/// \exception VizRailCoreException 文本不是指定的编码
+	[[nodiscard]] std::wstring DecodeText(std::string_view text, TextEncoding encoding = TextEncoding::Auto);
+
+	struct TextImportOptions
+	{
+		TextEncoding Encoding = TextEncoding::Auto;
+		/// 并行解析时每块的字节数，块边界对齐到下一行的行首
+		size_t ChunkSize = size_t{4} << 20;
+	};
+
+	/// 按列存放的交点表，列名与项目数据库的曲线表相同
+	struct JdColumns
+	{
+		std::vector<unsigned> JdH;
+		std::vector<double> N;
+		std::vector<double> E;
+		std::vector<double> Angle;
+		std::vector<double> R;
+		std::vector<double> Ls;
+		/// 第一个交点的起点里程
+		double StartMileage = 0.0;
+
+		[[nodiscard]] size_t Size() const
+		{
+			return N.size();
+		}
+
+		/// \brief 转为HorizontalAlignment的输入，派生字段为0
+		[[nodiscard]] std::vector<Jd> ToJds() const;
+	};
+
+	/// 按列存放的坐标点表，如测量点、逐桩坐标
+	struct PointColumns
+	{
+		std::vector<double> N;
+		std::vector<double> E;
+		/// 里程列，文件中没有里程列时为空
+		std::vector<double> Mileage;
+
+		[[nodiscard]] size_t Size() const
+		{
+			return N.size();
+		}
+	};
+
+	/// \brief 导入CSV或TXT格式的交点表。列名为交点号、坐标N、坐标E、偏角、曲线半径、前缓和曲线、起点里程，
+	/// 也可以用英文列名JdH、N、E、Angle、R、Ls、StartMileage。必须有坐标列，其余列缺省为0，交点号缺省为行序号，
+	/// 起点里程只取第一个交点的值，其余列被忽略。分隔符为逗号、制表符或空白，由表头确定
+	/// \exception TextImportException 文件无法读取、缺少列或数值有误，错误信息含文件名、行号和列号
+	[[nodiscard]] JdColumns ImportJdTable(const std::filesystem::path& path, const TextImportOptions& options = {});
+
+	/// \brief 导入坐标点表。列名为坐标N/N、坐标E/E，可选的里程列为里程/连续里程/Mileage，其余列被忽略。
+	/// 第一行全为数值时视为没有表头，各列依次为N、E和可选的里程。
+	/// 文件以只读方式映射到内存，按行分块并行解析，不逐行分配内存
+	/// \exception TextImportException 同上
+	[[nodiscard]] PointColumns ImportPoints(const std::filesystem::path& path, const TextImportOptions& options = {});
+}
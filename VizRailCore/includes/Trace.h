@@ -0,0 +1,106 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+
+// 性能跟踪。定义VIZRAIL_ENABLE_TRACING编译时，热点路径上的计时和计数宏记录到各线程自己的缓冲区；
+// 未定义时这些宏展开为空，不产生任何代码。查询计数和导出跟踪的接口始终存在，未启用时计数恒为0
+#ifdef VIZRAIL_ENABLE_TRACING
+#define VIZRAIL_TRACE_CONCAT_IMPL(a, b) a##b
+#define VIZRAIL_TRACE_CONCAT(a, b) VIZRAIL_TRACE_CONCAT_IMPL(a, b)
+/// 记录所在作用域的耗时，name必须是字符串字面量
+#define VIZRAIL_TRACE_SCOPE(name) \
+	const ::VizRailCore::TraceScope VIZRAIL_TRACE_CONCAT(vizRailTraceScope, __LINE__)(name)
+/// 记录所在作用域的耗时，并将耗时（纳秒）累加到计数器counter
+#define VIZRAIL_TRACE_TIMED(name, counter) \
+	const ::VizRailCore::TraceScope VIZRAIL_TRACE_CONCAT(vizRailTraceScope, __LINE__)( \
+		name, ::VizRailCore::TraceCounter::counter)
+/// 计数器counter增加value
+#define VIZRAIL_TRACE_COUNT(counter, value) \
+	::VizRailCore::Trace::Add(::VizRailCore::TraceCounter::counter, static_cast<uint64_t>(value))
+#else
+#define VIZRAIL_TRACE_SCOPE(name) ((void)0)
+#define VIZRAIL_TRACE_TIMED(name, counter) ((void)0)
+#define VIZRAIL_TRACE_COUNT(counter, value) ((void)0)
+#endif
+
+namespace VizRailCore
+{
+	enum class TraceCounter
+	{
+		/// 线元刷新次数
+		Refreshes,
+		/// 线元刷新累计耗时（纳秒）
+		RefreshNanoseconds,
+		/// 刷新中重新构造的线元数，形状未变而沿用原对象的线元不计
+		ElementsRebuilt,
+		/// 里程查询和空间查询次数
+		Queries,
+		/// 显示列表按线元缓存的命中次数
+		CacheHits,
+		/// 显示列表按线元缓存的未命中次数，即重新生成的线元片段数
+		CacheMisses,
+		/// 生成显示列表时离散出的多段线顶点数
+		TessellatedVertices,
+		Count
+	};
+
+	using TraceCounters = std::array<uint64_t, static_cast<size_t>(TraceCounter::Count)>;
+
+	/// 性能跟踪的查询与导出接口。计数器始终累计，计时事件只在StartRecording和StopRecording之间记录
+	class Trace
+	{
+	public:
+		/// 编译时是否启用了跟踪（VIZRAIL_ENABLE_TRACING）
+		[[nodiscard]] static bool IsCompiledIn();
+
+		/// 当前线程的计数器增加value
+		static void Add(TraceCounter counter, uint64_t value);
+
+		/// 所有线程（包括已退出的线程）的计数器之和
+		[[nodiscard]] static TraceCounters Counters();
+
+		static void ResetCounters();
+
+		/// 计数器名称，用于输出
+		[[nodiscard]] static const char* CounterName(TraceCounter counter);
+
+		/// 开始记录计时事件。每个线程最多保留MaxEventsPerThread个事件，超出的事件被丢弃
+		static void StartRecording();
+
+		static void StopRecording();
+
+		[[nodiscard]] static bool IsRecording();
+
+		/// 丢弃已记录的计时事件
+		static void ClearEvents();
+
+		/// \brief 以Chrome跟踪事件格式（chrome://tracing、Perfetto可直接打开）输出已记录的事件和当前计数器
+		static void WriteChromeTrace(std::ostream& stream);
+
+		/// \brief 同上，写入文件
+		static void SaveChromeTrace(const std::filesystem::path& path);
+
+		static constexpr size_t MaxEventsPerThread = 1 << 20;
+	};
+
+	/// 作用域计时器，由VIZRAIL_TRACE_SCOPE和VIZRAIL_TRACE_TIMED创建
+	class TraceScope
+	{
+	public:
+		explicit TraceScope(const char* name, TraceCounter elapsedCounter = TraceCounter::Count);
+
+		TraceScope(const TraceScope&) = delete;
+		TraceScope& operator=(const TraceScope&) = delete;
+
+		~TraceScope();
+
+	private:
+		const char* _name;
+		TraceCounter _elapsedCounter;
+		bool _recording = false;
+		std::chrono::steady_clock::time_point _start;
+	};
+}
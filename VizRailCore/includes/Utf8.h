@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace VizRailCore
+{
+	/// 非法序列解码后替换为的字符
+	constexpr char32_t ReplacementCharacter = 0xFFFD;
+
+	/// \brief 读取一个UTF-8编码的码点，position移到下一个码点。
+	/// 截断的序列、过长编码、代理项和超出U+10FFFF的码点都是非法序列
+	/// \return 非法序列时返回false，code为U+FFFD，position只移过首字节或已读取的续字节
+	bool DecodeUtf8(std::string_view text, size_t& position, char32_t& code);
+
+	/// \brief 追加一个码点的UTF-8编码，代理项和超出U+10FFFF的码点按U+FFFD编码
+	void AppendUtf8(std::string& output, char32_t code);
+
+	/// \brief 追加宽字符串的UTF-8编码。wchar_t在Windows上为UTF-16，合并其中的代理对，孤立的代理项按U+FFFD编码
+	void AppendUtf8(std::string& output, std::wstring_view text);
+
+	/// \brief 追加一个码点，wchar_t为UTF-16时超出基本多文种平面的码点写为代理对
+	void AppendWide(std::wstring& output, char32_t code);
+
+	[[nodiscard]] std::string ToUtf8(std::wstring_view text);
+
+	/// \brief UTF-8转宽字符串，非法序列按U+FFFD处理
+	[[nodiscard]] std::wstring FromUtf8(std::string_view text);
+
+	/// \brief UTF-8转宽字符串，遇到非法序列时返回false
+	bool TryFromUtf8(std::string_view text, std::wstring& result);
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include <string>
+
 #include "Angle.h"
 #include "Coordinate.h"
 
@@ -8,6 +10,9 @@ namespace VizRailCore
 
 	Angle GetAzimuthAngle(const Point2D point1, const Point2D point2);
 
+#ifdef _WIN32
+	/// 按系统代码页（ANSI）转换
 	std::wstring String2Wstring(const std::string& str);
+#endif
 
 }
@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "HorizontalAlignment.h"
+
+namespace VizRailCore
+{
+	/// 平面设计标准，取值为0的项不检查
+	struct DesignRules
+	{
+		/// 最小曲线半径
+		double MinRadius = 0.0;
+		/// 最小缓和曲线长
+		double MinTransitionLength = 0.0;
+		/// 最小圆曲线长
+		double MinCircularLength = 0.0;
+		/// 最小夹直线长
+		double MinIntermediateLength = 0.0;
+	};
+
+	/// 一条不满足设计标准的检查结果
+	struct ValidationIssue
+	{
+		/// 线元名，如“曲线3”“夹直线4”
+		std::wstring Element;
+		std::wstring Message;
+	};
+
+	/// \brief 按设计标准检查线路的曲线半径、缓和曲线长、圆曲线长和夹直线长，相邻曲线切线长之和超过交点间距时报告曲线重叠
+	/// \param alignment 已刷新的线路
+	/// \return 按线路顺序排列的检查结果，全部满足时为空
+	[[nodiscard]] std::vector<ValidationIssue> Validate(const HorizontalAlignment& alignment, const DesignRules& rules);
+}
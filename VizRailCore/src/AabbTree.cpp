@@ -0,0 +1,165 @@
+#include "AabbTree.h"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+using namespace VizRailCore;
+
+namespace
+{
+	// 叶节点最多容纳的包围盒数量
+	constexpr uint32_t LeafSize = 4;
+}
+
+AabbTree::AabbTree(const std::vector<BoundingBox>& boxes)
+{
+	Build(boxes);
+}
+
+void AabbTree::Build(const std::vector<BoundingBox>& boxes)
+{
+	Clear();
+	if (boxes.empty())
+	{
+		return;
+	}
+
+	_boxes = boxes;
+	_items.resize(boxes.size());
+	std::iota(_items.begin(), _items.end(), 0u);
+
+	std::vector<Point2D> centers;
+	centers.reserve(boxes.size());
+	for (const auto& box : boxes)
+	{
+		centers.push_back(box.Center());
+	}
+
+	_nodes.reserve(2 * (boxes.size() / LeafSize + 1));
+	BuildNode(centers, 0, static_cast<uint32_t>(_items.size()));
+}
+
+void AabbTree::Clear()
+{
+	_nodes.clear();
+	_items.clear();
+	_boxes.clear();
+}
+
+uint32_t AabbTree::BuildNode(std::vector<Point2D>& centers, const uint32_t begin, const uint32_t end)
+{
+	const auto index = static_cast<uint32_t>(_nodes.size());
+	_nodes.emplace_back();
+
+	BoundingBox box;
+	BoundingBox centerBox;
+	for (uint32_t i = begin; i < end; ++i)
+	{
+		box.Extend(_boxes[_items[i]]);
+		centerBox.Extend(centers[_items[i]]);
+	}
+	_nodes[index].Box = box;
+
+	if (end - begin <= LeafSize)
+	{
+		_nodes[index].Offset = begin;
+		_nodes[index].Count = end - begin;
+		return index;
+	}
+
+	// 沿中心点分布较宽的轴按中位数划分
+	const bool splitX = centerBox.Width() >= centerBox.Height();
+	const uint32_t mid = begin + (end - begin) / 2;
+	std::nth_element(_items.begin() + begin, _items.begin() + mid, _items.begin() + end,
+	                 [&centers, splitX](const uint32_t a, const uint32_t b)
+	                 {
+		                 return splitX ? centers[a].X() < centers[b].X() : centers[a].Y() < centers[b].Y();
+	                 });
+
+	BuildNode(centers, begin, mid);
+	const uint32_t right = BuildNode(centers, mid, end);
+	_nodes[index].Offset = right;
+	_nodes[index].Count = 0;
+	return index;
+}
+
+void AabbTree::Query(const BoundingBox& box, std::vector<size_t>& result) const
+{
+	result.clear();
+	if (_nodes.empty() || box.IsEmpty())
+	{
+		return;
+	}
+
+	uint32_t stack[MaxDepth];
+	size_t top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		const Node& node = _nodes[stack[--top]];
+		if (!node.Box.Intersects(box))
+		{
+			continue;
+		}
+		if (node.Count > 0)
+		{
+			for (uint32_t i = node.Offset; i < node.Offset + node.Count; ++i)
+			{
+				if (_boxes[_items[i]].Intersects(box))
+				{
+					result.push_back(_items[i]);
+				}
+			}
+			continue;
+		}
+		const auto current = static_cast<uint32_t>(&node - _nodes.data());
+		stack[top++] = node.Offset;
+		stack[top++] = current + 1;
+	}
+	std::sort(result.begin(), result.end());
+}
+
+void AabbTree::Query(const Ray2D& ray, std::vector<size_t>& result) const
+{
+	result.clear();
+	if (_nodes.empty())
+	{
+		return;
+	}
+
+	std::vector<std::pair<double, size_t>> hits;
+	uint32_t stack[MaxDepth];
+	size_t top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		const uint32_t current = stack[--top];
+		const Node& node = _nodes[current];
+		double t = 0.0;
+		if (!node.Box.Intersects(ray, t))
+		{
+			continue;
+		}
+		if (node.Count > 0)
+		{
+			for (uint32_t i = node.Offset; i < node.Offset + node.Count; ++i)
+			{
+				if (_boxes[_items[i]].Intersects(ray, t))
+				{
+					hits.emplace_back(t, _items[i]);
+				}
+			}
+			continue;
+		}
+		stack[top++] = node.Offset;
+		stack[top++] = current + 1;
+	}
+
+	std::sort(hits.begin(), hits.end());
+	result.reserve(hits.size());
+	for (const auto& [t, item] : hits)
+	{
+		result.push_back(item);
+	}
+}
@@ -0,0 +1,338 @@
+#include "AlignmentImage.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <string>
+
+#include "Curve.h"
+#include "Exceptions.h"
+#include "IntermediateLine.h"
+#include "Utils.h"
+
+using namespace VizRailCore;
+using namespace VizRailCore::AlignmentImage;
+
+namespace
+{
+	/// 各段在映像中的位置
+	struct Layout
+	{
+		Section Jds{};
+		Section Elements{};
+		Section MileageIndex{};
+		size_t Size = 0;
+	};
+
+	size_t AlignUp(const size_t value)
+	{
+		return (value + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+	}
+
+	Layout ComputeLayout(const size_t jdCount, const size_t elementCount)
+	{
+		Layout layout;
+		size_t offset = AlignUp(sizeof(Header));
+		const auto place = [&offset](Section& section, const size_t count, const size_t recordSize)
+		{
+			section = {offset, count};
+			offset = AlignUp(offset + count * recordSize);
+		};
+		place(layout.Jds, jdCount, sizeof(JdRecord));
+		place(layout.Elements, elementCount, sizeof(ElementRecord));
+		place(layout.MileageIndex, elementCount, sizeof(MileageIndexEntry));
+		layout.Size = offset;
+		return layout;
+	}
+
+	/// 与Mileage的比较相同，相差小于机器精度时视为相等
+	bool OnElement(const ElementRecord& element, const double mileage)
+	{
+		constexpr double epsilon = std::numeric_limits<double>::epsilon();
+		return (mileage >= element.StartMileage || std::abs(mileage - element.StartMileage) < epsilon) &&
+			(mileage <= element.EndMileage || std::abs(mileage - element.EndMileage) < epsilon);
+	}
+
+	template <typename T>
+	std::span<const T> SectionSpan(const std::span<const std::byte> image, const Section& section)
+	{
+		if (section.Offset % alignof(T) != 0 || section.Offset > image.size() ||
+			section.Count > (image.size() - section.Offset) / sizeof(T))
+		{
+			throw VizRailCoreException(L"线路映像的段越界");
+		}
+		return {reinterpret_cast<const T*>(image.data() + section.Offset), static_cast<size_t>(section.Count)};
+	}
+}
+
+JdRecord AlignmentImage::MakeJdRecord(const Jd& jd)
+{
+	return {jd.JdH, 0, jd.N, jd.E, jd.Angle, jd.R, jd.Ls, jd.TH, jd.LH, jd.LJzx, jd.StartMileage, jd.EndMileage};
+}
+
+ElementRecord AlignmentImage::MakeElementRecord(const LineElement& element)
+{
+	ElementRecord record{};
+	record.StartMileage = element.StartMileage().Value();
+	record.EndMileage = element.EndMileage().Value();
+	const BoundingBox bounds = element.Bounds();
+	record.MinX = bounds.Min().X();
+	record.MinY = bounds.Min().Y();
+	record.MaxX = bounds.Max().X();
+	record.MaxY = bounds.Max().Y();
+
+	if (const auto line = dynamic_cast<const IntermediateLine*>(&element))
+	{
+		record.Kind = ElementKind::Line;
+		record.StartX = line->StartPoint().X();
+		record.StartY = line->StartPoint().Y();
+		const double length = line->Length();
+		if (length > 0)
+		{
+			const auto [dx, dy] = line->EndPoint() - line->StartPoint();
+			record.StartCos = dx / length;
+			record.StartSin = dy / length;
+			record.StartAzimuth = GetAzimuthAngle(line->StartPoint(), line->EndPoint()).Radian();
+		}
+		return record;
+	}
+
+	const auto& curve = dynamic_cast<const Curve&>(element);
+	record.Kind = ElementKind::Curve;
+	const Angle aZH = GetAzimuthAngle(curve.Jd1(), curve.Jd2());
+	const Angle aHZ = GetAzimuthAngle(curve.Jd3(), curve.Jd2());
+	const double th = curve.T_H();
+	record.StartCos = Angle::Cos(aZH);
+	record.StartSin = Angle::Sin(aZH);
+	record.StartX = curve.Jd2().X() - th * record.StartCos;
+	record.StartY = curve.Jd2().Y() - th * record.StartSin;
+	record.StartAzimuth = aZH.Radian();
+	record.EndCos = Angle::Cos(aHZ);
+	record.EndSin = Angle::Sin(aHZ);
+	record.EndX = curve.Jd2().X() - th * record.EndCos;
+	record.EndY = curve.Jd2().Y() - th * record.EndSin;
+	record.EndAzimuth = GetAzimuthAngle(curve.Jd2(), curve.Jd3()).Radian();
+
+	const double r = curve.R();
+	const double ls = curve.Ls();
+	record.R = r;
+	record.Ls = ls;
+	record.Turn = curve.IsRightTurn() ? 1.0 : -1.0;
+	record.M = curve.m();
+	record.P = curve.P();
+	record.HyMileage = curve.K(SpecialPoint::HY).Value();
+	record.QzMileage = curve.K(SpecialPoint::QZ).Value();
+	record.YhMileage = curve.K(SpecialPoint::YH).Value();
+	if (ls > 0)
+	{
+		record.SpiralX = 1.0 / (40 * r * r * ls * ls);
+		record.SpiralY = 1.0 / (6 * r * ls);
+		record.SpiralAngle = 1.0 / (2 * r * ls);
+	}
+	return record;
+}
+
+StationFrame AlignmentImage::EvaluateElement(const ElementRecord& element, const double mileage)
+{
+	if (element.Kind == ElementKind::Line)
+	{
+		const double l = std::max(0.0, mileage - element.StartMileage);
+		return {
+			{element.StartX + element.StartCos * l, element.StartY + element.StartSin * l},
+			Angle::FromRadian(element.StartAzimuth)
+		};
+	}
+
+	// 前半段（含QZ点）到ZH点的曲线长，后半段到HZ点的曲线长
+	const bool front = mileage <= element.QzMileage;
+	const double l = std::max(0.0, front ? mileage - element.StartMileage : element.EndMileage - mileage);
+	double x;
+	double y;
+	double angle;
+	if (l < element.Ls)
+	{
+		const double l2 = l * l;
+		x = l - l2 * l2 * l * element.SpiralX;
+		y = l2 * l * element.SpiralY;
+		angle = l2 * element.SpiralAngle;
+	}
+	else
+	{
+		const double phi = (l - 0.5 * element.Ls) / element.R;
+		x = element.M + element.R * std::sin(phi);
+		y = element.P + element.R * (1 - std::cos(phi));
+		angle = (l - element.Ls) / element.R + element.Ls / (2 * element.R);
+	}
+	y *= element.Turn;
+
+	if (front)
+	{
+		return {
+			{
+				element.StartX + x * element.StartCos - y * element.StartSin,
+				element.StartY + x * element.StartSin + y * element.StartCos
+			},
+			Angle::FromRadian(element.StartAzimuth + element.Turn * angle)
+		};
+	}
+	return {
+		{element.EndX + x * element.EndCos + y * element.EndSin, element.EndY + x * element.EndSin - y * element.EndCos},
+		Angle::FromRadian(element.EndAzimuth - element.Turn * angle)
+	};
+}
+
+size_t VizRailCore::AlignmentImageSize(const HorizontalAlignment& alignment)
+{
+	return ComputeLayout(alignment.GetJds().Size(), alignment.GetXys().Size()).Size;
+}
+
+void VizRailCore::WriteAlignmentImage(const HorizontalAlignment& alignment, const std::span<std::byte> destination)
+{
+	const auto& jds = alignment.GetJds();
+	const auto& xys = alignment.GetXys();
+	const Layout layout = ComputeLayout(jds.Size(), xys.Size());
+	if (destination.size() < layout.Size)
+	{
+		throw VizRailCoreException(std::format(L"线路映像需要{}字节，目标只有{}字节", layout.Size, destination.size()));
+	}
+	if (reinterpret_cast<uintptr_t>(destination.data()) % alignof(ElementRecord) != 0)
+	{
+		throw VizRailCoreException(L"线路映像的目标地址未按8字节对齐");
+	}
+
+	std::byte* base = destination.data();
+	std::memset(base, 0, layout.Size);
+	const BoundingBox& extents = alignment.Extents();
+	const Header header{
+		Magic, Version, layout.Size, alignment.Revision(), layout.Jds, layout.Elements, layout.MileageIndex,
+		extents.Min().X(), extents.Min().Y(), extents.Max().X(), extents.Max().Y()
+	};
+	std::memcpy(base, &header, sizeof(header));
+
+	for (size_t i = 0; i < jds.Size(); ++i)
+	{
+		const JdRecord record = MakeJdRecord(jds[i]);
+		std::memcpy(base + layout.Jds.Offset + i * sizeof(JdRecord), &record, sizeof(record));
+	}
+
+	std::vector<MileageIndexEntry> index;
+	index.reserve(xys.Size());
+	for (size_t i = 0; i < xys.Size(); ++i)
+	{
+		const ElementRecord record = MakeElementRecord(*xys[i].Element);
+		std::memcpy(base + layout.Elements.Offset + i * sizeof(ElementRecord), &record, sizeof(record));
+		index.push_back({record.StartMileage, static_cast<uint32_t>(i), 0});
+	}
+	// 与HorizontalAlignment的里程索引相同，起点里程相同时保持线元顺序
+	std::ranges::stable_sort(index, {}, &MileageIndexEntry::StartMileage);
+	if (!index.empty())
+	{
+		std::memcpy(base + layout.MileageIndex.Offset, index.data(), index.size() * sizeof(MileageIndexEntry));
+	}
+}
+
+std::vector<std::byte> VizRailCore::BuildAlignmentImage(const HorizontalAlignment& alignment)
+{
+	std::vector<std::byte> image(AlignmentImageSize(alignment));
+	WriteAlignmentImage(alignment, image);
+	return image;
+}
+
+void VizRailCore::SaveAlignmentImage(const HorizontalAlignment& alignment, const std::filesystem::path& path)
+{
+	ReplaceFile(path, BuildAlignmentImage(alignment));
+}
+
+AlignmentImageView::AlignmentImageView(const std::span<const std::byte> image)
+{
+	if (image.size() < sizeof(Header))
+	{
+		throw VizRailCoreException(L"数据长度不足，不是线路映像");
+	}
+	if (reinterpret_cast<uintptr_t>(image.data()) % alignof(ElementRecord) != 0)
+	{
+		throw VizRailCoreException(L"线路映像未按8字节对齐");
+	}
+	_header = reinterpret_cast<const Header*>(image.data());
+	if (_header->Magic != Magic)
+	{
+		throw VizRailCoreException(L"数据不是线路映像");
+	}
+	if (_header->Version != Version)
+	{
+		throw VizRailCoreException(std::format(L"不支持版本{}的线路映像", _header->Version));
+	}
+	if (_header->Size > image.size())
+	{
+		throw VizRailCoreException(L"线路映像不完整");
+	}
+	const auto bytes = image.first(static_cast<size_t>(_header->Size));
+	_jds = SectionSpan<JdRecord>(bytes, _header->Jds);
+	_elements = SectionSpan<ElementRecord>(bytes, _header->Elements);
+	_mileageIndex = SectionSpan<MileageIndexEntry>(bytes, _header->MileageIndex);
+}
+
+BoundingBox AlignmentImageView::Extents() const
+{
+	if (_header->MinX > _header->MaxX || _header->MinY > _header->MaxY)
+	{
+		return {};
+	}
+	return {{_header->MinX, _header->MinY}, {_header->MaxX, _header->MaxY}};
+}
+
+std::vector<Jd> AlignmentImageView::CopyJds() const
+{
+	std::vector<Jd> jds;
+	jds.reserve(_jds.size());
+	for (const JdRecord& record : _jds)
+	{
+		jds.push_back({
+			record.JdH, record.N, record.E, record.Angle, record.R, record.Ls, record.TH, record.LH, record.LJzx,
+			record.StartMileage, record.EndMileage
+		});
+	}
+	return jds;
+}
+
+Point2D AlignmentImageView::MileageToCoordinate(const Mileage& mileage) const
+{
+	return MileageToFrame(mileage).Point;
+}
+
+StationFrame AlignmentImageView::MileageToFrame(const Mileage& mileage) const
+{
+	if (mileage < 0)
+	{
+		throw VizRailCoreException(L"里程值不能为负数");
+	}
+	const size_t index = FindElement(mileage.Value());
+	StationFrame frame = EvaluateElement(_elements[index], mileage.Value());
+	frame.Element = index;
+	return frame;
+}
+
+size_t AlignmentImageView::FindElement(const double mileage) const
+{
+	// 起点里程不大于mileage的最后一个线元，与HorizontalAlignment::FindElement相同
+	const auto next = std::upper_bound(_mileageIndex.begin(), _mileageIndex.end(), mileage,
+	                                   [](const double value, const MileageIndexEntry& entry)
+	                                   {
+		                                   return value < entry.StartMileage;
+	                                   });
+	if (next != _mileageIndex.begin())
+	{
+		const uint32_t index = std::prev(next)->Element;
+		if (index < _elements.size() && OnElement(_elements[index], mileage))
+		{
+			return index;
+		}
+	}
+	throw NotInLineException(L"该里程不在线路上");
+}
+
+MappedAlignmentFile::MappedAlignmentFile(const std::filesystem::path& path) : _file(path), _view(_file.Bytes())
+{
+}
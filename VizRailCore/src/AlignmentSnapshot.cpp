@@ -0,0 +1,41 @@
+#include "AlignmentSnapshot.h"
+
+#include "Exceptions.h"
+
+using namespace VizRailCore;
+
+AlignmentSnapshotPublisher::AlignmentSnapshotPublisher(HorizontalAlignment& alignment) : _alignment(alignment)
+{
+	Publish();
+	_observer = _alignment.AddObserver([this](const HorizontalAlignment&, const ChangeSet&)
+	{
+		Publish();
+	});
+}
+
+AlignmentSnapshotPublisher::~AlignmentSnapshotPublisher()
+{
+	_alignment.RemoveObserver(_observer);
+}
+
+void AlignmentSnapshotPublisher::Publish()
+{
+	if (_alignment.InEdit())
+	{
+		throw VizRailCoreException(L"编辑事务中不能发布快照");
+	}
+	// 副本与线路共享交点和线元的分块及不可变的线元状态，之后的修改只会替换线路自己的引用
+	_current.store(std::make_shared<const HorizontalAlignment>(_alignment), std::memory_order_release);
+}
+
+void AlignmentSnapshotPublisher::MemoryUsage(MemoryReport& report, std::unordered_set<const void*>& visited) const
+{
+	const AlignmentSnapshot snapshot = Current();
+	if (snapshot == nullptr || !visited.insert(snapshot.get()).second)
+	{
+		return;
+	}
+	// 快照对象与控制块由make_shared一次分配
+	report.Inputs += sizeof(HorizontalAlignment) + 2 * sizeof(void*);
+	snapshot->MemoryUsage(report, visited);
+}
@@ -0,0 +1,74 @@
+#include "BufferedFileWriter.h"
+
+#include <charconv>
+#include <cmath>
+#include <format>
+
+#include "Exceptions.h"
+
+using namespace VizRailCore;
+
+BufferedFileWriter::BufferedFileWriter(const std::filesystem::path& path) : _path(path),
+                                                                           _stream(path, std::ios::binary |
+                                                                                   std::ios::trunc)
+{
+	if (!_stream)
+	{
+		throw VizRailCoreException(std::format(L"无法创建文件{}", path.wstring()));
+	}
+	// 留出一条记录的余量，缓冲区在写满之前不重新分配
+	_buffer.reserve(FlushSize + 4096);
+}
+
+void BufferedFileWriter::Raw(const std::string_view text)
+{
+	_buffer += text;
+	FlushIfFull();
+}
+
+void BufferedFileWriter::Close()
+{
+	Flush();
+	_stream.close();
+	if (_stream.fail())
+	{
+		throw VizRailCoreException(std::format(L"写入文件{}失败", _path.wstring()));
+	}
+}
+
+void BufferedFileWriter::AppendReal(const double value)
+{
+	char text[400];
+	const auto result = std::to_chars(text, text + sizeof text, std::isfinite(value) ? value : 0.0,
+	                                  std::chars_format::fixed);
+	_buffer.append(text, result.ptr);
+}
+
+void BufferedFileWriter::AppendInteger(const int64_t value)
+{
+	char text[24];
+	const auto result = std::to_chars(text, text + sizeof text, value);
+	_buffer.append(text, result.ptr);
+}
+
+void BufferedFileWriter::AppendInteger(const uint64_t value)
+{
+	char text[24];
+	const auto result = std::to_chars(text, text + sizeof text, value);
+	_buffer.append(text, result.ptr);
+}
+
+void BufferedFileWriter::Overwrite(const size_t offset, const std::string_view text)
+{
+	Flush();
+	_stream.seekp(static_cast<std::streamoff>(offset));
+	_stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+	_stream.seekp(0, std::ios::end);
+}
+
+void BufferedFileWriter::Flush()
+{
+	_stream.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+	_written += _buffer.size();
+	_buffer.clear();
+}
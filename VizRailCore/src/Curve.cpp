@@ -2,6 +2,7 @@
 #include "Curve.h"
 
 #include <cmath>
+#include <numbers>
 #include <stdexcept>
 
 #include "Exceptions.h"
@@ -9,6 +10,26 @@
 
 using namespace VizRailCore;
 
+namespace
+{
+	/// \brief 将圆弧加入包围盒，圆弧经过的坐标轴方向（0、π/2、π、3π/2）上取得极值
+	/// \param start 圆弧起点相对圆心的方向角（弧度）
+	/// \param sweep 圆弧扫过的角度（弧度），正值为逆时针
+	void ExtendArc(BoundingBox& box, const Point2D& center, const double radius, const double start,
+	               const double sweep)
+	{
+		const double lo = std::min(start, start + sweep);
+		const double hi = std::max(start, start + sweep);
+		box.Extend({center.X() + radius * std::cos(lo), center.Y() + radius * std::sin(lo)});
+		box.Extend({center.X() + radius * std::cos(hi), center.Y() + radius * std::sin(hi)});
+		constexpr double quarter = std::numbers::pi / 2;
+		for (double k = std::ceil(lo / quarter); k * quarter <= hi; ++k)
+		{
+			box.Extend({center.X() + radius * std::cos(k * quarter), center.Y() + radius * std::sin(k * quarter)});
+		}
+	}
+}
+
 Curve::Curve(const Point2D jd1, const Point2D jd2, const Point2D jd3,
              const double R,
              const double Ls, const Mileage& jdMileage) :
@@ -257,6 +278,75 @@ Point2D Curve::SpecialPointCoordinate(const SpecialPoint specialPoint) const
 	return MileageToCoordinate(K(specialPoint));
 }
 
+BoundingBox Curve::Bounds() const
+{
+	const Point2D ZH = ZHFrameToGlobal(0.0, 0.0);
+	const Point2D HZ = HZFrameToGlobal(0.0, 0.0);
+	const double G = IsRightTurn() ? 1.0 : -1.0;
+
+	BoundingBox box(ZH, HZ);
+	if (_ls > 0)
+	{
+		// 缓和曲线局部坐标x、y随曲线长单调增加且y(x)下凸，曲线位于起点、终点及终点在切线上的投影构成的三角形内
+		const double xe = _ls - std::pow(_ls, 5) / (40 * _r * _r * _ls * _ls);
+		const double ye = std::pow(_ls, 3) / (6 * _r * _ls);
+		box.Extend(ZHFrameToGlobal(xe, 0.0));
+		box.Extend(ZHFrameToGlobal(xe, ye));
+		box.Extend(HZFrameToGlobal(xe, 0.0));
+		box.Extend(HZFrameToGlobal(xe, ye));
+	}
+
+	// 圆曲线局部坐标为圆心(m, P+R)加R(sin φ, -cos φ)，φ从HY点的Ls/2R变化到QZ点
+	const double phiHY = 0.5 * _ls / _r;
+	const double phiQZ = (L_H() / 2 - 0.5 * _ls) / _r;
+	constexpr double halfPi = std::numbers::pi / 2;
+	const Angle aZH = GetAzimuthAngle(_jd1, _jd2);
+	const Angle aHZ = GetAzimuthAngle(_jd3, _jd2);
+	ExtendArc(box, ArcCenter(), _r, aZH.Radian() + G * (phiHY - halfPi), G * (phiQZ - phiHY));
+	ExtendArc(box, HZFrameToGlobal(m(), P() + _r), _r, aHZ.Radian() - G * (phiQZ - halfPi), G * (phiQZ - phiHY));
+	return box;
+}
+
+Point2D Curve::ArcCenter() const
+{
+	return ZHFrameToGlobal(m(), P() + _r);
+}
+
+bool Curve::Equals(const LineElement& other) const
+{
+	return SameShape(other) && static_cast<const Curve&>(other)._jdMileage == _jdMileage;
+}
+
+bool Curve::SameShape(const LineElement& other) const
+{
+	const auto* curve = dynamic_cast<const Curve*>(&other);
+	return curve != nullptr && curve->_jd1 == _jd1 && curve->_jd2 == _jd2 && curve->_jd3 == _jd3 &&
+		curve->_r == _r && curve->_ls == _ls;
+}
+
+Point2D Curve::ZHFrameToGlobal(const double lx, const double ly) const
+{
+	// 与MileageToCoordinate相同的坐标转换，左转曲线局部y坐标取反
+	const Angle aZH = GetAzimuthAngle(_jd1, _jd2);
+	const double th = T_H();
+	const double y = IsRightTurn() ? ly : -ly;
+	return {
+		_jd2.X() - th * Angle::Cos(aZH) + lx * Angle::Cos(aZH) - y * Angle::Sin(aZH),
+		_jd2.Y() - th * Angle::Sin(aZH) + lx * Angle::Sin(aZH) + y * Angle::Cos(aZH)
+	};
+}
+
+Point2D Curve::HZFrameToGlobal(const double lx, const double ly) const
+{
+	const Angle aHZ = GetAzimuthAngle(_jd3, _jd2);
+	const double th = T_H();
+	const double y = IsRightTurn() ? ly : -ly;
+	return {
+		_jd2.X() - th * Angle::Cos(aHZ) + lx * Angle::Cos(aHZ) + y * Angle::Sin(aHZ),
+		_jd2.Y() - th * Angle::Sin(aHZ) + lx * Angle::Sin(aHZ) - y * Angle::Cos(aHZ)
+	};
+}
+
 Angle Curve::Alpha() const
 {
 	auto [dx1, dy1] = _jd2 - _jd1;
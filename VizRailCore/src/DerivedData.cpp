@@ -0,0 +1,166 @@
+#include "DerivedData.h"
+
+using namespace VizRailCore;
+
+DerivedDataEntry::~DerivedDataEntry()
+{
+	Withdraw();
+}
+
+void DerivedDataEntry::Admit(const size_t bytes)
+{
+	DerivedDataManager::Instance().Admit(*this, bytes);
+}
+
+void DerivedDataEntry::Touch()
+{
+	// 本项已是最近使用的一项时不推进时钟，多个线程反复使用同一项时不争用时钟
+	std::atomic<uint64_t>& clock = DerivedDataManager::Instance()._clock;
+	if (_lastUse.load(std::memory_order_relaxed) != clock.load(std::memory_order_relaxed))
+	{
+		_lastUse.store(clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+	_hits.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DerivedDataEntry::Withdraw()
+{
+	DerivedDataManager::Instance().Withdraw(*this);
+}
+
+DerivedDataManager& DerivedDataManager::Instance()
+{
+	static DerivedDataManager* instance = new DerivedDataManager();
+	return *instance;
+}
+
+void DerivedDataManager::SetBudget(const size_t bytes)
+{
+	std::lock_guard lock(_mutex);
+	_budget = bytes;
+	if (_budget > 0)
+	{
+		EvictTo(_budget, nullptr);
+	}
+}
+
+size_t DerivedDataManager::Budget() const
+{
+	std::lock_guard lock(_mutex);
+	return _budget;
+}
+
+DerivedDataStatistics DerivedDataManager::Stats() const
+{
+	std::lock_guard lock(_mutex);
+	DerivedDataStatistics stats{_hits, _misses, _evictions, _entries, _bytes, _budget};
+	for (const DerivedDataEntry* entry = _head; entry != nullptr; entry = entry->_next)
+	{
+		stats.Hits += entry->_hits.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+void DerivedDataManager::ResetStats()
+{
+	std::lock_guard lock(_mutex);
+	_hits = 0;
+	_misses = 0;
+	_evictions = 0;
+	for (DerivedDataEntry* entry = _head; entry != nullptr; entry = entry->_next)
+	{
+		entry->_hits.store(0, std::memory_order_relaxed);
+	}
+}
+
+void DerivedDataManager::EvictAll()
+{
+	std::lock_guard lock(_mutex);
+	EvictTo(0, nullptr);
+}
+
+void DerivedDataManager::Admit(DerivedDataEntry& entry, const size_t bytes)
+{
+	std::lock_guard lock(_mutex);
+	++_misses;
+	if (entry._linked)
+	{
+		_bytes -= entry._bytes;
+		Detach(entry);
+	}
+	else
+	{
+		entry._linked = true;
+		++_entries;
+	}
+	PushFront(entry);
+	entry._bytes = bytes;
+	_bytes += bytes;
+	const uint64_t stamp = _clock.fetch_add(1, std::memory_order_relaxed) + 1;
+	entry._lastUse.store(stamp, std::memory_order_relaxed);
+	entry._linkedAt = stamp;
+	if (_budget > 0 && _bytes > _budget)
+	{
+		EvictTo(_budget, &entry);
+	}
+}
+
+void DerivedDataManager::Withdraw(DerivedDataEntry& entry)
+{
+	std::lock_guard lock(_mutex);
+	if (entry._linked)
+	{
+		Unlink(entry);
+	}
+}
+
+void DerivedDataManager::PushFront(DerivedDataEntry& entry)
+{
+	entry._previous = nullptr;
+	entry._next = _head;
+	(_head != nullptr ? _head->_previous : _tail) = &entry;
+	_head = &entry;
+}
+
+void DerivedDataManager::Detach(DerivedDataEntry& entry)
+{
+	(entry._previous != nullptr ? entry._previous->_next : _head) = entry._next;
+	(entry._next != nullptr ? entry._next->_previous : _tail) = entry._previous;
+	entry._previous = nullptr;
+	entry._next = nullptr;
+}
+
+void DerivedDataManager::Unlink(DerivedDataEntry& entry)
+{
+	Detach(entry);
+	entry._linked = false;
+	--_entries;
+	_bytes -= entry._bytes;
+	entry._bytes = 0;
+	// 不再驻留的项的命中数并入管理器，统计不因淘汰或析构而减少
+	_hits += entry._hits.exchange(0, std::memory_order_relaxed);
+}
+
+void DerivedDataManager::EvictTo(const size_t budget, const DerivedDataEntry* keep)
+{
+	// 每项至多因被使用过移到表头一次，keep每轮至多移动一次，步数有上限，
+	// 其他线程同时使用时可能提前结束而略超预算，由下一次Admit继续淘汰
+	size_t steps = 2 * _entries;
+	while (_bytes > budget && _tail != nullptr && steps-- > 0)
+	{
+		DerivedDataEntry& entry = *_tail;
+		if (&entry == keep || (budget > 0 && entry._lastUse.load(std::memory_order_relaxed) != entry._linkedAt))
+		{
+			// 移到表头后又被使用过的项获得第二次机会，重新记录时间，之后使用其他项时推进时钟
+			const uint64_t stamp = _clock.fetch_add(1, std::memory_order_relaxed) + 1;
+			entry._lastUse.store(stamp, std::memory_order_relaxed);
+			entry._linkedAt = stamp;
+			Detach(entry);
+			PushFront(entry);
+			continue;
+		}
+		Unlink(entry);
+		entry.Release();
+		++_evictions;
+	}
+}
@@ -0,0 +1,523 @@
+#include "DisplayListBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+
+#include "Curve.h"
+#include "IntermediateLine.h"
+#include "Trace.h"
+
+using namespace VizRailCore;
+
+namespace
+{
+	// 与原AutoCAD实体绘制保持一致的样式
+	constexpr DisplayStyle LineStyle = {3, 50};
+	constexpr DisplayStyle TransitionStyle = {2, 50};
+	constexpr DisplayStyle ArcStyle = {1, 50};
+	constexpr DisplayStyle MarkStyle = {3, 15};
+	constexpr DisplayStyle JdMarkStyle = {0, 25};
+	constexpr DisplayStyle JdStyle = {3, 25};
+	constexpr double TextHeight = 7.0;
+	constexpr double MarkLength = 10.0;
+	constexpr double JdRadius = 2.0;
+	constexpr double JdMarkOffset = 80.0;
+	// 多行标注的行距（倍字高）
+	constexpr double LineSpacing = 1.5;
+	// 避让网格边长，与百米标文字框尺寸相当
+	constexpr double LabelCellSize = 4 * TextHeight;
+
+	// 细节层级阈值（像素）
+	// 弦高容差取半个像素，离散误差不可见
+	constexpr double ChordTolerancePixels = 0.5;
+	// 相邻刻度的最小屏幕间距，小于该值时刻度线会挤在一起
+	constexpr double MinTickSpacingPixels = 12.0;
+	// 刻度线与交点圆圈的最小屏幕长度，小于该值时只剩一个点
+	constexpr double MinMarkPixels = 0.5;
+	// 文字的最小屏幕高度，小于该值时文字无法辨认
+	constexpr double MinTextPixels = 3.0;
+	// 里程刻度最大间隔，再大时不绘制刻度
+	constexpr int MaxTickInterval = 100000;
+
+	// 比例尺层级范围，超出范围的比例尺按边界层级处理
+	constexpr int MinLevel = -10;
+	constexpr int MaxLevel = 24;
+
+	/// \brief 刻度线文字的候选基线
+	/// \param point 刻度所在线路上的点
+	/// \param nx,ny 线路右侧单位法向
+	std::vector<LabelCandidate> MarkCandidates(const Point2D& point, const double nx, const double ny)
+	{
+		// 沿线前进方向
+		const double tx = -ny;
+		const double ty = nx;
+		// 依次尝试刻度端点处、向后错开一个字高、线路左侧对称位置及其错开位置
+		return {
+			{{point.X() + nx * MarkLength, point.Y() + ny * MarkLength}, nx, ny},
+			{{point.X() + nx * MarkLength - tx * TextHeight, point.Y() + ny * MarkLength - ty * TextHeight}, nx, ny},
+			{{point.X() - nx * MarkLength, point.Y() - ny * MarkLength}, -nx, -ny},
+			{{point.X() - nx * MarkLength + tx * TextHeight, point.Y() - ny * MarkLength + ty * TextHeight}, -nx, -ny},
+		};
+	}
+}
+
+DisplayDetail DisplayDetail::FromUnitsPerPixel(const double unitsPerPixel)
+{
+	DisplayDetail detail;
+	detail.ChordTolerance = ChordTolerancePixels * unitsPerPixel;
+
+	detail.SpecialPointMarks = MarkLength / unitsPerPixel >= MinMarkPixels;
+	detail.TickInterval = 0;
+	if (detail.SpecialPointMarks)
+	{
+		// 百米标重叠时只保留公里标，依此类推
+		for (int interval = 100; interval <= MaxTickInterval; interval *= 10)
+		{
+			if (interval / unitsPerPixel >= MinTickSpacingPixels)
+			{
+				detail.TickInterval = interval;
+				break;
+			}
+		}
+	}
+
+	const bool readable = TextHeight / unitsPerPixel >= MinTextPixels;
+	detail.TickLabels = readable && detail.TickInterval > 0;
+	detail.SpecialPointLabels = readable;
+	return detail;
+}
+
+int DisplayDetail::LevelOf(const double unitsPerPixel)
+{
+	if (!(unitsPerPixel > 0.0))
+	{
+		return MinLevel;
+	}
+	return std::clamp(static_cast<int>(std::ceil(std::log2(unitsPerPixel))), MinLevel, MaxLevel);
+}
+
+double DisplayDetail::UnitsPerPixelOf(const int level)
+{
+	return std::ldexp(1.0, level);
+}
+
+size_t DisplayListBuilder::Update(const HorizontalAlignment& alignment)
+{
+	DropEvicted();
+	return Update(alignment, _levels[FullDetailLevel]);
+}
+
+size_t DisplayListBuilder::Update(const HorizontalAlignment& alignment, const double unitsPerPixel)
+{
+	DropEvicted();
+	const int number = DisplayDetail::LevelOf(unitsPerPixel);
+	auto [it, inserted] = _levels.try_emplace(number);
+	if (inserted)
+	{
+		// 按层级内最粗的比例尺取细节参数，保证层级内任一比例尺下误差都不超过阈值
+		it->second.Detail = DisplayDetail::FromUnitsPerPixel(DisplayDetail::UnitsPerPixelOf(number));
+	}
+	return Update(alignment, it->second);
+}
+
+size_t DisplayListBuilder::Update(const HorizontalAlignment& alignment, Level& level)
+{
+	auto data = level.Cache.Data();
+	if (data != nullptr && data->Revision != 0 && data->Revision == alignment.Revision())
+	{
+		level.Cache.Touch();
+		_current = std::move(data);
+		return 0;
+	}
+	VIZRAIL_TRACE_SCOPE("DisplayListBuilder::Update");
+
+	if (data == nullptr)
+	{
+		data = std::make_shared<LevelData>();
+		data->Detail = level.Detail;
+	}
+	const auto& xys = alignment.GetXys();
+
+	size_t rebuilt = 0;
+	std::map<std::wstring, Entry> entries;
+	data->Fragments.clear();
+	data->Fragments.reserve(xys.Size() + 1);
+	for (const auto& xy : xys)
+	{
+		if (auto node = data->Entries.extract(xy.Key); !node.empty() && node.mapped().Revision == xy.Revision)
+		{
+			entries.insert(std::move(node));
+			VIZRAIL_TRACE_COUNT(CacheHits, 1);
+		}
+		else
+		{
+			entries.insert_or_assign(xy.Key, Entry{xy.Revision, BuildElement(xy.Element, data->Detail)});
+			++rebuilt;
+			VIZRAIL_TRACE_COUNT(CacheMisses, 1);
+		}
+		data->Fragments.push_back(entries.at(xy.Key).List);
+	}
+	data->Fragments.push_back(BuildJds(alignment.GetJds(), data->Detail));
+	data->Labels = PlaceLabels(data->Fragments);
+
+	data->Entries.swap(entries);
+	data->Revision = alignment.Revision();
+	std::unordered_set<const void*> visited;
+	const size_t bytes = MemoryUsage(*data, visited);
+	level.Cache.Store(data);
+	_current = std::move(data);
+	level.Cache.Admit(bytes);
+	return rebuilt;
+}
+
+std::shared_ptr<const DisplayList> DisplayListBuilder::PlaceLabels(
+	const std::vector<std::shared_ptr<const DisplayList>>& fragments)
+{
+	VIZRAIL_TRACE_SCOPE("DisplayListBuilder::PlaceLabels");
+	std::vector<const DisplayLabel*> labels;
+	std::vector<LabelRequest> requests;
+	for (const auto& fragment : fragments)
+	{
+		for (const auto& label : fragment->Labels)
+		{
+			labels.push_back(&label);
+			requests.push_back(label.Request);
+		}
+	}
+
+	LabelPlacer placer(LabelCellSize);
+	const auto placement = placer.Place(requests);
+
+	auto result = std::make_shared<DisplayList>();
+	result->Texts.reserve(placer.Size());
+	for (size_t i = 0; i < labels.size(); ++i)
+	{
+		if (placement[i] < 0)
+		{
+			continue;
+		}
+		// 候选位置为文字框左下角，还原为各行文字的基线起点
+		const DisplayLabel& label = *labels[i];
+		const LabelCandidate& candidate = label.Request.Candidates[placement[i]];
+		const double upX = -candidate.DirectionY;
+		const double upY = candidate.DirectionX;
+		for (size_t line = 0; line < label.Lines.size(); ++line)
+		{
+			const double offset = LineSpacing * label.TextHeight * static_cast<double>(label.Lines.size() - 1 - line);
+			result->Texts.push_back({
+				label.Style, {candidate.Position.X() + upX * offset, candidate.Position.Y() + upY * offset},
+				candidate.DirectionX, candidate.DirectionY, label.TextHeight, label.Lines[line]
+			});
+		}
+	}
+	return result;
+}
+
+const DisplayListBuilder::LevelData& DisplayListBuilder::Current() const
+{
+	static const LevelData Empty;
+	return _current == nullptr ? Empty : *_current;
+}
+
+void DisplayListBuilder::DropEvicted()
+{
+	std::erase_if(_levels, [](const auto& item)
+	{
+		return item.second.Cache.Data() == nullptr;
+	});
+}
+
+void DisplayListBuilder::Clear()
+{
+	_levels.clear();
+	_current.reset();
+}
+
+void DisplayListBuilder::MemoryUsage(MemoryReport& report, std::unordered_set<const void*>& visited) const
+{
+	// std::map的节点按左右子节点、父节点指针和颜色估算，make_shared的控制块按两个指针估算
+	constexpr size_t MapNode = 4 * sizeof(void*);
+	constexpr size_t ControlBlock = 2 * sizeof(void*);
+	const auto dataUsage = [&visited](const LevelData* data) -> size_t
+	{
+		if (data == nullptr || !visited.insert(data).second)
+		{
+			return 0;
+		}
+		return ControlBlock + sizeof(LevelData) + MemoryUsage(*data, visited);
+	};
+	for (const auto& [number, level] : _levels)
+	{
+		report.DisplayCaches += MapNode + sizeof(std::pair<const int, Level>) + dataUsage(level.Cache.Data().get());
+	}
+	// 已被淘汰但仍由生成器持有的当前层级
+	report.DisplayCaches += dataUsage(_current.get());
+}
+
+size_t DisplayListBuilder::MemoryUsage(const LevelData& data, std::unordered_set<const void*>& visited)
+{
+	// std::map的节点按左右子节点、父节点指针和颜色估算，make_shared的控制块按两个指针估算
+	constexpr size_t MapNode = 4 * sizeof(void*);
+	constexpr size_t ControlBlock = 2 * sizeof(void*);
+	const auto listUsage = [&visited](const std::shared_ptr<const DisplayList>& list) -> size_t
+	{
+		if (list == nullptr || !visited.insert(list.get()).second)
+		{
+			return 0;
+		}
+		return ControlBlock + sizeof(DisplayList) + list->MemoryUsage();
+	};
+
+	size_t bytes = 0;
+	for (const auto& [key, entry] : data.Entries)
+	{
+		bytes += MapNode + sizeof(std::pair<const std::wstring, Entry>) + StringHeapBytes(key) + listUsage(entry.List);
+	}
+	bytes += data.Fragments.capacity() * sizeof(std::shared_ptr<const DisplayList>);
+	for (const auto& fragment : data.Fragments)
+	{
+		bytes += listUsage(fragment);
+	}
+	bytes += listUsage(data.Labels);
+	return bytes;
+}
+
+std::shared_ptr<const DisplayList> DisplayListBuilder::BuildElement(const std::shared_ptr<LineElement>& element,
+                                                                    const DisplayDetail& detail)
+{
+	auto list = std::make_shared<DisplayList>();
+	if (const auto jzx = std::dynamic_pointer_cast<IntermediateLine>(element))
+	{
+		AddIntermediateLine(*list, *jzx, detail);
+	}
+	else if (const auto qx = std::dynamic_pointer_cast<Curve>(element))
+	{
+		AddCurve(*list, *qx, detail);
+		if (detail.SpecialPointLabels)
+		{
+			AddJdMark(*list, *qx);
+		}
+	}
+#ifdef VIZRAIL_ENABLE_TRACING
+	for (const auto& polyline : list->Polylines)
+	{
+		VIZRAIL_TRACE_COUNT(TessellatedVertices, polyline.Points.size());
+	}
+#endif
+	return list;
+}
+
+std::shared_ptr<const DisplayList> DisplayListBuilder::BuildJds(const PersistentVector<Jd>& jds,
+                                                                const DisplayDetail& detail)
+{
+	auto list = std::make_shared<DisplayList>();
+	DisplayPolyline polyline{JdStyle, {}};
+	polyline.Points.reserve(jds.Size());
+	size_t i = 0;
+	for (const auto& jd : jds)
+	{
+		const Point2D point = {jd.E, jd.N};
+		if (detail.SpecialPointMarks)
+		{
+			list->Circles.push_back({JdStyle, point, JdRadius});
+		}
+		if (detail.SpecialPointLabels)
+		{
+			// 依次尝试交点右侧、左侧、上方、下方
+			const std::wstring text = std::format(L"  JD{}", i);
+			const double width = LabelPlacer::EstimateWidth(text, TextHeight);
+			AddLabel(*list, JdStyle, LabelPriority::Jd, {text}, {
+				         {point, 1.0, 0.0},
+				         {{point.X() - width, point.Y()}, 1.0, 0.0},
+				         {{point.X(), point.Y() + TextHeight}, 1.0, 0.0},
+				         {{point.X(), point.Y() - 2 * TextHeight}, 1.0, 0.0},
+			         });
+		}
+		polyline.Points.push_back(point);
+		++i;
+	}
+	list->Polylines.push_back(std::move(polyline));
+	return list;
+}
+
+std::shared_ptr<const DisplayList> DisplayListBuilder::BuildCenterline(const std::span<const CenterlinePoint> points)
+{
+	auto list = std::make_shared<DisplayList>();
+	DisplayPolyline polyline{LineStyle, {}};
+	polyline.Points.reserve(points.size());
+	for (const CenterlinePoint& point : points)
+	{
+		polyline.Points.push_back({point.X, point.Y});
+	}
+	list->Polylines.push_back(std::move(polyline));
+	return list;
+}
+
+void DisplayListBuilder::AddIntermediateLine(DisplayList& list, const IntermediateLine& jzx,
+                                             const DisplayDetail& detail)
+{
+	list.Polylines.push_back({LineStyle, {jzx.StartPoint(), jzx.EndPoint()}});
+	AddHectoMeter(list, jzx, jzx.StartMileage().Value(), jzx.EndMileage().Value(), detail);
+}
+
+void DisplayListBuilder::AddCurve(DisplayList& list, const Curve& qx, const DisplayDetail& detail)
+{
+	const auto mileageZH = qx.K(SpecialPoint::ZH);
+	const auto mileageHY = qx.K(SpecialPoint::HY);
+	const auto mileageYH = qx.K(SpecialPoint::YH);
+	const auto mileageHZ = qx.K(SpecialPoint::HZ);
+	const auto ZH = qx.MileageToCoordinate(mileageZH);
+	const auto HY = qx.MileageToCoordinate(mileageHY);
+	const auto YH = qx.MileageToCoordinate(mileageYH);
+	const auto HZ = qx.MileageToCoordinate(mileageHZ);
+
+	// 前缓和曲线
+	DisplayPolyline transition1{TransitionStyle, {}};
+	AddTransition(transition1, qx, mileageZH.Value(), mileageHY.Value(), detail);
+	transition1.Points.push_back(HY);
+	list.Polylines.push_back(std::move(transition1));
+
+	// 圆曲线部分直接输出圆弧
+	const Point2D center = qx.ArcCenter();
+	const double G = qx.IsRightTurn() ? 1.0 : -1.0;
+	list.Arcs.push_back({
+		ArcStyle, center, qx.R(), std::atan2(HY.Y() - center.Y(), HY.X() - center.X()),
+		G * (qx.L_H() - 2 * qx.Ls()) / qx.R()
+	});
+
+	// 后缓和曲线
+	DisplayPolyline transition2{TransitionStyle, {}};
+	AddTransition(transition2, qx, mileageYH.Value(), mileageHZ.Value(), detail);
+	transition2.Points.push_back(HZ);
+	list.Polylines.push_back(std::move(transition2));
+
+	AddHectoMeter(list, qx, mileageZH.Value(), mileageHZ.Value(), detail);
+	AddMileageMark(list, ZH, qx.MileageToAzimuthAngle(mileageZH), std::format(L" ZH {}", mileageZH.GetString()),
+	               detail);
+	AddMileageMark(list, HY, qx.MileageToAzimuthAngle(mileageHY), std::format(L" HY {}", mileageHY.GetString()),
+	               detail);
+	AddMileageMark(list, YH, qx.MileageToAzimuthAngle(mileageYH), std::format(L" YH {}", mileageYH.GetString()),
+	               detail);
+	AddMileageMark(list, HZ, qx.MileageToAzimuthAngle(mileageHZ), std::format(L" HZ {}", mileageHZ.GetString()),
+	               detail);
+}
+
+void DisplayListBuilder::AddTransition(DisplayPolyline& polyline, const Curve& qx, const double startMileage,
+                                       const double endMileage, const DisplayDetail& detail)
+{
+	// 缓和曲线曲率不超过1/R，步长s对应的弦高不超过s^2/(8R)，据此由弦高容差反算步长
+	double step = 1.0;
+	if (detail.ChordTolerance > 0.0)
+	{
+		step = std::clamp(std::sqrt(8.0 * detail.ChordTolerance * qx.R()), 1.0,
+		                  std::max(endMileage - startMileage, 1.0));
+	}
+	const auto count = static_cast<size_t>(std::ceil((endMileage - startMileage) / step));
+	polyline.Points.reserve(polyline.Points.size() + count + 1);
+	for (double j = startMileage; j < endMileage; j += step)
+	{
+		polyline.Points.push_back(qx.MileageToCoordinate(j));
+	}
+}
+
+void DisplayListBuilder::AddHectoMeter(DisplayList& list, const LineElement& line, const double startMileage,
+                                       const double endMileage, const DisplayDetail& detail)
+{
+	const int interval = detail.TickInterval;
+	if (interval <= 0)
+	{
+		return;
+	}
+	for (int i = (static_cast<int>(startMileage) / interval + 1) * interval; i < endMileage; i += interval)
+	{
+		const auto coordinate = line.MileageToCoordinate(i);
+		const auto azimuthAngle = line.MileageToAzimuthAngle(i);
+		const double dx = MarkLength * Angle::Cos(azimuthAngle - Angle::HalfPi());
+		const double dy = MarkLength * Angle::Sin(azimuthAngle - Angle::HalfPi());
+		const Point2D end = {coordinate.X() + dx, coordinate.Y() + dy};
+		list.Polylines.push_back({MarkStyle, {coordinate, end}});
+		if (!detail.TickLabels)
+		{
+			continue;
+		}
+		if (i % 1000 == 0)
+		{
+			const Mileage mileage(i);
+			AddLabel(list, MarkStyle, LabelPriority::Kilometre, {std::format(L"  {} {}", mileage.Prefix(), i / 1000)},
+			         MarkCandidates(coordinate, dx / MarkLength, dy / MarkLength));
+		}
+		else
+		{
+			AddLabel(list, MarkStyle, LabelPriority::Hectometre, {std::format(L"  {}", (i / 100) % 10)},
+			         MarkCandidates(coordinate, dx / MarkLength, dy / MarkLength));
+		}
+	}
+}
+
+void DisplayListBuilder::AddMileageMark(DisplayList& list, const Point2D& point, const Angle& azimuthAngle,
+                                        const std::wstring& text, const DisplayDetail& detail)
+{
+	if (!detail.SpecialPointMarks)
+	{
+		return;
+	}
+	const double dx = MarkLength * Angle::Cos(azimuthAngle - Angle::HalfPi());
+	const double dy = MarkLength * Angle::Sin(azimuthAngle - Angle::HalfPi());
+	const Point2D end = {point.X() + dx, point.Y() + dy};
+	list.Polylines.push_back({MarkStyle, {point, end}});
+	if (detail.SpecialPointLabels)
+	{
+		AddLabel(list, MarkStyle, LabelPriority::SpecialPoint, {text},
+		         MarkCandidates(point, dx / MarkLength, dy / MarkLength));
+	}
+}
+
+void DisplayListBuilder::AddJdMark(DisplayList& list, const Curve& qx)
+{
+	const auto mileageQZ = qx.K(SpecialPoint::QZ);
+	const auto aQZ = qx.MileageToAzimuthAngle(mileageQZ);
+	const auto jd = qx.Jd2();
+	// n为曲中点处线路右侧法向，t为前进方向
+	const double nx = Angle::Cos(aQZ - Angle::HalfPi());
+	const double ny = Angle::Sin(aQZ - Angle::HalfPi());
+	const double tx = Angle::Cos(aQZ);
+	const double ty = Angle::Sin(aQZ);
+	const auto at = [&jd](const double x, const double y) { return Point2D{jd.X() + x, jd.Y() + y}; };
+
+	// 依次尝试交点右侧、右侧更远处、左侧、左侧更远处；右侧文字逆行书写，左侧文字顺行书写，均背离交点展开
+	AddLabel(list, JdMarkStyle, LabelPriority::Jd, {
+		         std::format(L"R={:.6f}  Ls={:.6f}", qx.R(), qx.Ls()),
+		         std::format(L"L={:.6f}  T={:.6f}", qx.L_H(), qx.T_H())
+	         }, {
+		         {at(JdMarkOffset * nx, JdMarkOffset * ny), -tx, -ty},
+		         {at(2 * JdMarkOffset * nx, 2 * JdMarkOffset * ny), -tx, -ty},
+		         {at(-JdMarkOffset * nx, -JdMarkOffset * ny), tx, ty},
+		         {at(-2 * JdMarkOffset * nx, -2 * JdMarkOffset * ny), tx, ty},
+	         });
+}
+
+void DisplayListBuilder::AddLabel(DisplayList& list, const DisplayStyle& style, const LabelPriority priority,
+                                  std::vector<std::wstring> lines, const std::vector<LabelCandidate>& baselines)
+{
+	DisplayLabel label{style, TextHeight, std::move(lines), {priority, 0.0, 0.0, {}}};
+	for (const auto& line : label.Lines)
+	{
+		label.Request.Width = std::max(label.Request.Width, LabelPlacer::EstimateWidth(line, TextHeight));
+	}
+	// 文字框自末行基线起向上覆盖全部行
+	const double descent = LineSpacing * TextHeight * static_cast<double>(label.Lines.size() - 1);
+	label.Request.Height = TextHeight + descent;
+	label.Request.Candidates.reserve(baselines.size());
+	for (const auto& baseline : baselines)
+	{
+		label.Request.Candidates.push_back({
+			{
+				baseline.Position.X() + baseline.DirectionY * descent,
+				baseline.Position.Y() - baseline.DirectionX * descent
+			},
+			baseline.DirectionX, baseline.DirectionY
+		});
+	}
+	list.Labels.push_back(std::move(label));
+}
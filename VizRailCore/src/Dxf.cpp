@@ -0,0 +1,873 @@
+#include "Dxf.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <format>
+#include <numbers>
+#include <optional>
+#include <string_view>
+#include <tuple>
+
+#include "BufferedFileWriter.h"
+#include "DisplayListBuilder.h"
+#include "Exceptions.h"
+#include "MappedFile.h"
+
+using namespace VizRailCore;
+
+namespace
+{
+	constexpr double DegreesPerRadian = 180.0 / std::numbers::pi;
+	// $HANDSEED占位值的位数，写完后回填
+	constexpr size_t HandleSeedDigits = 16;
+
+	std::string Hex(uint64_t value)
+	{
+		char text[16];
+		const auto result = std::to_chars(text, text + sizeof text, value, 16);
+		std::string hex(text, result.ptr);
+		std::ranges::transform(hex, hex.begin(), [](const char c)
+		{
+			return c >= 'a' && c <= 'f' ? static_cast<char>(c - 'a' + 'A') : c;
+		});
+		return hex;
+	}
+
+	/// ASCII字符原样输出，其余字符写为\U+XXXX，控制字符替换为空格
+	std::string Escape(const std::wstring_view text)
+	{
+		std::string result;
+		result.reserve(text.size());
+		for (const wchar_t c : text)
+		{
+			const auto code = static_cast<uint32_t>(c);
+			if (code < 0x20 || code == 0x7F)
+			{
+				result.push_back(' ');
+			}
+			else if (code < 0x7F)
+			{
+				result.push_back(static_cast<char>(code));
+			}
+			else if (code > 0xFFFF || (code >= 0xD800 && code <= 0xDFFF))
+			{
+				// \U+只能表示基本多文种平面的字符
+				result.push_back('?');
+			}
+			else
+			{
+				const std::string hex = Hex(code);
+				result += "\\U+";
+				result.append(4 - hex.size(), '0');
+				result += hex;
+			}
+		}
+		return result;
+	}
+
+	/// 组码和值各占一行的DXF输出流，句柄按写出顺序分配
+	class DxfStream final : public BufferedFileWriter
+	{
+	public:
+		using BufferedFileWriter::BufferedFileWriter;
+
+		void Text(const int code, const std::string_view value)
+		{
+			Code(code);
+			_buffer += value;
+			_buffer += "\r\n";
+			FlushIfFull();
+		}
+
+		void String(const int code, const std::wstring_view value)
+		{
+			Text(code, Escape(value));
+		}
+
+		void Real(const int code, const double value)
+		{
+			Code(code);
+			AppendReal(value);
+			_buffer += "\r\n";
+			FlushIfFull();
+		}
+
+		void Integer(const int code, const int64_t value)
+		{
+			Code(code);
+			AppendInteger(value);
+			_buffer += "\r\n";
+			FlushIfFull();
+		}
+
+		void Handle(const int code, const uint64_t handle)
+		{
+			Text(code, Hex(handle));
+		}
+
+		[[nodiscard]] uint64_t NewHandle()
+		{
+			return _nextHandle++;
+		}
+
+		/// 写出$HANDSEED的占位值，Close时回填为下一个未使用的句柄
+		void HandleSeed()
+		{
+			Code(5);
+			_seedOffset = Offset();
+			_buffer.append(HandleSeedDigits, '0');
+			_buffer += "\r\n";
+		}
+
+		void Close()
+		{
+			if (_seedOffset != NoSeed)
+			{
+				const std::string hex = Hex(_nextHandle);
+				Overwrite(_seedOffset, std::string(HandleSeedDigits - hex.size(), '0') + hex);
+			}
+			BufferedFileWriter::Close();
+		}
+
+	private:
+		static constexpr size_t NoSeed = static_cast<size_t>(-1);
+
+		void Code(const int code)
+		{
+			char text[8];
+			const auto result = std::to_chars(text, text + sizeof text, code);
+			// 与AutoCAD相同，组码右对齐到3个字符
+			_buffer.append(std::max<ptrdiff_t>(0, 3 - (result.ptr - text)), ' ');
+			_buffer.append(text, result.ptr);
+			_buffer += "\r\n";
+		}
+
+		size_t _seedOffset = NoSeed;
+		uint64_t _nextHandle = 1;
+	};
+
+	/// 图层名中不允许的字符替换为下划线
+	std::wstring LayerName(const std::wstring& name)
+	{
+		std::wstring layer = name;
+		for (wchar_t& c : layer)
+		{
+			if (std::wstring_view(L"<>/\\\":;?*|=,`").find(c) != std::wstring_view::npos)
+			{
+				c = L'_';
+			}
+		}
+		return layer.empty() ? L"VizRail" : layer;
+	}
+
+	/// 符号表的表头
+	/// \return 表的句柄，表中记录的所有者
+	uint64_t BeginTable(DxfStream& out, const char* name, const size_t count)
+	{
+		const uint64_t handle = out.NewHandle();
+		out.Text(0, "TABLE");
+		out.Text(2, name);
+		out.Handle(5, handle);
+		out.Handle(330, 0);
+		out.Text(100, "AcDbSymbolTable");
+		out.Integer(70, static_cast<int64_t>(count));
+		return handle;
+	}
+
+	uint64_t BeginRecord(DxfStream& out, const char* type, const uint64_t table, const char* subclass)
+	{
+		const uint64_t handle = out.NewHandle();
+		out.Text(0, type);
+		out.Handle(5, handle);
+		out.Handle(330, table);
+		out.Text(100, "AcDbSymbolTableRecord");
+		out.Text(100, subclass);
+		return handle;
+	}
+
+	struct BlockRecords
+	{
+		uint64_t ModelSpace;
+		uint64_t PaperSpace;
+	};
+
+	void WriteHeader(DxfStream& out, const BoundingBox& extents)
+	{
+		out.Text(0, "SECTION");
+		out.Text(2, "HEADER");
+		out.Text(9, "$ACADVER");
+		out.Text(1, "AC1015");
+		out.Text(9, "$HANDSEED");
+		out.HandleSeed();
+		// 单位为米
+		out.Text(9, "$INSUNITS");
+		out.Integer(70, 6);
+		if (!extents.IsEmpty())
+		{
+			out.Text(9, "$EXTMIN");
+			out.Real(10, extents.Min().X());
+			out.Real(20, extents.Min().Y());
+			out.Real(30, 0.0);
+			out.Text(9, "$EXTMAX");
+			out.Real(10, extents.Max().X());
+			out.Real(20, extents.Max().Y());
+			out.Real(30, 0.0);
+		}
+		out.Text(0, "ENDSEC");
+	}
+
+	BlockRecords WriteTables(DxfStream& out, const std::vector<std::string>& layers)
+	{
+		out.Text(0, "SECTION");
+		out.Text(2, "TABLES");
+
+		BeginTable(out, "VPORT", 0);
+		out.Text(0, "ENDTAB");
+
+		const uint64_t lineTypes = BeginTable(out, "LTYPE", 3);
+		for (const char* name : {"ByBlock", "ByLayer", "Continuous"})
+		{
+			BeginRecord(out, "LTYPE", lineTypes, "AcDbLinetypeTableRecord");
+			out.Text(2, name);
+			out.Integer(70, 0);
+			out.Text(3, std::string_view(name) == "Continuous" ? "Solid line" : "");
+			out.Integer(72, 65);
+			out.Integer(73, 0);
+			out.Real(40, 0.0);
+		}
+		out.Text(0, "ENDTAB");
+
+		const uint64_t layerTable = BeginTable(out, "LAYER", layers.size() + 1);
+		const auto writeLayer = [&](const std::string_view name)
+		{
+			BeginRecord(out, "LAYER", layerTable, "AcDbLayerTableRecord");
+			out.Text(2, name);
+			out.Integer(70, 0);
+			out.Integer(62, 7);
+			out.Text(6, "Continuous");
+		};
+		// 图层0总是存在
+		writeLayer("0");
+		for (const auto& layer : layers)
+		{
+			writeLayer(layer);
+		}
+		out.Text(0, "ENDTAB");
+
+		// 中文字形用AutoCAD自带的大字体
+		const uint64_t styles = BeginTable(out, "STYLE", 1);
+		BeginRecord(out, "STYLE", styles, "AcDbTextStyleTableRecord");
+		out.Text(2, "Standard");
+		out.Integer(70, 0);
+		out.Real(40, 0.0);
+		out.Real(41, 1.0);
+		out.Real(50, 0.0);
+		out.Integer(71, 0);
+		out.Real(42, 2.5);
+		out.Text(3, "txt");
+		out.Text(4, "gbcbig.shx");
+		out.Text(0, "ENDTAB");
+
+		for (const char* name : {"VIEW", "UCS"})
+		{
+			BeginTable(out, name, 0);
+			out.Text(0, "ENDTAB");
+		}
+
+		const uint64_t applications = BeginTable(out, "APPID", 2);
+		for (const char* name : {"ACAD", DxfApplicationName})
+		{
+			BeginRecord(out, "APPID", applications, "AcDbRegAppTableRecord");
+			out.Text(2, name);
+			out.Integer(70, 0);
+		}
+		out.Text(0, "ENDTAB");
+
+		BeginTable(out, "DIMSTYLE", 0);
+		out.Text(100, "AcDbDimStyleTable");
+		out.Integer(71, 0);
+		out.Text(0, "ENDTAB");
+
+		const uint64_t blockRecords = BeginTable(out, "BLOCK_RECORD", 2);
+		BlockRecords records{};
+		records.ModelSpace = BeginRecord(out, "BLOCK_RECORD", blockRecords, "AcDbBlockTableRecord");
+		out.Text(2, "*Model_Space");
+		records.PaperSpace = BeginRecord(out, "BLOCK_RECORD", blockRecords, "AcDbBlockTableRecord");
+		out.Text(2, "*Paper_Space");
+		out.Text(0, "ENDTAB");
+
+		out.Text(0, "ENDSEC");
+		return records;
+	}
+
+	void WriteBlocks(DxfStream& out, const BlockRecords& records)
+	{
+		out.Text(0, "SECTION");
+		out.Text(2, "BLOCKS");
+		for (const auto& [name, record, paperSpace] : {
+			     std::tuple{"*Model_Space", records.ModelSpace, false},
+			     std::tuple{"*Paper_Space", records.PaperSpace, true}
+		     })
+		{
+			out.Text(0, "BLOCK");
+			out.Handle(5, out.NewHandle());
+			out.Handle(330, record);
+			out.Text(100, "AcDbEntity");
+			if (paperSpace)
+			{
+				out.Integer(67, 1);
+			}
+			out.Text(8, "0");
+			out.Text(100, "AcDbBlockBegin");
+			out.Text(2, name);
+			out.Integer(70, 0);
+			out.Real(10, 0.0);
+			out.Real(20, 0.0);
+			out.Real(30, 0.0);
+			out.Text(3, name);
+			out.Text(1, "");
+
+			out.Text(0, "ENDBLK");
+			out.Handle(5, out.NewHandle());
+			out.Handle(330, record);
+			out.Text(100, "AcDbEntity");
+			if (paperSpace)
+			{
+				out.Integer(67, 1);
+			}
+			out.Text(8, "0");
+			out.Text(100, "AcDbBlockEnd");
+		}
+		out.Text(0, "ENDSEC");
+	}
+
+	void WriteObjects(DxfStream& out)
+	{
+		const uint64_t root = out.NewHandle();
+		const uint64_t groups = out.NewHandle();
+		out.Text(0, "SECTION");
+		out.Text(2, "OBJECTS");
+		out.Text(0, "DICTIONARY");
+		out.Handle(5, root);
+		out.Handle(330, 0);
+		out.Text(100, "AcDbDictionary");
+		out.Integer(281, 1);
+		out.Text(3, "ACAD_GROUP");
+		out.Handle(350, groups);
+		out.Text(0, "DICTIONARY");
+		out.Handle(5, groups);
+		out.Handle(330, root);
+		out.Text(100, "AcDbDictionary");
+		out.Integer(281, 1);
+		out.Text(0, "ENDSEC");
+	}
+
+	/// 模型空间中一条线路的图元
+	class EntityWriter
+	{
+	public:
+		EntityWriter(DxfStream& out, const uint64_t owner, std::string layer) : _out(out), _owner(owner),
+			_layer(std::move(layer))
+		{
+		}
+
+		void Write(const DisplayList& list)
+		{
+			for (const auto& polyline : list.Polylines)
+			{
+				Polyline(polyline.Style, polyline.Points);
+			}
+			for (const auto& arc : list.Arcs)
+			{
+				Arc(arc);
+			}
+			for (const auto& circle : list.Circles)
+			{
+				Begin("CIRCLE", circle.Style);
+				_out.Text(100, "AcDbCircle");
+				Point(circle.Center);
+				_out.Real(40, circle.Radius);
+			}
+			for (const auto& text : list.Texts)
+			{
+				Text(text);
+			}
+		}
+
+		/// \brief 写出交点线，附带可由ReadDxfJdPolylines读回的曲线参数
+		void JdPolyline(const DisplayStyle& style, const std::wstring& name, const PersistentVector<Jd>& jds)
+		{
+			std::vector<Point2D> points;
+			points.reserve(jds.Size());
+			for (const auto& jd : jds)
+			{
+				points.emplace_back(jd.E, jd.N);
+			}
+			Polyline(style, points);
+			if (points.size() < 2 || jds.Size() > DxfMaxCurveDataJds)
+			{
+				return;
+			}
+			_out.Text(1001, DxfApplicationName);
+			_out.String(1000, name);
+			_out.Real(1040, jds[0].StartMileage);
+			_out.Integer(1071, static_cast<int64_t>(jds.Size()));
+			for (const auto& jd : jds)
+			{
+				_out.Integer(1071, jd.JdH);
+				_out.Real(1040, jd.R);
+				_out.Real(1040, jd.Ls);
+			}
+		}
+
+	private:
+		void Begin(const char* type, const DisplayStyle& style)
+		{
+			_out.Text(0, type);
+			_out.Handle(5, _out.NewHandle());
+			_out.Handle(330, _owner);
+			_out.Text(100, "AcDbEntity");
+			_out.Text(8, _layer);
+			_out.Integer(62, style.Color);
+			_out.Integer(370, style.LineWeight);
+		}
+
+		void Point(const Point2D& point)
+		{
+			_out.Real(10, point.X());
+			_out.Real(20, point.Y());
+			_out.Real(30, 0.0);
+		}
+
+		void Polyline(const DisplayStyle& style, const std::vector<Point2D>& points)
+		{
+			if (points.size() < 2)
+			{
+				return;
+			}
+			Begin("LWPOLYLINE", style);
+			_out.Text(100, "AcDbPolyline");
+			_out.Integer(90, static_cast<int64_t>(points.size()));
+			_out.Integer(70, 0);
+			for (const auto& point : points)
+			{
+				_out.Real(10, point.X());
+				_out.Real(20, point.Y());
+			}
+		}
+
+		void Arc(const DisplayArc& arc)
+		{
+			// DXF的圆弧总是由起点角逆时针到终点角
+			const double start = arc.Sweep >= 0.0 ? arc.StartAngle : arc.StartAngle + arc.Sweep;
+			const double end = start + std::abs(arc.Sweep);
+			Begin("ARC", arc.Style);
+			_out.Text(100, "AcDbCircle");
+			Point(arc.Center);
+			_out.Real(40, arc.Radius);
+			_out.Text(100, "AcDbArc");
+			_out.Real(50, Normalize(start * DegreesPerRadian));
+			_out.Real(51, Normalize(end * DegreesPerRadian));
+		}
+
+		void Text(const DisplayText& text)
+		{
+			Begin("TEXT", text.Style);
+			_out.Text(100, "AcDbText");
+			Point(text.Position);
+			_out.Real(40, text.Height);
+			_out.String(1, text.Text);
+			const double rotation = Normalize(std::atan2(text.DirectionY, text.DirectionX) * DegreesPerRadian);
+			if (rotation != 0.0)
+			{
+				_out.Real(50, rotation);
+			}
+			_out.Text(100, "AcDbText");
+		}
+
+		/// 角度化为[0, 360)
+		static double Normalize(const double degrees)
+		{
+			const double value = std::fmod(degrees, 360.0);
+			return value < 0.0 ? value + 360.0 : value;
+		}
+
+		DxfStream& _out;
+		uint64_t _owner;
+		std::string _layer;
+	};
+
+	// ---- 读取 ----
+
+	std::string_view TrimSpaces(std::string_view text)
+	{
+		while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+		{
+			text.remove_prefix(1);
+		}
+		while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r'))
+		{
+			text.remove_suffix(1);
+		}
+		return text;
+	}
+
+	bool EqualsIgnoreCase(const std::wstring_view a, const std::wstring_view b)
+	{
+		return std::ranges::equal(a, b, [](const wchar_t x, const wchar_t y)
+		{
+			const auto lower = [](const wchar_t c)
+			{
+				return c >= L'A' && c <= L'Z' ? static_cast<wchar_t>(c - L'A' + L'a') : c;
+			};
+			return lower(x) == lower(y);
+		});
+	}
+
+	struct Group
+	{
+		int Code = 0;
+		std::string_view Value;
+		/// 组码所在的行号
+		size_t Line = 0;
+	};
+
+	/// 依次读取ASCII DXF中的组码和值
+	class GroupReader
+	{
+	public:
+		GroupReader(const std::filesystem::path& path, const std::string_view text) : _path(path), _text(text)
+		{
+		}
+
+		bool Next(Group& group)
+		{
+			if (_offset >= _text.size())
+			{
+				return false;
+			}
+			group.Line = _line;
+			const std::string_view code = TrimSpaces(NextLine());
+			if (code.empty() && _offset >= _text.size())
+			{
+				return false;
+			}
+			const auto [end, error] = std::from_chars(code.data(), code.data() + code.size(), group.Code);
+			if (error != std::errc() || end != code.data() + code.size())
+			{
+				throw Error(group, L"组码不是整数");
+			}
+			group.Value = NextLine();
+			if (!group.Value.empty() && group.Value.back() == '\r')
+			{
+				group.Value.remove_suffix(1);
+			}
+			return true;
+		}
+
+		[[nodiscard]] double Number(const Group& group) const
+		{
+			const std::string_view text = TrimSpaces(group.Value);
+			double value;
+			const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+			if (error != std::errc() || end != text.data() + text.size())
+			{
+				throw Error(group, std::format(L"组码{}的值不是数值", group.Code));
+			}
+			return value;
+		}
+
+		[[nodiscard]] int64_t Integer(const Group& group) const
+		{
+			const std::string_view text = TrimSpaces(group.Value);
+			int64_t value;
+			const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+			if (error != std::errc() || end != text.data() + text.size())
+			{
+				throw Error(group, std::format(L"组码{}的值不是整数", group.Code));
+			}
+			return value;
+		}
+
+		/// 按UTF-8或GBK解码并还原\U+XXXX转义
+		[[nodiscard]] std::wstring String(const Group& group) const
+		{
+			std::wstring text;
+			try
+			{
+				text = DecodeText(group.Value);
+			}
+			catch (const VizRailCoreException& e)
+			{
+				throw Error(group, std::format(L"组码{}的值{}", group.Code, e.GetMsg()));
+			}
+			std::wstring result;
+			result.reserve(text.size());
+			for (size_t i = 0; i < text.size(); ++i)
+			{
+				unsigned code = 0;
+				if (text.compare(i, 3, L"\\U+") == 0 && i + 7 <= text.size() &&
+					std::all_of(text.begin() + i + 3, text.begin() + i + 7, [&code](const wchar_t c)
+					{
+						const int digit = c >= L'0' && c <= L'9'
+							                  ? c - L'0'
+							                  : c >= L'A' && c <= L'F'
+							                  ? c - L'A' + 10
+							                  : c >= L'a' && c <= L'f'
+							                  ? c - L'a' + 10
+							                  : -1;
+						code = code * 16 + static_cast<unsigned>(digit);
+						return digit >= 0;
+					}))
+				{
+					result.push_back(static_cast<wchar_t>(code));
+					i += 6;
+				}
+				else
+				{
+					result.push_back(text[i]);
+				}
+			}
+			return result;
+		}
+
+		[[nodiscard]] TextImportException Error(const Group& group, const std::wstring& message) const
+		{
+			return TextImportException(std::format(L"{}第{}行：{}", _path.wstring(), group.Line, message), group.Line, 0);
+		}
+
+	private:
+		std::string_view NextLine()
+		{
+			const size_t end = _text.find('\n', _offset);
+			const std::string_view line = _text.substr(_offset, end == std::string_view::npos ? end : end - _offset);
+			_offset = end == std::string_view::npos ? _text.size() : end + 1;
+			++_line;
+			return line;
+		}
+
+		const std::filesystem::path& _path;
+		std::string_view _text;
+		size_t _offset = 0;
+		size_t _line = 1;
+	};
+
+	/// 读取中的一个LWPOLYLINE
+	struct PendingPolyline
+	{
+		Group Start;
+		std::wstring Layer;
+		std::vector<double> X;
+		std::vector<double> Y;
+		bool PaperSpace = false;
+		/// 当前在哪个应用的扩展数据中，0为不在扩展数据中，1为VIZRAIL，2为其他应用
+		int Application = 0;
+		bool HasCurveData = false;
+		std::wstring Name;
+		std::vector<double> Reals;
+		std::vector<int64_t> Integers;
+	};
+}
+
+void VizRailCore::SaveDxf(const std::filesystem::path& path, const std::span<const DxfAlignment> alignments)
+{
+	BoundingBox extents;
+	std::vector<std::string> layers;
+	for (const auto& alignment : alignments)
+	{
+		extents.Extend(alignment.Alignment->Extents());
+		std::string layer = Escape(LayerName(alignment.Name));
+		if (std::ranges::find(layers, layer) == layers.end())
+		{
+			layers.push_back(std::move(layer));
+		}
+	}
+
+	DxfStream out(path);
+	WriteHeader(out, extents);
+	const BlockRecords records = WriteTables(out, layers);
+	WriteBlocks(out, records);
+
+	out.Text(0, "SECTION");
+	out.Text(2, "ENTITIES");
+	for (const auto& alignment : alignments)
+	{
+		EntityWriter writer(out, records.ModelSpace, Escape(LayerName(alignment.Name)));
+		// 每条线路用独立的生成器，写完即释放，整张图不同时驻留在内存中
+		DisplayListBuilder builder;
+		builder.Update(*alignment.Alignment);
+		const auto& fragments = builder.Fragments();
+		for (size_t i = 0; i + 1 < fragments.size(); ++i)
+		{
+			writer.Write(*fragments[i]);
+		}
+		// 最后一个片段为交点及交点连线，交点线单独写出以附带曲线参数
+		if (!fragments.empty())
+		{
+			DisplayList jds = *fragments.back();
+			const DisplayStyle style = jds.Polylines.empty() ? DisplayStyle{} : jds.Polylines.front().Style;
+			jds.Polylines.clear();
+			writer.Write(jds);
+			writer.JdPolyline(style, alignment.Name, alignment.Alignment->GetJds());
+		}
+		writer.Write(*builder.Labels());
+	}
+	out.Text(0, "ENDSEC");
+
+	WriteObjects(out);
+	out.Text(0, "EOF");
+	out.Close();
+}
+
+std::vector<DxfJdPolyline> VizRailCore::ReadDxfJdPolylines(const std::filesystem::path& path,
+                                                           const std::wstring& layer)
+{
+	std::optional<MappedFile> file;
+	try
+	{
+		file.emplace(path);
+	}
+	catch (const VizRailCoreException& e)
+	{
+		throw TextImportException(e.GetMsg(), 0, 0);
+	}
+	const std::string_view text(reinterpret_cast<const char*>(file->Bytes().data()), file->Bytes().size());
+	if (text.starts_with("AutoCAD Binary DXF"))
+	{
+		throw TextImportException(std::format(L"{}：不支持二进制DXF", path.wstring()), 0, 0);
+	}
+
+	GroupReader reader(path, text);
+	std::vector<DxfJdPolyline> result;
+	std::optional<PendingPolyline> pending;
+	const auto finish = [&]
+	{
+		if (!pending)
+		{
+			return;
+		}
+		PendingPolyline polyline = std::move(*pending);
+		pending.reset();
+		if (polyline.X.size() != polyline.Y.size())
+		{
+			throw reader.Error(polyline.Start, L"LWPOLYLINE的顶点坐标不完整");
+		}
+		const bool onLayer = !layer.empty() && EqualsIgnoreCase(polyline.Layer, layer);
+		if (polyline.PaperSpace || polyline.X.size() < 2 || !(polyline.HasCurveData || onLayer))
+		{
+			return;
+		}
+
+		const size_t count = polyline.X.size();
+		DxfJdPolyline jdPolyline;
+		jdPolyline.Name = polyline.HasCurveData && !polyline.Name.empty() ? polyline.Name : polyline.Layer;
+		jdPolyline.Layer = std::move(polyline.Layer);
+		JdColumns& jds = jdPolyline.Jds;
+		jds.N = std::move(polyline.Y);
+		jds.E = std::move(polyline.X);
+		jds.Angle.assign(count, 0.0);
+		jds.R.assign(count, 0.0);
+		jds.Ls.assign(count, 0.0);
+		jds.JdH.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			jds.JdH[i] = static_cast<unsigned>(i);
+		}
+		// 交点数与顶点数不符时（如在AutoCAD中编辑过顶点）不使用扩展数据中的曲线参数
+		if (polyline.HasCurveData && polyline.Integers.size() == count + 1 &&
+			polyline.Integers[0] == static_cast<int64_t>(count) && polyline.Reals.size() == 2 * count + 1)
+		{
+			jdPolyline.HasCurveData = true;
+			jds.StartMileage = polyline.Reals[0];
+			for (size_t i = 0; i < count; ++i)
+			{
+				jds.JdH[i] = static_cast<unsigned>(polyline.Integers[i + 1]);
+				jds.R[i] = polyline.Reals[1 + 2 * i];
+				jds.Ls[i] = polyline.Reals[2 + 2 * i];
+			}
+		}
+		result.push_back(std::move(jdPolyline));
+	};
+
+	std::string_view section;
+	bool sectionName = false;
+	Group group;
+	while (reader.Next(group))
+	{
+		if (group.Code == 0)
+		{
+			finish();
+			const std::string_view type = TrimSpaces(group.Value);
+			sectionName = type == "SECTION";
+			if (type == "ENDSEC")
+			{
+				section = {};
+			}
+			else if (type == "EOF")
+			{
+				break;
+			}
+			else if (section == "ENTITIES" && type == "LWPOLYLINE")
+			{
+				pending.emplace().Start = group;
+			}
+			continue;
+		}
+		if (sectionName && group.Code == 2)
+		{
+			section = TrimSpaces(group.Value);
+			sectionName = false;
+			continue;
+		}
+		if (!pending)
+		{
+			continue;
+		}
+
+		PendingPolyline& polyline = *pending;
+		if (group.Code == 1001)
+		{
+			polyline.Application = TrimSpaces(group.Value) == DxfApplicationName ? 1 : 2;
+			polyline.HasCurveData = polyline.HasCurveData || polyline.Application == 1;
+			continue;
+		}
+		if (polyline.Application == 0)
+		{
+			switch (group.Code)
+			{
+			case 8:
+				polyline.Layer = reader.String(group);
+				break;
+			case 10:
+				polyline.X.push_back(reader.Number(group));
+				break;
+			case 20:
+				polyline.Y.push_back(reader.Number(group));
+				break;
+			case 67:
+				polyline.PaperSpace = reader.Integer(group) != 0;
+				break;
+			default:
+				break;
+			}
+		}
+		else if (polyline.Application == 1)
+		{
+			if (group.Code == 1000 && polyline.Name.empty())
+			{
+				polyline.Name = reader.String(group);
+			}
+			else if (group.Code == 1040)
+			{
+				polyline.Reals.push_back(reader.Number(group));
+			}
+			else if (group.Code == 1070 || group.Code == 1071)
+			{
+				polyline.Integers.push_back(reader.Integer(group));
+			}
+		}
+	}
+	finish();
+	return result;
+}
@@ -1,59 +1,621 @@
 #include "HorizontalAlignment.h"
 
-#include <execution>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <numbers>
 #include <format>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string_view>
 
+#include "AlignmentImage.h"
 #include "Curve.h"
 #include "Exceptions.h"
 #include "IntermediateLine.h"
+#include "RefreshArena.h"
+#include "TaskScheduler.h"
+#include "Trace.h"
 
 using namespace VizRailCore;
 
+namespace
+{
+	// 投影时判断垂足是否落在线元范围之外的容差（m）
+	constexpr double ProjectionTolerance = 1e-6;
+
+	/// 点在单个线元上的投影
+	struct ElementProjection
+	{
+		double Station = 0.0;
+		double Offset = 0.0;
+		double Distance = std::numeric_limits<double>::infinity();
+		/// 垂足被限制在线元端点，点位于线元起点之前或终点之后
+		bool Outside = false;
+	};
+
+	/// 缓和曲线局部坐标系（原点为ZH或HZ点，x轴指向交点，y轴指向曲线内侧）中的点到缓和曲线的垂足，
+	/// 返回垂足到原点的曲线长，限制在[0, Ls]内。缓和曲线在局部坐标系中接近x轴，以点的x坐标为初值，
+	/// 切线角和曲率由曲线长直接求出，牛顿迭代通常2至3次收敛
+	double ProjectOnSpiral(const AlignmentImage::ElementRecord& element, const double qx, const double qy)
+	{
+		double l = std::clamp(qx, 0.0, element.Ls);
+		for (int iteration = 0; iteration < 16; ++iteration)
+		{
+			const double l2 = l * l;
+			const double dx = qx - (l - l2 * l2 * l * element.SpiralX);
+			const double dy = qy - l2 * l * element.SpiralY;
+			const double angle = l2 * element.SpiralAngle;
+			const double c = std::cos(angle);
+			const double s = std::sin(angle);
+			// 点到曲线上点的向量在切线上的分量f(l)为0处即垂足，f'(l) = 曲率·法向分量 - 1
+			const double along = dx * c + dy * s;
+			const double normal = dy * c - dx * s;
+			const double slope = 1.0 - 2.0 * l * element.SpiralAngle * normal;
+			// 点远在曲线内侧时f'(l)接近0，退化为沿切线方向的一步
+			const double next = std::clamp(l + along / std::max(slope, 0.5), 0.0, element.Ls);
+			const bool converged = std::abs(next - l) < 1e-9;
+			l = next;
+			if (converged)
+			{
+				break;
+			}
+		}
+		return l;
+	}
+
+	ElementProjection ProjectOnElement(const AlignmentImage::ElementRecord& element, const Point2D& point)
+	{
+		const double start = element.StartMileage;
+		const double end = element.EndMileage;
+		if (!(end > start))
+		{
+			return {};
+		}
+
+		if (element.Kind == AlignmentImage::ElementKind::Line)
+		{
+			// 直线直接求垂足
+			const double tx = element.StartCos;
+			const double ty = element.StartSin;
+			const double px = point.X() - element.StartX;
+			const double py = point.Y() - element.StartY;
+			const double along = px * tx + py * ty;
+			const double t = std::clamp(along, 0.0, end - start);
+			const double ox = px - t * tx;
+			const double oy = py - t * ty;
+			const bool outside = along < -ProjectionTolerance || along > end - start + ProjectionTolerance;
+			return {start + t, -(tx * oy - ty * ox), std::hypot(ox, oy), outside};
+		}
+
+		// 点在ZH点和HZ点局部坐标系中的坐标，y轴指向曲线内侧
+		const double sx = point.X() - element.StartX;
+		const double sy = point.Y() - element.StartY;
+		const double frontX = sx * element.StartCos + sy * element.StartSin;
+		const double frontY = element.Turn * (sy * element.StartCos - sx * element.StartSin);
+		const double ex = point.X() - element.EndX;
+		const double ey = point.Y() - element.EndY;
+		const double backX = ex * element.EndCos + ey * element.EndSin;
+		const double backY = element.Turn * (ex * element.EndSin - ey * element.EndCos);
+
+		// 里程为station处的候选垂足，beyond为点位于曲线起点之前或终点之后
+		ElementProjection best;
+		const auto candidate = [&](const double station, const bool beyond)
+		{
+			const StationFrame frame = AlignmentImage::EvaluateElement(element, station);
+			const auto [dx, dy] = point - frame.Point;
+			const double distance = std::hypot(dx, dy);
+			if (distance < best.Distance)
+			{
+				const double tx = Angle::Cos(frame.Azimuth);
+				const double ty = Angle::Sin(frame.Azimuth);
+				// X为E坐标，Y为N坐标，切线与垂线的叉积为正时点在左侧
+				best = {station, -(tx * dy - ty * dx), distance, beyond};
+			}
+		};
+
+		// 圆曲线在局部坐标系中的圆心为(m, p + R)，由点相对圆心的方向直接得到垂足到原点的曲线长。
+		// 前后半段分别在ZH点和HZ点局部坐标系中求垂足，与线元坐标的计算方式一致
+		const double phiQz = (element.QzMileage - start - 0.5 * element.Ls) / element.R;
+		const auto arc = [&element, phiQz](const double qx, const double qy)
+		{
+			// 圆心角以QZ点为参考取值，避免在圆曲线背后跳变
+			const double phi = std::atan2(qx - element.M, element.P + element.R - qy);
+			return 0.5 * element.Ls + element.R * (phiQz + std::remainder(phi - phiQz, 2 * std::numbers::pi));
+		};
+		// 没有缓和曲线时圆曲线两端即曲线两端
+		const bool circular = element.Ls <= 0;
+		const double frontArc = arc(frontX, frontY);
+		candidate(start + std::clamp(frontArc, element.HyMileage - start, element.QzMileage - start),
+		          circular && frontArc < -ProjectionTolerance);
+		const double backArc = arc(backX, backY);
+		candidate(end - std::clamp(backArc, end - element.YhMileage, end - element.QzMileage),
+		          circular && backArc < -ProjectionTolerance);
+
+		if (element.Ls > 0)
+		{
+			const double front = ProjectOnSpiral(element, frontX, frontY);
+			candidate(start + front, front <= 0 && frontX < -ProjectionTolerance);
+			const double back = ProjectOnSpiral(element, backX, backY);
+			candidate(end - back, back <= 0 && backX < -ProjectionTolerance);
+		}
+		return best;
+	}
+
+	// 所有线路共用的修订号来源，保证修订号在进程内唯一
+	std::atomic<uint64_t> NextRevision = 1;
+
+	// 线元名对应的线元下标：曲线k为2(k-1)，夹直线k为2k-1，最后一条夹直线在末尾。名称不存在时返回count
+	size_t XyIndex(const std::wstring_view key, const size_t count)
+	{
+		const auto number = [&key](const std::wstring_view prefix) -> size_t
+		{
+			if (!key.starts_with(prefix) || key.size() == prefix.size())
+			{
+				return 0;
+			}
+			size_t value = 0;
+			for (size_t i = prefix.size(); i < key.size(); ++i)
+			{
+				if (key[i] < L'0' || key[i] > L'9')
+				{
+					return 0;
+				}
+				value = value * 10 + (key[i] - L'0');
+			}
+			return value;
+		};
+
+		const size_t curves = count / 2;
+		if (const size_t k = number(L"曲线"); k > 0)
+		{
+			return k <= curves ? 2 * (k - 1) : count;
+		}
+		if (const size_t k = number(L"夹直线"); k > 0)
+		{
+			if (k <= curves)
+			{
+				return 2 * k - 1;
+			}
+			return k == curves + 1 && count > 0 ? 2 * curves : count;
+		}
+		return count;
+	}
+
+	// 只比较输入参数，不比较刷新时写入的里程等派生字段
+	bool SameInput(const Jd& a, const Jd& b)
+	{
+		return a.JdH == b.JdH && a.N == b.N && a.E == b.E && a.Angle == b.Angle && a.R == b.R && a.Ls == b.Ls;
+	}
+
+	// 撤销和重做时只知道前后两组交点：长度相同时逐个比较，否则把首尾相同部分之间的交点都视为修改
+	void DiffJds(const PersistentVector<Jd>& before, const PersistentVector<Jd>& after, ChangeSet& changes)
+	{
+		const size_t oldSize = before.Size();
+		const size_t newSize = after.Size();
+		if (oldSize == newSize)
+		{
+			auto it = before.begin();
+			size_t i = 0;
+			for (const auto& jd : after)
+			{
+				if (!SameInput(*it, jd))
+				{
+					changes.TouchedJds.push_back(i);
+				}
+				++it;
+				++i;
+			}
+			return;
+		}
+
+		size_t prefix = 0;
+		auto oldIt = before.begin();
+		auto newIt = after.begin();
+		while (prefix < oldSize && prefix < newSize && SameInput(*oldIt, *newIt))
+		{
+			++prefix;
+			++oldIt;
+			++newIt;
+		}
+		size_t suffix = 0;
+		while (suffix < oldSize - prefix && suffix < newSize - prefix &&
+			SameInput(before[oldSize - 1 - suffix], after[newSize - 1 - suffix]))
+		{
+			++suffix;
+		}
+		for (size_t i = prefix; i < newSize - suffix; ++i)
+		{
+			changes.TouchedJds.push_back(i);
+		}
+		if (newSize > oldSize)
+		{
+			changes.InsertedJds = newSize - oldSize;
+		}
+		else
+		{
+			changes.RemovedJds = oldSize - newSize;
+		}
+	}
+
+	bool SameJd(const Jd& a, const Jd& b)
+	{
+		return a.JdH == b.JdH && a.N == b.N && a.E == b.E && a.Angle == b.Angle && a.R == b.R && a.Ls == b.Ls &&
+			a.TH == b.TH && a.LH == b.LH && a.LJzx == b.LJzx && a.StartMileage == b.StartMileage &&
+			a.EndMileage == b.EndMileage;
+	}
+
+	/// \brief ElementState的分配池。每次刷新都产生一个新状态，旧状态在线路、副本和历史记录都不再引用时释放，
+	/// 稳定状态下新状态复用刚释放的块，不再访问堆。状态可能在任何线程上释放，因此用同步的池。
+	/// 池有意不析构：静态存储期的线路可能在池之后才析构
+	std::pmr::memory_resource& StatePool()
+	{
+		static auto* pool = new std::pmr::synchronized_pool_resource();
+		return *pool;
+	}
+
+	// 交点数少于该值时串行刷新，线程调度的开销会超过并行的收益
+	constexpr size_t ParallelRefreshThreshold = 512;
+	constexpr size_t ParallelRefreshGrain = 128;
+
+	// 对[0, count)的每个下标调用f，数量较多时在共用调度器上分块并行执行。f只能写入与下标对应的位置
+	template <typename F>
+	void ForEachIndex(const size_t count, const F& f)
+	{
+		if (count < ParallelRefreshThreshold)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				f(i);
+			}
+			return;
+		}
+		ParallelFor(0, count, ParallelRefreshGrain, f);
+	}
+}
+
 HorizontalAlignment::HorizontalAlignment(const std::vector<Jd>& jds): _jds(jds)
 {
 	Refresh();
 }
 
+const std::shared_ptr<const HorizontalAlignment::ElementState>& HorizontalAlignment::EmptyState()
+{
+	static const std::shared_ptr<const ElementState> empty = std::make_shared<const ElementState>();
+	return empty;
+}
+
+template <typename Operation>
+void HorizontalAlignment::Edit(Operation&& operation)
+{
+	// 不在事务中调用的单个修改视为只含一步操作的事务
+	BeginEdit();
+	try
+	{
+		operation();
+	}
+	catch (...)
+	{
+		CancelEdit();
+		throw;
+	}
+	CommitEdit();
+}
+
 void HorizontalAlignment::AddJd(const Jd& jd)
 {
-	_jds.push_back(jd);
-	Refresh();
+	Edit([this, &jd]
+	{
+		_jds = _jds.PushBack(jd);
+		_editTouched.push_back(1);
+		++_editInserted;
+	});
 }
 
 void HorizontalAlignment::AddJd(const std::vector<Jd>& jds)
 {
-	_jds.insert(_jds.cend(), jds.cbegin(), jds.cend());
-	Refresh();
+	Edit([this, &jds]
+	{
+		for (const auto& jd : jds)
+		{
+			_jds = _jds.PushBack(jd);
+		}
+		_editTouched.resize(_jds.Size(), 1);
+		_editInserted += jds.size();
+	});
 }
 
 void HorizontalAlignment::RemoveJd(const std::vector<Jd>::difference_type index)
 {
-	_jds.erase(_jds.begin() + index);
-	Refresh();
+	Edit([this, index]
+	{
+		if (index < 0 || static_cast<size_t>(index) >= _jds.Size())
+		{
+			throw VizRailCoreException(L"交点索引超出范围");
+		}
+		_jds = _jds.Erase(static_cast<size_t>(index));
+		_editTouched.erase(_editTouched.begin() + index);
+		++_editRemoved;
+	});
 }
 
 void HorizontalAlignment::InsertJd(const std::vector<Jd>::difference_type index, const Jd& jd)
 {
-	_jds.insert(_jds.cbegin() + index, jd);
-	Refresh();
+	Edit([this, index, &jd]
+	{
+		if (index < 0 || static_cast<size_t>(index) > _jds.Size())
+		{
+			throw VizRailCoreException(L"交点索引超出范围");
+		}
+		_jds = _jds.Insert(static_cast<size_t>(index), jd);
+		_editTouched.insert(_editTouched.cbegin() + index, 1);
+		++_editInserted;
+	});
 }
 
 void HorizontalAlignment::UpdateJd(const size_t index, const Jd& jd)
 {
-	try
+	Edit([this, index, &jd]
+	{
+		if (index >= _jds.Size())
+		{
+			throw VizRailCoreException(L"交点索引超出范围");
+		}
+		// 值未变时不复制分块路径，交点仍记为修改过
+		if (!SameJd(_jds[index], jd))
+		{
+			_jds = _jds.Set(index, jd);
+		}
+		_editTouched[index] = 1;
+	});
+}
+
+void HorizontalAlignment::MoveJd(const size_t index, const double offsetN, const double offsetE)
+{
+	Edit([this, index, offsetN, offsetE]
+	{
+		if (index >= _jds.Size())
+		{
+			throw VizRailCoreException(L"交点索引超出范围");
+		}
+		Jd jd = _jds[index];
+		jd.N += offsetN;
+		jd.E += offsetE;
+		_jds = _jds.Set(index, jd);
+		_editTouched[index] = 1;
+	});
+}
+
+void HorizontalAlignment::BeginEdit()
+{
+	if (_editStack.empty())
+	{
+		// 最外层事务开始前没有改动标记，放弃时直接清空，不必保存副本
+		_editTouched.assign(_jds.Size(), 0);
+		_editInserted = 0;
+		_editRemoved = 0;
+		_editStack.push_back({_jds, {}, 0, 0});
+		return;
+	}
+	_editStack.push_back({_jds, _editTouched, _editInserted, _editRemoved});
+}
+
+ChangeSet HorizontalAlignment::CommitEdit()
+{
+	if (_editStack.empty())
+	{
+		throw VizRailCoreException(L"没有进行中的编辑事务");
+	}
+	if (_editStack.size() > 1)
+	{
+		// 内层事务的改动并入外层事务，由最外层统一刷新
+		_editStack.pop_back();
+		return {};
+	}
+
+	std::vector<size_t> touched;
+	for (size_t i = 0; i < _editTouched.size(); ++i)
+	{
+		if (_editTouched[i])
+		{
+			touched.push_back(i);
+		}
+	}
+
+	ChangeSet changes;
+	if (!touched.empty() || _editInserted > 0 || _editRemoved > 0)
+	{
+		HistoryEntry previous{std::move(_editStack.front().Jds), _state};
+		try
+		{
+			changes = RefreshXys();
+		}
+		catch (...)
+		{
+			// RefreshXys失败时线元保持不变，交点也恢复到事务开始前，保持二者一致
+			_jds = std::move(previous.Jds);
+			_editStack.clear();
+			_editTouched.clear();
+			throw;
+		}
+		_history.Push(_history.Undo, std::move(previous));
+		_history.Redo.clear();
+	}
+	changes.TouchedJds = std::move(touched);
+	changes.InsertedJds = _editInserted;
+	changes.RemovedJds = _editRemoved;
+	changes.Revision = _state->Revision;
+	_editStack.clear();
+	_editTouched.clear();
+
+	if (!changes.IsEmpty())
+	{
+		Notify(changes);
+	}
+	return changes;
+}
+
+void HorizontalAlignment::CancelEdit()
+{
+	if (_editStack.empty())
+	{
+		throw VizRailCoreException(L"没有进行中的编辑事务");
+	}
+	auto& state = _editStack.back();
+	_jds = std::move(state.Jds);
+	if (_editStack.size() == 1)
+	{
+		_editTouched.clear();
+	}
+	else
+	{
+		_editTouched = std::move(state.Touched);
+	}
+	_editInserted = state.Inserted;
+	_editRemoved = state.Removed;
+	_editStack.pop_back();
+}
+
+size_t HorizontalAlignment::AddObserver(ChangeObserver observer)
+{
+	const size_t id = _observers.NextId++;
+	_observers.Items.emplace_back(id, std::move(observer));
+	return id;
+}
+
+void HorizontalAlignment::RemoveObserver(const size_t id)
+{
+	std::erase_if(_observers.Items, [id](const auto& item) { return item.first == id; });
+}
+
+bool HorizontalAlignment::Undo()
+{
+	if (InEdit())
+	{
+		throw VizRailCoreException(L"编辑事务中不能撤销或重做");
+	}
+	if (_history.Undo.empty())
+	{
+		return false;
+	}
+
+	HistoryEntry current{_jds, _state};
+	const ChangeSet changes = Restore(_history.Undo.back());
+	_history.Undo.pop_back();
+	_history.Push(_history.Redo, std::move(current));
+	Notify(changes);
+	return true;
+}
+
+bool HorizontalAlignment::Redo()
+{
+	if (InEdit())
+	{
+		throw VizRailCoreException(L"编辑事务中不能撤销或重做");
+	}
+	if (_history.Redo.empty())
+	{
+		return false;
+	}
+
+	HistoryEntry current{_jds, _state};
+	const ChangeSet changes = Restore(_history.Redo.back());
+	_history.Redo.pop_back();
+	_history.Push(_history.Undo, std::move(current));
+	Notify(changes);
+	return true;
+}
+
+void HorizontalAlignment::SetHistoryLimit(const size_t steps, const size_t cachedStates)
+{
+	_history.Steps = steps;
+	_history.CachedStates = cachedStates;
+	while (_history.Undo.size() > steps)
 	{
-		_jds.at(index) = jd;
-		Refresh();
+		_history.Undo.pop_front();
 	}
-	catch (std::out_of_range&)
+	while (_history.Redo.size() > steps)
 	{
-		throw VizRailCoreException(L"交点索引超出范围");
+		_history.Redo.pop_front();
+	}
+	for (auto* stack : {&_history.Undo, &_history.Redo})
+	{
+		for (size_t i = 0; i + cachedStates < stack->size(); ++i)
+		{
+			(*stack)[i].State.reset();
+		}
+	}
+}
+
+void HorizontalAlignment::ClearHistory()
+{
+	_history.Undo.clear();
+	_history.Redo.clear();
+}
+
+void HorizontalAlignment::History::Push(std::deque<HistoryEntry>& stack, HistoryEntry entry)
+{
+	if (Steps == 0)
+	{
+		return;
+	}
+	stack.push_back(std::move(entry));
+	if (stack.size() > Steps)
+	{
+		stack.pop_front();
+	}
+	// 只有最近的CachedStates步保留线元，每次入栈最多使一步超出范围
+	if (stack.size() > CachedStates)
+	{
+		stack[stack.size() - 1 - CachedStates].State.reset();
+	}
+}
+
+ChangeSet HorizontalAlignment::Restore(const HistoryEntry& entry)
+{
+	const PersistentVector<Jd> previousJds = _jds;
+	ChangeSet changes;
+	if (entry.State != nullptr)
+	{
+		const RefreshArena::Scope arena;
+		changes = DiffElements(*_state, *entry.State, arena.Resource());
+		_jds = entry.Jds;
+		_state = entry.State;
+	}
+	else
+	{
+		// 线元已被淘汰出缓存，由交点重新计算，形状未变的线元仍沿用当前的线元对象
+		_jds = entry.Jds;
+		try
+		{
+			changes = RefreshXys();
+		}
+		catch (...)
+		{
+			_jds = previousJds;
+			throw;
+		}
+	}
+	DiffJds(previousJds, _jds, changes);
+	changes.Revision = _state->Revision;
+	return changes;
+}
+
+void HorizontalAlignment::Notify(const ChangeSet& changes) const
+{
+	// 回调中可能注销自身，遍历副本
+	const auto observers = _observers.Items;
+	for (const auto& [id, observer] : observers)
+	{
+		observer(*this, changes);
 	}
 }
 
 void HorizontalAlignment::Refresh()
 {
-	_xys.clear();
 	RefreshXys();
 }
 
@@ -63,130 +625,488 @@ Point2D HorizontalAlignment::MileageToCoordinate(const Mileage& mileage) const
 	{
 		throw VizRailCoreException(L"里程值不能为负数");
 	}
-	for (const auto& [key, value] : _xys)
+	VIZRAIL_TRACE_COUNT(Queries, 1);
+	return _state->Xys[FindElement(mileage)].Element->MileageToCoordinate(mileage);
+}
+
+StationFrame HorizontalAlignment::MileageToFrame(const Mileage& mileage) const
+{
+	if (mileage < 0)
+	{
+		throw VizRailCoreException(L"里程值不能为负数");
+	}
+	VIZRAIL_TRACE_COUNT(Queries, 1);
+	const size_t index = FindElement(mileage);
+	const LineElement& element = *_state->Xys[index].Element;
+	return {element.MileageToCoordinate(mileage), element.MileageToAzimuthAngle(mileage), index};
+}
+
+StationOffset HorizontalAlignment::CoordinateToMileage(const Point2D& point) const
+{
+	VIZRAIL_TRACE_COUNT(Queries, 1);
+	const auto index = Index();
+	std::optional<ElementProjection> best;
+	size_t bestIndex = 0;
+	// 包围盒比已找到的垂足还远的线元不可能更近
+	index->Tree.VisitNearest(point, [&](const size_t i)
 	{
-		if (value->IsOnIt(mileage))
+		const ElementProjection projection = ProjectOnElement(index->Records[i], point);
+		// 垂足恰好落在两个线元的公共端点时距离相等，优先取垂足在线元范围内的一个，
+		// 同样在范围内时取下标较小的一个，结果与访问顺序无关
+		bool better = !best || projection.Distance < best->Distance;
+		if (best && projection.Distance == best->Distance)
 		{
-			const Point2D coordinate = value->MileageToCoordinate(mileage);
-			return coordinate;
+			better = best->Outside != projection.Outside ? best->Outside : i < bestIndex;
 		}
+		if (better)
+		{
+			best = projection;
+			bestIndex = i;
+		}
+		return projection.Distance;
+	});
+	// 线元之间切线连续，垂足只会在线路两端落到线元之外
+	if (!best || best->Outside)
+	{
+		throw NotInLineException(L"该点不在线路范围内");
 	}
-	throw NotInLineException(L"该里程不在线路上");
+	return {Mileage(best->Station), best->Offset, bestIndex};
 }
 
 double HorizontalAlignment::GetTotalMileage() const
 {
-	return std::reduce(_xys.cbegin(), _xys.cend(), 0.0,
-	                   [](const double sum, const std::pair<std::wstring, std::shared_ptr<LineElement>>& pair)
-	                   {
-		                   return sum + pair.second->Length();
-	                   });
+	return std::accumulate(_state->Xys.begin(), _state->Xys.end(), 0.0,
+	                       [](const double sum, const XyEntry& xy)
+	                       {
+		                       return sum + xy.Element->Length();
+	                       });
+}
+
+const std::shared_ptr<LineElement>& HorizontalAlignment::GetXy(const std::wstring& key) const
+{
+	const auto& xys = _state->Xys;
+	const size_t index = XyIndex(key, xys.Size());
+	if (index >= xys.Size() || xys[index].Key != key)
+	{
+		throw VizRailCoreException(L"线元不存在");
+	}
+	return xys[index].Element;
+}
+
+std::vector<size_t> HorizontalAlignment::QueryElements(const BoundingBox& box) const
+{
+	std::vector<size_t> result;
+	QueryElements(box, result);
+	return result;
+}
+
+void HorizontalAlignment::QueryElements(const BoundingBox& box, std::vector<size_t>& result) const
+{
+	VIZRAIL_TRACE_COUNT(Queries, 1);
+	Index()->Tree.Query(box, result);
+}
+
+std::vector<size_t> HorizontalAlignment::QueryElements(const Ray2D& ray) const
+{
+	VIZRAIL_TRACE_COUNT(Queries, 1);
+	std::vector<size_t> result;
+	Index()->Tree.Query(ray, result);
+	return result;
+}
+
+std::shared_ptr<const HorizontalAlignment::QueryIndex> HorizontalAlignment::Index() const
+{
+	const ElementState& state = *_state;
+	return state.Index.Get([&state]
+	{
+		VIZRAIL_TRACE_SCOPE("HorizontalAlignment::BuildIndex");
+		QueryIndex index;
+		std::vector<BoundingBox> boxes;
+		boxes.reserve(state.Xys.Size());
+		index.Records.reserve(state.Xys.Size());
+		for (const auto& xy : state.Xys)
+		{
+			boxes.push_back(xy.Element->Bounds());
+			AlignmentImage::ElementRecord& record = index.Records.emplace_back(
+				AlignmentImage::MakeElementRecord(*xy.Element));
+			if (record.Kind == AlignmentImage::ElementKind::Line)
+			{
+				record.EndMileage = std::min(record.EndMileage, record.StartMileage + xy.Element->Length());
+			}
+		}
+		index.Tree.Build(boxes);
+
+		const size_t count = state.Xys.Size();
+		index.MileageOrder.resize(count);
+		std::iota(index.MileageOrder.begin(), index.MileageOrder.end(), 0u);
+		std::stable_sort(index.MileageOrder.begin(), index.MileageOrder.end(), [&state](const uint32_t a, const uint32_t b)
+		{
+			return state.Xys[a].Element->StartMileage().Value() < state.Xys[b].Element->StartMileage().Value();
+		});
+		index.StartMileages.reserve(count);
+		for (const uint32_t i : index.MileageOrder)
+		{
+			index.StartMileages.push_back(state.Xys[i].Element->StartMileage().Value());
+		}
+		return index;
+	}, [](const QueryIndex& index)
+	{
+		return sizeof(QueryIndex) + index.MemoryUsage();
+	});
+}
+
+size_t HorizontalAlignment::FindElement(const Mileage& mileage) const
+{
+	const auto index = Index();
+	const auto& xys = _state->Xys;
+	// 起点里程不大于mileage的最后一个线元。相邻线元首尾相接，公共端点归后一个线元，两者在该点坐标相同
+	const auto next = std::upper_bound(index->StartMileages.begin(), index->StartMileages.end(), mileage.Value());
+	if (next != index->StartMileages.begin())
+	{
+		const uint32_t element = index->MileageOrder[next - index->StartMileages.begin() - 1];
+		if (xys[element].Element->IsOnIt(mileage))
+		{
+			return element;
+		}
+	}
+	throw NotInLineException(L"该里程不在线路上");
 }
 
-void HorizontalAlignment::RefreshXys()
+MemoryReport HorizontalAlignment::MemoryUsage() const
 {
-	// 计算所有交点里程
-	std::vector<double> jdMileages;
-	for (size_t i = 0; i < _jds.size(); ++i)
+	MemoryReport report;
+	std::unordered_set<const void*> visited;
+	MemoryUsage(report, visited);
+	return report;
+}
+
+void HorizontalAlignment::MemoryUsage(MemoryReport& report, std::unordered_set<const void*>& visited) const
+{
+	report.Inputs += _jds.MemoryUsage(visited);
+	MemoryUsage(*_state, report, visited);
+	for (const auto* stack : {&_history.Undo, &_history.Redo})
 	{
-		if (i == 0)
+		for (const auto& entry : *stack)
 		{
-			jdMileages.push_back(_jds[0].StartMileage);
+			// 历史记录中缓存的线元和空间索引都计入历史记录
+			MemoryReport cached;
+			cached.Inputs += sizeof(HistoryEntry) + entry.Jds.MemoryUsage(visited);
+			if (entry.State != nullptr)
+			{
+				MemoryUsage(*entry.State, cached, visited);
+			}
+			report.History += cached.Total();
+		}
+	}
+}
+
+size_t HorizontalAlignment::MemoryUsage(std::unordered_set<const void*>& visited) const
+{
+	MemoryReport report;
+	MemoryUsage(report, visited);
+	return report.Total();
+}
+
+void HorizontalAlignment::MemoryUsage(const ElementState& state, MemoryReport& report,
+                                      std::unordered_set<const void*>& visited)
+{
+	if (!visited.insert(&state).second)
+	{
+		return;
+	}
+	report.Elements += sizeof(ElementState) + state.Jds.MemoryUsage(visited);
+	// 只统计驻留的索引，已被淘汰的不占内存
+	if (const auto index = state.Index.Current())
+	{
+		report.Indices += index->MemoryUsage();
+	}
+	report.Elements += state.Xys.MemoryUsage(visited, [&visited](const XyEntry& xy)
+	{
+		// 线元对象按make_shared的一次分配计
+		size_t size = StringHeapBytes(xy.Key);
+		if (visited.insert(xy.Element.get()).second)
+		{
+			size += 2 * sizeof(void*) +
+				(dynamic_cast<const Curve*>(xy.Element.get()) != nullptr ? sizeof(Curve) : sizeof(IntermediateLine));
+		}
+		return size;
+	});
+}
+
+struct HorizontalAlignment::BuiltElements
+{
+	explicit BuiltElements(std::pmr::memory_resource* resource) : Jds(resource), JdMileages(resource),
+	                                                              Curves(resource), Lines(resource)
+	{
+	}
+
+	/// 写入了里程等派生字段的交点
+	std::pmr::vector<Jd> Jds;
+	std::pmr::vector<double> JdMileages;
+	/// 曲线k+1在Curves[k]，夹直线k+1在Lines[k]
+	std::pmr::vector<std::optional<Curve>> Curves;
+	std::pmr::vector<std::optional<IntermediateLine>> Lines;
+
+	[[nodiscard]] size_t Count() const
+	{
+		return Curves.size() + Lines.size();
+	}
+
+	/// 按GetXys()的顺序：曲线k为2(k-1)，夹直线k为2k-1，最后一条夹直线在末尾
+	[[nodiscard]] bool IsCurve(const size_t index) const
+	{
+		return index % 2 == 0 && index / 2 < Curves.size();
+	}
+
+	[[nodiscard]] const LineElement& Element(const size_t index) const
+	{
+		if (IsCurve(index))
+		{
+			return *Curves[index / 2];
+		}
+		return *Lines[index / 2];
+	}
+
+	/// 线元名写入buffer，返回指向buffer的视图。不经过std::format，避免每个线元都分配一次字符串
+	std::wstring_view Key(const size_t index, std::array<wchar_t, 32>& buffer) const
+	{
+		const std::wstring_view prefix = IsCurve(index) ? L"曲线" : L"夹直线";
+		std::array<char, 24> digits{};
+		char* digitsEnd = std::to_chars(digits.data(), digits.data() + digits.size(), index / 2 + 1).ptr;
+		auto out = std::copy(prefix.begin(), prefix.end(), buffer.begin());
+		out = std::copy(digits.data(), digitsEnd, out);
+		return {buffer.data(), static_cast<size_t>(out - buffer.begin())};
+	}
+
+	/// 把线元复制到堆上，供刷新后的线路长期持有
+	[[nodiscard]] std::shared_ptr<LineElement> Share(const size_t index) const
+	{
+		if (IsCurve(index))
+		{
+			return std::make_shared<Curve>(*Curves[index / 2]);
+		}
+		return std::make_shared<IntermediateLine>(*Lines[index / 2]);
+	}
+};
+
+ChangeSet HorizontalAlignment::RefreshXys()
+{
+	VIZRAIL_TRACE_TIMED("HorizontalAlignment::RefreshXys", RefreshNanoseconds);
+	VIZRAIL_TRACE_COUNT(Refreshes, 1);
+
+	// 临时结果都在当前线程的分配区中构造，刷新结束时整体释放。
+	// 交点参数非法导致构造失败时交点和线元均保持不变
+	const RefreshArena::Scope arena;
+	BuiltElements built(arena.Resource());
+	BuildXys(built);
+
+	auto state = std::allocate_shared<ElementState>(std::pmr::polymorphic_allocator<ElementState>(&StatePool()));
+	state->Revision = NextRevision++;
+
+	// 与刷新前相同的线元沿用原对象和修订号，使线路副本之间共享线元，只有变化的线元才复制到堆上
+	const auto& previousXys = _state->Xys;
+	const size_t count = built.Count();
+	std::pmr::vector<XyEntry> changed(count, arena.Resource());
+	std::pmr::vector<const XyEntry*> entries(count, arena.Resource());
+	std::array<wchar_t, 32> buffer{};
+	for (size_t i = 0; i < count; ++i)
+	{
+		const std::wstring_view key = built.Key(i, buffer);
+		const LineElement& element = built.Element(i);
+		const size_t index = XyIndex(key, previousXys.Size());
+		if (index < previousXys.Size() && previousXys[index].Key == key &&
+			previousXys[index].Element->Equals(element))
+		{
+			entries[i] = &previousXys[index];
 		}
 		else
 		{
-			jdMileages.push_back(jdMileages[i - 1] + Jd::Distance(_jds[i], _jds[i - 1]));
+			changed[i] = {std::wstring(key), built.Share(i), state->Revision};
+			entries[i] = &changed[i];
+			VIZRAIL_TRACE_COUNT(ElementsRebuilt, 1);
+		}
+		state->Extents.Extend(element.Bounds());
+	}
+	for (const auto& jd : built.Jds)
+	{
+		state->Extents.Extend({jd.E, jd.N});
+	}
+
+	// 写回时只复制内容发生变化的分块，其余分块与刷新前（及线路的其他副本）共享
+	state->Xys = previousXys.Assign(count, [&entries](const size_t i) -> const XyEntry&
+	{
+		return *entries[i];
+	}, [](const XyEntry& a, const XyEntry& b)
+	{
+		return a.Element == b.Element && a.Revision == b.Revision && a.Key == b.Key;
+	});
+	state->Jds = _state->Jds.Assign(std::span<const Jd>(built.Jds), SameJd);
+
+	ChangeSet changes = DiffElements(*_state, *state, arena.Resource());
+	_state = std::move(state);
+	return changes;
+}
+
+ChangeSet HorizontalAlignment::DiffElements(const ElementState& previous, const ElementState& state,
+                                             std::pmr::memory_resource* resource)
+{
+	VIZRAIL_TRACE_SCOPE("HorizontalAlignment::DiffElements");
+	// GetXys()中曲线排在其前一条夹直线之前，先按里程排序得到沿线顺序
+	// 起点里程相同时按原顺序，与稳定排序相同；std::stable_sort的临时缓冲直接向堆申请，不经过分配区
+	const auto sortByMileage = [resource](const PersistentVector<XyEntry>& xys)
+	{
+		std::pmr::vector<std::pair<double, const XyEntry*>> keyed(resource);
+		keyed.reserve(xys.Size());
+		for (const auto& xy : xys)
+		{
+			keyed.emplace_back(xy.Element->StartMileage().Value(), &xy);
 		}
+		std::pmr::vector<size_t> order(keyed.size(), resource);
+		std::iota(order.begin(), order.end(), size_t{0});
+		std::ranges::sort(order, [&keyed](const size_t a, const size_t b)
+		{
+			return keyed[a].first < keyed[b].first || (keyed[a].first == keyed[b].first && a < b);
+		});
+		std::pmr::vector<const XyEntry*> entries(resource);
+		entries.reserve(order.size());
+		for (const size_t i : order)
+		{
+			entries.push_back(keyed[i].second);
+		}
+		return entries;
+	};
+	const auto previousEntries = sortByMileage(previous.Xys);
+	const auto currentEntries = sortByMileage(state.Xys);
+	const auto before = [&](const size_t i) -> const LineElement& { return *previousEntries[i]->Element; };
+	const auto current = [&](const size_t i) -> const LineElement& { return *currentEntries[i]->Element; };
+
+	// 一次编辑只改变沿线连续的一段线元：从两端分别跳过形状相同的线元，剩下的即为几何变化的线元
+	const size_t oldSize = previousEntries.size();
+	const size_t newSize = currentEntries.size();
+	size_t prefix = 0;
+	while (prefix < oldSize && prefix < newSize && current(prefix).SameShape(before(prefix)))
+	{
+		++prefix;
+	}
+	size_t suffix = 0;
+	while (suffix < oldSize - prefix && suffix < newSize - prefix &&
+		current(newSize - 1 - suffix).SameShape(before(oldSize - 1 - suffix)))
+	{
+		++suffix;
 	}
 
-	if (_jds.size() > 2)
+	ChangeSet changes;
+	if (suffix > 0)
 	{
-		// 交点数大于2时，构造曲线和夹直线对象
+		changes.MileageShift = current(newSize - suffix).StartMileage().Value() -
+			before(oldSize - suffix).StartMileage().Value();
+	}
 
-		unsigned int jzxCount = 0;
-		unsigned int curveCount = 0;
-		size_t i = 1;
-		for (; i < _jds.size() - 1; ++i)
+	const size_t end = newSize - suffix;
+	if (prefix < end)
+	{
+		changes.StartMileage = current(prefix).StartMileage().Value();
+		changes.EndMileage = current(end - 1).EndMileage().Value();
+		for (size_t i = prefix; i < end; ++i)
 		{
-			// 遍历交点序列（除了第一个和最后一个交点），分别构造曲线和当前曲线的前一个夹直线
-			Point2D jd1 = {_jds[i - 1].E, _jds[i - 1].N};
-			Point2D jd2 = {_jds[i].E, _jds[i].N};
-			Point2D jd3 = {_jds[i + 1].E, _jds[i + 1].N};
-			// 构造曲线对象
-			++curveCount;
-			const double r = _jds[i].R;
-			const double ls = _jds[i].Ls;
-			auto curve = std::make_shared<Curve>(jd1, jd2, jd3, r, ls, jdMileages[i]);
+			changes.AffectedElements.push_back(currentEntries[i]->Key);
+		}
+	}
+	else if (suffix > 0)
+	{
+		// 只删除了线元，变化区间退化为下游第一个线元的起点
+		changes.StartMileage = changes.EndMileage = current(end).StartMileage().Value();
+	}
+	else if (prefix > 0)
+	{
+		changes.StartMileage = changes.EndMileage = current(prefix - 1).EndMileage().Value();
+	}
+	return changes;
+}
+
+void HorizontalAlignment::BuildXys(BuiltElements& built) const
+{
+	VIZRAIL_TRACE_SCOPE("HorizontalAlignment::BuildXys");
+	auto& jds = built.Jds;
+	jds.assign(_jds.begin(), _jds.end());
+	const size_t count = jds.size();
+
+	// 计算所有交点里程。各段距离可以并行计算，累加必须保持从前往后的顺序，
+	// 否则浮点舍入不同，里程会与逐个累加的结果有微小差异
+	auto& jdMileages = built.JdMileages;
+	jdMileages.resize(count);
+	ForEachIndex(count, [&](const size_t i)
+	{
+		jdMileages[i] = i == 0 ? jds[0].StartMileage : Jd::Distance(jds[i], jds[i - 1]);
+	});
+	std::partial_sum(jdMileages.begin(), jdMileages.end(), jdMileages.begin());
 
-			const auto th = curve->T_H();
-			const auto lh = curve->L_H();
-			_jds[i].StartMileage = jdMileages[i] - th;
-			_jds[i].EndMileage = jdMileages[i] + th;
-			_jds[i].TH = th;
-			_jds[i].LH = lh;
+	if (count > 2)
+	{
+		// 交点数大于2时，构造曲线和夹直线对象。曲线k只依赖交点k-1、k、k+1和交点k的里程，
+		// 夹直线k只依赖曲线k-1和曲线k，因此先并行构造全部曲线，再并行构造全部夹直线
+		const size_t curveCount = count - 2;
+		auto& curves = built.Curves;
+		auto& lines = built.Lines;
+		curves.resize(curveCount);
+		lines.resize(curveCount + 1);
+
+		ForEachIndex(curveCount, [&](const size_t k)
+		{
+			// 曲线k+1位于交点i处
+			const size_t i = k + 1;
+			const Point2D jd1 = {jds[i - 1].E, jds[i - 1].N};
+			const Point2D jd2 = {jds[i].E, jds[i].N};
+			const Point2D jd3 = {jds[i + 1].E, jds[i + 1].N};
+			const auto& curve = curves[k].emplace(jd1, jd2, jd3, jds[i].R, jds[i].Ls, jdMileages[i]);
 
-			std::wstring key = std::format(L"曲线{}", curveCount);
-			_xys.insert_or_assign(key, curve);
-			_xysOrder.emplace_back(key);
+			const auto th = curve.T_H();
+			const auto lh = curve.L_H();
+			jds[i].StartMileage = jdMileages[i] - th;
+			jds[i].EndMileage = jdMileages[i] + th;
+			jds[i].TH = th;
+			jds[i].LH = lh;
+		});
 
-			// 构造夹直线对象
-			++jzxCount;
-			double jzxStartMileage = 0.0;
+		ForEachIndex(curveCount, [&](const size_t k)
+		{
+			// 夹直线k+1位于曲线k+1之前，终点为曲线k+1的ZH点
 			Point2D startPoint;
-			if (jzxCount == 1)
+			double startMileage = 0.0;
+			if (k == 0)
 			{
-				// 第一条夹直线的起点为第一个交点
-				startPoint = Point2D{_jds[i - 1].E, _jds[i - 1].N};
-				// 第一条夹直线的起点里程为第一个交点里程
-				jzxStartMileage = jdMileages[i - 1];
+				// 第一条夹直线的起点为第一个交点，起点里程为第一个交点里程
+				startPoint = Point2D{jds[0].E, jds[0].N};
+				startMileage = jdMileages[0];
 			}
 			else
 			{
-				// 不是第一条夹直线时，起点为上一条曲线的HZ点
-				const auto lastCurve = std::dynamic_pointer_cast<Curve>(
-					_xys.at(std::format(L"曲线{}", curveCount - 1)));
-				startPoint = lastCurve->SpecialPointCoordinate(SpecialPoint::HZ);
-				// 不是第一条夹直线时，起点里程为上一条曲线的HZ点里程
-				jzxStartMileage = lastCurve->K(SpecialPoint::HZ).Value();
+				// 不是第一条夹直线时，起点为上一条曲线的HZ点，起点里程为上一条曲线的HZ点里程
+				startPoint = curves[k - 1]->SpecialPointCoordinate(SpecialPoint::HZ);
+				startMileage = curves[k - 1]->K(SpecialPoint::HZ).Value();
 			}
+			const Point2D endPoint = curves[k]->SpecialPointCoordinate(SpecialPoint::ZH);
+			const double endMileage = curves[k]->K(SpecialPoint::ZH).Value();
 
-			// 不是最后一条夹直线时，终点里程为当前曲线的ZH点里程
-			const double jzxEndMileage = curve->K(SpecialPoint::ZH).Value();
-
-			// 不是最后一条夹直线时，终点为当前曲线的ZH点
-			const Point2D endPoint = curve->SpecialPointCoordinate(SpecialPoint::ZH);
-
-			auto jzx = std::make_shared<IntermediateLine>(
-				startPoint, jzxStartMileage, endPoint, jzxEndMileage);
-			key = std::format(L"夹直线{}", jzxCount);
-			_xys.insert_or_assign(key, jzx);
-			_xysOrder.emplace_back(key);
-		}
+			lines[k].emplace(startPoint, startMileage, endPoint, endMileage);
+		});
 
 		// 构造最后一条夹直线，起点为最后一条曲线的HZ点，终点为最后一个交点，起点里程为最后一条曲线的HZ点里程，
 		// 终点里程为最后一条曲线的HZ点里程加直线长
-		const auto lastCurve = std::dynamic_pointer_cast<Curve>(
-			_xys.at(std::format(L"曲线{}", curveCount)));
+		const auto& lastCurve = curves.back();
 		const Point2D startPoint = lastCurve->SpecialPointCoordinate(SpecialPoint::HZ);
-		const Point2D endPoint = {_jds[i].E, _jds[i].N};
+		const Point2D endPoint = {jds[count - 1].E, jds[count - 1].N};
 		const double startMileage = lastCurve->K(SpecialPoint::HZ).Value();
 		const double endMileage = startMileage + Point2D::Distance(startPoint, endPoint);
-		auto jzx = std::make_shared<IntermediateLine>(
-			startPoint, startMileage, endPoint, endMileage);
-		_jds[i].StartMileage = endMileage;
-		_jds[i].EndMileage = endMileage;
-		const auto key = std::format(L"夹直线{}", jzxCount + 1);
-		_xys.insert_or_assign(key, jzx);
-		_xysOrder.emplace_back(key);
+		jds[count - 1].StartMileage = endMileage;
+		jds[count - 1].EndMileage = endMileage;
+		lines.back().emplace(startPoint, startMileage, endPoint, endMileage);
 	}
 	// 只有两个交点时，只构造一个夹直线对象，起点和终点分别为两个交点
-	if (_jds.size() == 2)
-	{
-		VizRailCore::Point2D jd1 = {_jds[0].E, _jds[0].N};
-		const double startMileage = jdMileages[0];
-		VizRailCore::Point2D jd2 = {_jds[1].E, _jds[1].N};
-		const double endMileage = jdMileages[1];
-		auto jzx = std::make_shared<VizRailCore::IntermediateLine>(jd1, startMileage, jd2, endMileage);
-		_xys.insert_or_assign(L"夹直线1", jzx);
+	if (count == 2)
+	{
+		const Point2D jd1 = {jds[0].E, jds[0].N};
+		const Point2D jd2 = {jds[1].E, jds[1].N};
+		built.Lines.emplace_back(std::in_place, jd1, jdMileages[0], jd2, jdMileages[1]);
 	}
 }
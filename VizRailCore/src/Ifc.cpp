@@ -0,0 +1,627 @@
+#include "Ifc.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <numbers>
+#include <random>
+#include <string_view>
+
+#include "BufferedFileWriter.h"
+#include "Curve.h"
+#include "Exceptions.h"
+#include "IntermediateLine.h"
+#include "Stationing.h"
+
+using namespace VizRailCore;
+
+namespace
+{
+	/// IFC GlobalId所用的64个字符
+	constexpr std::string_view GuidCharacters = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_$";
+
+	/// ISO 10303-21实体记录的输出流，实体编号按分配顺序递增
+	class StepStream final : public BufferedFileWriter
+	{
+	public:
+		explicit StepStream(const std::filesystem::path& path) : BufferedFileWriter(path),
+		                                                         _random(std::random_device{}())
+		{
+		}
+
+		/// 预先分配实体编号，用于在实体写出之前引用它
+		[[nodiscard]] uint64_t Reserve()
+		{
+			return _nextId++;
+		}
+
+		uint64_t Begin(const std::string_view type)
+		{
+			return Begin(type, Reserve());
+		}
+
+		uint64_t Begin(const std::string_view type, const uint64_t id)
+		{
+			_buffer += '#';
+			AppendInteger(id);
+			_buffer += '=';
+			_buffer += type;
+			_buffer += '(';
+			_first = true;
+			return id;
+		}
+
+		void End()
+		{
+			_buffer += ");\n";
+			FlushIfFull();
+		}
+
+		void Ref(const uint64_t id)
+		{
+			Separator();
+			_buffer += '#';
+			AppendInteger(id);
+		}
+
+		/// 按能精确还原的最短定点形式输出，STEP的实数必须带小数点
+		void Real(const double value)
+		{
+			Separator();
+			const size_t start = _buffer.size();
+			AppendReal(value);
+			if (_buffer.find('.', start) == std::string::npos)
+			{
+				_buffer += '.';
+			}
+		}
+
+		void Integer(const int64_t value)
+		{
+			Separator();
+			AppendInteger(value);
+		}
+
+		/// ASCII字符原样输出，其余字符写为\X2\（基本多文种平面）或\X4\控制指令
+		void String(const std::wstring_view value)
+		{
+			Separator();
+			_buffer += '\'';
+			const auto hex = [this](const uint32_t code, const int digits)
+			{
+				char text[8];
+				const auto result = std::to_chars(text, text + sizeof text, code, 16);
+				_buffer.append(digits - (result.ptr - text), '0');
+				for (const char* c = text; c != result.ptr; ++c)
+				{
+					_buffer += *c >= 'a' && *c <= 'f' ? static_cast<char>(*c - 'a' + 'A') : *c;
+				}
+			};
+			const char* open = nullptr;
+			for (const wchar_t c : value)
+			{
+				const auto code = static_cast<uint32_t>(c);
+				const char* needed = code >= 0x20 && code < 0x7F ? nullptr : code <= 0xFFFF ? "\\X2\\" : "\\X4\\";
+				if (open != needed && open != nullptr)
+				{
+					_buffer += "\\X0\\";
+				}
+				if (needed != nullptr && open != needed)
+				{
+					_buffer += needed;
+				}
+				open = needed;
+				if (needed == nullptr)
+				{
+					if (c == L'\'' || c == L'\\')
+					{
+						_buffer += static_cast<char>(c);
+					}
+					_buffer += static_cast<char>(c);
+				}
+				else
+				{
+					hex(code, code <= 0xFFFF ? 4 : 8);
+				}
+			}
+			if (open != nullptr)
+			{
+				_buffer += "\\X0\\";
+			}
+			_buffer += '\'';
+		}
+
+		void Enum(const std::string_view value)
+		{
+			Separator();
+			_buffer += '.';
+			_buffer += value;
+			_buffer += '.';
+		}
+
+		/// 未给出的可选属性
+		void Null()
+		{
+			Separator();
+			_buffer += '$';
+		}
+
+		/// 由子类型重新定义为派生属性
+		void Derived()
+		{
+			Separator();
+			_buffer += '*';
+		}
+
+		void BeginList()
+		{
+			Separator();
+			_buffer += '(';
+			_first = true;
+		}
+
+		void EndList()
+		{
+			_buffer += ')';
+			_first = false;
+		}
+
+		void RefList(const std::span<const uint64_t> ids)
+		{
+			BeginList();
+			for (const uint64_t id : ids)
+			{
+				Ref(id);
+			}
+			EndList();
+		}
+
+		/// 随机生成的22个字符的IfcGloballyUniqueId
+		void Guid()
+		{
+			const uint64_t high = _random();
+			const uint64_t low = _random();
+			uint8_t bytes[16];
+			for (int i = 0; i < 8; ++i)
+			{
+				bytes[i] = static_cast<uint8_t>(high >> (56 - 8 * i));
+				bytes[8 + i] = static_cast<uint8_t>(low >> (56 - 8 * i));
+			}
+			// 第一个字节编码为2个字符，其余每3个字节编码为4个字符
+			char text[22];
+			text[0] = GuidCharacters[bytes[0] >> 6];
+			text[1] = GuidCharacters[bytes[0] & 0x3F];
+			for (int group = 0; group < 5; ++group)
+			{
+				const uint32_t value = static_cast<uint32_t>(bytes[1 + 3 * group]) << 16 |
+					static_cast<uint32_t>(bytes[2 + 3 * group]) << 8 | bytes[3 + 3 * group];
+				for (int k = 0; k < 4; ++k)
+				{
+					text[2 + 4 * group + k] = GuidCharacters[value >> (18 - 6 * k) & 0x3F];
+				}
+			}
+			Separator();
+			_buffer += '\'';
+			_buffer.append(text, sizeof text);
+			_buffer += '\'';
+		}
+
+	private:
+		void Separator()
+		{
+			if (!_first)
+			{
+				_buffer += ',';
+			}
+			_first = false;
+		}
+
+		bool _first = true;
+		uint64_t _nextId = 1;
+		std::mt19937_64 _random;
+	};
+
+	/// 写出IfcRoot的公共属性GlobalId、OwnerHistory、Name、Description
+	void WriteRoot(StepStream& out, const std::wstring_view name = {})
+	{
+		out.Guid();
+		out.Null();
+		if (name.empty())
+		{
+			out.Null();
+		}
+		else
+		{
+			out.String(name);
+		}
+		out.Null();
+	}
+
+	void WriteRelNests(StepStream& out, const uint64_t parent, const std::span<const uint64_t> children)
+	{
+		out.Begin("IFCRELNESTS");
+		WriteRoot(out);
+		out.Ref(parent);
+		out.RefList(children);
+		out.End();
+	}
+
+	/// 方向角，自X轴（东）逆时针起算的弧度
+	double DirectionAngle(const Point2D& from, const Point2D& to)
+	{
+		return std::atan2(to.Y() - from.Y(), to.X() - from.X());
+	}
+
+	/// 圆弧上一点沿前进方向的方向角
+	double ArcDirection(const Point2D& point, const Point2D& center, const bool clockwise)
+	{
+		const double radial = DirectionAngle(center, point);
+		return std::remainder(clockwise ? radial - std::numbers::pi / 2 : radial + std::numbers::pi / 2,
+		                      2 * std::numbers::pi);
+	}
+
+	/// 一条线路的平面线形、超高和中线折线，按里程顺序逐段写出
+	class AlignmentWriter
+	{
+	public:
+		AlignmentWriter(StepStream& out, const IfcAlignmentSource& source, const IfcExportOptions& options,
+		                const uint64_t placement, const uint64_t axisContext) : _out(out), _source(source),
+			_options(options), _hasCant(!source.Cant.empty())
+		{
+			_alignment = out.Reserve();
+			const uint64_t shape = out.Reserve();
+			out.Begin("IFCALIGNMENT", _alignment);
+			WriteRoot(out, source.Name);
+			out.Null();
+			out.Ref(placement);
+			out.Ref(shape);
+			out.Null();
+			out.End();
+
+			_horizontal = out.Begin("IFCALIGNMENTHORIZONTAL");
+			WriteRoot(out);
+			out.Null();
+			out.Null();
+			out.Null();
+			out.End();
+			std::vector<uint64_t> layouts{_horizontal};
+			if (_hasCant)
+			{
+				_cant = out.Begin("IFCALIGNMENTCANT");
+				WriteRoot(out);
+				out.Null();
+				out.Null();
+				out.Null();
+				out.Real(options.RailHeadDistance);
+				out.End();
+				layouts.push_back(_cant);
+			}
+			WriteRelNests(out, _alignment, layouts);
+
+			WriteSegments();
+
+			const uint64_t polyline = out.Begin("IFCPOLYLINE");
+			out.RefList(_points);
+			out.End();
+			const uint64_t representation = out.Begin("IFCSHAPEREPRESENTATION");
+			out.Ref(axisContext);
+			out.String(L"Axis");
+			out.String(L"Curve2D");
+			out.RefList({&polyline, 1});
+			out.End();
+			out.Begin("IFCPRODUCTDEFINITIONSHAPE", shape);
+			out.Null();
+			out.Null();
+			out.RefList({&representation, 1});
+			out.End();
+		}
+
+		[[nodiscard]] uint64_t Id() const
+		{
+			return _alignment;
+		}
+
+	private:
+		void WriteSegments()
+		{
+			const HorizontalAlignment& alignment = *_source.Alignment;
+			const auto& xys = alignment.GetXys();
+			const auto order = ElementsByMileage(alignment);
+			size_t curveIndex = 0;
+			Point2D end;
+			double endDirection = 0.0;
+			for (const size_t index : order)
+			{
+				const LineElement& element = *xys[index].Element;
+				if (const auto curve = dynamic_cast<const Curve*>(&element))
+				{
+					// 按里程顺序的第k条曲线位于交点k+1处
+					++curveIndex;
+					const double cant = _hasCant ? _source.Cant[curveIndex] : 0.0;
+					WriteCurve(*curve, cant);
+					end = curve->SpecialPointCoordinate(SpecialPoint::HZ);
+					endDirection = DirectionAngle(curve->Jd2(), curve->Jd3());
+				}
+				else if (const auto line = dynamic_cast<const IntermediateLine*>(&element))
+				{
+					const double length = Point2D::Distance(line->StartPoint(), line->EndPoint());
+					if (length > 0.0)
+					{
+						endDirection = DirectionAngle(line->StartPoint(), line->EndPoint());
+						Horizontal(nullptr, nullptr, line->StartPoint(), endDirection, 0.0, 0.0, length, "LINE");
+						Cant(length, 0.0, 0.0, false, "CONSTANTCANT");
+						AddPoint(line->StartPoint());
+					}
+					end = line->EndPoint();
+				}
+			}
+			if (!order.empty())
+			{
+				// IFC 4.3要求平面线形和超高以零长度的段结尾
+				Horizontal(nullptr, nullptr, end, endDirection, 0.0, 0.0, 0.0, "LINE");
+				Cant(0.0, 0.0, 0.0, false, "CONSTANTCANT");
+				AddPoint(end);
+			}
+
+			WriteRelNests(_out, _horizontal, _horizontalSegments);
+			if (_hasCant)
+			{
+				WriteRelNests(_out, _cant, _cantSegments);
+			}
+		}
+
+		void WriteCurve(const Curve& curve, const double cant)
+		{
+			const Point2D zh = curve.SpecialPointCoordinate(SpecialPoint::ZH);
+			const Point2D hy = curve.SpecialPointCoordinate(SpecialPoint::HY);
+			const Point2D yh = curve.SpecialPointCoordinate(SpecialPoint::YH);
+			const Point2D center = curve.ArcCenter();
+			const Point2D jd1 = curve.Jd1();
+			const Point2D jd2 = curve.Jd2();
+			const Point2D jd3 = curve.Jd3();
+			const bool clockwise = (jd2.X() - jd1.X()) * (jd3.Y() - jd2.Y()) - (jd2.Y() - jd1.Y()) * (jd3.X() - jd2.X()) <
+				0.0;
+			// IFC中左转（逆时针）的曲率半径为正
+			const double radius = clockwise ? -curve.R() : curve.R();
+			const double ls = curve.Ls();
+			const double arcLength = curve.L_H() - 2 * ls;
+			if (ls > 0.0)
+			{
+				Horizontal("ZH", "HY", zh, DirectionAngle(jd1, jd2), 0.0, radius, ls, "CLOTHOID");
+				Cant(ls, 0.0, cant, clockwise, "LINEARTRANSITION");
+			}
+			if (arcLength > 0.0)
+			{
+				Horizontal("HY", "YH", hy, ArcDirection(hy, center, clockwise), radius, radius, arcLength,
+				           "CIRCULARARC");
+				Cant(arcLength, cant, cant, clockwise, "CONSTANTCANT");
+			}
+			if (ls > 0.0)
+			{
+				Horizontal("YH", "HZ", yh, ArcDirection(yh, center, clockwise), radius, 0.0, ls, "CLOTHOID");
+				Cant(ls, cant, 0.0, clockwise, "LINEARTRANSITION");
+			}
+
+			// 与BuildCenterline相同：弦长s的弦高约为s²/8R，缓和曲线上的曲率半径不小于R
+			const double start = curve.K(SpecialPoint::ZH).Value();
+			const double length = curve.K(SpecialPoint::HZ).Value() - start;
+			const double step = 2.0 * std::sqrt(2.0 * curve.R() * _options.ChordTolerance);
+			const size_t count = std::max<size_t>(1, static_cast<size_t>(std::ceil(length / step)));
+			for (size_t k = 0; k < count; ++k)
+			{
+				AddPoint(curve.MileageToCoordinate(
+					Mileage(start + length * static_cast<double>(k) / static_cast<double>(count))));
+			}
+		}
+
+		void Horizontal(const char* startTag, const char* endTag, const Point2D& start, const double direction,
+		                const double startRadius, const double endRadius, const double length,
+		                const std::string_view type)
+		{
+			const uint64_t point = _out.Begin("IFCCARTESIANPOINT");
+			_out.BeginList();
+			_out.Real(start.X());
+			_out.Real(start.Y());
+			_out.EndList();
+			_out.End();
+
+			const uint64_t parameters = _out.Begin("IFCALIGNMENTHORIZONTALSEGMENT");
+			for (const char* tag : {startTag, endTag})
+			{
+				if (tag == nullptr)
+				{
+					_out.Null();
+				}
+				else
+				{
+					_out.String(std::wstring(tag, tag + std::char_traits<char>::length(tag)));
+				}
+			}
+			_out.Ref(point);
+			_out.Real(direction);
+			_out.Real(startRadius);
+			_out.Real(endRadius);
+			_out.Real(length);
+			_out.Null();
+			_out.Enum(type);
+			_out.End();
+			_horizontalSegments.push_back(Segment(parameters));
+		}
+
+		/// \brief 写出与平面线形段对应的超高段，外轨抬高cant
+		void Cant(const double length, const double startCant, const double endCant, const bool clockwise,
+		          const std::string_view type)
+		{
+			if (!_hasCant)
+			{
+				return;
+			}
+			// 右转（顺时针）曲线的外轨为左轨
+			const double startLeft = clockwise ? startCant : 0.0;
+			const double endLeft = clockwise ? endCant : 0.0;
+			const double startRight = clockwise ? 0.0 : startCant;
+			const double endRight = clockwise ? 0.0 : endCant;
+			const uint64_t parameters = _out.Begin("IFCALIGNMENTCANTSEGMENT");
+			_out.Null();
+			_out.Null();
+			_out.Real(_cantDistance);
+			_out.Real(length);
+			_out.Real(startLeft);
+			_out.Real(endLeft);
+			_out.Real(startRight);
+			_out.Real(endRight);
+			_out.Enum(type);
+			_out.End();
+			_cantSegments.push_back(Segment(parameters));
+			_cantDistance += length;
+		}
+
+		/// 包装设计参数的IfcAlignmentSegment
+		uint64_t Segment(const uint64_t parameters)
+		{
+			const uint64_t segment = _out.Begin("IFCALIGNMENTSEGMENT");
+			WriteRoot(_out);
+			_out.Null();
+			_out.Null();
+			_out.Null();
+			_out.Ref(parameters);
+			_out.End();
+			return segment;
+		}
+
+		void AddPoint(const Point2D& point)
+		{
+			_points.push_back(_out.Begin("IFCCARTESIANPOINT"));
+			_out.BeginList();
+			_out.Real(point.X());
+			_out.Real(point.Y());
+			_out.EndList();
+			_out.End();
+		}
+
+		StepStream& _out;
+		const IfcAlignmentSource& _source;
+		const IfcExportOptions& _options;
+		bool _hasCant;
+		uint64_t _alignment = 0;
+		uint64_t _horizontal = 0;
+		uint64_t _cant = 0;
+		double _cantDistance = 0.0;
+		// 集合关系需要的实体编号，每个8字节，不保留实体本身
+		std::vector<uint64_t> _horizontalSegments;
+		std::vector<uint64_t> _cantSegments;
+		std::vector<uint64_t> _points;
+	};
+}
+
+void VizRailCore::SaveIfc(const std::filesystem::path& path, const std::span<const IfcAlignmentSource> alignments,
+                          const IfcExportOptions& options)
+{
+	if (!(options.ChordTolerance > 0.0))
+	{
+		throw VizRailCoreException(L"弦高容差必须大于0");
+	}
+	for (const auto& alignment : alignments)
+	{
+		if (!alignment.Cant.empty() && alignment.Cant.size() != alignment.Alignment->GetJds().Size())
+		{
+			throw VizRailCoreException(std::format(L"线路{}的超高数与交点数不符", alignment.Name));
+		}
+	}
+
+	StepStream out(path);
+	const auto now = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+	const auto today = std::chrono::floor<std::chrono::days>(now);
+	const std::chrono::year_month_day date(today);
+	const std::chrono::hh_mm_ss time(now - today);
+	out.Raw("ISO-10303-21;\nHEADER;\nFILE_DESCRIPTION(('ViewDefinition [Alignment-basedView]'),'2;1');\n");
+	out.Raw(std::format("FILE_NAME('','{:04}-{:02}-{:02}T{:02}:{:02}:{:02}',(''),(''),'VizRail','VizRail','');\n",
+	                    static_cast<int>(date.year()), static_cast<unsigned>(date.month()),
+	                    static_cast<unsigned>(date.day()), time.hours().count(), time.minutes().count(),
+	                    time.seconds().count()));
+	out.Raw("FILE_SCHEMA(('IFC4X3_ADD2'));\nENDSEC;\nDATA;\n");
+
+	const uint64_t project = out.Reserve();
+	const uint64_t length = out.Begin("IFCSIUNIT");
+	out.Derived();
+	out.Enum("LENGTHUNIT");
+	out.Null();
+	out.Enum("METRE");
+	out.End();
+	const uint64_t angle = out.Begin("IFCSIUNIT");
+	out.Derived();
+	out.Enum("PLANEANGLEUNIT");
+	out.Null();
+	out.Enum("RADIAN");
+	out.End();
+	const uint64_t units = out.Begin("IFCUNITASSIGNMENT");
+	const uint64_t unitList[] = {length, angle};
+	out.RefList(unitList);
+	out.End();
+
+	const uint64_t origin = out.Begin("IFCCARTESIANPOINT");
+	out.BeginList();
+	out.Real(0.0);
+	out.Real(0.0);
+	out.Real(0.0);
+	out.EndList();
+	out.End();
+	const uint64_t axes = out.Begin("IFCAXIS2PLACEMENT3D");
+	out.Ref(origin);
+	out.Null();
+	out.Null();
+	out.End();
+	const uint64_t context = out.Begin("IFCGEOMETRICREPRESENTATIONCONTEXT");
+	out.Null();
+	out.String(L"Model");
+	out.Integer(3);
+	out.Real(1e-5);
+	out.Ref(axes);
+	out.Null();
+	out.End();
+	const uint64_t axisContext = out.Begin("IFCGEOMETRICREPRESENTATIONSUBCONTEXT");
+	out.String(L"Axis");
+	out.String(L"Model");
+	for (int i = 0; i < 4; ++i)
+	{
+		out.Derived();
+	}
+	out.Ref(context);
+	out.Null();
+	out.Enum("MODEL_VIEW");
+	out.Null();
+	out.End();
+
+	out.Begin("IFCPROJECT", project);
+	WriteRoot(out, options.ProjectName);
+	out.Null();
+	out.Null();
+	out.Null();
+	out.RefList({&context, 1});
+	out.Ref(units);
+	out.End();
+
+	const uint64_t placement = out.Begin("IFCLOCALPLACEMENT");
+	out.Null();
+	out.Ref(axes);
+	out.End();
+
+	std::vector<uint64_t> ids;
+	for (const auto& alignment : alignments)
+	{
+		ids.push_back(AlignmentWriter(out, alignment, options, placement, axisContext).Id());
+	}
+	if (!ids.empty())
+	{
+		out.Begin("IFCRELAGGREGATES");
+		WriteRoot(out);
+		out.Ref(project);
+		out.RefList(ids);
+		out.End();
+	}
+
+	out.Raw("ENDSEC;\nEND-ISO-10303-21;\n");
+	out.Close();
+}
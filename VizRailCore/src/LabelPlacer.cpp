@@ -0,0 +1,158 @@
+#include "LabelPlacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+using namespace VizRailCore;
+
+namespace
+{
+	// 相接的文字框不算重叠
+	constexpr double OverlapEpsilon = 1e-9;
+
+	uint64_t CellKey(const int64_t ix, const int64_t iy)
+	{
+		return static_cast<uint64_t>(ix) << 32 ^ static_cast<uint32_t>(iy);
+	}
+}
+
+LabelPlacer::LabelPlacer(const double cellSize) : _cellSize(cellSize)
+{
+	if (!(cellSize > 0.0))
+	{
+		throw std::invalid_argument("cellSize cannot be negative or zero");
+	}
+}
+
+std::vector<int> LabelPlacer::Place(const std::vector<LabelRequest>& labels)
+{
+	std::vector<uint32_t> order(labels.size());
+	std::iota(order.begin(), order.end(), 0u);
+	std::stable_sort(order.begin(), order.end(), [&labels](const uint32_t a, const uint32_t b)
+	{
+		return labels[a].Priority < labels[b].Priority;
+	});
+
+	std::vector<int> result(labels.size(), -1);
+	for (const auto index : order)
+	{
+		const auto& label = labels[index];
+		result[index] = TryPlace(label.Width, label.Height, label.Candidates);
+	}
+	return result;
+}
+
+int LabelPlacer::TryPlace(const double width, const double height, const std::vector<LabelCandidate>& candidates)
+{
+	for (size_t i = 0; i < candidates.size(); ++i)
+	{
+		const Box box = MakeBox(candidates[i], width, height);
+		if (!Collides(box))
+		{
+			Insert(box);
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
+
+void LabelPlacer::Clear()
+{
+	_boxes.clear();
+	_grid.clear();
+}
+
+double LabelPlacer::EstimateWidth(const std::wstring& text, const double height)
+{
+	double width = 0.0;
+	for (const wchar_t c : text)
+	{
+		width += c < 0x2E80 ? 0.8 * height : height;
+	}
+	return width;
+}
+
+LabelPlacer::Box LabelPlacer::MakeBox(const LabelCandidate& candidate, const double width, const double height)
+{
+	const double length = std::hypot(candidate.DirectionX, candidate.DirectionY);
+	const double ux = length > 0.0 ? candidate.DirectionX / length : 1.0;
+	const double uy = length > 0.0 ? candidate.DirectionY / length : 0.0;
+	// 文字向上的方向为基线方向逆时针旋转90度
+	const double centerX = candidate.Position.X() + ux * width / 2 - uy * height / 2;
+	const double centerY = candidate.Position.Y() + uy * width / 2 + ux * height / 2;
+	return {centerX, centerY, ux, uy, width / 2, height / 2};
+}
+
+bool LabelPlacer::Overlaps(const Box& a, const Box& b)
+{
+	// 分离轴定理：两个矩形的四条边法向上投影均重叠时才相交
+	const double dx = b.CenterX - a.CenterX;
+	const double dy = b.CenterY - a.CenterY;
+	const double axes[4][2] = {{a.UX, a.UY}, {-a.UY, a.UX}, {b.UX, b.UY}, {-b.UY, b.UX}};
+	for (const auto& axis : axes)
+	{
+		const double distance = std::abs(dx * axis[0] + dy * axis[1]);
+		const double ra = a.HalfWidth * std::abs(a.UX * axis[0] + a.UY * axis[1]) +
+			a.HalfHeight * std::abs(-a.UY * axis[0] + a.UX * axis[1]);
+		const double rb = b.HalfWidth * std::abs(b.UX * axis[0] + b.UY * axis[1]) +
+			b.HalfHeight * std::abs(-b.UY * axis[0] + b.UX * axis[1]);
+		if (distance >= ra + rb - OverlapEpsilon)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename Visitor>
+void LabelPlacer::ForEachCell(const Box& box, Visitor&& visitor) const
+{
+	// 有向矩形的轴对齐外包范围
+	const double extentX = box.HalfWidth * std::abs(box.UX) + box.HalfHeight * std::abs(box.UY);
+	const double extentY = box.HalfWidth * std::abs(box.UY) + box.HalfHeight * std::abs(box.UX);
+	const auto minX = static_cast<int64_t>(std::floor((box.CenterX - extentX) / _cellSize));
+	const auto maxX = static_cast<int64_t>(std::floor((box.CenterX + extentX) / _cellSize));
+	const auto minY = static_cast<int64_t>(std::floor((box.CenterY - extentY) / _cellSize));
+	const auto maxY = static_cast<int64_t>(std::floor((box.CenterY + extentY) / _cellSize));
+	for (int64_t ix = minX; ix <= maxX; ++ix)
+	{
+		for (int64_t iy = minY; iy <= maxY; ++iy)
+		{
+			visitor(CellKey(ix, iy));
+		}
+	}
+}
+
+bool LabelPlacer::Collides(const Box& box) const
+{
+	bool collides = false;
+	ForEachCell(box, [this, &box, &collides](const uint64_t key)
+	{
+		if (collides)
+		{
+			return;
+		}
+		const auto it = _grid.find(key);
+		if (it == _grid.end())
+		{
+			return;
+		}
+		collides = std::any_of(it->second.begin(), it->second.end(), [this, &box](const uint32_t other)
+		{
+			return Overlaps(box, _boxes[other]);
+		});
+	});
+	return collides;
+}
+
+void LabelPlacer::Insert(const Box& box)
+{
+	const auto index = static_cast<uint32_t>(_boxes.size());
+	_boxes.push_back(box);
+	ForEachCell(box, [this, index](const uint64_t key)
+	{
+		_grid[key].push_back(index);
+	});
+}
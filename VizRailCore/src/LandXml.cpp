@@ -0,0 +1,1147 @@
+#include "LandXml.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+#include "BufferedFileWriter.h"
+#include "Curve.h"
+#include "Exceptions.h"
+#include "IntermediateLine.h"
+#include "MappedFile.h"
+#include "Stationing.h"
+#include "Utf8.h"
+
+using namespace VizRailCore;
+
+namespace
+{
+	// 相邻几何元素首尾点允许的距离（米），LandXML中的坐标常舍入到毫米
+	constexpr double ContinuityTolerance = 0.01;
+	// 前后缓和曲线长允许的差（米）
+	constexpr double TransitionTolerance = 0.001;
+	// 相邻直线方向差的正弦值不超过此值时视为共线
+	constexpr double CollinearTolerance = 1e-6;
+
+	struct Vector2D
+	{
+		double X = 0.0;
+		double Y = 0.0;
+	};
+
+	Vector2D Direction(const Point2D& from, const Point2D& to)
+	{
+		return {to.X() - from.X(), to.Y() - from.Y()};
+	}
+
+	double Cross(const Vector2D& a, const Vector2D& b)
+	{
+		return a.X * b.Y - a.Y * b.X;
+	}
+
+	double Norm(const Vector2D& v)
+	{
+		return std::hypot(v.X, v.Y);
+	}
+
+	/// 圆弧上一点沿前进方向的切线
+	Vector2D ArcTangent(const Point2D& point, const Point2D& center, const bool clockwise)
+	{
+		const Vector2D radius = Direction(center, point);
+		return clockwise ? Vector2D{radius.Y, -radius.X} : Vector2D{-radius.Y, radius.X};
+	}
+
+	/// \brief 求过point1沿direction1和过point2沿direction2的两条直线的交点
+	/// \return 两直线平行时为空；t1、t2为交点在两直线上的参数
+	std::optional<Point2D> Intersect(const Point2D& point1, const Vector2D& direction1, const Point2D& point2,
+	                                 const Vector2D& direction2, double* t1 = nullptr, double* t2 = nullptr)
+	{
+		const double denominator = Cross(direction1, direction2);
+		if (std::abs(denominator) <= CollinearTolerance * Norm(direction1) * Norm(direction2))
+		{
+			return std::nullopt;
+		}
+		const Vector2D offset = Direction(point1, point2);
+		const double s = Cross(offset, direction2) / denominator;
+		if (t1 != nullptr)
+		{
+			*t1 = s;
+		}
+		if (t2 != nullptr)
+		{
+			*t2 = Cross(offset, direction1) / denominator;
+		}
+		return Point2D{point1.X() + s * direction1.X, point1.Y() + s * direction1.Y};
+	}
+
+	// ---- 写出 ----
+
+	/// 缓冲写出的XML文本
+	class XmlStream final : public BufferedFileWriter
+	{
+	public:
+		using BufferedFileWriter::BufferedFileWriter;
+
+		/// 转义后以UTF-8输出，控制字符替换为空格
+		void Escaped(const std::wstring_view text)
+		{
+			size_t start = 0;
+			for (size_t i = 0; i <= text.size(); ++i)
+			{
+				const char* entity = nullptr;
+				if (i < text.size())
+				{
+					switch (text[i])
+					{
+					case L'&': entity = "&amp;";
+						break;
+					case L'<': entity = "&lt;";
+						break;
+					case L'>': entity = "&gt;";
+						break;
+					case L'"': entity = "&quot;";
+						break;
+					default:
+						if (static_cast<uint32_t>(text[i]) < 0x20)
+						{
+							entity = " ";
+						}
+						break;
+					}
+					if (entity == nullptr)
+					{
+						continue;
+					}
+				}
+				AppendUtf8(_buffer, text.substr(start, i - start));
+				if (entity != nullptr)
+				{
+					_buffer += entity;
+				}
+				start = i + 1;
+			}
+		}
+
+		void Attribute(const std::string_view name, const double value)
+		{
+			_buffer += ' ';
+			_buffer += name;
+			_buffer += "=\"";
+			AppendReal(value);
+			_buffer += '"';
+		}
+
+		void Attribute(const std::string_view name, const std::string_view value)
+		{
+			_buffer += ' ';
+			_buffer += name;
+			_buffer += "=\"";
+			_buffer += value;
+			_buffer += '"';
+		}
+
+		/// 点元素，坐标为“北 东”
+		void Point(const std::string_view name, const Point2D& point)
+		{
+			_buffer += "<";
+			_buffer += name;
+			_buffer += ">";
+			AppendReal(point.Y());
+			_buffer += ' ';
+			AppendReal(point.X());
+			_buffer += "</";
+			_buffer += name;
+			_buffer += ">";
+		}
+	};
+
+	void WriteLine(XmlStream& out, const Point2D& start, const Point2D& end, const double startMileage)
+	{
+		const double length = Point2D::Distance(start, end);
+		// 零长度的直线（相邻曲线首尾相接）不写出
+		if (!(length > 0.0))
+		{
+			return;
+		}
+		out.Raw("<Line");
+		out.Attribute("staStart", startMileage);
+		out.Attribute("length", length);
+		out.Raw(">");
+		out.Point("Start", start);
+		out.Point("End", end);
+		out.Raw("</Line>\n");
+	}
+
+	void WriteSpiral(XmlStream& out, const Point2D& start, const Vector2D& startDirection, const Point2D& end,
+	                 const Vector2D& endDirection, const double length, const double radius, const bool entering,
+	                 const bool clockwise, const double startMileage)
+	{
+		out.Raw("<Spiral");
+		out.Attribute("staStart", startMileage);
+		out.Attribute("length", length);
+		if (entering)
+		{
+			out.Attribute("radiusStart", "INF");
+			out.Attribute("radiusEnd", radius);
+		}
+		else
+		{
+			out.Attribute("radiusStart", radius);
+			out.Attribute("radiusEnd", "INF");
+		}
+		out.Attribute("rot", clockwise ? "cw" : "ccw");
+		out.Attribute("spiType", "clothoid");
+		out.Raw(">");
+		out.Point("Start", start);
+		if (const auto pi = Intersect(start, startDirection, end, endDirection))
+		{
+			out.Point("PI", *pi);
+		}
+		out.Point("End", end);
+		out.Raw("</Spiral>\n");
+	}
+
+	void WriteCurve(XmlStream& out, const Curve& curve)
+	{
+		const Point2D zh = curve.SpecialPointCoordinate(SpecialPoint::ZH);
+		const Point2D hy = curve.SpecialPointCoordinate(SpecialPoint::HY);
+		const Point2D yh = curve.SpecialPointCoordinate(SpecialPoint::YH);
+		const Point2D hz = curve.SpecialPointCoordinate(SpecialPoint::HZ);
+		const Point2D center = curve.ArcCenter();
+		const Vector2D entry = Direction(curve.Jd1(), curve.Jd2());
+		const Vector2D exit = Direction(curve.Jd2(), curve.Jd3());
+		const bool clockwise = Cross(entry, exit) < 0.0;
+		const Vector2D hyTangent = ArcTangent(hy, center, clockwise);
+		const Vector2D yhTangent = ArcTangent(yh, center, clockwise);
+		const double ls = curve.Ls();
+
+		if (ls > 0.0)
+		{
+			WriteSpiral(out, zh, entry, hy, hyTangent, ls, curve.R(), true, clockwise,
+			            curve.K(SpecialPoint::ZH).Value());
+		}
+		const double arcLength = curve.L_H() - 2 * ls;
+		if (arcLength > 0.0)
+		{
+			out.Raw("<Curve");
+			out.Attribute("staStart", curve.K(SpecialPoint::HY).Value());
+			out.Attribute("length", arcLength);
+			out.Attribute("radius", curve.R());
+			out.Attribute("rot", clockwise ? "cw" : "ccw");
+			out.Attribute("crvType", "arc");
+			out.Raw(">");
+			out.Point("Start", hy);
+			out.Point("Center", center);
+			out.Point("End", yh);
+			// 圆心角不小于180°时切线不相交，PI是可选的
+			double t1 = 0.0;
+			double t2 = 0.0;
+			if (const auto pi = Intersect(hy, hyTangent, yh, yhTangent, &t1, &t2); pi && t1 > 0.0 && t2 < 0.0)
+			{
+				out.Point("PI", *pi);
+			}
+			out.Raw("</Curve>\n");
+		}
+		if (ls > 0.0)
+		{
+			WriteSpiral(out, yh, yhTangent, hz, exit, ls, curve.R(), false, clockwise,
+			            curve.K(SpecialPoint::YH).Value());
+		}
+	}
+
+	void WriteAlignment(XmlStream& out, const LandXmlAlignment& source)
+	{
+		const HorizontalAlignment& alignment = *source.Alignment;
+		const auto& xys = alignment.GetXys();
+		const auto& jds = alignment.GetJds();
+
+		out.Raw("<Alignment name=\"");
+		out.Escaped(source.Name);
+		out.Raw("\"");
+		out.Attribute("length", alignment.GetTotalMileage());
+		out.Attribute("staStart", jds.Size() == 0 ? 0.0 : jds[0].StartMileage);
+		out.Raw(">\n<CoordGeom>\n");
+		for (const size_t index : ElementsByMileage(alignment))
+		{
+			const LineElement& element = *xys[index].Element;
+			if (const auto curve = dynamic_cast<const Curve*>(&element))
+			{
+				WriteCurve(out, *curve);
+			}
+			else if (const auto line = dynamic_cast<const IntermediateLine*>(&element))
+			{
+				WriteLine(out, line->StartPoint(), line->EndPoint(), line->StartMileage().Value());
+			}
+		}
+		out.Raw("</CoordGeom>\n</Alignment>\n");
+	}
+
+	// ---- 读取 ----
+
+	bool IsSpace(const char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+
+	std::string_view Trim(std::string_view text)
+	{
+		while (!text.empty() && IsSpace(text.front()))
+		{
+			text.remove_prefix(1);
+		}
+		while (!text.empty() && IsSpace(text.back()))
+		{
+			text.remove_suffix(1);
+		}
+		return text;
+	}
+
+	/// 去掉名称空间前缀
+	std::string_view LocalName(const std::string_view name)
+	{
+		const size_t colon = name.find(':');
+		return colon == std::string_view::npos ? name : name.substr(colon + 1);
+	}
+
+	bool EqualsIgnoreCase(const std::string_view a, const std::string_view b)
+	{
+		return std::ranges::equal(a, b, [](const char x, const char y)
+		{
+			const auto lower = [](const char c)
+			{
+				return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+			};
+			return lower(x) == lower(y);
+		});
+	}
+
+	enum class XmlEvent
+	{
+		Start,
+		End,
+		Text,
+	};
+
+	/// 映射在内存中的XML的拉取式解析器，名称、属性和文本都是指向原文的视图，不分配内存。
+	/// 自闭合元素依次产生Start和End。只检查标签嵌套，不校验DTD，不展开自定义实体
+	class XmlReader
+	{
+	public:
+		XmlReader(const std::filesystem::path& path, const std::string_view text) : _path(path), _text(text)
+		{
+			if (_text.starts_with("\xEF\xBB\xBF"))
+			{
+				_offset = 3;
+			}
+		}
+
+		[[nodiscard]] XmlEvent Event() const
+		{
+			return _event;
+		}
+
+		/// 当前元素不含名称空间前缀的名称
+		[[nodiscard]] std::string_view Name() const
+		{
+			return LocalName(_name);
+		}
+
+		/// 当前文本，未还原实体引用
+		[[nodiscard]] std::string_view RawText() const
+		{
+			return _value;
+		}
+
+		/// 当前事件在文件中的字节位置
+		[[nodiscard]] size_t Position() const
+		{
+			return _position;
+		}
+
+		[[nodiscard]] TextEncoding Encoding() const
+		{
+			return _encoding;
+		}
+
+		/// \brief 读取下一个事件，忽略注释、处理指令和DOCTYPE
+		/// \return 文件结束时返回false
+		bool Next()
+		{
+			if (_pendingEnd)
+			{
+				_pendingEnd = false;
+				_event = XmlEvent::End;
+				return true;
+			}
+			while (_offset < _text.size())
+			{
+				_position = _offset;
+				if (_text[_offset] != '<')
+				{
+					const size_t end = std::min(_text.find('<', _offset), _text.size());
+					_value = _text.substr(_offset, end - _offset);
+					_offset = end;
+					_event = XmlEvent::Text;
+					return true;
+				}
+				const std::string_view rest = _text.substr(_offset);
+				if (rest.starts_with("<!--"))
+				{
+					_offset = Find("-->", _offset + 4) + 3;
+				}
+				else if (rest.starts_with("<![CDATA["))
+				{
+					const size_t end = Find("]]>", _offset + 9);
+					_value = _text.substr(_offset + 9, end - _offset - 9);
+					_offset = end + 3;
+					_event = XmlEvent::Text;
+					return true;
+				}
+				else if (rest.starts_with("<?"))
+				{
+					const size_t end = Find("?>", _offset + 2);
+					const std::string_view instruction = _text.substr(_offset + 2, end - _offset - 2);
+					if (instruction.starts_with("xml") && instruction.size() > 3 && IsSpace(instruction[3]))
+					{
+						ReadDeclaration(instruction);
+					}
+					_offset = end + 2;
+				}
+				else if (rest.starts_with("<!"))
+				{
+					SkipDeclaration();
+				}
+				else if (rest.starts_with("</"))
+				{
+					const size_t end = Find(">", _offset + 2);
+					_name = Trim(_text.substr(_offset + 2, end - _offset - 2));
+					_offset = end + 1;
+					if (_open.empty() || _open.back() != _name)
+					{
+						throw Error(std::format(L"结束标签{}与开始标签不匹配", Wide(_name)));
+					}
+					_open.pop_back();
+					_event = XmlEvent::End;
+					return true;
+				}
+				else
+				{
+					ReadStartTag();
+					return true;
+				}
+			}
+			if (!_open.empty())
+			{
+				_position = _text.size();
+				throw Error(std::format(L"元素{}没有结束", Wide(_open.back())));
+			}
+			return false;
+		}
+
+		/// 当前开始标签中属性的原始值，没有该属性时为空
+		[[nodiscard]] std::optional<std::string_view> RawAttribute(const std::string_view name) const
+		{
+			std::string_view rest = _attributes;
+			while (true)
+			{
+				rest = Trim(rest);
+				const size_t equal = rest.find('=');
+				if (rest.empty() || equal == std::string_view::npos)
+				{
+					return std::nullopt;
+				}
+				const std::string_view key = Trim(rest.substr(0, equal));
+				rest = Trim(rest.substr(equal + 1));
+				if (rest.empty() || (rest.front() != '"' && rest.front() != '\''))
+				{
+					throw Error(std::format(L"属性{}的值缺少引号", Wide(key)));
+				}
+				const size_t close = rest.find(rest.front(), 1);
+				if (close == std::string_view::npos)
+				{
+					throw Error(std::format(L"属性{}的值缺少引号", Wide(key)));
+				}
+				if (LocalName(key) == name)
+				{
+					return rest.substr(1, close - 1);
+				}
+				rest.remove_prefix(close + 1);
+			}
+		}
+
+		/// 还原实体引用并按文件的编码解码
+		[[nodiscard]] std::wstring Decode(const std::string_view raw) const
+		{
+			std::wstring result;
+			size_t start = 0;
+			const auto flush = [&](const size_t end)
+			{
+				if (end > start)
+				{
+					try
+					{
+						result += DecodeText(raw.substr(start, end - start), _encoding);
+					}
+					catch (const VizRailCoreException& e)
+					{
+						throw Error(e.GetMsg());
+					}
+				}
+			};
+			for (size_t i = raw.find('&'); i != std::string_view::npos; i = raw.find('&', start))
+			{
+				flush(i);
+				const size_t semicolon = raw.find(';', i);
+				if (semicolon == std::string_view::npos)
+				{
+					throw Error(L"实体引用缺少分号");
+				}
+				const std::string_view entity = raw.substr(i + 1, semicolon - i - 1);
+				if (entity == "amp")
+				{
+					result.push_back(L'&');
+				}
+				else if (entity == "lt")
+				{
+					result.push_back(L'<');
+				}
+				else if (entity == "gt")
+				{
+					result.push_back(L'>');
+				}
+				else if (entity == "quot")
+				{
+					result.push_back(L'"');
+				}
+				else if (entity == "apos")
+				{
+					result.push_back(L'\'');
+				}
+				else if (entity.starts_with('#'))
+				{
+					const bool hex = entity.size() > 1 && (entity[1] == 'x' || entity[1] == 'X');
+					const std::string_view digits = entity.substr(hex ? 2 : 1);
+					uint32_t code = 0;
+					const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), code,
+					                                          hex ? 16 : 10);
+					if (error != std::errc() || end != digits.data() + digits.size() || digits.empty() ||
+						code > 0x10FFFF)
+					{
+						throw Error(std::format(L"无效的字符引用&{};", Wide(entity)));
+					}
+					AppendWide(result, code);
+				}
+				else
+				{
+					throw Error(std::format(L"不支持的实体引用&{};", Wide(entity)));
+				}
+				start = semicolon + 1;
+			}
+			flush(raw.size());
+			return result;
+		}
+
+		/// \brief 读取当前开始标签中的数值属性
+		/// \return 没有该属性时为空，INF为正无穷
+		[[nodiscard]] std::optional<double> NumberAttribute(const std::string_view name) const
+		{
+			const auto raw = RawAttribute(name);
+			if (!raw)
+			{
+				return std::nullopt;
+			}
+			const std::string_view text = Trim(*raw);
+			if (EqualsIgnoreCase(text, "INF"))
+			{
+				return std::numeric_limits<double>::infinity();
+			}
+			double value;
+			const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+			if (text.empty() || error != std::errc() || end != text.data() + text.size())
+			{
+				throw Error(std::format(L"属性{}的值不是数值", Wide(name)));
+			}
+			return value;
+		}
+
+		/// \brief 读到当前开始标签对应的结束标签，返回其间的原文，不允许有子元素
+		[[nodiscard]] std::string_view ReadText()
+		{
+			if (_pendingEnd)
+			{
+				Next();
+				return {};
+			}
+			const size_t start = _offset;
+			const size_t depth = _open.size();
+			while (Next() && _open.size() >= depth)
+			{
+				if (_event == XmlEvent::Start)
+				{
+					throw Error(std::format(L"元素{}中不应有子元素", Wide(_open[depth - 1])));
+				}
+			}
+			return _text.substr(start, _position - start);
+		}
+
+		/// 跳过当前开始标签对应的整个元素
+		void Skip()
+		{
+			if (_pendingEnd)
+			{
+				Next();
+				return;
+			}
+			const size_t depth = _open.size();
+			while (_open.size() >= depth && Next())
+			{
+			}
+		}
+
+		[[nodiscard]] TextImportException Error(const std::wstring& message) const
+		{
+			const size_t line = 1 + static_cast<size_t>(std::count(_text.begin(), _text.begin() + _position, '\n'));
+			return TextImportException(std::format(L"{}第{}行：{}", _path.wstring(), line, message), line, 0);
+		}
+
+		[[nodiscard]] TextImportException ErrorAt(const size_t position, const std::wstring& message) const
+		{
+			XmlReader copy(_path, _text);
+			copy._position = position;
+			return copy.Error(message);
+		}
+
+	private:
+		/// 名称只含ASCII时直接转换，用于错误信息
+		static std::wstring Wide(const std::string_view text)
+		{
+			std::wstring result;
+			for (const char c : text)
+			{
+				result.push_back(static_cast<unsigned char>(c) < 0x80 ? static_cast<wchar_t>(c) : L'?');
+			}
+			return result;
+		}
+
+		size_t Find(const std::string_view token, const size_t from) const
+		{
+			const size_t position = _text.find(token, from);
+			if (position == std::string_view::npos)
+			{
+				throw Error(std::format(L"缺少{}", Wide(token)));
+			}
+			return position;
+		}
+
+		void ReadDeclaration(const std::string_view declaration)
+		{
+			_attributes = declaration.substr(3);
+			if (const auto encoding = RawAttribute("encoding"))
+			{
+				if (EqualsIgnoreCase(*encoding, "UTF-8"))
+				{
+					_encoding = TextEncoding::Utf8;
+				}
+				else if (EqualsIgnoreCase(*encoding, "GBK") || EqualsIgnoreCase(*encoding, "GB2312") ||
+					EqualsIgnoreCase(*encoding, "GB18030"))
+				{
+					_encoding = TextEncoding::Gbk;
+				}
+			}
+			_attributes = {};
+		}
+
+		/// 跳过DOCTYPE等声明，内部子集中可以有尖括号
+		void SkipDeclaration()
+		{
+			int brackets = 0;
+			for (size_t i = _offset + 2; i < _text.size(); ++i)
+			{
+				const char c = _text[i];
+				if (c == '"' || c == '\'')
+				{
+					i = Find(std::string_view(&c, 1), i + 1);
+				}
+				else if (c == '[')
+				{
+					++brackets;
+				}
+				else if (c == ']')
+				{
+					--brackets;
+				}
+				else if (c == '>' && brackets <= 0)
+				{
+					_offset = i + 1;
+					return;
+				}
+			}
+			throw Error(L"声明没有结束");
+		}
+
+		void ReadStartTag()
+		{
+			size_t i = _offset + 1;
+			while (i < _text.size() && !IsSpace(_text[i]) && _text[i] != '>' && _text[i] != '/')
+			{
+				++i;
+			}
+			_name = _text.substr(_offset + 1, i - _offset - 1);
+			if (_name.empty())
+			{
+				throw Error(L"缺少元素名");
+			}
+			const size_t attributes = i;
+			// 属性值中可以有>，跳过引号内的内容
+			for (; i < _text.size() && _text[i] != '>'; ++i)
+			{
+				if (_text[i] == '"' || _text[i] == '\'')
+				{
+					i = Find(std::string_view(&_text[i], 1), i + 1);
+				}
+			}
+			if (i >= _text.size())
+			{
+				throw Error(std::format(L"元素{}的标签没有结束", Wide(_name)));
+			}
+			const bool selfClosing = _text[i - 1] == '/';
+			_attributes = _text.substr(attributes, i - attributes - (selfClosing ? 1 : 0));
+			_offset = i + 1;
+			_event = XmlEvent::Start;
+			_pendingEnd = selfClosing;
+			if (!selfClosing)
+			{
+				_open.push_back(_name);
+			}
+		}
+
+		const std::filesystem::path& _path;
+		std::string_view _text;
+		size_t _offset = 0;
+		size_t _position = 0;
+		XmlEvent _event = XmlEvent::Text;
+		std::string_view _name;
+		std::string_view _attributes;
+		std::string_view _value;
+		bool _pendingEnd = false;
+		TextEncoding _encoding = TextEncoding::Auto;
+		// 未结束的元素，深度即LandXML的嵌套层数
+		std::vector<std::string_view> _open;
+	};
+
+	enum class SegmentKind
+	{
+		Line,
+		Arc,
+		Spiral,
+	};
+
+	/// CoordGeom中的一个几何元素
+	struct Segment
+	{
+		SegmentKind Kind = SegmentKind::Line;
+		Point2D Start;
+		Point2D End;
+		Vector2D StartDirection;
+		Vector2D EndDirection;
+		double Length = 0.0;
+		/// 圆弧半径；缓和曲线起点和终点的半径，直线端为无穷大
+		double Radius = 0.0;
+		double StartRadius = 0.0;
+		double EndRadius = 0.0;
+		/// 开始标签的位置，用于错误信息
+		size_t Position = 0;
+	};
+
+	/// 读取“北 东 [高程]”格式的点
+	Point2D ReadPoint(XmlReader& reader)
+	{
+		std::string_view text = Trim(reader.ReadText());
+		double values[2] = {};
+		for (double& value : values)
+		{
+			const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+			if (error != std::errc() || text.empty())
+			{
+				throw reader.Error(L"点的坐标不是数值");
+			}
+			text = Trim(text.substr(static_cast<size_t>(end - text.data())));
+		}
+		return {values[1], values[0]};
+	}
+
+	/// 读取一个Line、Curve或Spiral元素，读完时位于其结束标签
+	Segment ReadSegment(XmlReader& reader)
+	{
+		Segment segment;
+		segment.Position = reader.Position();
+		const std::string_view name = reader.Name();
+		segment.Kind = name == "Line" ? SegmentKind::Line : name == "Curve" ? SegmentKind::Arc : SegmentKind::Spiral;
+		bool clockwise = false;
+		if (segment.Kind != SegmentKind::Line)
+		{
+			const auto rotation = reader.RawAttribute("rot");
+			if (!rotation || (*rotation != "cw" && *rotation != "ccw"))
+			{
+				throw reader.Error(L"曲线缺少rot属性或其值不是cw、ccw");
+			}
+			clockwise = *rotation == "cw";
+		}
+		if (segment.Kind == SegmentKind::Arc)
+		{
+			if (const auto type = reader.RawAttribute("crvType"); type && *type != "arc")
+			{
+				throw reader.Error(L"只支持crvType为arc的曲线");
+			}
+			segment.Radius = reader.NumberAttribute("radius").value_or(0.0);
+		}
+		else if (segment.Kind == SegmentKind::Spiral)
+		{
+			const auto length = reader.NumberAttribute("length");
+			const auto startRadius = reader.NumberAttribute("radiusStart");
+			const auto endRadius = reader.NumberAttribute("radiusEnd");
+			if (!length || !startRadius || !endRadius)
+			{
+				throw reader.Error(L"缓和曲线缺少length、radiusStart或radiusEnd属性");
+			}
+			segment.Length = *length;
+			segment.StartRadius = *startRadius;
+			segment.EndRadius = *endRadius;
+		}
+
+		std::optional<Point2D> start;
+		std::optional<Point2D> end;
+		std::optional<Point2D> center;
+		std::optional<Point2D> pi;
+		while (reader.Next() && reader.Event() != XmlEvent::End)
+		{
+			if (reader.Event() != XmlEvent::Start)
+			{
+				continue;
+			}
+			const std::string_view child = reader.Name();
+			std::optional<Point2D>* target = child == "Start"
+				                                 ? &start
+				                                 : child == "End"
+				                                 ? &end
+				                                 : child == "Center"
+				                                 ? &center
+				                                 : child == "PI"
+				                                 ? &pi
+				                                 : nullptr;
+			if (target == nullptr)
+			{
+				reader.Skip();
+				continue;
+			}
+			if (reader.RawAttribute("pntRef"))
+			{
+				throw reader.Error(L"不支持以pntRef引用的点");
+			}
+			*target = ReadPoint(reader);
+		}
+		if (!start || !end)
+		{
+			throw reader.ErrorAt(segment.Position, L"几何元素缺少Start或End");
+		}
+		segment.Start = *start;
+		segment.End = *end;
+
+		switch (segment.Kind)
+		{
+		case SegmentKind::Line:
+			segment.StartDirection = segment.EndDirection = Direction(segment.Start, segment.End);
+			break;
+		case SegmentKind::Arc:
+			if (!center)
+			{
+				throw reader.ErrorAt(segment.Position, L"圆曲线缺少Center");
+			}
+			if (!(segment.Radius > 0.0))
+			{
+				segment.Radius = Point2D::Distance(segment.Start, *center);
+			}
+			segment.StartDirection = ArcTangent(segment.Start, *center, clockwise);
+			segment.EndDirection = ArcTangent(segment.End, *center, clockwise);
+			break;
+		case SegmentKind::Spiral:
+			if (!pi)
+			{
+				throw reader.ErrorAt(segment.Position, L"缓和曲线缺少PI");
+			}
+			segment.StartDirection = Direction(segment.Start, *pi);
+			segment.EndDirection = Direction(*pi, segment.End);
+			break;
+		}
+		return segment;
+	}
+
+	/// 将依次读入的几何元素换算为交点
+	class JdBuilder
+	{
+	public:
+		explicit JdBuilder(const XmlReader& reader) : _reader(reader)
+		{
+		}
+
+		void Add(const Segment& segment)
+		{
+			// 零长度的直线不影响线形
+			if (segment.Kind == SegmentKind::Line && !(Norm(segment.StartDirection) > 0.0))
+			{
+				return;
+			}
+			if (!_last)
+			{
+				AddJd(segment.Start, 0.0, 0.0);
+			}
+			else if (Point2D::Distance(_last->End, segment.Start) > ContinuityTolerance)
+			{
+				throw _reader.ErrorAt(segment.Position, L"几何元素的起点与上一元素的终点不重合");
+			}
+
+			switch (segment.Kind)
+			{
+			case SegmentKind::Line:
+				if (_group)
+				{
+					FinishGroup();
+				}
+				else if (_last && _last->Kind == SegmentKind::Line &&
+					std::abs(Cross(_last->EndDirection, segment.StartDirection)) >
+					CollinearTolerance * Norm(_last->EndDirection) * Norm(segment.StartDirection))
+				{
+					throw _reader.ErrorAt(segment.Position, L"相邻直线之间缺少曲线");
+				}
+				break;
+			case SegmentKind::Arc:
+				if (_group && (_group->HasArc || _group->ExitLs))
+				{
+					FinishGroup();
+				}
+				Group(segment).HasArc = true;
+				_group->Radius = segment.Radius;
+				break;
+			case SegmentKind::Spiral:
+				if (std::isinf(segment.StartRadius))
+				{
+					if (_group)
+					{
+						FinishGroup();
+					}
+					Group(segment).EntryLs = segment.Length;
+					_group->SpiralRadius = segment.EndRadius;
+				}
+				else if (std::isinf(segment.EndRadius))
+				{
+					if (_group && _group->ExitLs)
+					{
+						FinishGroup();
+					}
+					Group(segment).ExitLs = segment.Length;
+					_group->SpiralRadius = segment.StartRadius;
+				}
+				else
+				{
+					throw _reader.ErrorAt(segment.Position, L"不支持两端半径都有限的缓和曲线（复曲线）");
+				}
+				break;
+			}
+			if (_group)
+			{
+				_group->ExitPoint = segment.End;
+				_group->ExitDirection = segment.EndDirection;
+			}
+			_last = segment;
+		}
+
+		JdColumns Finish()
+		{
+			if (_group)
+			{
+				FinishGroup();
+			}
+			if (_last)
+			{
+				AddJd(_last->End, 0.0, 0.0);
+			}
+			return std::move(_jds);
+		}
+
+	private:
+		/// 一组连续的缓和曲线和圆曲线，对应一个交点
+		struct CurveGroup
+		{
+			size_t Position = 0;
+			Point2D EntryPoint;
+			Vector2D EntryDirection;
+			Point2D ExitPoint;
+			Vector2D ExitDirection;
+			bool HasArc = false;
+			double Radius = 0.0;
+			double SpiralRadius = 0.0;
+			std::optional<double> EntryLs;
+			std::optional<double> ExitLs;
+		};
+
+		CurveGroup& Group(const Segment& segment)
+		{
+			if (!_group)
+			{
+				_group.emplace();
+				_group->Position = segment.Position;
+				_group->EntryPoint = segment.Start;
+				_group->EntryDirection = segment.StartDirection;
+			}
+			return *_group;
+		}
+
+		void FinishGroup()
+		{
+			const CurveGroup group = *_group;
+			_group.reset();
+			if (group.EntryLs.has_value() != group.ExitLs.has_value() ||
+				(group.EntryLs && std::abs(*group.EntryLs - *group.ExitLs) > TransitionTolerance))
+			{
+				throw _reader.ErrorAt(group.Position, L"不支持前后缓和曲线长不同的曲线");
+			}
+			double entry = 0.0;
+			double exit = 0.0;
+			const auto jd = Intersect(group.EntryPoint, group.EntryDirection, group.ExitPoint, group.ExitDirection,
+			                          &entry, &exit);
+			if (!jd || entry < 0.0 || exit > 0.0)
+			{
+				throw _reader.ErrorAt(group.Position, L"曲线的进出切线不相交于曲线前方（转角不小于180°）");
+			}
+			AddJd(*jd, group.HasArc ? group.Radius : group.SpiralRadius, group.EntryLs.value_or(0.0));
+		}
+
+		void AddJd(const Point2D& point, const double r, const double ls)
+		{
+			_jds.JdH.push_back(static_cast<unsigned>(_jds.Size()));
+			_jds.N.push_back(point.Y());
+			_jds.E.push_back(point.X());
+			_jds.Angle.push_back(0.0);
+			_jds.R.push_back(r);
+			_jds.Ls.push_back(ls);
+		}
+
+		const XmlReader& _reader;
+		JdColumns _jds;
+		std::optional<Segment> _last;
+		std::optional<CurveGroup> _group;
+	};
+
+	/// 读取一个Alignment元素，读完时位于其结束标签
+	LandXmlJdAlignment ReadAlignment(XmlReader& reader)
+	{
+		LandXmlJdAlignment alignment;
+		if (const auto name = reader.RawAttribute("name"))
+		{
+			alignment.Name = reader.Decode(*name);
+		}
+		const double startMileage = reader.NumberAttribute("staStart").value_or(0.0);
+		JdBuilder builder(reader);
+		while (reader.Next() && reader.Event() != XmlEvent::End)
+		{
+			if (reader.Event() != XmlEvent::Start)
+			{
+				continue;
+			}
+			if (reader.Name() != "CoordGeom")
+			{
+				// Profile、Cant、StaEquation等
+				reader.Skip();
+				continue;
+			}
+			while (reader.Next() && reader.Event() != XmlEvent::End)
+			{
+				if (reader.Event() != XmlEvent::Start)
+				{
+					continue;
+				}
+				const std::string_view name = reader.Name();
+				if (name == "Line" || name == "Curve" || name == "Spiral")
+				{
+					builder.Add(ReadSegment(reader));
+				}
+				else if (name == "Feature")
+				{
+					reader.Skip();
+				}
+				else
+				{
+					throw reader.Error(std::format(L"不支持的几何元素{}", reader.Decode(name)));
+				}
+			}
+		}
+		alignment.Jds = builder.Finish();
+		alignment.Jds.StartMileage = startMileage;
+		return alignment;
+	}
+}
+
+void VizRailCore::SaveLandXml(const std::filesystem::path& path, const std::span<const LandXmlAlignment> alignments)
+{
+	XmlStream out(path);
+	const auto now = std::chrono::system_clock::now();
+	const auto today = std::chrono::floor<std::chrono::days>(now);
+	const std::chrono::year_month_day date(today);
+	const std::chrono::hh_mm_ss time(std::chrono::floor<std::chrono::seconds>(now - today));
+
+	out.Raw("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	out.Raw(std::format(
+		"<LandXML xmlns=\"http://www.landxml.org/schema/LandXML-1.2\" version=\"1.2\" "
+		"date=\"{:04}-{:02}-{:02}\" time=\"{:02}:{:02}:{:02}\">\n",
+		static_cast<int>(date.year()), static_cast<unsigned>(date.month()), static_cast<unsigned>(date.day()),
+		time.hours().count(), time.minutes().count(), time.seconds().count()));
+	out.Raw("<Units><Metric areaUnit=\"squareMeter\" linearUnit=\"meter\" volumeUnit=\"cubicMeter\" "
+		"temperatureUnit=\"celsius\" pressureUnit=\"milliBars\" angularUnit=\"decimal degrees\" "
+		"directionUnit=\"decimal degrees\"/></Units>\n");
+	out.Raw("<Application name=\"VizRail\" manufacturer=\"VizRail\"/>\n");
+	out.Raw("<Alignments>\n");
+	for (const auto& alignment : alignments)
+	{
+		WriteAlignment(out, alignment);
+	}
+	out.Raw("</Alignments>\n</LandXML>\n");
+	out.Close();
+}
+
+void VizRailCore::ReadLandXml(const std::filesystem::path& path,
+                              const std::function<void(LandXmlJdAlignment&&)>& sink)
+{
+	std::optional<MappedFile> file;
+	try
+	{
+		file.emplace(path);
+	}
+	catch (const VizRailCoreException& e)
+	{
+		throw TextImportException(e.GetMsg(), 0, 0);
+	}
+	const std::string_view text(reinterpret_cast<const char*>(file->Bytes().data()), file->Bytes().size());
+	XmlReader reader(path, text);
+	while (reader.Next())
+	{
+		if (reader.Event() == XmlEvent::Start && reader.Name() == "Alignment")
+		{
+			sink(ReadAlignment(reader));
+		}
+	}
+}
+
+std::vector<LandXmlJdAlignment> VizRailCore::ReadLandXml(const std::filesystem::path& path)
+{
+	std::vector<LandXmlJdAlignment> alignments;
+	ReadLandXml(path, [&alignments](LandXmlJdAlignment&& alignment)
+	{
+		alignments.push_back(std::move(alignment));
+	});
+	return alignments;
+}
@@ -0,0 +1,123 @@
+#include "MappedFile.h"
+
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include "Exceptions.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace VizRailCore;
+
+namespace
+{
+	/// 临时文件名的后缀，同一文件的多个写入者（线程或进程）各用各的临时文件
+	std::wstring TemporarySuffix()
+	{
+		static const uint64_t process = std::random_device()();
+		static std::atomic<uint64_t> counter = 0;
+		return std::format(L".{}.{}.tmp", process, counter.fetch_add(1, std::memory_order_relaxed));
+	}
+}
+
+void VizRailCore::ReplaceFile(const std::filesystem::path& path, const std::span<const std::byte> content)
+{
+	std::filesystem::path temporary = path;
+	temporary += TemporarySuffix();
+	std::error_code error;
+	{
+		std::ofstream file(temporary, std::ios::binary);
+		if (!file)
+		{
+			throw VizRailCoreException(std::format(L"无法创建文件{}", temporary.wstring()));
+		}
+		file.write(reinterpret_cast<const char*>(content.data()), static_cast<std::streamsize>(content.size()));
+		if (!file.flush())
+		{
+			file.close();
+			std::filesystem::remove(temporary, error);
+			throw VizRailCoreException(std::format(L"写入文件{}失败", temporary.wstring()));
+		}
+	}
+	std::filesystem::rename(temporary, path, error);
+	if (error)
+	{
+		std::filesystem::remove(temporary, error);
+		throw VizRailCoreException(std::format(L"无法替换文件{}", path.wstring()));
+	}
+}
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+	const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+	                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw VizRailCoreException(std::format(L"无法打开文件{}", path.wstring()));
+	}
+	LARGE_INTEGER size{};
+	const HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart > 0
+		                       ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+		                       : nullptr;
+	CloseHandle(file);
+	if (mapping == nullptr)
+	{
+		throw VizRailCoreException(std::format(L"无法映射文件{}", path.wstring()));
+	}
+	// 视图保持对映射对象的引用，关闭句柄后映射仍然有效
+	_address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (_address == nullptr)
+	{
+		throw VizRailCoreException(std::format(L"无法映射文件{}", path.wstring()));
+	}
+	_size = static_cast<size_t>(size.QuadPart);
+}
+
+MappedFile::~MappedFile()
+{
+	UnmapViewOfFile(_address);
+}
+#else
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+	const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+	{
+		throw VizRailCoreException(std::format(L"无法打开文件{}", path.wstring()));
+	}
+	struct stat status{};
+	void* address = MAP_FAILED;
+	if (fstat(file, &status) == 0 && status.st_size > 0)
+	{
+		address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+	}
+	// 映射保持对文件的引用，关闭描述符后映射仍然有效
+	close(file);
+	if (address == MAP_FAILED)
+	{
+		throw VizRailCoreException(std::format(L"无法映射文件{}", path.wstring()));
+	}
+	_address = address;
+	_size = static_cast<size_t>(status.st_size);
+}
+
+MappedFile::~MappedFile()
+{
+	munmap(const_cast<void*>(_address), _size);
+}
+#endif
@@ -0,0 +1,307 @@
+#include "ProjectCache.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <string>
+
+#include "Exceptions.h"
+#include "MappedFile.h"
+
+using namespace VizRailCore;
+using namespace VizRailCore::AlignmentImage;
+
+enum class ProjectCache::Kind : uint32_t
+{
+	Image = 1,
+	Stations = 2,
+	Centerline = 3,
+};
+
+namespace
+{
+	constexpr uint32_t CacheMagic = 0x45435256; // "VRCE"
+	/// 缓存文件容器格式的版本，与DerivedDataVersion分开，负载算法改变时不必修改
+	constexpr uint32_t CacheFormatVersion = 1;
+
+	/// 缓存文件头，其后依次为JdRecord数组和负载，负载起点按SectionAlignment对齐
+	struct CacheHeader
+	{
+		uint32_t Magic;
+		uint32_t FormatVersion;
+		uint32_t AlgorithmVersion;
+		uint32_t Kind;
+		uint64_t ContentHash;
+		/// 计算参数（桩距、弦高容差等）的位模式
+		uint64_t Parameter;
+		uint64_t JdCount;
+		uint64_t JdOffset;
+		uint64_t PayloadOffset;
+		uint64_t PayloadSize;
+	};
+
+	static_assert(sizeof(CacheHeader) == 64);
+
+	/// 0.0与-0.0的位模式不同但数值相同，统一为0.0的位模式
+	uint64_t NormalizedBits(const double value)
+	{
+		return std::bit_cast<uint64_t>(value + 0.0);
+	}
+
+	/// 按JdContentHash的规则逐字段比较交点，不比较填充字段
+	bool SameJd(const JdRecord& a, const JdRecord& b)
+	{
+		const auto same = [](const double x, const double y)
+		{
+			return NormalizedBits(x) == NormalizedBits(y);
+		};
+		return a.JdH == b.JdH && same(a.N, b.N) && same(a.E, b.E) && same(a.Angle, b.Angle) && same(a.R, b.R) &&
+			same(a.Ls, b.Ls) && same(a.TH, b.TH) && same(a.LH, b.LH) && same(a.LJzx, b.LJzx) &&
+			same(a.StartMileage, b.StartMileage) && same(a.EndMileage, b.EndMileage);
+	}
+
+	class Fnv1a
+	{
+	public:
+		/// 按小端字节序加入一个64位值
+		void Add(const uint64_t value)
+		{
+			for (int shift = 0; shift < 64; shift += 8)
+			{
+				_hash = (_hash ^ (value >> shift & 0xFF)) * 0x100000001B3;
+			}
+		}
+
+		void Add(const double value)
+		{
+			Add(NormalizedBits(value));
+		}
+
+		[[nodiscard]] uint64_t Value() const
+		{
+			return _hash;
+		}
+
+	private:
+		uint64_t _hash = 0xCBF29CE484222325;
+	};
+
+	size_t AlignUp(const size_t value)
+	{
+		return (value + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+	}
+
+	std::wstring Hex(const uint64_t value)
+	{
+		std::wstring text(16, L'0');
+		for (size_t i = 0; i < 16; ++i)
+		{
+			text[15 - i] = L"0123456789abcdef"[value >> (i * 4) & 0xF];
+		}
+		return text;
+	}
+
+	std::vector<JdRecord> JdRecords(const HorizontalAlignment& alignment)
+	{
+		const auto& jds = alignment.GetJds();
+		std::vector<JdRecord> records;
+		records.reserve(jds.Size());
+		for (size_t i = 0; i < jds.Size(); ++i)
+		{
+			records.push_back(MakeJdRecord(jds[i]));
+		}
+		return records;
+	}
+
+	/// \brief 检查缓存文件头和交点表，返回负载
+	/// \exception VizRailCoreException 文件不能用于当前线路
+	std::span<const std::byte> Validate(const std::span<const std::byte> file, const CacheHeader& expected,
+	                                    const std::vector<JdRecord>& jds)
+	{
+		if (file.size() < sizeof(CacheHeader))
+		{
+			throw VizRailCoreException(L"缓存文件不完整");
+		}
+		CacheHeader header;
+		std::memcpy(&header, file.data(), sizeof(header));
+		if (header.Magic != expected.Magic || header.FormatVersion != expected.FormatVersion)
+		{
+			throw VizRailCoreException(L"不是缓存文件或格式版本不符");
+		}
+		if (header.AlgorithmVersion != expected.AlgorithmVersion || header.Kind != expected.Kind ||
+			header.ContentHash != expected.ContentHash || header.Parameter != expected.Parameter)
+		{
+			throw VizRailCoreException(L"缓存文件的版本或参数不符");
+		}
+		const uint64_t jdBytes = header.JdCount * sizeof(JdRecord);
+		if (header.JdCount != jds.size() || header.JdOffset % alignof(JdRecord) != 0 ||
+			header.JdOffset > file.size() || jdBytes > file.size() - header.JdOffset ||
+			header.PayloadOffset % SectionAlignment != 0 || header.PayloadOffset > file.size() ||
+			header.PayloadSize > file.size() - header.PayloadOffset)
+		{
+			throw VizRailCoreException(L"缓存文件不完整");
+		}
+		// 内容哈希相同不代表交点表相同，逐项比较排除哈希冲突
+		const auto* cached = reinterpret_cast<const JdRecord*>(file.data() + header.JdOffset);
+		if (!std::equal(jds.begin(), jds.end(), cached, SameJd))
+		{
+			throw VizRailCoreException(L"缓存文件的交点表与线路不符");
+		}
+		return file.subspan(header.PayloadOffset, header.PayloadSize);
+	}
+
+	std::vector<std::byte> Serialize(CacheHeader header, const std::vector<JdRecord>& jds,
+	                                 const std::span<const std::byte> payload)
+	{
+		header.JdCount = jds.size();
+		header.JdOffset = sizeof(CacheHeader);
+		header.PayloadOffset = AlignUp(header.JdOffset + jds.size() * sizeof(JdRecord));
+		header.PayloadSize = payload.size();
+		std::vector<std::byte> file(header.PayloadOffset + payload.size());
+		std::memcpy(file.data(), &header, sizeof(header));
+		if (!jds.empty())
+		{
+			std::memcpy(file.data() + header.JdOffset, jds.data(), jds.size() * sizeof(JdRecord));
+		}
+		if (!payload.empty())
+		{
+			std::memcpy(file.data() + header.PayloadOffset, payload.data(), payload.size());
+		}
+		return file;
+	}
+}
+
+uint64_t VizRailCore::JdContentHash(const HorizontalAlignment& alignment)
+{
+	Fnv1a hash;
+	hash.Add(uint64_t{DerivedDataVersion});
+	const auto& jds = alignment.GetJds();
+	hash.Add(uint64_t{jds.Size()});
+	for (size_t i = 0; i < jds.Size(); ++i)
+	{
+		const Jd& jd = jds[i];
+		hash.Add(uint64_t{jd.JdH});
+		for (const double value : {
+			     jd.N, jd.E, jd.Angle, jd.R, jd.Ls, jd.TH, jd.LH, jd.LJzx, jd.StartMileage, jd.EndMileage
+		     })
+		{
+			hash.Add(value);
+		}
+	}
+	return hash.Value();
+}
+
+ProjectCache::ProjectCache(std::filesystem::path directory) : _directory(std::move(directory))
+{
+}
+
+CachedAlignmentImage ProjectCache::Image(const HorizontalAlignment& alignment)
+{
+	auto [owner, bytes] = Load(Kind::Image, alignment, 0.0, [&]
+	{
+		return BuildAlignmentImage(alignment);
+	}, [](const std::span<const std::byte> payload)
+	{
+		(void)AlignmentImageView(payload);
+	});
+	return {std::move(owner), AlignmentImageView(bytes)};
+}
+
+CachedArray<StationRecord> ProjectCache::Stations(const HorizontalAlignment& alignment, const double interval)
+{
+	if (!(interval > 0.0))
+	{
+		throw VizRailCoreException(L"桩距必须大于0");
+	}
+	return LoadArray<StationRecord>(Kind::Stations, alignment, interval, [&]
+	{
+		return BuildStationTable(alignment, interval);
+	});
+}
+
+CachedArray<CenterlinePoint> ProjectCache::Centerline(const HorizontalAlignment& alignment,
+                                                      const double chordTolerance)
+{
+	if (!(chordTolerance > 0.0))
+	{
+		throw VizRailCoreException(L"弦高容差必须大于0");
+	}
+	return LoadArray<CenterlinePoint>(Kind::Centerline, alignment, chordTolerance, [&]
+	{
+		return BuildCenterline(alignment, chordTolerance);
+	});
+}
+
+ProjectCache::Statistics ProjectCache::Stats() const
+{
+	return {_hits.load(), _misses.load(), _rejected.load(), _writeFailures.load()};
+}
+
+template <typename T>
+CachedArray<T> ProjectCache::LoadArray(const Kind kind, const HorizontalAlignment& alignment, const double parameter,
+                                       const std::function<std::vector<T>()>& build)
+{
+	auto [owner, bytes] = Load(kind, alignment, parameter, [&]
+	{
+		const std::vector<T> items = build();
+		const auto bytes = std::as_bytes(std::span(items));
+		return std::vector<std::byte>(bytes.begin(), bytes.end());
+	}, [](const std::span<const std::byte> payload)
+	{
+		if (payload.size() % sizeof(T) != 0)
+		{
+			throw VizRailCoreException(L"缓存文件的负载长度不符");
+		}
+	});
+	return {std::move(owner), {reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T)}};
+}
+
+ProjectCache::Payload ProjectCache::Load(const Kind kind, const HorizontalAlignment& alignment, const double parameter,
+                                         const std::function<std::vector<std::byte>()>& build,
+                                         const std::function<void(std::span<const std::byte>)>& validate)
+{
+	const CacheHeader expected{
+		CacheMagic, CacheFormatVersion, DerivedDataVersion, static_cast<uint32_t>(kind), JdContentHash(alignment),
+		std::bit_cast<uint64_t>(parameter), 0, 0, 0, 0
+	};
+	const std::vector<JdRecord> jds = JdRecords(alignment);
+	const wchar_t* name = kind == Kind::Image ? L"image" : kind == Kind::Stations ? L"stations" : L"centerline";
+	const std::filesystem::path path = _directory / std::format(L"{}-{}-{}.vrc", name, Hex(expected.ContentHash),
+	                                                            Hex(expected.Parameter));
+
+	std::error_code error;
+	if (std::filesystem::exists(path, error))
+	{
+		try
+		{
+			auto file = std::make_shared<const MappedFile>(path);
+			const auto payload = Validate(file->Bytes(), expected, jds);
+			validate(payload);
+			++_hits;
+			return {std::move(file), payload};
+		}
+		catch (const VizRailCoreException&)
+		{
+			++_rejected;
+		}
+	}
+	else
+	{
+		++_misses;
+	}
+
+	auto payload = std::make_shared<const std::vector<std::byte>>(build());
+	try
+	{
+		std::filesystem::create_directories(_directory, error);
+		ReplaceFile(path, Serialize(expected, jds, *payload));
+	}
+	catch (const VizRailCoreException&)
+	{
+		// 缓存只是加速手段，目录只读或磁盘已满时仍返回计算结果
+		++_writeFailures;
+	}
+	const std::span<const std::byte> bytes(*payload);
+	return {std::move(payload), bytes};
+}
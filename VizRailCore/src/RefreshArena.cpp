@@ -0,0 +1,82 @@
+#include "RefreshArena.h"
+
+using namespace VizRailCore;
+
+namespace
+{
+	// 超过该大小的缓冲区不再保留，偶尔刷新一次的超长线路不应让线程长期占用大块内存
+	constexpr size_t MaxRetainedCapacity = 16 * 1024 * 1024;
+}
+
+RefreshArena::Scope::Scope() : _arena(ForCurrentThread())
+{
+	++_arena._depth;
+}
+
+RefreshArena::Scope::~Scope()
+{
+	if (--_arena._depth == 0)
+	{
+		_arena.Release();
+	}
+}
+
+std::pmr::memory_resource* RefreshArena::Scope::Resource() const
+{
+	return &*_arena._resource;
+}
+
+RefreshArena::RefreshArena()
+{
+	_resource.emplace(&_overflow);
+}
+
+RefreshArena& RefreshArena::ForCurrentThread()
+{
+	thread_local RefreshArena arena;
+	return arena;
+}
+
+void RefreshArena::Release()
+{
+	if (_overflow.Bytes == 0)
+	{
+		// 本次刷新没有超出缓冲区，回到缓冲区起点即可
+		_resource->release();
+		return;
+	}
+
+	// 按本次的总用量扩大缓冲区，下次同样规模的刷新不再访问堆
+	const size_t capacity = _capacity + _overflow.Bytes;
+	_resource.reset();
+	_overflow.Bytes = 0;
+	if (capacity <= MaxRetainedCapacity)
+	{
+		_buffer = std::make_unique_for_overwrite<std::byte[]>(capacity);
+		_capacity = capacity;
+	}
+	if (_buffer != nullptr)
+	{
+		_resource.emplace(_buffer.get(), _capacity, &_overflow);
+	}
+	else
+	{
+		_resource.emplace(&_overflow);
+	}
+}
+
+void* RefreshArena::Overflow::do_allocate(const size_t bytes, const size_t alignment)
+{
+	Bytes += bytes;
+	return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void RefreshArena::Overflow::do_deallocate(void* p, const size_t bytes, const size_t alignment)
+{
+	std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+bool RefreshArena::Overflow::do_is_equal(const memory_resource& other) const noexcept
+{
+	return this == &other;
+}
@@ -0,0 +1,519 @@
+#include "StationTableFile.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#include "Exceptions.h"
+
+using namespace VizRailCore;
+using namespace VizRailCore::StationTableFile;
+
+// Raw编码的列直接写出和映射本机的double，文件规定为小端序
+static_assert(std::endian::native == std::endian::little);
+
+namespace
+{
+	/// 量化值的绝对值上限，保证二阶差分不溢出int64
+	constexpr double QuantizedLimit = 0x1p60;
+
+	size_t AlignUp(const size_t value)
+	{
+		return (value + ChunkAlignment - 1) / ChunkAlignment * ChunkAlignment;
+	}
+
+	void AppendVarint(std::string& buffer, const int64_t value)
+	{
+		// zigzag编码使绝对值小的负数也只占少量字节
+		uint64_t bits = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+		while (bits >= 0x80)
+		{
+			buffer += static_cast<char>((bits & 0x7F) | 0x80);
+			bits >>= 7;
+		}
+		buffer += static_cast<char>(bits);
+	}
+
+	/// Xor编码中第i个值的预测值：首值为0，第二个值为前一个值，其后由前两个值线性外推。
+	/// 2*a是精确的，写出和读取时得到同样的预测值；外推结果不是有限值时改用前一个值，避免NaN的位模式因平台而异
+	uint64_t PredictBits(const std::span<const double> values, const size_t i)
+	{
+		if (i == 0)
+		{
+			return 0;
+		}
+		const double previous = values[i - 1];
+		if (i > 1)
+		{
+			if (const double predicted = 2.0 * previous - values[i - 2]; std::isfinite(predicted))
+			{
+				return std::bit_cast<uint64_t>(predicted);
+			}
+		}
+		return std::bit_cast<uint64_t>(previous);
+	}
+
+	/// 块内各列的原点，里程以块的首桩为原点
+	std::array<double, MaxColumns> ColumnOrigins(const Header& header, const double firstMileage)
+	{
+		return {firstMileage, header.OriginN, header.OriginE, 0.0, 0.0, 0.0};
+	}
+
+	class ChunkWriter
+	{
+	public:
+		ChunkWriter(const std::filesystem::path& path, const Header& header) : _path(path),
+		                                                                      _stream(path, std::ios::binary |
+		                                                                              std::ios::trunc),
+		                                                                      _header(header)
+		{
+			if (!_stream)
+			{
+				throw VizRailCoreException(std::format(L"无法创建文件{}", path.wstring()));
+			}
+			// 先写入占位的文件头，块索引的位置在全部块写出后才确定
+			_offset = AlignUp(sizeof(Header));
+			const std::string padding(_offset, '\0');
+			_stream.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+		}
+
+		/// 写出一块，columns为各列的值，行数相同
+		void Write(const std::array<std::vector<double>, MaxColumns>& columns)
+		{
+			const size_t rows = columns[MileageColumn].size();
+			_buffer.clear();
+			if (_header.Encoding == Encoding::Raw)
+			{
+				for (uint32_t c = 0; c < _header.ColumnCount; ++c)
+				{
+					_buffer.append(reinterpret_cast<const char*>(columns[c].data()), rows * sizeof(double));
+				}
+			}
+			else if (_header.Encoding == Encoding::Xor)
+			{
+				for (uint32_t c = 0; c < _header.ColumnCount; ++c)
+				{
+					EncodeColumnXor(columns[c]);
+				}
+			}
+			else
+			{
+				const auto origins = ColumnOrigins(_header, columns[MileageColumn].front());
+				for (uint32_t c = 0; c < _header.ColumnCount; ++c)
+				{
+					EncodeColumn(columns[c], origins[c], _header.Resolution[c]);
+				}
+			}
+
+			_chunks.push_back({
+				columns[MileageColumn].front(), columns[MileageColumn].back(), _header.RowCount, _offset, _buffer.size(),
+				static_cast<uint32_t>(rows), 0
+			});
+			_header.RowCount += rows;
+			Append(_buffer.data(), _buffer.size());
+		}
+
+		void Close()
+		{
+			_header.ChunkCount = _chunks.size();
+			_header.ChunkIndexOffset = _offset;
+			Append(reinterpret_cast<const char*>(_chunks.data()), _chunks.size() * sizeof(ChunkEntry));
+			_stream.seekp(0);
+			_stream.write(reinterpret_cast<const char*>(&_header), sizeof(Header));
+			_stream.close();
+			if (_stream.fail())
+			{
+				throw VizRailCoreException(std::format(L"写入文件{}失败", _path.wstring()));
+			}
+		}
+
+	private:
+		void EncodeColumn(const std::vector<double>& values, const double origin, const double resolution)
+		{
+			int64_t previous = 0;
+			int64_t delta = 0;
+			for (size_t i = 0; i < values.size(); ++i)
+			{
+				const double scaled = (values[i] - origin) / resolution;
+				if (!(std::abs(scaled) < QuantizedLimit))
+				{
+					throw VizRailCoreException(std::format(L"数值{}不能按分辨率{}压缩", values[i], resolution));
+				}
+				const int64_t quantized = std::llround(scaled);
+				// 首值、一阶差分，其后为二阶差分
+				if (i == 0)
+				{
+					AppendVarint(_buffer, quantized);
+				}
+				else if (i == 1)
+				{
+					delta = quantized - previous;
+					AppendVarint(_buffer, delta);
+				}
+				else
+				{
+					const int64_t next = quantized - previous;
+					AppendVarint(_buffer, next - delta);
+					delta = next;
+				}
+				previous = quantized;
+			}
+		}
+
+		void EncodeColumnXor(const std::vector<double>& values)
+		{
+			for (size_t i = 0; i < values.size(); ++i)
+			{
+				// 控制字节为0表示与预测值相同，否则高4位为末尾的零字节数，低4位为其后存放的字节数
+				uint64_t bits = std::bit_cast<uint64_t>(values[i]) ^ PredictBits(values, i);
+				if (bits == 0)
+				{
+					_buffer += '\0';
+					continue;
+				}
+				const int trailing = std::countr_zero(bits) / 8;
+				const int count = 8 - std::countl_zero(bits) / 8 - trailing;
+				_buffer += static_cast<char>(trailing << 4 | count);
+				bits >>= 8 * trailing;
+				for (int b = 0; b < count; ++b, bits >>= 8)
+				{
+					_buffer += static_cast<char>(bits & 0xFF);
+				}
+			}
+		}
+
+		/// 写出数据并补零到下一个对齐位置
+		void Append(const char* data, const size_t size)
+		{
+			_stream.write(data, static_cast<std::streamsize>(size));
+			const size_t end = AlignUp(_offset + size);
+			static constexpr char zeros[ChunkAlignment] = {};
+			_stream.write(zeros, static_cast<std::streamsize>(end - _offset - size));
+			_offset = end;
+		}
+
+		std::filesystem::path _path;
+		std::ofstream _stream;
+		Header _header;
+		size_t _offset = 0;
+		std::string _buffer;
+		std::vector<ChunkEntry> _chunks;
+	};
+
+	class ColumnReader
+	{
+	public:
+		explicit ColumnReader(const std::span<const std::byte> bytes) : _bytes(bytes)
+		{
+		}
+
+		void Decode(std::vector<double>& values, const size_t rows, const double origin, const double resolution)
+		{
+			values.resize(rows);
+			int64_t quantized = 0;
+			int64_t delta = 0;
+			for (size_t i = 0; i < rows; ++i)
+			{
+				if (i == 0)
+				{
+					quantized = ReadVarint();
+				}
+				else
+				{
+					delta = i == 1 ? ReadVarint() : delta + ReadVarint();
+					quantized += delta;
+				}
+				values[i] = origin + static_cast<double>(quantized) * resolution;
+			}
+		}
+
+		void DecodeXor(std::vector<double>& values, const size_t rows)
+		{
+			values.resize(rows);
+			for (size_t i = 0; i < rows; ++i)
+			{
+				const uint8_t control = ReadByte();
+				const int trailing = control >> 4;
+				const int count = control & 0x0F;
+				if (trailing + count > 8 || (control != 0 && count == 0))
+				{
+					throw VizRailCoreException(L"逐桩表文件的数据块损坏");
+				}
+				uint64_t bits = 0;
+				for (int b = 0; b < count; ++b)
+				{
+					bits |= uint64_t{ReadByte()} << 8 * (trailing + b);
+				}
+				values[i] = std::bit_cast<double>(bits ^ PredictBits(values, i));
+			}
+		}
+
+	private:
+		uint8_t ReadByte()
+		{
+			if (_position >= _bytes.size())
+			{
+				throw VizRailCoreException(L"逐桩表文件的数据块损坏");
+			}
+			return static_cast<uint8_t>(_bytes[_position++]);
+		}
+
+		int64_t ReadVarint()
+		{
+			uint64_t bits = 0;
+			for (int shift = 0; shift < 64; shift += 7)
+			{
+				if (_position >= _bytes.size())
+				{
+					break;
+				}
+				const auto byte = static_cast<uint8_t>(_bytes[_position++]);
+				bits |= static_cast<uint64_t>(byte & 0x7F) << shift;
+				if ((byte & 0x80) == 0)
+				{
+					return static_cast<int64_t>(bits >> 1) ^ -static_cast<int64_t>(bits & 1);
+				}
+			}
+			throw VizRailCoreException(L"逐桩表文件的数据块损坏");
+		}
+
+		std::span<const std::byte> _bytes;
+		size_t _position = 0;
+	};
+
+	std::vector<double>& ColumnOf(StationColumns& columns, const uint32_t column)
+	{
+		switch (column)
+		{
+		case MileageColumn:
+			return columns.Mileage;
+		case NColumn:
+			return columns.N;
+		case EColumn:
+			return columns.E;
+		case AzimuthColumn:
+			return columns.Azimuth;
+		case CurvatureColumn:
+			return columns.Curvature;
+		default:
+			return columns.Z;
+		}
+	}
+}
+
+void VizRailCore::SaveStationTable(const std::filesystem::path& path, const HorizontalAlignment& alignment,
+                                   const std::span<const StationRecord> stations,
+                                   const std::span<const double> elevations, const StationTableOptions& options)
+{
+	if (options.ChunkRows == 0)
+	{
+		throw VizRailCoreException(L"每块的行数必须大于0");
+	}
+	if (!(options.CoordinateResolution > 0.0))
+	{
+		throw VizRailCoreException(L"坐标分辨率必须大于0");
+	}
+	if (!elevations.empty() && elevations.size() != stations.size())
+	{
+		throw VizRailCoreException(std::format(L"高程数{}与桩数{}不符", elevations.size(), stations.size()));
+	}
+	if (!std::ranges::is_sorted(stations, {}, &StationRecord::Mileage))
+	{
+		throw VizRailCoreException(L"桩未按里程排序");
+	}
+
+	Header header{};
+	header.Magic = Magic;
+	header.Version = Version;
+	header.Encoding = options.Encoding;
+	header.ColumnCount = elevations.empty() ? ZColumn : MaxColumns;
+	if (options.Encoding == Encoding::Compressed && !stations.empty())
+	{
+		// 以首桩附近的整米点为原点，量化值只与桩到原点的距离有关
+		header.OriginN = std::round(stations.front().N);
+		header.OriginE = std::round(stations.front().E);
+	}
+	header.Resolution[MileageColumn] = MileageResolution;
+	header.Resolution[NColumn] = options.CoordinateResolution;
+	header.Resolution[EColumn] = options.CoordinateResolution;
+	header.Resolution[AzimuthColumn] = AzimuthResolution;
+	header.Resolution[CurvatureColumn] = CurvatureResolution;
+	header.Resolution[ZColumn] = options.CoordinateResolution;
+
+	ChunkWriter writer(path, header);
+	std::array<std::vector<double>, MaxColumns> columns;
+	for (size_t first = 0; first < stations.size(); first += options.ChunkRows)
+	{
+		const size_t rows = std::min<size_t>(options.ChunkRows, stations.size() - first);
+		for (auto& column : columns)
+		{
+			column.clear();
+		}
+		for (size_t i = first; i < first + rows; ++i)
+		{
+			const StationRecord& station = stations[i];
+			columns[MileageColumn].push_back(station.Mileage);
+			columns[NColumn].push_back(station.N);
+			columns[EColumn].push_back(station.E);
+			columns[AzimuthColumn].push_back(station.Azimuth);
+			columns[CurvatureColumn].push_back(StationCurvature(alignment, station));
+			if (!elevations.empty())
+			{
+				columns[ZColumn].push_back(elevations[i]);
+			}
+		}
+		writer.Write(columns);
+	}
+	writer.Close();
+}
+
+StationTableReader::StationTableReader(const std::filesystem::path& path) : _file(path)
+{
+	const auto bytes = _file.Bytes();
+	if (bytes.size() < sizeof(Header))
+	{
+		throw VizRailCoreException(L"数据长度不足，不是逐桩表文件");
+	}
+	std::memcpy(&_header, bytes.data(), sizeof(Header));
+	if (_header.Magic != Magic)
+	{
+		throw VizRailCoreException(L"数据不是逐桩表文件");
+	}
+	if (_header.Version != Version)
+	{
+		throw VizRailCoreException(std::format(L"不支持版本{}的逐桩表文件", _header.Version));
+	}
+	if ((_header.Encoding != Encoding::Raw && _header.Encoding != Encoding::Compressed &&
+			_header.Encoding != Encoding::Xor) ||
+		(_header.ColumnCount != ZColumn && _header.ColumnCount != MaxColumns))
+	{
+		throw VizRailCoreException(L"逐桩表文件头损坏");
+	}
+	if (_header.ChunkIndexOffset % alignof(ChunkEntry) != 0 || _header.ChunkIndexOffset > bytes.size() ||
+		_header.ChunkCount > (bytes.size() - _header.ChunkIndexOffset) / sizeof(ChunkEntry))
+	{
+		throw VizRailCoreException(L"逐桩表文件的块索引越界");
+	}
+	_chunks = {
+		reinterpret_cast<const ChunkEntry*>(bytes.data() + _header.ChunkIndexOffset),
+		static_cast<size_t>(_header.ChunkCount)
+	};
+
+	uint64_t rows = 0;
+	for (const ChunkEntry& chunk : _chunks)
+	{
+		const bool raw = _header.Encoding == Encoding::Raw;
+		if (chunk.FirstRow != rows || chunk.Rows == 0 || chunk.Offset > bytes.size() ||
+			chunk.Size > bytes.size() - chunk.Offset ||
+			(raw && (chunk.Offset % alignof(double) != 0 ||
+				chunk.Size != uint64_t{chunk.Rows} * _header.ColumnCount * sizeof(double))))
+		{
+			throw VizRailCoreException(L"逐桩表文件的数据块越界");
+		}
+		rows += chunk.Rows;
+	}
+	if (rows != _header.RowCount)
+	{
+		throw VizRailCoreException(L"逐桩表文件的行数与块索引不符");
+	}
+}
+
+std::span<const double> StationTableReader::RawColumn(const size_t chunk, const Column column) const
+{
+	if (_header.Encoding != Encoding::Raw)
+	{
+		throw VizRailCoreException(L"逐桩表文件不是Raw编码");
+	}
+	if (chunk >= _chunks.size() || column >= _header.ColumnCount)
+	{
+		throw VizRailCoreException(L"逐桩表文件中没有该块或该列");
+	}
+	const ChunkEntry& entry = _chunks[chunk];
+	return {
+		reinterpret_cast<const double*>(_file.Bytes().data() + entry.Offset) + size_t{column} * entry.Rows,
+		entry.Rows
+	};
+}
+
+StationColumns StationTableReader::ReadChunk(const size_t chunk) const
+{
+	StationColumns columns;
+	DecodeChunk(chunk, columns, -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
+	return columns;
+}
+
+StationColumns StationTableReader::ReadRange(const double from, const double to) const
+{
+	StationColumns columns;
+	// 块按里程排序，第一个末桩里程不小于from的块起依次解码，直到首桩里程大于to
+	auto it = std::ranges::partition_point(_chunks, [from](const ChunkEntry& chunk)
+	{
+		return chunk.LastMileage < from;
+	});
+	for (; it != _chunks.end() && it->FirstMileage <= to; ++it)
+	{
+		DecodeChunk(static_cast<size_t>(it - _chunks.begin()), columns, from, to);
+	}
+	return columns;
+}
+
+StationColumns StationTableReader::ReadAll() const
+{
+	StationColumns columns;
+	for (size_t i = 0; i < _chunks.size(); ++i)
+	{
+		DecodeChunk(i, columns, -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
+	}
+	return columns;
+}
+
+void StationTableReader::DecodeChunk(const size_t chunk, StationColumns& columns, const double from,
+                                     const double to) const
+{
+	const ChunkEntry& entry = _chunks[chunk];
+	std::array<std::vector<double>, MaxColumns> decoded;
+	std::array<std::span<const double>, MaxColumns> values;
+	if (_header.Encoding == Encoding::Raw)
+	{
+		for (uint32_t c = 0; c < _header.ColumnCount; ++c)
+		{
+			values[c] = RawColumn(chunk, static_cast<Column>(c));
+		}
+	}
+	else
+	{
+		ColumnReader reader(_file.Bytes().subspan(static_cast<size_t>(entry.Offset), static_cast<size_t>(entry.Size)));
+		const auto origins = ColumnOrigins(_header, entry.FirstMileage);
+		for (uint32_t c = 0; c < _header.ColumnCount; ++c)
+		{
+			if (_header.Encoding == Encoding::Xor)
+			{
+				reader.DecodeXor(decoded[c], entry.Rows);
+			}
+			else
+			{
+				reader.Decode(decoded[c], entry.Rows, origins[c], _header.Resolution[c]);
+			}
+			values[c] = decoded[c];
+		}
+	}
+
+	const auto mileages = values[MileageColumn];
+	const size_t begin = std::ranges::lower_bound(mileages, from) - mileages.begin();
+	const size_t end = std::ranges::upper_bound(mileages, to) - mileages.begin();
+	if (begin >= end)
+	{
+		return;
+	}
+	for (uint32_t c = 0; c < _header.ColumnCount; ++c)
+	{
+		auto& column = ColumnOf(columns, c);
+		column.insert(column.end(), values[c].begin() + begin, values[c].begin() + end);
+	}
+}
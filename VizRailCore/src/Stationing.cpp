@@ -0,0 +1,186 @@
+#include "Stationing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "Curve.h"
+#include "Exceptions.h"
+#include "TaskScheduler.h"
+
+using namespace VizRailCore;
+
+namespace
+{
+	constexpr std::pair<SpecialPoint, StationPoint> FeaturePoints[] = {
+		{SpecialPoint::ZH, StationPoint::ZH}, {SpecialPoint::HY, StationPoint::HY}, {SpecialPoint::QZ, StationPoint::QZ},
+		{SpecialPoint::YH, StationPoint::YH}, {SpecialPoint::HZ, StationPoint::HZ},
+	};
+
+	StationRecord MakeStation(const LineElement& element, const size_t index, const double mileage,
+	                          const Point2D& point, const StationPoint type)
+	{
+		return {
+			mileage, point.Y(), point.X(), element.MileageToAzimuthAngle(Mileage(mileage)).Radian(),
+			static_cast<uint32_t>(index), type
+		};
+	}
+}
+
+std::vector<size_t> VizRailCore::ElementsByMileage(const HorizontalAlignment& alignment)
+{
+	const auto& xys = alignment.GetXys();
+	std::vector<size_t> order(xys.Size());
+	std::iota(order.begin(), order.end(), size_t{0});
+	std::ranges::stable_sort(order, {}, [&](const size_t i)
+	{
+		return xys[i].Element->StartMileage().Value();
+	});
+	return order;
+}
+
+std::vector<StationRecord> VizRailCore::BuildStationTable(const HorizontalAlignment& alignment, const double interval)
+{
+	if (!(interval > 0.0))
+	{
+		throw VizRailCoreException(L"桩距必须大于0");
+	}
+	const auto& xys = alignment.GetXys();
+	const auto order = ElementsByMileage(alignment);
+	if (order.empty())
+	{
+		return {};
+	}
+	const double first = xys[order.front()].Element->StartMileage().Value();
+	const double last = xys[order.back()].Element->EndMileage().Value();
+
+	// 每个线元负责[起点里程, 终点里程)内的桩，最后一个线元包括终点，各线元的桩可以独立计算
+	std::vector<std::vector<StationRecord>> parts(order.size());
+	ParallelFor(0, order.size(), 1, [&](const size_t i)
+	{
+		const size_t index = order[i];
+		const LineElement& element = *xys[index].Element;
+		const double start = element.StartMileage().Value();
+		const double end = element.EndMileage().Value();
+		const bool lastElement = i + 1 == order.size();
+		const auto contains = [&](const double mileage)
+		{
+			return mileage >= start - StationTolerance &&
+				(lastElement ? mileage <= end + StationTolerance : mileage < end - StationTolerance);
+		};
+		auto& stations = parts[i];
+		const auto add = [&](const double mileage, const StationPoint type)
+		{
+			stations.push_back(MakeStation(element, index, mileage, element.MileageToCoordinate(Mileage(mileage)),
+			                               type));
+		};
+
+		// 加0.0把ceil得到的-0.0变为0.0，避免输出负零
+		for (double k = std::ceil(start / interval - StationTolerance) + 0.0;; ++k)
+		{
+			const double mileage = k * interval;
+			if (!contains(mileage))
+			{
+				break;
+			}
+			add(mileage, StationPoint::Interval);
+		}
+		if (i == 0)
+		{
+			add(first, StationPoint::Start);
+		}
+		if (lastElement)
+		{
+			add(last, StationPoint::End);
+		}
+		if (const auto curve = dynamic_cast<const Curve*>(&element))
+		{
+			for (const auto& [point, type] : FeaturePoints)
+			{
+				stations.push_back(MakeStation(element, index, curve->K(point).Value(),
+				                               curve->SpecialPointCoordinate(point), type));
+			}
+		}
+		std::ranges::stable_sort(stations, {}, &StationRecord::Mileage);
+	});
+
+	std::vector<StationRecord> table;
+	table.reserve(std::accumulate(parts.begin(), parts.end(), size_t{0}, [](const size_t sum, const auto& part)
+	{
+		return sum + part.size();
+	}));
+	for (const auto& part : parts)
+	{
+		for (const auto& station : part)
+		{
+			// 特征点与整桩或相邻线元的端点重合时只保留一个，类型取特征点
+			if (!table.empty() && station.Mileage - table.back().Mileage < StationTolerance)
+			{
+				if (station.Point != StationPoint::Interval)
+				{
+					table.back().Point = station.Point;
+				}
+				continue;
+			}
+			table.push_back(station);
+		}
+	}
+	return table;
+}
+
+double VizRailCore::StationCurvature(const HorizontalAlignment& alignment, const StationRecord& station)
+{
+	const auto curve = dynamic_cast<const Curve*>(alignment.GetXys()[station.Element].Element.get());
+	if (curve == nullptr)
+	{
+		return 0.0;
+	}
+	// 前半段（含QZ点）到ZH点的曲线长，后半段到HZ点的曲线长，与Curve的计算相同
+	const double l = station.Mileage <= curve->K(SpecialPoint::QZ).Value()
+		                 ? station.Mileage - curve->K(SpecialPoint::ZH).Value()
+		                 : curve->K(SpecialPoint::HZ).Value() - station.Mileage;
+	const double ls = curve->Ls();
+	const double curvature = l < ls ? std::max(0.0, l) / (curve->R() * ls) : 1.0 / curve->R();
+	return curve->IsRightTurn() ? curvature : -curvature;
+}
+
+std::vector<CenterlinePoint> VizRailCore::BuildCenterline(const HorizontalAlignment& alignment,
+                                                          const double chordTolerance)
+{
+	if (!(chordTolerance > 0.0))
+	{
+		throw VizRailCoreException(L"弦高容差必须大于0");
+	}
+	const auto& xys = alignment.GetXys();
+	const auto order = ElementsByMileage(alignment);
+	std::vector<CenterlinePoint> points;
+	const auto add = [&](const LineElement& element, const double mileage)
+	{
+		const Point2D point = element.MileageToCoordinate(Mileage(mileage));
+		points.push_back({mileage, point.X(), point.Y()});
+	};
+	// 每个线元只输出起点和内部的点，终点与下一线元的起点相同，由下一线元输出
+	for (const size_t index : order)
+	{
+		const LineElement& element = *xys[index].Element;
+		const double start = element.StartMileage().Value();
+		add(element, start);
+		if (const auto curve = dynamic_cast<const Curve*>(&element))
+		{
+			// 半径为R的圆弧上弦长s的弦高约为s²/8R，缓和曲线上的曲率半径不小于R
+			const double length = curve->K(SpecialPoint::HZ).Value() - start;
+			const double step = 2.0 * std::sqrt(2.0 * curve->R() * chordTolerance);
+			const size_t count = std::max<size_t>(1, static_cast<size_t>(std::ceil(length / step)));
+			for (size_t k = 1; k < count; ++k)
+			{
+				add(element, start + length * static_cast<double>(k) / static_cast<double>(count));
+			}
+		}
+	}
+	if (!order.empty())
+	{
+		const LineElement& element = *xys[order.back()].Element;
+		add(element, element.EndMileage().Value());
+	}
+	return points;
+}
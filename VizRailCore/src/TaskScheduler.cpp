@@ -0,0 +1,187 @@
+#include "TaskScheduler.h"
+
+using namespace VizRailCore;
+
+namespace
+{
+	// 当前线程所属的调度器及其工作线程序号，非工作线程为nullptr
+	thread_local TaskScheduler* CurrentScheduler = nullptr;
+	thread_local size_t CurrentWorker = 0;
+
+	std::mutex DefaultMutex;
+	std::unique_ptr<TaskScheduler> DefaultScheduler;
+	std::atomic<TaskScheduler*> DefaultInstance = nullptr;
+	// SetDefaultWorkerCount设置的工作线程数，未设置时按硬件线程数确定
+	size_t DefaultWorkerCount = 0;
+	bool DefaultWorkerCountSet = false;
+}
+
+TaskScheduler::TaskScheduler(const size_t workerCount)
+{
+	_workers.reserve(workerCount);
+	for (size_t i = 0; i < workerCount; ++i)
+	{
+		_workers.push_back(std::make_unique<Worker>());
+	}
+	// 所有队列建好后再启动线程，工作线程窃取时会访问其他线程的队列
+	for (size_t i = 0; i < workerCount; ++i)
+	{
+		_workers[i]->Thread = std::thread([this, i]
+		{
+			WorkerLoop(i);
+		});
+	}
+}
+
+TaskScheduler::~TaskScheduler()
+{
+	{
+		std::lock_guard lock(_mutex);
+		_stopping = true;
+	}
+	_wake.notify_all();
+	for (const auto& worker : _workers)
+	{
+		worker->Thread.join();
+	}
+}
+
+void TaskScheduler::Submit(Task task)
+{
+	if (CurrentScheduler == this)
+	{
+		// 工作线程提交的任务放入自己队列的队尾，自己优先执行，缓存中的数据还热
+		auto& worker = *_workers[CurrentWorker];
+		std::lock_guard lock(worker.Mutex);
+		worker.Tasks.push_back(std::move(task));
+		_queued.fetch_add(1, std::memory_order_release);
+	}
+	else
+	{
+		std::lock_guard lock(_mutex);
+		_injected.push_back(std::move(task));
+		_queued.fetch_add(1, std::memory_order_release);
+	}
+	NotifyWaiters();
+	if (!_workers.empty())
+	{
+		// 先取得锁再通知，保证等待中的线程在检查_queued之后才会收到通知，不会丢失唤醒
+		{
+			std::lock_guard lock(_mutex);
+		}
+		_wake.notify_one();
+	}
+}
+
+bool TaskScheduler::RunOne()
+{
+	Task task;
+	if (!TakeTask(task))
+	{
+		return false;
+	}
+	task();
+	return true;
+}
+
+bool TaskScheduler::TakeTask(Task& task)
+{
+	if (_queued.load(std::memory_order_acquire) == 0)
+	{
+		return false;
+	}
+
+	const bool isWorker = CurrentScheduler == this;
+	const size_t self = isWorker ? CurrentWorker : 0;
+	if (isWorker)
+	{
+		auto& worker = *_workers[self];
+		std::lock_guard lock(worker.Mutex);
+		if (!worker.Tasks.empty())
+		{
+			task = std::move(worker.Tasks.back());
+			worker.Tasks.pop_back();
+			_queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	{
+		std::lock_guard lock(_mutex);
+		if (!_injected.empty())
+		{
+			task = std::move(_injected.front());
+			_injected.pop_front();
+			_queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	// 从其他工作线程队列的队首窃取，那里是最早提交、拆分得最粗的任务
+	for (size_t offset = isWorker ? 1 : 0; offset < _workers.size(); ++offset)
+	{
+		auto& victim = *_workers[(self + offset) % _workers.size()];
+		std::lock_guard lock(victim.Mutex);
+		if (!victim.Tasks.empty())
+		{
+			task = std::move(victim.Tasks.front());
+			victim.Tasks.pop_front();
+			_queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+void TaskScheduler::WorkerLoop(const size_t index)
+{
+	CurrentScheduler = this;
+	CurrentWorker = index;
+	while (true)
+	{
+		if (RunOne())
+		{
+			continue;
+		}
+		std::unique_lock lock(_mutex);
+		_wake.wait(lock, [this]
+		{
+			return _stopping || _queued.load(std::memory_order_acquire) > 0;
+		});
+		if (_stopping)
+		{
+			return;
+		}
+	}
+}
+
+TaskScheduler& TaskScheduler::Default()
+{
+	if (TaskScheduler* scheduler = DefaultInstance.load(std::memory_order_acquire))
+	{
+		return *scheduler;
+	}
+
+	std::lock_guard lock(DefaultMutex);
+	if (!DefaultScheduler)
+	{
+		// 调用Default的线程在等待时也会执行任务，工作线程比硬件线程少一个
+		const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+		DefaultScheduler = std::make_unique<TaskScheduler>(DefaultWorkerCountSet ? DefaultWorkerCount : hardware - 1);
+		DefaultInstance.store(DefaultScheduler.get(), std::memory_order_release);
+	}
+	return *DefaultScheduler;
+}
+
+void TaskScheduler::SetDefaultWorkerCount(const size_t workerCount)
+{
+	ShutdownDefault();
+	std::lock_guard lock(DefaultMutex);
+	DefaultWorkerCount = workerCount;
+	DefaultWorkerCountSet = true;
+}
+
+void TaskScheduler::ShutdownDefault()
+{
+	std::lock_guard lock(DefaultMutex);
+	DefaultInstance.store(nullptr, std::memory_order_release);
+	DefaultScheduler.reset();
+}
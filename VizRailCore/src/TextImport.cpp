@@ -0,0 +1,592 @@
+#include "TextImport.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "Exceptions.h"
+#include "MappedFile.h"
+#include "TaskScheduler.h"
+#include "Utf8.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <iconv.h>
+#endif
+
+using namespace VizRailCore;
+
+namespace
+{
+	constexpr std::string_view Bom = "\xEF\xBB\xBF";
+	constexpr double Missing = std::numeric_limits<double>::quiet_NaN();
+
+	/// 要读取的一列
+	struct ColumnSpec
+	{
+		std::initializer_list<std::wstring_view> Names;
+		/// 用于错误信息的列名
+		const wchar_t* Label;
+		bool Required;
+	};
+
+	/// 文件中各列对应的ColumnSpec下标，-1为不读取的列
+	struct Layout
+	{
+		/// 0表示以连续的空格或制表符分隔
+		char Delimiter = ',';
+		/// 数据起点的字节偏移和行号
+		size_t DataOffset = 0;
+		size_t FirstLine = 1;
+		std::vector<int> Targets;
+	};
+
+	struct ChunkError
+	{
+		/// 块内的行序号，从0开始
+		size_t Line;
+		size_t Column;
+		std::wstring Message;
+	};
+
+	/// 一块数据的解析结果
+	struct Chunk
+	{
+		std::string_view Text;
+		std::vector<std::vector<double>> Columns;
+		/// 各行数据在块内的行序号，只在需要时记录
+		std::vector<size_t> Lines;
+		size_t LineCount = 0;
+		std::optional<ChunkError> Error;
+	};
+
+	std::wstring DisplayPath(const std::filesystem::path& path);
+
+	/// \brief 解码GBK
+	std::wstring DecodeGbk(const std::string_view text)
+	{
+		if (text.empty())
+		{
+			return {};
+		}
+#ifdef _WIN32
+		const int length = MultiByteToWideChar(936, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
+		std::wstring result(static_cast<size_t>(length), L'\0');
+		MultiByteToWideChar(936, 0, text.data(), static_cast<int>(text.size()), result.data(), length);
+		return result;
+#else
+		const iconv_t converter = iconv_open("UTF-8", "GBK");
+		if (converter == reinterpret_cast<iconv_t>(-1))
+		{
+			throw VizRailCoreException(L"系统不支持GBK编码");
+		}
+		// GBK的每个字符转为UTF-8后不超过3字节
+		std::string input(text);
+		std::string output(input.size() * 3 / 2 + 4, '\0');
+		char* in = input.data();
+		size_t inLeft = input.size();
+		char* out = output.data();
+		size_t outLeft = output.size();
+		const size_t converted = iconv(converter, &in, &inLeft, &out, &outLeft);
+		iconv_close(converter);
+		output.resize(output.size() - outLeft);
+		std::wstring result;
+		if (converted == static_cast<size_t>(-1) || !TryFromUtf8(output, result))
+		{
+			throw VizRailCoreException(L"不是合法的GBK编码");
+		}
+		return result;
+#endif
+	}
+
+	std::wstring DisplayPath(const std::filesystem::path& path)
+	{
+#ifdef _WIN32
+		return path.wstring();
+#else
+		const std::u8string text = path.u8string();
+		std::wstring result;
+		if (!TryFromUtf8({reinterpret_cast<const char*>(text.data()), text.size()}, result))
+		{
+			return path.wstring();
+		}
+		return result;
+#endif
+	}
+
+	TextImportException FileError(const std::filesystem::path& path, const std::wstring& message)
+	{
+		return TextImportException(std::format(L"{}：{}", DisplayPath(path), message), 0, 0);
+	}
+
+	/// 去掉首尾空白和包围的双引号
+	template <typename Char>
+	std::basic_string_view<Char> TrimField(std::basic_string_view<Char> text)
+	{
+		const auto space = [](const Char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+		};
+		while (!text.empty() && space(text.front()))
+		{
+			text.remove_prefix(1);
+		}
+		while (!text.empty() && space(text.back()))
+		{
+			text.remove_suffix(1);
+		}
+		if (text.size() >= 2 && text.front() == '"' && text.back() == '"')
+		{
+			text = text.substr(1, text.size() - 2);
+		}
+		return text;
+	}
+
+	/// \brief 依次对一行中的每个字段调用visit(列序号, 字段)
+	template <typename Char, typename Visit>
+	void SplitFields(const std::basic_string_view<Char> line, const char delimiter, const Visit& visit)
+	{
+		size_t column = 0;
+		if (delimiter != 0)
+		{
+			size_t start = 0;
+			while (true)
+			{
+				const size_t end = line.find(static_cast<Char>(delimiter), start);
+				visit(column++, line.substr(start, end == std::basic_string_view<Char>::npos ? end : end - start));
+				if (end == std::basic_string_view<Char>::npos)
+				{
+					return;
+				}
+				start = end + 1;
+			}
+		}
+		const auto space = [](const Char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r';
+		};
+		for (size_t i = 0; i < line.size();)
+		{
+			if (space(line[i]))
+			{
+				++i;
+				continue;
+			}
+			const size_t start = i;
+			while (i < line.size() && !space(line[i]))
+			{
+				++i;
+			}
+			visit(column++, line.substr(start, i - start));
+		}
+	}
+
+	bool IsBlank(const std::string_view line)
+	{
+		return TrimField(line).empty() && line.find('"') == std::string_view::npos;
+	}
+
+	/// \brief 解析数值，空字段为Missing
+	bool ParseNumber(std::string_view text, double& value)
+	{
+		text = TrimField(text);
+		if (text.empty())
+		{
+			value = Missing;
+			return true;
+		}
+		if (text.front() == '+')
+		{
+			text.remove_prefix(1);
+		}
+		const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+		return error == std::errc() && end == text.data() + text.size() && std::isfinite(value);
+	}
+
+	bool EqualsIgnoreCase(const std::wstring_view a, const std::wstring_view b)
+	{
+		return std::ranges::equal(a, b, [](const wchar_t x, const wchar_t y)
+		{
+			const auto lower = [](const wchar_t c)
+			{
+				return c >= L'A' && c <= L'Z' ? static_cast<wchar_t>(c - L'A' + L'a') : c;
+			};
+			return lower(x) == lower(y);
+		});
+	}
+
+	std::string_view NextLine(const std::string_view text, size_t& offset)
+	{
+		const size_t end = text.find('\n', offset);
+		const std::string_view line = text.substr(offset, end == std::string_view::npos ? end : end - offset);
+		offset = end == std::string_view::npos ? text.size() : end + 1;
+		return line;
+	}
+
+	/// \brief 由第一个非空行确定分隔符和各列的含义
+	/// \param headerless 第一行全为数值时使用的列顺序，为空时必须有表头
+	Layout ReadLayout(const std::filesystem::path& path, std::string_view text, const std::vector<ColumnSpec>& specs,
+	                  const TextEncoding encoding, const bool headerless)
+	{
+		Layout layout;
+		if (text.starts_with(Bom))
+		{
+			layout.DataOffset = Bom.size();
+		}
+		std::string_view header;
+		while (layout.DataOffset < text.size())
+		{
+			header = NextLine(text, layout.DataOffset);
+			if (!IsBlank(header))
+			{
+				break;
+			}
+			++layout.FirstLine;
+		}
+		if (IsBlank(header))
+		{
+			throw FileError(path, L"文件中没有数据");
+		}
+		layout.Delimiter = header.find(',') != std::string_view::npos
+			                   ? ','
+			                   : header.find('\t') != std::string_view::npos
+			                   ? '\t'
+			                   : '\0';
+
+		bool numeric = true;
+		size_t fields = 0;
+		SplitFields(header, layout.Delimiter, [&](size_t, const std::string_view field)
+		{
+			double value;
+			numeric = numeric && ParseNumber(field, value) && !std::isnan(value);
+			++fields;
+		});
+		if (numeric && headerless)
+		{
+			// 没有表头，第一行即是数据，各列依次对应specs
+			layout.DataOffset = header.data() - text.data();
+			for (size_t i = 0; i < std::min(fields, specs.size()); ++i)
+			{
+				layout.Targets.push_back(static_cast<int>(i));
+			}
+			return layout;
+		}
+		++layout.FirstLine;
+
+		std::wstring decoded;
+		try
+		{
+			decoded = DecodeText(header, encoding);
+		}
+		catch (const VizRailCoreException& e)
+		{
+			throw FileError(path, L"表头" + e.GetMsg());
+		}
+		SplitFields(std::wstring_view(decoded), layout.Delimiter, [&](const size_t column, const std::wstring_view field)
+		{
+			layout.Targets.push_back(-1);
+			for (size_t i = 0; i < specs.size(); ++i)
+			{
+				const bool taken = std::ranges::find(layout.Targets, static_cast<int>(i)) != layout.Targets.end();
+				if (!taken && std::ranges::any_of(specs[i].Names, [&](const std::wstring_view name)
+				{
+					return EqualsIgnoreCase(TrimField(field), name);
+				}))
+				{
+					layout.Targets[column] = static_cast<int>(i);
+					break;
+				}
+			}
+		});
+		return layout;
+	}
+
+	/// \brief 将数据按行首对齐分块，每块约chunkSize字节
+	std::vector<Chunk> SplitChunks(const std::string_view text, const size_t offset, const size_t chunkSize)
+	{
+		std::vector<Chunk> chunks;
+		for (size_t start = offset; start < text.size();)
+		{
+			size_t end = std::min(text.size(), start + std::max<size_t>(chunkSize, 1));
+			if (end < text.size())
+			{
+				const size_t newline = text.find('\n', end - 1);
+				end = newline == std::string_view::npos ? text.size() : newline + 1;
+			}
+			chunks.emplace_back().Text = text.substr(start, end - start);
+			start = end;
+		}
+		return chunks;
+	}
+
+	void ParseChunk(Chunk& chunk, const Layout& layout, const std::vector<ColumnSpec>& specs, const bool recordLines)
+	{
+		chunk.Columns.resize(specs.size());
+		// 按平均每行约40字节预留，避免解析过程中反复扩容
+		for (auto& column : chunk.Columns)
+		{
+			column.reserve(chunk.Text.size() / 40 + 1);
+		}
+		std::vector<double> row(specs.size());
+		size_t offset = 0;
+		for (size_t line = 0; offset < chunk.Text.size(); ++line)
+		{
+			const std::string_view text = NextLine(chunk.Text, offset);
+			chunk.LineCount = line + 1;
+			if (IsBlank(text))
+			{
+				continue;
+			}
+			std::ranges::fill(row, Missing);
+			SplitFields(text, layout.Delimiter, [&](const size_t column, const std::string_view field)
+			{
+				if (column >= layout.Targets.size() || layout.Targets[column] < 0 || chunk.Error)
+				{
+					return;
+				}
+				const int target = layout.Targets[column];
+				if (!ParseNumber(field, row[target]))
+				{
+					chunk.Error = ChunkError{line, column + 1, std::format(L"{}不是数值", specs[target].Label)};
+				}
+			});
+			for (size_t i = 0; i < specs.size() && !chunk.Error; ++i)
+			{
+				if (specs[i].Required && std::isnan(row[i]))
+				{
+					chunk.Error = ChunkError{line, 0, std::format(L"缺少{}", specs[i].Label)};
+				}
+			}
+			if (chunk.Error)
+			{
+				// 之后的块仍然解析完，只报告文件中第一个错误
+				return;
+			}
+			for (size_t i = 0; i < specs.size(); ++i)
+			{
+				chunk.Columns[i].push_back(row[i]);
+			}
+			if (recordLines)
+			{
+				chunk.Lines.push_back(line);
+			}
+		}
+	}
+
+	/// 解析结果，各列行数相同
+	struct Table
+	{
+		std::vector<std::vector<double>> Columns;
+		std::vector<int> Targets;
+		/// 各行数据的行号（从1开始），只在需要时记录
+		std::vector<size_t> Lines;
+	};
+
+	Table ParseFile(const std::filesystem::path& path, const std::vector<ColumnSpec>& specs,
+	                const TextImportOptions& options, const bool headerless, const bool recordLines)
+	{
+		std::error_code error;
+		const auto size = std::filesystem::file_size(path, error);
+		if (error)
+		{
+			throw FileError(path, L"无法打开文件");
+		}
+		if (size == 0)
+		{
+			throw FileError(path, L"文件中没有数据");
+		}
+		std::optional<MappedFile> file;
+		try
+		{
+			file.emplace(path);
+		}
+		catch (const VizRailCoreException& e)
+		{
+			throw TextImportException(e.GetMsg(), 0, 0);
+		}
+		const std::string_view text(reinterpret_cast<const char*>(file->Bytes().data()), file->Bytes().size());
+
+		const Layout layout = ReadLayout(path, text, specs, options.Encoding, headerless);
+		for (size_t i = 0; i < specs.size(); ++i)
+		{
+			if (specs[i].Required && std::ranges::find(layout.Targets, static_cast<int>(i)) == layout.Targets.end())
+			{
+				throw FileError(path, std::format(L"缺少{}列", specs[i].Label));
+			}
+		}
+
+		std::vector<Chunk> chunks = SplitChunks(text, layout.DataOffset, options.ChunkSize);
+		ParallelFor(0, chunks.size(), 1, [&](const size_t i)
+		{
+			ParseChunk(chunks[i], layout, specs, recordLines);
+		});
+
+		Table table;
+		table.Targets = layout.Targets;
+		table.Columns.resize(specs.size());
+		size_t rows = 0;
+		size_t firstLine = layout.FirstLine;
+		for (const Chunk& chunk : chunks)
+		{
+			if (chunk.Error)
+			{
+				const size_t line = firstLine + chunk.Error->Line;
+				const std::wstring location = chunk.Error->Column > 0
+					                              ? std::format(L"第{}行第{}列", line, chunk.Error->Column)
+					                              : std::format(L"第{}行", line);
+				throw TextImportException(std::format(L"{}{}：{}", DisplayPath(path), location, chunk.Error->Message),
+				                          line, chunk.Error->Column);
+			}
+			rows += chunk.Columns.front().size();
+			firstLine += chunk.LineCount;
+		}
+		for (size_t i = 0; i < specs.size(); ++i)
+		{
+			table.Columns[i].reserve(rows);
+		}
+		table.Lines.reserve(recordLines ? rows : 0);
+		firstLine = layout.FirstLine;
+		for (const Chunk& chunk : chunks)
+		{
+			for (size_t i = 0; i < specs.size(); ++i)
+			{
+				table.Columns[i].insert(table.Columns[i].end(), chunk.Columns[i].begin(), chunk.Columns[i].end());
+			}
+			for (const size_t line : chunk.Lines)
+			{
+				table.Lines.push_back(firstLine + line);
+			}
+			firstLine += chunk.LineCount;
+		}
+		return table;
+	}
+
+	/// \brief 缺失值替换为fallback
+	std::vector<double> Fill(std::vector<double> values, const double fallback)
+	{
+		for (double& value : values)
+		{
+			if (std::isnan(value))
+			{
+				value = fallback;
+			}
+		}
+		return values;
+	}
+}
+
+std::wstring VizRailCore::DecodeText(const std::string_view text, const TextEncoding encoding)
+{
+	std::wstring result;
+	if (encoding != TextEncoding::Gbk && TryFromUtf8(text, result))
+	{
+		return result;
+	}
+	if (encoding == TextEncoding::Utf8)
+	{
+		throw VizRailCoreException(L"不是合法的UTF-8编码");
+	}
+	return DecodeGbk(text);
+}
+
+std::vector<Jd> JdColumns::ToJds() const
+{
+	std::vector<Jd> jds(Size());
+	for (size_t i = 0; i < jds.size(); ++i)
+	{
+		jds[i].JdH = JdH[i];
+		jds[i].N = N[i];
+		jds[i].E = E[i];
+		jds[i].Angle = Angle[i];
+		jds[i].R = R[i];
+		jds[i].Ls = Ls[i];
+	}
+	if (!jds.empty())
+	{
+		jds.front().StartMileage = StartMileage;
+	}
+	return jds;
+}
+
+JdColumns VizRailCore::ImportJdTable(const std::filesystem::path& path, const TextImportOptions& options)
+{
+	enum Column { JdH, N, E, Angle, R, Ls, StartMileage };
+	const std::vector<ColumnSpec> specs = {
+		{{L"交点号", L"JdH"}, L"交点号", false},
+		{{L"坐标N", L"N"}, L"坐标N", true},
+		{{L"坐标E", L"E"}, L"坐标E", true},
+		{{L"偏角", L"Angle"}, L"偏角", false},
+		{{L"曲线半径", L"R"}, L"曲线半径", false},
+		{{L"前缓和曲线", L"Ls"}, L"前缓和曲线", false},
+		{{L"起点里程", L"StartMileage"}, L"起点里程", false},
+	};
+	Table table = ParseFile(path, specs, options, false, true);
+	const size_t count = table.Columns[N].size();
+	if (count < 2)
+	{
+		throw FileError(path, L"交点数少于2");
+	}
+
+	JdColumns jds;
+	jds.JdH.resize(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const double number = table.Columns[JdH][i];
+		jds.JdH[i] = std::isnan(number) ? static_cast<unsigned>(i) : static_cast<unsigned>(number);
+	}
+	jds.N = std::move(table.Columns[N]);
+	jds.E = std::move(table.Columns[E]);
+	jds.Angle = Fill(std::move(table.Columns[Angle]), 0.0);
+	jds.R = Fill(std::move(table.Columns[R]), 0.0);
+	jds.Ls = Fill(std::move(table.Columns[Ls]), 0.0);
+	jds.StartMileage = std::isnan(table.Columns[StartMileage].front()) ? 0.0 : table.Columns[StartMileage].front();
+	// 首尾交点不设曲线
+	jds.R.front() = jds.R.back() = 0.0;
+	jds.Ls.front() = jds.Ls.back() = 0.0;
+	for (size_t i = 1; i + 1 < count; ++i)
+	{
+		const auto rowError = [&](const wchar_t* message)
+		{
+			return TextImportException(std::format(L"{}第{}行：{}", DisplayPath(path), table.Lines[i], message),
+			                           table.Lines[i], 0);
+		};
+		if (!(jds.R[i] > 0.0))
+		{
+			throw rowError(L"曲线半径必须大于0");
+		}
+		if (jds.Ls[i] < 0.0)
+		{
+			throw rowError(L"缓和曲线长不能为负数");
+		}
+	}
+	return jds;
+}
+
+PointColumns VizRailCore::ImportPoints(const std::filesystem::path& path, const TextImportOptions& options)
+{
+	enum Column { N, E, Mileage };
+	const std::vector<ColumnSpec> specs = {
+		{{L"坐标N", L"N"}, L"坐标N", true},
+		{{L"坐标E", L"E"}, L"坐标E", true},
+		{{L"里程", L"连续里程", L"Mileage"}, L"里程", false},
+	};
+	Table table = ParseFile(path, specs, options, true, false);
+	PointColumns points;
+	points.N = std::move(table.Columns[N]);
+	points.E = std::move(table.Columns[E]);
+	if (std::ranges::find(table.Targets, static_cast<int>(Mileage)) != table.Targets.end())
+	{
+		points.Mileage = std::move(table.Columns[Mileage]);
+	}
+	return points;
+}
@@ -0,0 +1,289 @@
+#include "Trace.h"
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Exceptions.h"
+
+using namespace VizRailCore;
+
+namespace
+{
+#ifdef VIZRAIL_ENABLE_TRACING
+	constexpr bool CompiledIn = true;
+#else
+	constexpr bool CompiledIn = false;
+#endif
+
+	constexpr size_t CounterCount = static_cast<size_t>(TraceCounter::Count);
+
+	constexpr const char* CounterNames[CounterCount] = {
+		"Refreshes", "RefreshNanoseconds", "ElementsRebuilt", "Queries", "CacheHits", "CacheMisses",
+		"TessellatedVertices",
+	};
+
+	/// 时间均为相对Epoch的纳秒数
+	struct TraceEvent
+	{
+		const char* Name;
+		int64_t Start;
+		int64_t Duration;
+	};
+
+	/// 每个线程的计数器和事件。计数器由所属线程累加，汇总和清零时由其他线程读写
+	struct ThreadBuffer
+	{
+		size_t Id = 0;
+		std::array<std::atomic<uint64_t>, CounterCount> Counters{};
+		std::mutex Mutex;
+		std::vector<TraceEvent> Events;
+	};
+
+	std::mutex RegistryMutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> Buffers;
+	// 已退出线程的计数器之和，由RegistryMutex保护
+	TraceCounters RetiredCounters{};
+	size_t NextThreadId = 1;
+	std::atomic<bool> Recording = false;
+
+	// 事件时间的起点，静态初始化时确定，保证早于所有事件
+	const auto Epoch = std::chrono::steady_clock::now();
+
+	int64_t Nanoseconds(const std::chrono::steady_clock::duration duration)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+	}
+
+	/// 线程首次记录时登记缓冲区，退出时把计数器并入RetiredCounters。
+	/// 还有事件的缓冲区继续留在登记表中，导出时仍能看到已退出线程的事件
+	class ThreadBufferHolder
+	{
+	public:
+		ThreadBufferHolder() : Buffer(std::make_shared<ThreadBuffer>())
+		{
+			std::lock_guard lock(RegistryMutex);
+			Buffer->Id = NextThreadId++;
+			Buffers.push_back(Buffer);
+		}
+
+		ThreadBufferHolder(const ThreadBufferHolder&) = delete;
+		ThreadBufferHolder& operator=(const ThreadBufferHolder&) = delete;
+
+		~ThreadBufferHolder()
+		{
+			std::lock_guard lock(RegistryMutex);
+			for (size_t i = 0; i < CounterCount; ++i)
+			{
+				RetiredCounters[i] += Buffer->Counters[i].exchange(0, std::memory_order_relaxed);
+			}
+			std::lock_guard eventsLock(Buffer->Mutex);
+			if (Buffer->Events.empty())
+			{
+				std::erase(Buffers, Buffer);
+			}
+		}
+
+		std::shared_ptr<ThreadBuffer> Buffer;
+	};
+
+	ThreadBuffer& LocalBuffer()
+	{
+		thread_local ThreadBufferHolder holder;
+		return *holder.Buffer;
+	}
+
+	void WriteString(std::ostream& stream, const char* text)
+	{
+		stream << '"';
+		for (; *text != '\0'; ++text)
+		{
+			if (*text == '"' || *text == '\\')
+			{
+				stream << '\\';
+			}
+			stream << *text;
+		}
+		stream << '"';
+	}
+
+	/// 跟踪事件格式的时间单位为微秒
+	void WriteMicroseconds(std::ostream& stream, const int64_t nanoseconds)
+	{
+		stream << nanoseconds / 1000 << '.';
+		const auto fraction = std::to_string(nanoseconds % 1000);
+		stream << std::string(3 - fraction.size(), '0') << fraction;
+	}
+}
+
+bool Trace::IsCompiledIn()
+{
+	return CompiledIn;
+}
+
+void Trace::Add(const TraceCounter counter, const uint64_t value)
+{
+	if constexpr (CompiledIn)
+	{
+		LocalBuffer().Counters[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+	}
+}
+
+TraceCounters Trace::Counters()
+{
+	std::lock_guard lock(RegistryMutex);
+	TraceCounters counters = RetiredCounters;
+	for (const auto& buffer : Buffers)
+	{
+		for (size_t i = 0; i < CounterCount; ++i)
+		{
+			counters[i] += buffer->Counters[i].load(std::memory_order_relaxed);
+		}
+	}
+	return counters;
+}
+
+void Trace::ResetCounters()
+{
+	std::lock_guard lock(RegistryMutex);
+	RetiredCounters.fill(0);
+	for (const auto& buffer : Buffers)
+	{
+		for (auto& counter : buffer->Counters)
+		{
+			counter.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+const char* Trace::CounterName(const TraceCounter counter)
+{
+	return CounterNames[static_cast<size_t>(counter)];
+}
+
+void Trace::StartRecording()
+{
+	Recording.store(true, std::memory_order_relaxed);
+}
+
+void Trace::StopRecording()
+{
+	Recording.store(false, std::memory_order_relaxed);
+}
+
+bool Trace::IsRecording()
+{
+	return Recording.load(std::memory_order_relaxed);
+}
+
+void Trace::ClearEvents()
+{
+	std::lock_guard lock(RegistryMutex);
+	for (const auto& buffer : Buffers)
+	{
+		std::lock_guard eventsLock(buffer->Mutex);
+		buffer->Events.clear();
+		buffer->Events.shrink_to_fit();
+	}
+}
+
+void Trace::WriteChromeTrace(std::ostream& stream)
+{
+	const TraceCounters counters = Counters();
+	const int64_t now = Nanoseconds(std::chrono::steady_clock::now() - Epoch);
+
+	std::lock_guard lock(RegistryMutex);
+	stream << "{\"traceEvents\":[";
+	bool first = true;
+	const auto separator = [&]
+	{
+		stream << (first ? "\n" : ",\n");
+		first = false;
+	};
+	for (const auto& buffer : Buffers)
+	{
+		std::lock_guard eventsLock(buffer->Mutex);
+		if (buffer->Events.empty())
+		{
+			continue;
+		}
+		separator();
+		stream << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->Id
+			<< R"(,"args":{"name":"Thread )" << buffer->Id << "\"}}";
+		for (const auto& event : buffer->Events)
+		{
+			separator();
+			stream << "{\"name\":";
+			WriteString(stream, event.Name);
+			stream << R"(,"cat":"VizRailCore","ph":"X","pid":1,"tid":)" << buffer->Id << ",\"ts\":";
+			WriteMicroseconds(stream, event.Start);
+			stream << ",\"dur\":";
+			WriteMicroseconds(stream, event.Duration);
+			stream << '}';
+		}
+	}
+	// 计数器在导出时刻的值，每个计数器一条曲线
+	for (size_t i = 0; i < CounterCount; ++i)
+	{
+		separator();
+		stream << "{\"name\":";
+		WriteString(stream, CounterNames[i]);
+		stream << R"(,"ph":"C","pid":1,"tid":0,"ts":)";
+		WriteMicroseconds(stream, now);
+		stream << R"(,"args":{"value":)" << counters[i] << "}}";
+	}
+	stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+void Trace::SaveChromeTrace(const std::filesystem::path& path)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+	{
+		throw VizRailCoreException(L"无法创建跟踪文件");
+	}
+	WriteChromeTrace(file);
+	if (!file.flush())
+	{
+		throw VizRailCoreException(L"写入跟踪文件失败");
+	}
+}
+
+TraceScope::TraceScope(const char* name, const TraceCounter elapsedCounter) : _name(name),
+	_elapsedCounter(elapsedCounter)
+{
+	if constexpr (CompiledIn)
+	{
+		_recording = Recording.load(std::memory_order_relaxed);
+		if (_recording || _elapsedCounter != TraceCounter::Count)
+		{
+			_start = std::chrono::steady_clock::now();
+		}
+	}
+}
+
+TraceScope::~TraceScope()
+{
+	if (!CompiledIn || (!_recording && _elapsedCounter == TraceCounter::Count))
+	{
+		return;
+	}
+	const auto end = std::chrono::steady_clock::now();
+	const int64_t duration = Nanoseconds(end - _start);
+	if (_elapsedCounter != TraceCounter::Count)
+	{
+		Trace::Add(_elapsedCounter, static_cast<uint64_t>(duration));
+	}
+	if (_recording)
+	{
+		auto& buffer = LocalBuffer();
+		std::lock_guard lock(buffer.Mutex);
+		if (buffer.Events.size() < Trace::MaxEventsPerThread)
+		{
+			buffer.Events.push_back({_name, Nanoseconds(_start - Epoch), duration});
+		}
+	}
+}
@@ -0,0 +1,155 @@
+#include "Utf8.h"
+
+using namespace VizRailCore;
+
+bool VizRailCore::DecodeUtf8(const std::string_view text, size_t& position, char32_t& code)
+{
+	const auto lead = static_cast<unsigned char>(text[position++]);
+	if (lead < 0x80)
+	{
+		code = lead;
+		return true;
+	}
+	code = ReplacementCharacter;
+	size_t length;
+	char32_t value;
+	char32_t minimum;
+	if ((lead & 0xE0) == 0xC0)
+	{
+		length = 1;
+		value = lead & 0x1F;
+		minimum = 0x80;
+	}
+	else if ((lead & 0xF0) == 0xE0)
+	{
+		length = 2;
+		value = lead & 0x0F;
+		minimum = 0x800;
+	}
+	else if ((lead & 0xF8) == 0xF0)
+	{
+		length = 3;
+		value = lead & 0x07;
+		minimum = 0x10000;
+	}
+	else
+	{
+		return false;
+	}
+	for (size_t i = 0; i < length; ++i)
+	{
+		if (position >= text.size() || (static_cast<unsigned char>(text[position]) & 0xC0) != 0x80)
+		{
+			return false;
+		}
+		value = value << 6 | (static_cast<unsigned char>(text[position++]) & 0x3F);
+	}
+	if (value < minimum || value > 0x10FFFF || (value >= 0xD800 && value < 0xE000))
+	{
+		return false;
+	}
+	code = value;
+	return true;
+}
+
+void VizRailCore::AppendUtf8(std::string& output, char32_t code)
+{
+	if ((code >= 0xD800 && code < 0xE000) || code > 0x10FFFF)
+	{
+		code = ReplacementCharacter;
+	}
+	if (code < 0x80)
+	{
+		output += static_cast<char>(code);
+	}
+	else if (code < 0x800)
+	{
+		output += static_cast<char>(0xC0 | code >> 6);
+		output += static_cast<char>(0x80 | (code & 0x3F));
+	}
+	else if (code < 0x10000)
+	{
+		output += static_cast<char>(0xE0 | code >> 12);
+		output += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+		output += static_cast<char>(0x80 | (code & 0x3F));
+	}
+	else
+	{
+		output += static_cast<char>(0xF0 | code >> 18);
+		output += static_cast<char>(0x80 | (code >> 12 & 0x3F));
+		output += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+		output += static_cast<char>(0x80 | (code & 0x3F));
+	}
+}
+
+void VizRailCore::AppendUtf8(std::string& output, const std::wstring_view text)
+{
+	for (size_t i = 0; i < text.size(); ++i)
+	{
+		auto code = static_cast<char32_t>(text[i]);
+		if (code >= 0xD800 && code < 0xDC00 && i + 1 < text.size())
+		{
+			// UTF-16代理对
+			const auto low = static_cast<char32_t>(text[i + 1]);
+			if (low >= 0xDC00 && low < 0xE000)
+			{
+				code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+				++i;
+			}
+		}
+		AppendUtf8(output, code);
+	}
+}
+
+void VizRailCore::AppendWide(std::wstring& output, const char32_t code)
+{
+	if constexpr (sizeof(wchar_t) == 2)
+	{
+		if (code >= 0x10000)
+		{
+			output += static_cast<wchar_t>(0xD800 + ((code - 0x10000) >> 10));
+			output += static_cast<wchar_t>(0xDC00 + ((code - 0x10000) & 0x3FF));
+			return;
+		}
+	}
+	output += static_cast<wchar_t>(code);
+}
+
+std::string VizRailCore::ToUtf8(const std::wstring_view text)
+{
+	std::string result;
+	result.reserve(text.size());
+	AppendUtf8(result, text);
+	return result;
+}
+
+std::wstring VizRailCore::FromUtf8(const std::string_view text)
+{
+	std::wstring result;
+	result.reserve(text.size());
+	size_t position = 0;
+	while (position < text.size())
+	{
+		char32_t code;
+		DecodeUtf8(text, position, code);
+		AppendWide(result, code);
+	}
+	return result;
+}
+
+bool VizRailCore::TryFromUtf8(const std::string_view text, std::wstring& result)
+{
+	result.clear();
+	result.reserve(text.size());
+	size_t position = 0;
+	while (position < text.size())
+	{
+		char32_t code;
+		if (!DecodeUtf8(text, position, code))
+		{
+			return false;
+		}
+		AppendWide(result, code);
+	}
+	return true;
+}
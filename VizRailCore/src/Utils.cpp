@@ -1,6 +1,8 @@
 #include "Utils.h"
 
+#ifdef _WIN32
 #include <atlmem.h>
+#endif
 
 using namespace VizRailCore;
 
@@ -48,6 +50,7 @@ Angle VizRailCore::GetAzimuthAngle(const Point2D point1, const Point2D point2)
 	return GetAzimuthAngle(dx, dy);
 }
 
+#ifdef _WIN32
 std::wstring VizRailCore::String2Wstring(const std::string& str)
 {
 	std::wstring result;
@@ -62,4 +65,4 @@ std::wstring VizRailCore::String2Wstring(const std::string& str)
 	delete[] buffer;
 	return result;
 }
-
+#endif
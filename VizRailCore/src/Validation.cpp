@@ -0,0 +1,76 @@
+#include "Validation.h"
+
+#include <format>
+
+using namespace VizRailCore;
+
+namespace
+{
+	// 长度比较的容差，避免按标准取整设计的值因舍入误差被误报
+	constexpr double LengthTolerance = 1e-6;
+
+	bool LessThan(const double value, const double minimum)
+	{
+		return minimum > 0.0 && value < minimum - LengthTolerance;
+	}
+}
+
+std::vector<ValidationIssue> VizRailCore::Validate(const HorizontalAlignment& alignment, const DesignRules& rules)
+{
+	std::vector<ValidationIssue> issues;
+	const auto& jds = alignment.GetJds();
+	const size_t count = jds.Size();
+	if (count < 2)
+	{
+		return issues;
+	}
+
+	// 首尾交点不设曲线，切线长按0计
+	const auto tangent = [&](const size_t i)
+	{
+		return i == 0 || i + 1 == count ? 0.0 : jds[i].TH;
+	};
+
+	for (size_t i = 1; i < count; ++i)
+	{
+		// 夹直线i位于交点i-1和交点i之间
+		const std::wstring line = std::format(L"夹直线{}", i);
+		const double length = Jd::Distance(jds[i - 1], jds[i]) - tangent(i - 1) - tangent(i);
+		if (length < -LengthTolerance)
+		{
+			issues.push_back({line, std::format(L"前后曲线重叠{:.3f}m", -length)});
+		}
+		else if (i > 1 && i + 1 < count && LessThan(length, rules.MinIntermediateLength))
+		{
+			// 首尾两条夹直线连接的是线路起终点，不受最小夹直线长限制
+			issues.push_back({line, std::format(L"夹直线长{:.3f}m小于最小夹直线长{:.3f}m", length, rules.MinIntermediateLength)});
+		}
+
+		if (i + 1 == count)
+		{
+			break;
+		}
+
+		// 曲线i位于交点i处
+		const std::wstring curve = std::format(L"曲线{}", i);
+		const Jd& jd = jds[i];
+		if (LessThan(jd.R, rules.MinRadius))
+		{
+			issues.push_back({curve, std::format(L"曲线半径{:.3f}m小于最小曲线半径{:.3f}m", jd.R, rules.MinRadius)});
+		}
+		if (LessThan(jd.Ls, rules.MinTransitionLength))
+		{
+			issues.push_back({curve, std::format(L"缓和曲线长{:.3f}m小于最小缓和曲线长{:.3f}m", jd.Ls, rules.MinTransitionLength)});
+		}
+		const double circular = jd.LH - 2 * jd.Ls;
+		if (circular < -LengthTolerance)
+		{
+			issues.push_back({curve, L"偏角过小，两段缓和曲线重叠"});
+		}
+		else if (LessThan(circular, rules.MinCircularLength))
+		{
+			issues.push_back({curve, std::format(L"圆曲线长{:.3f}m小于最小圆曲线长{:.3f}m", circular, rules.MinCircularLength)});
+		}
+	}
+	return issues;
+}
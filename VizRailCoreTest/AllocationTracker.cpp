@@ -0,0 +1,99 @@
+#include "AllocationTracker.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	// 平凡类型的thread_local不需要动态初始化，程序启动早期的分配也能安全计数
+	thread_local AllocationStats ThreadAllocations;
+
+	void* Allocate(const std::size_t size)
+	{
+		++ThreadAllocations.Count;
+		ThreadAllocations.Bytes += size;
+		return std::malloc(size == 0 ? 1 : size);
+	}
+
+	void* AllocateAligned(const std::size_t size, const std::align_val_t alignment)
+	{
+		++ThreadAllocations.Count;
+		ThreadAllocations.Bytes += size;
+		const auto align = static_cast<std::size_t>(alignment);
+#ifdef _MSC_VER
+		return _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+		return std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+	}
+
+	void FreeAligned(void* p)
+	{
+#ifdef _MSC_VER
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+}
+
+AllocationScope::AllocationScope() : _start(ThreadAllocations)
+{
+}
+
+AllocationStats AllocationScope::Stats() const
+{
+	return {ThreadAllocations.Count - _start.Count, ThreadAllocations.Bytes - _start.Bytes};
+}
+
+bool AllocatesAtMostMatcher::match(const std::function<void()>& action) const
+{
+	_actual = MeasureAllocations(action);
+	return !ExactAllocationCounts || _actual.Count <= _count;
+}
+
+std::string AllocatesAtMostMatcher::describe() const
+{
+	return "allocates at most " + std::to_string(_count) + " times (actually " + std::to_string(_actual.Count) +
+		" times, " + std::to_string(_actual.Bytes) + " bytes)";
+}
+
+// 替换全局分配函数。数组和nothrow版本的默认实现会转调这些函数，不需要单独替换
+
+void* operator new(const std::size_t size)
+{
+	if (void* p = Allocate(size))
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+	if (void* p = AllocateAligned(size, alignment))
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+	FreeAligned(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+	FreeAligned(p);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include <catch2/matchers/catch_matchers.hpp>
+
+/// MSVC调试版的迭代器调试会为每个标准容器和字符串额外分配一个代理对象，分配次数不反映发布版的行为，
+/// 这时AllocatesAtMost不做检查，其他依赖确切次数的断言也应跳过
+#if defined(_MSC_VER) && _ITERATOR_DEBUG_LEVEL > 0
+inline constexpr bool ExactAllocationCounts = false;
+#else
+inline constexpr bool ExactAllocationCounts = true;
+#endif
+
+/// 堆分配统计，由本测试程序替换的全局operator new按线程累计
+struct AllocationStats
+{
+	size_t Count = 0;
+	size_t Bytes = 0;
+};
+
+/// 统计当前线程在作用域内的堆分配次数和字节数，其他线程的分配不计入
+class AllocationScope
+{
+public:
+	AllocationScope();
+
+	/// 从构造到现在的堆分配
+	[[nodiscard]] AllocationStats Stats() const;
+
+private:
+	AllocationStats _start;
+};
+
+/// \brief 执行action并返回其间当前线程的堆分配
+template <typename Action>
+AllocationStats MeasureAllocations(const Action& action)
+{
+	const AllocationScope scope;
+	action();
+	return scope.Stats();
+}
+
+/// 断言一个动作的堆分配次数不超过上限
+class AllocatesAtMostMatcher final : public Catch::Matchers::MatcherBase<std::function<void()>>
+{
+public:
+	explicit AllocatesAtMostMatcher(const size_t count) : _count(count)
+	{
+	}
+
+	bool match(const std::function<void()>& action) const override;
+
+	std::string describe() const override;
+
+private:
+	size_t _count;
+	mutable AllocationStats _actual;
+};
+
+/// \brief 用法：REQUIRE_THAT([&] { ... }, AllocatesAtMost(0))
+inline AllocatesAtMostMatcher AllocatesAtMost(const size_t count)
+{
+	return AllocatesAtMostMatcher(count);
+}
+
+/// \brief 用法：REQUIRE_THAT([&] { (void)curve.MileageToCoordinate(mileage); }, AllocatesNothing())
+inline AllocatesAtMostMatcher AllocatesNothing()
+{
+	return AllocatesAtMostMatcher(0);
+}
@@ -0,0 +1,177 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <random>
+
+#include "AabbTree.h"
+#include "Curve.h"
+#include "HorizontalAlignment.h"
+
+using namespace Catch;
+using namespace VizRailCore;
+
+TEST_CASE("CurveBoundsShouldContainCurve", "[AabbTree]")
+{
+	const Point2D jd1 = {3342247.107195, 507118.139447};
+	const Point2D jd2 = {3339134.96392, 503688.185001};
+	const Point2D jd3 = {3330609.751766, 483014.208169};
+	const Point2D jd4 = {3331514.645487, 470764.921972};
+	const Curve curve1(jd1, jd2, jd3, 10000.0, 590.0, 5000.0);
+	const Curve curve2(jd2, jd3, jd4, 10000.0, 590.0, 10000.0);
+	const Curve curve3(jd1, jd2, jd3, 300.0, 0.0, 5000.0);
+
+	for (const auto& curve : {curve1, curve2, curve3})
+	{
+		const BoundingBox bounds = curve.Bounds();
+		BoundingBox sampled;
+		const double start = curve.K(SpecialPoint::ZH).Value();
+		const double end = curve.K(SpecialPoint::HZ).Value();
+		for (double mileage = start; mileage < end; mileage += 1.0)
+		{
+			const Point2D point = curve.MileageToCoordinate(mileage);
+			REQUIRE(bounds.Inflated(1e-6).Contains(point));
+			sampled.Extend(point);
+		}
+		sampled.Extend(curve.MileageToCoordinate(end));
+
+		// 解析包围盒应与逐米采样结果基本一致
+		REQUIRE(bounds.Min().X() == Approx(sampled.Min().X()).margin(1.0));
+		REQUIRE(bounds.Min().Y() == Approx(sampled.Min().Y()).margin(1.0));
+		REQUIRE(bounds.Max().X() == Approx(sampled.Max().X()).margin(1.0));
+		REQUIRE(bounds.Max().Y() == Approx(sampled.Max().Y()).margin(1.0));
+	}
+}
+
+TEST_CASE("AabbTreeQueryShouldMatchBruteForce", "[AabbTree]")
+{
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<double> position(0.0, 1000.0);
+	std::uniform_real_distribution<double> size(0.0, 20.0);
+
+	std::vector<BoundingBox> boxes;
+	for (int i = 0; i < 1000; ++i)
+	{
+		const Point2D min = {position(rng), position(rng)};
+		boxes.emplace_back(min, Point2D{min.X() + size(rng), min.Y() + size(rng)});
+	}
+	const AabbTree tree(boxes);
+	REQUIRE(tree.Size() == boxes.size());
+
+	BoundingBox all;
+	for (const auto& box : boxes)
+	{
+		all.Extend(box);
+	}
+	REQUIRE(tree.Bounds().Min() == all.Min());
+	REQUIRE(tree.Bounds().Max() == all.Max());
+
+	SECTION("RectangleQuery")
+	{
+		std::vector<size_t> result;
+		for (int i = 0; i < 100; ++i)
+		{
+			const Point2D min = {position(rng), position(rng)};
+			const BoundingBox query(min, Point2D{min.X() + 100.0, min.Y() + 50.0});
+			tree.Query(query, result);
+
+			std::vector<size_t> expected;
+			for (size_t j = 0; j < boxes.size(); ++j)
+			{
+				if (boxes[j].Intersects(query))
+				{
+					expected.push_back(j);
+				}
+			}
+			REQUIRE(result == expected);
+		}
+	}
+
+	SECTION("NearestQuery")
+	{
+		for (int i = 0; i < 100; ++i)
+		{
+			// 以包围盒中心代表对象，最近对象应与逐个比较的结果相同，且只访问一小部分对象
+			const Point2D point = {position(rng) * 1.2 - 100.0, position(rng) * 1.2 - 100.0};
+			size_t nearest = boxes.size();
+			double best = std::numeric_limits<double>::infinity();
+			size_t visited = 0;
+			tree.VisitNearest(point, [&](const size_t index)
+			{
+				++visited;
+				const double distance = Point2D::Distance(point, boxes[index].Center());
+				if (distance < best)
+				{
+					best = distance;
+					nearest = index;
+				}
+				return distance;
+			});
+
+			double expected = std::numeric_limits<double>::infinity();
+			for (const auto& box : boxes)
+			{
+				expected = std::min(expected, Point2D::Distance(point, box.Center()));
+			}
+			REQUIRE(nearest < boxes.size());
+			REQUIRE(best == expected);
+			REQUIRE(visited < boxes.size() / 10);
+		}
+	}
+
+	SECTION("RayQuery")
+	{
+		std::vector<size_t> result;
+		const Ray2D ray({-10.0, 500.0}, 1.0, 0.1);
+		tree.Query(ray, result);
+
+		size_t expectedCount = 0;
+		for (const auto& box : boxes)
+		{
+			double t = 0.0;
+			expectedCount += box.Intersects(ray, t) ? 1 : 0;
+		}
+		REQUIRE(result.size() == expectedCount);
+
+		double lastT = 0.0;
+		for (const auto index : result)
+		{
+			double t = 0.0;
+			REQUIRE(boxes[index].Intersects(ray, t));
+			REQUIRE(t >= lastT);
+			lastT = t;
+		}
+	}
+}
+
+TEST_CASE("HorizontalAlignmentShouldIndexElements", "[AabbTree]")
+{
+	const std::vector<Jd> jds = {
+		{0, 507118.139447, 3342247.107195, 0, 0, 0, 0, 0, 0, 0, 0},
+		{1, 503688.185001, 3339134.96392, 0, 10000.0, 590.0, 0, 0, 0, 0, 0},
+		{2, 483014.208169, 3330609.751766, 0, 10000.0, 590.0, 0, 0, 0, 0, 0},
+		{3, 470764.921972, 3331514.645487, 0, 8000.0, 590.0, 0, 0, 0, 0, 0},
+		{4, 468474.95, 3335628.27, 0, 0, 0, 0, 0, 0, 0, 0},
+	};
+	const HorizontalAlignment alignment(jds);
+	const auto& xys = alignment.GetXys();
+	REQUIRE(xys.Size() == 7);
+
+	const BoundingBox& extents = alignment.Extents();
+	for (const auto& jd : jds)
+	{
+		REQUIRE(extents.Contains(Point2D{jd.E, jd.N}));
+	}
+
+	// 以某一线元的中点附近为查询范围，结果应包含该线元
+	for (size_t i = 0; i < xys.Size(); ++i)
+	{
+		const auto& element = xys[i].Element;
+		const BoundingBox bounds = element->Bounds();
+		const BoundingBox query(bounds.Center(), bounds.Center());
+		const auto result = alignment.QueryElements(query);
+		REQUIRE(std::find(result.begin(), result.end(), i) != result.end());
+	}
+
+	const BoundingBox far({0.0, 0.0}, {1.0, 1.0});
+	REQUIRE(alignment.QueryElements(far).empty());
+}
@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#include "AlignmentImage.h"
+#include "Exceptions.h"
+#include "ZigzagJds.h"
+
+using namespace Catch;
+using namespace VizRailCore;
+
+namespace
+{
+	/// 逐里程比较映像视图与线路的查询结果
+	void RequireSameFrames(const AlignmentImageView& view, const HorizontalAlignment& alignment)
+	{
+		const auto& xys = alignment.GetXys();
+		const double end = xys[xys.Size() - 1].Element->EndMileage().Value();
+		for (double mileage = 0.0; mileage <= end; mileage += 13.7)
+		{
+			INFO("mileage " << mileage);
+			const StationFrame expected = alignment.MileageToFrame(Mileage(mileage));
+			const StationFrame frame = view.MileageToFrame(Mileage(mileage));
+			REQUIRE(frame.Element == expected.Element);
+			REQUIRE(frame.Point.X() == Approx(expected.Point.X()).margin(1e-6));
+			REQUIRE(frame.Point.Y() == Approx(expected.Point.Y()).margin(1e-6));
+			REQUIRE(frame.Azimuth.Radian() == Approx(expected.Azimuth.Radian()).margin(1e-12));
+		}
+		REQUIRE_THROWS_AS(view.MileageToFrame(Mileage(end + 1.0)), NotInLineException);
+	}
+}
+
+TEST_CASE("AlignmentImageShouldMatchAlignment", "[AlignmentImage]")
+{
+	// 折线交替左转和右转，曲线前后半段和缓和曲线、圆曲线都会查询到
+	const HorizontalAlignment alignment(ZigzagJds(30));
+	const std::vector<std::byte> image = BuildAlignmentImage(alignment);
+	REQUIRE(image.size() == AlignmentImageSize(alignment));
+
+	const AlignmentImageView view(image);
+	REQUIRE(view.Revision() == alignment.Revision());
+	REQUIRE(view.Elements().size() == alignment.GetXys().Size());
+	REQUIRE(view.Extents().Min() == alignment.Extents().Min());
+	REQUIRE(view.Extents().Max() == alignment.Extents().Max());
+	RequireSameFrames(view, alignment);
+
+	// 交点表原样保留，可以在其他进程中重建线路
+	const auto jds = view.CopyJds();
+	REQUIRE(jds.size() == alignment.GetJds().Size());
+	for (size_t i = 0; i < jds.size(); ++i)
+	{
+		REQUIRE(std::memcmp(&jds[i].N, &alignment.GetJds()[i].N, sizeof(double) * 10) == 0);
+		REQUIRE(jds[i].JdH == alignment.GetJds()[i].JdH);
+	}
+	// 重建的线路修订号不同，其余内容与原映像逐字节相同
+	const auto rebuilt = BuildAlignmentImage(HorizontalAlignment(jds));
+	AlignmentImage::Header header;
+	std::memcpy(&header, image.data(), sizeof(header));
+	REQUIRE(rebuilt.size() == image.size());
+	REQUIRE(std::equal(rebuilt.begin() + header.Jds.Offset, rebuilt.end(), image.begin() + header.Jds.Offset));
+}
+
+TEST_CASE("AlignmentImageShouldBePositionIndependent", "[AlignmentImage]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(10));
+	const std::vector<std::byte> image = BuildAlignmentImage(alignment);
+	// 复制到另一地址（模拟映射到其他进程）后直接查询
+	std::vector<std::byte> moved(image.size() + 64);
+	std::byte* start = moved.data() + 64;
+	std::memcpy(start, image.data(), image.size());
+	const AlignmentImageView view({start, image.size()});
+	RequireSameFrames(view, alignment);
+
+	const auto path = std::filesystem::temp_directory_path() / "VizRailCoreTest.vral";
+	SaveAlignmentImage(alignment, path);
+	{
+		const MappedAlignmentFile file(path);
+		RequireSameFrames(file.View(), alignment);
+	}
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("AlignmentImageShouldRejectInvalidData", "[AlignmentImage]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(5));
+	std::vector<std::byte> image = BuildAlignmentImage(alignment);
+	REQUIRE_THROWS_AS(AlignmentImageView(std::span(image).first(16)), VizRailCoreException);
+	REQUIRE_THROWS_AS(AlignmentImageView(std::span(image).first(image.size() - 1)), VizRailCoreException);
+	REQUIRE_THROWS_AS(AlignmentImageView(std::span(image).subspan(1)), VizRailCoreException);
+
+	AlignmentImage::Header header;
+	std::memcpy(&header, image.data(), sizeof(header));
+	auto corrupt = [&](auto modify)
+	{
+		AlignmentImage::Header modified = header;
+		modify(modified);
+		std::vector<std::byte> copy = image;
+		std::memcpy(copy.data(), &modified, sizeof(modified));
+		return copy;
+	};
+	REQUIRE_THROWS_AS(AlignmentImageView(corrupt([](auto& h) { h.Magic = 0; })), VizRailCoreException);
+	REQUIRE_THROWS_AS(AlignmentImageView(corrupt([](auto& h) { h.Version = 99; })), VizRailCoreException);
+	REQUIRE_THROWS_AS(AlignmentImageView(corrupt([](auto& h) { h.Elements.Count = 1u << 30; })),
+	                  VizRailCoreException);
+	REQUIRE_THROWS_AS(AlignmentImageView(corrupt([](auto& h) { h.Jds.Offset = h.Size + 8; })),
+	                  VizRailCoreException);
+
+	std::vector<std::byte> small(AlignmentImageSize(alignment) - 1);
+	REQUIRE_THROWS_AS(WriteAlignmentImage(alignment, small), VizRailCoreException);
+}
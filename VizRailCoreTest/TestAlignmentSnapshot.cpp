@@ -0,0 +1,184 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+
+#include "AlignmentSnapshot.h"
+#include "Exceptions.h"
+#include "ZigzagJds.h"
+
+using namespace VizRailCore;
+
+namespace
+{
+	/// 检查快照内部是否一致，返回不一致的原因，一致时返回空字符串
+	std::string CheckSnapshot(const HorizontalAlignment& snapshot)
+	{
+		const auto& jds = snapshot.GetJds();
+		const auto& xys = snapshot.GetXys();
+		if (xys.Size() != jds.Size() * 2 - 3)
+		{
+			return "element count does not match jd count";
+		}
+		// 线元按曲线、其前方夹直线的顺序排列，按起点里程排序后应首尾相接
+		std::vector<std::pair<double, double>> ranges;
+		for (const auto& xy : xys)
+		{
+			ranges.emplace_back(xy.Element->StartMileage().Value(), xy.Element->EndMileage().Value());
+		}
+		std::ranges::sort(ranges);
+		for (size_t i = 1; i < ranges.size(); ++i)
+		{
+			if (std::abs(ranges[i].first - ranges[i - 1].second) > 1e-6)
+			{
+				return "elements are not continuous";
+			}
+		}
+		if (snapshot.QueryElements(snapshot.Extents()).size() != xys.Size())
+		{
+			return "index does not cover all elements";
+		}
+		const auto& middle = xys[xys.Size() / 2];
+		if (snapshot.GetXy(middle.Key).get() != middle.Element.get())
+		{
+			return "element lookup does not match route order";
+		}
+		const Point2D point = snapshot.MileageToCoordinate(middle.Element->StartMileage());
+		if (!snapshot.Extents().Contains(point))
+		{
+			return "coordinate is outside extents";
+		}
+		return {};
+	}
+}
+
+TEST_CASE("SnapshotShouldNotChangeAfterPublish", "[AlignmentSnapshot]")
+{
+	HorizontalAlignment alignment(ZigzagJds(20));
+	const AlignmentSnapshotPublisher publisher(alignment);
+
+	const AlignmentSnapshot before = publisher.Current();
+	REQUIRE(before->Revision() == alignment.Revision());
+
+	alignment.MoveJd(10, 300.0, 0.0);
+	const AlignmentSnapshot after = publisher.Current();
+	REQUIRE(after->Revision() == alignment.Revision());
+	REQUIRE(after->Revision() != before->Revision());
+	REQUIRE(before->GetJds()[10].N == 20000.0);
+	REQUIRE(after->GetJds()[10].N == 20300.0);
+
+	// 快照与线路共享未变化的线元
+	REQUIRE(after->GetXys()[0].Element == before->GetXys()[0].Element);
+
+	// 撤销同样发布新快照
+	REQUIRE(alignment.Undo());
+	REQUIRE(publisher.Current()->Revision() == before->Revision());
+	REQUIRE(CheckSnapshot(*publisher.Current()) == "");
+}
+
+TEST_CASE("SnapshotShouldNotPublishInsideEdit", "[AlignmentSnapshot]")
+{
+	HorizontalAlignment alignment(ZigzagJds(10));
+	AlignmentSnapshotPublisher publisher(alignment);
+	const uint64_t revision = publisher.Current()->Revision();
+	{
+		EditTransaction transaction(alignment);
+		alignment.MoveJd(3, 100.0, 0.0);
+		alignment.MoveJd(4, 100.0, 0.0);
+		REQUIRE_THROWS_AS(publisher.Publish(), VizRailCoreException);
+		// 事务提交前读者看到的仍是修改前的快照
+		REQUIRE(publisher.Current()->Revision() == revision);
+		transaction.Commit();
+	}
+	REQUIRE(publisher.Current()->GetJds()[3].N == 6100.0);
+}
+
+TEST_CASE("SnapshotReadersShouldSeeConsistentStateDuringEdits", "[AlignmentSnapshot]")
+{
+	HorizontalAlignment alignment(ZigzagJds(200));
+	const AlignmentSnapshotPublisher publisher(alignment);
+
+	constexpr size_t readerCount = 4;
+	std::atomic<bool> stop = false;
+	std::vector<std::string> failures(readerCount);
+	std::vector<size_t> reads(readerCount, 0);
+	std::vector<std::thread> readers;
+	for (size_t r = 0; r < readerCount; ++r)
+	{
+		readers.emplace_back([&, r]
+		{
+			uint64_t lastRevision = 0;
+			while (!stop.load(std::memory_order_relaxed) && failures[r].empty())
+			{
+				const AlignmentSnapshot snapshot = publisher.Current();
+				// 写线程只做编辑不做撤销，修订号单调递增
+				if (snapshot->Revision() < lastRevision)
+				{
+					failures[r] = "revision went backwards";
+					break;
+				}
+				lastRevision = snapshot->Revision();
+				try
+				{
+					failures[r] = CheckSnapshot(*snapshot);
+				}
+				catch (const std::exception& e)
+				{
+					failures[r] = e.what();
+				}
+				++reads[r];
+			}
+		});
+	}
+
+	// 写线程出错时也要先停下读线程再报告
+	std::string writerFailure;
+	std::mt19937 random(20240618);
+	std::ptrdiff_t inserted = 0;
+	for (int step = 0; step < 300 && writerFailure.empty(); ++step)
+	{
+		try
+		{
+			// 移动、插入、删除交替进行，删除的是上一步插入的交点，线路始终保持在原折线附近
+			const size_t count = alignment.GetJds().Size();
+			switch (step % 3)
+			{
+			case 0:
+				alignment.MoveJd(1 + random() % (count - 2), 0.0, static_cast<double>(random() % 101) - 50.0);
+				break;
+			case 1:
+				{
+					inserted = static_cast<std::ptrdiff_t>(1 + random() % (count - 2));
+					const auto& a = alignment.GetJds()[inserted - 1];
+					const auto& b = alignment.GetJds()[inserted];
+					alignment.InsertJd(inserted, {0, (a.N + b.N) / 2, (a.E + b.E) / 2 + 100.0, 0, 300.0, 40.0, 0, 0, 0, 0, 0});
+					break;
+				}
+			default:
+				alignment.RemoveJd(inserted);
+				break;
+			}
+		}
+		catch (const std::exception& e)
+		{
+			writerFailure = e.what();
+		}
+	}
+	stop = true;
+	for (auto& reader : readers)
+	{
+		reader.join();
+	}
+
+	REQUIRE(writerFailure == "");
+	for (size_t r = 0; r < readerCount; ++r)
+	{
+		INFO("reader " << r);
+		REQUIRE(failures[r] == "");
+		REQUIRE(reads[r] > 0);
+	}
+	REQUIRE(publisher.Current()->Revision() == alignment.Revision());
+	REQUIRE(CheckSnapshot(*publisher.Current()) == "");
+}
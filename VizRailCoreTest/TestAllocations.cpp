@@ -0,0 +1,145 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+
+#include <thread>
+
+#include "AlignmentImage.h"
+#include "AllocationTracker.h"
+#include "Curve.h"
+#include "HorizontalAlignment.h"
+#include "IntermediateLine.h"
+#include "Mileage.h"
+#include "ZigzagJds.h"
+
+using namespace VizRailCore;
+
+TEST_CASE("AllocationScopeShouldCountCurrentThreadOnly", "[Allocations]")
+{
+	const AllocationScope scope;
+	const auto value = std::make_unique<int>(42);
+	std::thread([]
+	{
+		const std::vector<double> others(100);
+	}).join();
+	// std::thread自身的状态对象由当前线程分配
+	REQUIRE(scope.Stats().Count >= 1);
+	REQUIRE(scope.Stats().Bytes < 100 * sizeof(double));
+
+	// 直接调用分配函数，new表达式成对的分配和释放可能被编译器省略
+	const auto stats = MeasureAllocations([] { ::operator delete(::operator new(sizeof(int))); });
+	REQUIRE(stats.Count == 1);
+	REQUIRE(stats.Bytes == sizeof(int));
+	REQUIRE_THAT([] { const std::vector<int> v(3); }, AllocatesAtMost(1));
+	REQUIRE_THAT([] { const int v[3]{}; (void)v; }, AllocatesNothing());
+	if constexpr (ExactAllocationCounts)
+	{
+		REQUIRE_FALSE(AllocatesNothing().match([] { ::operator delete(::operator new(sizeof(int))); }));
+	}
+}
+
+TEST_CASE("MileageShouldNotAllocate", "[Allocations]")
+{
+	const Mileage mileage(1000.0);
+	REQUIRE_THAT([&]
+	{
+		const Mileage copy(mileage);
+		(void)(copy + 1.0);
+		(void)(copy - 1.0);
+		(void)(copy < 5.0);
+		(void)copy.Value();
+		(void)copy.Prefix();
+	}, AllocatesNothing());
+}
+
+TEST_CASE("ElementQueriesShouldNotAllocate", "[Allocations]")
+{
+	const Curve curve({0, 0}, {100, 100}, {0, 200}, 10.0, 1.0, 1000.0);
+	const IntermediateLine line({0, 0}, 0.0, {100, 100}, 141.0);
+
+	for (const double ratio : {0.0, 0.1, 0.5, 1.0})
+	{
+		const Mileage mileage = curve.StartMileage() + curve.Length() * ratio;
+		INFO("mileage " << mileage.Value());
+		REQUIRE_THAT([&]
+		{
+			(void)curve.MileageToCoordinate(mileage);
+			(void)curve.MileageToAzimuthAngle(mileage);
+			(void)curve.IsOnIt(mileage);
+		}, AllocatesNothing());
+	}
+	REQUIRE_THAT([&]
+	{
+		(void)curve.K(SpecialPoint::HZ);
+		(void)curve.SpecialPointCoordinate(SpecialPoint::QZ);
+		(void)curve.Bounds();
+		(void)curve.Length();
+		(void)curve.T_H();
+		(void)curve.Equals(curve);
+	}, AllocatesNothing());
+
+	REQUIRE_THAT([&]
+	{
+		(void)line.MileageToCoordinate(Mileage(50.0));
+		(void)line.MileageToAzimuthAngle(Mileage(50.0));
+		(void)line.Bounds();
+		(void)line.Length();
+	}, AllocatesNothing());
+}
+
+TEST_CASE("AlignmentQueriesShouldNotAllocate", "[Allocations]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(20));
+	const std::wstring key = L"曲线3";
+	// 里程索引在首次查询时建立
+	(void)alignment.MileageToCoordinate(Mileage(0.0));
+
+	REQUIRE_THAT([&]
+	{
+		for (double mileage = 0; mileage < alignment.GetTotalMileage(); mileage += 500.0)
+		{
+			(void)alignment.MileageToCoordinate(Mileage(mileage));
+		}
+		(void)alignment.GetXy(key);
+		(void)alignment.Extents();
+		(void)alignment.GetJds()[5];
+	}, AllocatesNothing());
+
+	REQUIRE_THAT([&]
+	{
+		double length = 0;
+		for (const auto& xy : alignment.GetXys())
+		{
+			length += xy.Element->Length();
+		}
+		REQUIRE(length > 0);
+	}, AllocatesNothing());
+
+	// 首次查询建立空间索引；之后复用结果容器的视口查询不再分配
+	std::vector<size_t> result;
+	alignment.QueryElements(alignment.Extents(), result);
+	REQUIRE(result.size() == alignment.GetXys().Size());
+	REQUIRE_THAT([&]
+	{
+		alignment.QueryElements(alignment.Extents(), result);
+		alignment.QueryElements(alignment.GetXy(key)->Bounds(), result);
+	}, AllocatesNothing());
+	REQUIRE_FALSE(result.empty());
+	REQUIRE(result == alignment.QueryElements(alignment.GetXy(key)->Bounds()));
+}
+
+TEST_CASE("AlignmentImageQueriesShouldNotAllocate", "[Allocations]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(20));
+	const std::vector<std::byte> image = BuildAlignmentImage(alignment);
+	const AlignmentImageView view(image);
+	REQUIRE_THAT([&]
+	{
+		for (double mileage = 0; mileage < alignment.GetTotalMileage(); mileage += 500.0)
+		{
+			(void)view.MileageToFrame(Mileage(mileage));
+		}
+		(void)view.Extents();
+		(void)view.Jds()[5];
+	}, AllocatesNothing());
+	REQUIRE_THAT([&] { (void)AlignmentImageView(image); }, AllocatesNothing());
+}
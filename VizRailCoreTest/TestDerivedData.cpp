@@ -0,0 +1,206 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <vector>
+
+#include "AllocationTracker.h"
+#include "DerivedData.h"
+#include "DisplayListBuilder.h"
+#include "HorizontalAlignment.h"
+#include "ZigzagJds.h"
+
+using namespace Catch;
+using namespace VizRailCore;
+
+namespace
+{
+	/// 测试期间使用指定预算，结束时恢复为不限并清零统计
+	struct BudgetScope
+	{
+		explicit BudgetScope(const size_t bytes)
+		{
+			DerivedDataManager::Instance().EvictAll();
+			DerivedDataManager::Instance().ResetStats();
+			DerivedDataManager::Instance().SetBudget(bytes);
+		}
+
+		~BudgetScope()
+		{
+			DerivedDataManager::Instance().SetBudget(0);
+			DerivedDataManager::Instance().ResetStats();
+		}
+	};
+
+	/// 建立一块指定字节数的数据，记录建立次数
+	std::shared_ptr<const std::vector<char>> Use(DerivedData<std::vector<char>>& data, const size_t bytes,
+	                                             size_t& builds)
+	{
+		return data.Get([&]
+		{
+			++builds;
+			return std::vector<char>(bytes);
+		}, [](const std::vector<char>& value)
+		{
+			return value.size();
+		});
+	}
+}
+
+TEST_CASE("DerivedDataShouldEvictLeastRecentlyUsed", "[DerivedData]")
+{
+	const BudgetScope scope(250);
+	DerivedData<std::vector<char>> a;
+	DerivedData<std::vector<char>> b;
+	DerivedData<std::vector<char>> c;
+	size_t builds = 0;
+
+	(void)Use(a, 100, builds);
+	(void)Use(b, 100, builds);
+	// a比b更近使用，建立c时淘汰b
+	(void)Use(a, 100, builds);
+	const auto held = Use(c, 100, builds);
+	REQUIRE(builds == 3);
+	REQUIRE(a.Current() != nullptr);
+	REQUIRE(b.Current() == nullptr);
+	REQUIRE(c.Current() != nullptr);
+
+	auto stats = DerivedDataManager::Instance().Stats();
+	REQUIRE(stats.Hits == 1);
+	REQUIRE(stats.Misses == 3);
+	REQUIRE(stats.Evictions == 1);
+	REQUIRE(stats.Entries == 2);
+	REQUIRE(stats.Bytes == 200);
+	REQUIRE(stats.HitRate() == Approx(0.25));
+
+	// 被淘汰的项在下次使用时重新建立，此时a最久未使用
+	(void)Use(c, 100, builds);
+	(void)Use(b, 100, builds);
+	REQUIRE(builds == 4);
+	REQUIRE(a.Current() == nullptr);
+
+	// 调低预算立即淘汰，仍被持有的数据在持有期间有效
+	DerivedDataManager::Instance().SetBudget(50);
+	REQUIRE(c.Current() == nullptr);
+	REQUIRE(held->size() == 100);
+	stats = DerivedDataManager::Instance().Stats();
+	REQUIRE(stats.Entries == 0);
+	REQUIRE(stats.Bytes == 0);
+
+	// 单项超出预算时仍然保留，只淘汰其他项
+	(void)Use(a, 100, builds);
+	REQUIRE(a.Current() != nullptr);
+}
+
+TEST_CASE("DerivedDataEvictionShouldNotAllocate", "[DerivedData]")
+{
+	const BudgetScope scope(0);
+	std::vector<DerivedData<std::vector<char>>> data(1000);
+	size_t builds = 0;
+	for (auto& item : data)
+	{
+		(void)Use(item, 100, builds);
+	}
+	// 一半的项被使用过，淘汰时移回表头而保留
+	for (size_t i = 0; i < data.size(); i += 2)
+	{
+		(void)Use(data[i], 100, builds);
+	}
+
+	const auto stats = MeasureAllocations([]
+	{
+		DerivedDataManager::Instance().SetBudget(50000);
+	});
+	if constexpr (ExactAllocationCounts)
+	{
+		REQUIRE(stats.Count == 0);
+	}
+	REQUIRE(DerivedDataManager::Instance().Stats().Entries == 500);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		REQUIRE((data[i].Current() != nullptr) == (i % 2 == 0));
+	}
+}
+
+TEST_CASE("DerivedDataShouldWithdrawOnDestruction", "[DerivedData]")
+{
+	const BudgetScope scope(0);
+	size_t builds = 0;
+	{
+		DerivedData<std::vector<char>> data;
+		(void)Use(data, 64, builds);
+		REQUIRE(DerivedDataManager::Instance().Stats().Bytes == 64);
+		(void)Use(data, 64, builds);
+	}
+	const auto stats = DerivedDataManager::Instance().Stats();
+	REQUIRE(stats.Entries == 0);
+	REQUIRE(stats.Bytes == 0);
+	// 析构的项的命中数仍计入统计
+	REQUIRE(stats.Hits == 1);
+}
+
+TEST_CASE("AlignmentIndexShouldBeRebuiltAfterEviction", "[DerivedData]")
+{
+	const HorizontalAlignment first(ZigzagJds(20));
+	const HorizontalAlignment second(ZigzagJds(20, {.E = 5000.0}));
+	const Point2D expected = first.MileageToCoordinate(Mileage(3000.0));
+	const auto expectedProjection = first.CoordinateToMileage(expected);
+
+	// 预算只容得下一条线路的索引，两条线路交替查询时互相淘汰
+	const BudgetScope scope(1);
+	for (int round = 0; round < 3; ++round)
+	{
+		const Point2D point = first.MileageToCoordinate(Mileage(3000.0));
+		REQUIRE(point.X() == expected.X());
+		REQUIRE(point.Y() == expected.Y());
+		REQUIRE(first.CoordinateToMileage(expected).Station.Value() == expectedProjection.Station.Value());
+		(void)second.MileageToCoordinate(Mileage(3000.0));
+		REQUIRE(second.MemoryUsage().Indices > 0);
+		REQUIRE(first.MemoryUsage().Indices == 0);
+	}
+	const auto stats = DerivedDataManager::Instance().Stats();
+	REQUIRE(stats.Misses == 6);
+	REQUIRE(stats.Evictions == 5);
+	REQUIRE(stats.Hits == 3);
+	REQUIRE(stats.Entries == 1);
+}
+
+TEST_CASE("DisplayCachesShouldBeRebuiltAfterEviction", "[DerivedData]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(10));
+	const size_t count = alignment.GetXys().Size();
+	DisplayListBuilder builder;
+	const BudgetScope scope(0);
+	REQUIRE(builder.Update(alignment, 1.0) == count);
+	REQUIRE(builder.Update(alignment, 1.0) == 0);
+	REQUIRE(DerivedDataManager::Instance().Stats().Entries == 1);
+
+	// 当前层级被淘汰后仍由生成器持有到下一次Update，之后重建
+	DerivedDataManager::Instance().EvictAll();
+	REQUIRE(builder.Fragments().size() == count + 1);
+	REQUIRE(builder.Update(alignment, 1.0) == count);
+	REQUIRE(builder.Fragments().size() == count + 1);
+	const auto stats = DerivedDataManager::Instance().Stats();
+	REQUIRE(stats.Hits == 1);
+	REQUIRE(stats.Misses == 2);
+	REQUIRE(stats.Evictions == 1);
+}
+
+TEST_CASE("EvictedDisplayLevelsShouldBeFreedImmediately", "[DerivedData]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(10));
+	DisplayListBuilder builder;
+	const BudgetScope scope(0);
+	REQUIRE(builder.Update(alignment, 1.0) > 0);
+	const std::weak_ptr fine = builder.Fragments().front();
+	REQUIRE(builder.Update(alignment, 100.0) > 0);
+	const std::weak_ptr coarse = builder.Fragments().front();
+	REQUIRE(DerivedDataManager::Instance().Stats().Entries == 2);
+
+	// 非当前层级的数据在淘汰时立即释放，当前层级保持有效到下一次Update
+	DerivedDataManager::Instance().EvictAll();
+	REQUIRE(fine.expired());
+	REQUIRE_FALSE(coarse.expired());
+	REQUIRE(builder.Fragments().front() == coarse.lock());
+	REQUIRE(builder.Update(alignment, 1.0) > 0);
+	REQUIRE(coarse.expired());
+}
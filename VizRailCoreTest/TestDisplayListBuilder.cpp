@@ -0,0 +1,227 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+
+#include "Curve.h"
+#include "DisplayListBuilder.h"
+
+using namespace VizRailCore;
+
+namespace
+{
+	std::vector<Jd> SampleJds()
+	{
+		return {
+			{0, 507118.139447, 3342247.107195, 0, 0, 0, 0, 0, 0, 0, 0},
+			{1, 503688.185001, 3339134.96392, 0, 10000.0, 590.0, 0, 0, 0, 0, 0},
+			{2, 483014.208169, 3330609.751766, 0, 10000.0, 590.0, 0, 0, 0, 0, 0},
+			{3, 470764.921972, 3331514.645487, 0, 8000.0, 590.0, 0, 0, 0, 0, 0},
+			{4, 468474.95, 3335628.27, 0, 0, 0, 0, 0, 0, 0, 0},
+		};
+	}
+}
+
+TEST_CASE("DisplayListShouldContainAllElements", "[DisplayListBuilder]")
+{
+	const HorizontalAlignment alignment(SampleJds());
+	DisplayListBuilder builder;
+	REQUIRE(builder.Update(alignment) == alignment.GetXys().Size());
+	REQUIRE(builder.Revision() == alignment.Revision());
+
+	// 每个线元一个片段，另加交点片段
+	const auto& fragments = builder.Fragments();
+	REQUIRE(fragments.size() == alignment.GetXys().Size() + 1);
+
+	size_t arcs = 0;
+	size_t labels = 0;
+	for (const auto& fragment : fragments)
+	{
+		arcs += fragment->Arcs.size();
+		labels += fragment->Labels.size();
+	}
+	REQUIRE(arcs == 3);
+	// 每千米至少10个百米标注
+	REQUIRE(labels >= static_cast<size_t>(alignment.GetTotalMileage() / 100.0) - 10);
+
+	// 样例线路标注稀疏，全部标注都能放下（交点曲线要素为两行文字）
+	REQUIRE(builder.Labels()->Texts.size() == labels + 3);
+
+	const auto& jdFragment = *fragments.back();
+	REQUIRE(jdFragment.Circles.size() == 5);
+	REQUIRE(jdFragment.Polylines.front().Points.size() == 5);
+}
+
+TEST_CASE("DisplayListShouldOnlyRebuildChangedElements", "[DisplayListBuilder]")
+{
+	HorizontalAlignment alignment(SampleJds());
+	DisplayListBuilder builder;
+	builder.Update(alignment);
+	const auto fragments = builder.Fragments();
+
+	SECTION("UnchangedAlignment")
+	{
+		REQUIRE(builder.Update(alignment) == 0);
+		REQUIRE(builder.Fragments() == fragments);
+	}
+
+	SECTION("RefreshWithoutChange")
+	{
+		alignment.Refresh();
+		REQUIRE(builder.Update(alignment) == 0);
+		REQUIRE(builder.Revision() == alignment.Revision());
+	}
+
+	SECTION("MoveLastJd")
+	{
+		// 移动最后一个交点只影响最后一条曲线及其前后的夹直线
+		alignment.MoveJd(4, 100.0, 50.0);
+		REQUIRE(builder.Update(alignment) == 3);
+		const auto& updated = builder.Fragments();
+		for (size_t i = 0; i < 4; ++i)
+		{
+			REQUIRE(updated[i] == fragments[i]);
+		}
+		REQUIRE(updated[4] != fragments[4]);
+	}
+}
+
+TEST_CASE("DisplayCacheMemoryShouldBeReported", "[DisplayListBuilder]")
+{
+	const HorizontalAlignment alignment(SampleJds());
+	DisplayListBuilder builder;
+	MemoryReport empty;
+	std::unordered_set<const void*> visited;
+	builder.MemoryUsage(empty, visited);
+	REQUIRE(empty.Total() == 0);
+
+	builder.Update(alignment);
+	MemoryReport full;
+	builder.MemoryUsage(full, visited);
+	REQUIRE(full.DisplayCaches > 0);
+	REQUIRE(full.Total() == full.DisplayCaches);
+
+	// 粗略层级的缓存单独计算，且比完整细节小
+	builder.Update(alignment, 100.0);
+	MemoryReport both;
+	builder.MemoryUsage(both, visited);
+	REQUIRE(both.DisplayCaches > 0);
+	REQUIRE(both.DisplayCaches < full.DisplayCaches);
+
+	builder.Clear();
+	MemoryReport cleared;
+	std::unordered_set<const void*> fresh;
+	builder.MemoryUsage(cleared, fresh);
+	REQUIRE(cleared.Total() == 0);
+}
+
+TEST_CASE("DisplayDetailShouldCoarsenWithScale", "[DisplayListBuilder]")
+{
+	const auto fine = DisplayDetail::FromUnitsPerPixel(0.1);
+	REQUIRE(fine.TickInterval == 100);
+	REQUIRE(fine.TickLabels);
+	REQUIRE(fine.SpecialPointLabels);
+
+	// 百米标间距不足时只保留公里标，文字过小不再绘制
+	const auto medium = DisplayDetail::FromUnitsPerPixel(10.0);
+	REQUIRE(medium.TickInterval == 1000);
+	REQUIRE_FALSE(medium.TickLabels);
+	REQUIRE_FALSE(medium.SpecialPointLabels);
+	REQUIRE(medium.SpecialPointMarks);
+
+	const auto coarse = DisplayDetail::FromUnitsPerPixel(100.0);
+	REQUIRE(coarse.TickInterval == 0);
+	REQUIRE_FALSE(coarse.SpecialPointMarks);
+	REQUIRE(coarse.ChordTolerance == 50.0);
+
+	REQUIRE(DisplayDetail::LevelOf(100.0) == 7);
+	REQUIRE(DisplayDetail::LevelOf(128.0) == 7);
+	REQUIRE(DisplayDetail::UnitsPerPixelOf(7) == 128.0);
+}
+
+TEST_CASE("CoarseDisplayListShouldHaveFewPrimitives", "[DisplayListBuilder]")
+{
+	const HorizontalAlignment alignment(SampleJds());
+	DisplayListBuilder builder;
+
+	const auto count = [&builder]
+	{
+		size_t primitives = 0;
+		size_t vertices = 0;
+		for (const auto& fragment : builder.Fragments())
+		{
+			primitives += fragment->PrimitiveCount();
+			for (const auto& polyline : fragment->Polylines)
+			{
+				vertices += polyline.Points.size();
+			}
+		}
+		return std::pair{primitives, vertices};
+	};
+
+	builder.Update(alignment);
+	const auto [fullPrimitives, fullVertices] = count();
+
+	// 全线显示时只剩线形本身：每个夹直线1条多段线，每条曲线2条缓和曲线和1段圆弧，另加交点连线
+	builder.Update(alignment, 100.0);
+	const auto [coarsePrimitives, coarseVertices] = count();
+	REQUIRE(coarsePrimitives == 4 + 3 * 3 + 1);
+	REQUIRE(coarseVertices < 50);
+	REQUIRE(fullVertices > 20 * coarseVertices);
+	REQUIRE(fullPrimitives > 20 * coarsePrimitives);
+
+	// 切换回完整细节时直接使用已有缓存
+	REQUIRE(builder.Update(alignment) == 0);
+	REQUIRE(builder.Update(alignment, 120.0) == 0);
+	REQUIRE(builder.Update(alignment, 300.0) == alignment.GetXys().Size());
+}
+
+TEST_CASE("SimplifiedTransitionShouldStayWithinTolerance", "[DisplayListBuilder]")
+{
+	const HorizontalAlignment alignment(SampleJds());
+	const auto& xys = alignment.GetXys();
+	for (const double unitsPerPixel : {0.5, 4.0, 32.0})
+	{
+		const auto detail = DisplayDetail::FromUnitsPerPixel(unitsPerPixel);
+		for (const auto& xy : xys)
+		{
+			const auto element = xy.Element;
+			const auto curve = std::dynamic_pointer_cast<Curve>(element);
+			if (curve == nullptr)
+			{
+				continue;
+			}
+			const auto list = DisplayListBuilder::BuildElement(element, detail);
+			const auto& points = list->Polylines.front().Points;
+			REQUIRE(points.size() >= 2);
+
+			// 弦中点到曲线的距离即弦高，缓和曲线平缓，弧长可用弦长近似
+			double mileage = curve->K(SpecialPoint::ZH).Value();
+			for (size_t i = 0; i + 1 < points.size(); ++i)
+			{
+				const double chord = std::hypot(points[i + 1].X() - points[i].X(), points[i + 1].Y() - points[i].Y());
+				const Point2D onCurve = curve->MileageToCoordinate(mileage + chord / 2);
+				const double mx = (points[i].X() + points[i + 1].X()) / 2 - onCurve.X();
+				const double my = (points[i].Y() + points[i + 1].Y()) / 2 - onCurve.Y();
+				REQUIRE(std::hypot(mx, my) <= detail.ChordTolerance);
+				mileage += chord;
+			}
+		}
+	}
+}
+
+TEST_CASE("CenterlineDisplayListShouldFollowCachedPolyline", "[DisplayListBuilder]")
+{
+	const HorizontalAlignment alignment(SampleJds());
+	const auto centerline = BuildCenterline(alignment, 0.01);
+	const auto list = DisplayListBuilder::BuildCenterline(centerline);
+	REQUIRE(list->Polylines.size() == 1);
+	REQUIRE(list->Arcs.empty());
+	REQUIRE(list->Labels.empty());
+	const auto& points = list->Polylines.front().Points;
+	REQUIRE(points.size() == centerline.size());
+	for (size_t i = 0; i < points.size(); ++i)
+	{
+		REQUIRE(points[i].X() == centerline[i].X);
+		REQUIRE(points[i].Y() == centerline[i].Y);
+	}
+}
@@ -0,0 +1,195 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <numbers>
+#include <string>
+#include <vector>
+
+#include "Dxf.h"
+#include "Exceptions.h"
+#include "ZigzagJds.h"
+
+using namespace Catch;
+using namespace VizRailCore;
+
+namespace
+{
+	struct TemporaryFile
+	{
+		std::filesystem::path Path;
+
+		explicit TemporaryFile(const char* name) : Path(std::filesystem::temp_directory_path() / name)
+		{
+		}
+
+		~TemporaryFile()
+		{
+			std::error_code error;
+			std::filesystem::remove(Path, error);
+		}
+	};
+
+	/// DXF中的一个组码和值
+	struct DxfGroup
+	{
+		int Code;
+		std::string Value;
+	};
+
+	std::vector<DxfGroup> ReadGroups(const std::filesystem::path& path)
+	{
+		std::ifstream stream(path, std::ios::binary);
+		std::vector<DxfGroup> groups;
+		std::string code;
+		std::string value;
+		while (std::getline(stream, code) && std::getline(stream, value))
+		{
+			if (!value.empty() && value.back() == '\r')
+			{
+				value.pop_back();
+			}
+			groups.push_back({std::stoi(code), value});
+		}
+		return groups;
+	}
+}
+
+TEST_CASE("DxfShouldRoundTripJdPolylines", "[Dxf]")
+{
+	const HorizontalAlignment first(ZigzagJds(8, {.N = 0.125, .StartMileage = 1234.5, .FirstJdH = 1}));
+	const HorizontalAlignment second(ZigzagJds(5, {.N = 0.125, .E = 5000.0, .StartMileage = 1234.5, .FirstJdH = 1}));
+	const TemporaryFile file("VizRailDxfRoundTrip.dxf");
+	const std::vector<DxfAlignment> alignments = {{L"方案1", &first}, {L"比较/方案", &second}};
+	SaveDxf(file.Path, alignments);
+
+	const auto polylines = ReadDxfJdPolylines(file.Path);
+	REQUIRE(polylines.size() == 2);
+	REQUIRE(polylines[0].Name == L"方案1");
+	REQUIRE(polylines[0].Layer == L"方案1");
+	REQUIRE(polylines[1].Name == L"比较/方案");
+	REQUIRE(polylines[1].Layer == L"比较_方案");
+	for (size_t k = 0; k < 2; ++k)
+	{
+		const HorizontalAlignment& expected = k == 0 ? first : second;
+		const DxfJdPolyline& polyline = polylines[k];
+		REQUIRE(polyline.HasCurveData);
+		REQUIRE(polyline.Jds.Size() == expected.GetJds().Size());
+		REQUIRE(polyline.Jds.StartMileage == 1234.5);
+		for (size_t i = 0; i < polyline.Jds.Size(); ++i)
+		{
+			// 数值按最短精确形式写出，读回后完全相同
+			const Jd& jd = expected.GetJds()[i];
+			REQUIRE(polyline.Jds.JdH[i] == jd.JdH);
+			REQUIRE(polyline.Jds.N[i] == jd.N);
+			REQUIRE(polyline.Jds.E[i] == jd.E);
+			REQUIRE(polyline.Jds.R[i] == jd.R);
+			REQUIRE(polyline.Jds.Ls[i] == jd.Ls);
+		}
+		const HorizontalAlignment restored(polyline.Jds.ToJds());
+		REQUIRE(restored.GetTotalMileage() == expected.GetTotalMileage());
+	}
+
+	// 按图层读取时，不带扩展数据的交点线也被读出
+	const TemporaryFile plain("VizRailDxfPlain.dxf");
+	{
+		std::ofstream stream(plain.Path, std::ios::binary);
+		stream << "0\nSECTION\n2\nENTITIES\n0\nLWPOLYLINE\n8\nJD\\U+7EBF\n90\n3\n10\n1\n20\n2\n10\n3\n20\n4\n10\n5\n20\n6\n"
+			"0\nLWPOLYLINE\n8\nOther\n90\n2\n10\n0\n20\n0\n10\n1\n20\n1\n0\nENDSEC\n0\nEOF\n";
+	}
+	REQUIRE(ReadDxfJdPolylines(plain.Path).empty());
+	const auto onLayer = ReadDxfJdPolylines(plain.Path, L"jd线");
+	REQUIRE(onLayer.size() == 1);
+	REQUIRE_FALSE(onLayer[0].HasCurveData);
+	REQUIRE(onLayer[0].Name == L"JD线");
+	REQUIRE(onLayer[0].Jds.E == std::vector{1.0, 3.0, 5.0});
+	REQUIRE(onLayer[0].Jds.N == std::vector{2.0, 4.0, 6.0});
+	REQUIRE(onLayer[0].Jds.JdH == std::vector<unsigned>{0, 1, 2});
+}
+
+TEST_CASE("DxfCircularCurvesShouldBeExactArcs", "[Dxf]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(6, {.N = 0.125, .StartMileage = 1234.5, .FirstJdH = 1}));
+	const TemporaryFile file("VizRailDxfArcs.dxf");
+	const std::vector<DxfAlignment> alignments = {{L"方案", &alignment}};
+	SaveDxf(file.Path, alignments);
+	const auto groups = ReadGroups(file.Path);
+
+	REQUIRE(groups.front().Value == "SECTION");
+	REQUIRE(groups.back().Value == "EOF");
+	size_t arcs = 0;
+	unsigned long long maxHandle = 0;
+	unsigned long long handleSeed = 0;
+	for (size_t i = 0; i < groups.size(); ++i)
+	{
+		if (groups[i].Code == 9 && groups[i].Value == "$HANDSEED")
+		{
+			handleSeed = std::stoull(groups[i + 1].Value, nullptr, 16);
+		}
+		else if (groups[i].Code == 5 && groups[i - 1].Value != "$HANDSEED")
+		{
+			maxHandle = std::max(maxHandle, std::stoull(groups[i].Value, nullptr, 16));
+		}
+		if (groups[i].Code != 0 || groups[i].Value != "ARC")
+		{
+			continue;
+		}
+		++arcs;
+		double x = 0, y = 0, radius = 0, start = 0, end = 0;
+		for (size_t k = i + 1; k < groups.size() && groups[k].Code != 0; ++k)
+		{
+			const double value = groups[k].Code == 8 || groups[k].Code == 100 || groups[k].Code == 5 ||
+			                     groups[k].Code == 330
+				                     ? 0.0
+				                     : std::stod(groups[k].Value);
+			switch (groups[k].Code)
+			{
+			case 10: x = value;
+				break;
+			case 20: y = value;
+				break;
+			case 40: radius = value;
+				break;
+			case 50: start = value;
+				break;
+			case 51: end = value;
+				break;
+			default: break;
+			}
+		}
+		REQUIRE(radius == 800.0);
+		// 圆弧的起点、中点和终点都在线路上
+		if (end < start)
+		{
+			end += 360.0;
+		}
+		for (const double degrees : {start, (start + end) / 2, end})
+		{
+			const double angle = degrees * std::numbers::pi / 180.0;
+			const Point2D point{x + radius * std::cos(angle), y + radius * std::sin(angle)};
+			REQUIRE(std::abs(alignment.CoordinateToMileage(point).Offset) < 1e-6);
+		}
+	}
+	REQUIRE(arcs == 4);
+	REQUIRE(handleSeed > maxHandle);
+}
+
+TEST_CASE("DxfReaderShouldReportLine", "[Dxf]")
+{
+	const TemporaryFile file("VizRailDxfBad.dxf");
+	{
+		std::ofstream stream(file.Path, std::ios::binary);
+		stream << "  0\r\nSECTION\r\n  2\r\nENTITIES\r\n  0\r\nLWPOLYLINE\r\n 10\r\n1.5x\r\n";
+	}
+	try
+	{
+		(void)ReadDxfJdPolylines(file.Path);
+		FAIL("应当抛出TextImportException");
+	}
+	catch (const TextImportException& e)
+	{
+		REQUIRE(e.Line() == 7);
+	}
+}
@@ -0,0 +1,539 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <random>
+
+#include "AlignmentScheme.h"
+#include "Exceptions.h"
+#include "HorizontalAlignment.h"
+#include "TaskScheduler.h"
+#include "ZigzagJds.h"
+
+using namespace Catch;
+using namespace VizRailCore;
+
+namespace
+{
+	std::vector<Jd> SampleJds()
+	{
+		return {
+			{0, 507118.139447, 3342247.107195, 0, 0, 0, 0, 0, 0, 0, 0},
+			{1, 503688.185001, 3339134.96392, 0, 10000.0, 590.0, 0, 0, 0, 0, 0},
+			{2, 483014.208169, 3330609.751766, 0, 10000.0, 590.0, 0, 0, 0, 0, 0},
+			{3, 470764.921972, 3331514.645487, 0, 8000.0, 590.0, 0, 0, 0, 0, 0},
+			{4, 468474.95, 3335628.27, 0, 0, 0, 0, 0, 0, 0, 0},
+		};
+	}
+
+	bool SameElements(const HorizontalAlignment& a, const HorizontalAlignment& b)
+	{
+		if (a.GetXys().Size() != b.GetXys().Size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.GetXys().Size(); ++i)
+		{
+			const auto& xy = a.GetXys()[i];
+			if (xy.Key != b.GetXys()[i].Key || !xy.Element->Equals(*b.GetXys()[i].Element))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+TEST_CASE("EditTransactionShouldRefreshOnce", "[HorizontalAlignment]")
+{
+	HorizontalAlignment alignment(SampleJds());
+	HorizontalAlignment expected(SampleJds());
+	const auto revision = alignment.Revision();
+
+	alignment.BeginEdit();
+	REQUIRE(alignment.InEdit());
+	for (size_t i = 1; i < 4; ++i)
+	{
+		alignment.MoveJd(i, 10.0, -20.0);
+		expected.MoveJd(i, 10.0, -20.0);
+	}
+	// 事务中线元保持不变
+	REQUIRE(alignment.Revision() == revision);
+	REQUIRE(alignment.GetJds()[1].N == expected.GetJds()[1].N);
+
+	const ChangeSet changes = alignment.CommitEdit();
+	REQUIRE_FALSE(alignment.InEdit());
+	REQUIRE(changes.TouchedJds == std::vector<size_t>{1, 2, 3});
+	REQUIRE(changes.InsertedJds == 0);
+	REQUIRE(changes.RemovedJds == 0);
+	REQUIRE(changes.Revision == alignment.Revision());
+	REQUIRE(alignment.Revision() != revision);
+	REQUIRE(SameElements(alignment, expected));
+}
+
+TEST_CASE("EmptyEditTransactionShouldNotRefresh", "[HorizontalAlignment]")
+{
+	HorizontalAlignment alignment(SampleJds());
+	const auto revision = alignment.Revision();
+	alignment.BeginEdit();
+	const ChangeSet changes = alignment.CommitEdit();
+	REQUIRE(changes.IsEmpty());
+	REQUIRE(changes.Revision == revision);
+	REQUIRE(alignment.Revision() == revision);
+}
+
+TEST_CASE("EditTransactionShouldTrackInsertAndRemove", "[HorizontalAlignment]")
+{
+	HorizontalAlignment alignment(SampleJds());
+	EditTransaction edit(alignment);
+	alignment.MoveJd(3, 5.0, 5.0);
+	alignment.InsertJd(1, {9, 505000.0, 3341000.0, 0, 5000.0, 300.0, 0, 0, 0, 0, 0});
+	alignment.RemoveJd(0);
+	const ChangeSet changes = edit.Commit();
+
+	// 插入的交点和移动的交点在提交后的序列中分别位于0和3
+	REQUIRE(changes.TouchedJds == std::vector<size_t>{0, 3});
+	REQUIRE(changes.InsertedJds == 1);
+	REQUIRE(changes.RemovedJds == 1);
+	REQUIRE(alignment.GetJds().Size() == 5);
+	REQUIRE(alignment.GetJds()[0].JdH == 9);
+}
+
+TEST_CASE("NestedEditTransactionShouldRollBackIndependently", "[HorizontalAlignment]")
+{
+	HorizontalAlignment alignment(SampleJds());
+	HorizontalAlignment expected(SampleJds());
+	expected.MoveJd(1, 100.0, 0.0);
+
+	alignment.BeginEdit();
+	alignment.MoveJd(1, 100.0, 0.0);
+	{
+		EditTransaction inner(alignment);
+		alignment.MoveJd(2, 100.0, 0.0);
+		alignment.RemoveJd(4);
+		// 未提交的内层事务析构时放弃
+	}
+	REQUIRE(alignment.InEdit());
+	REQUIRE(alignment.GetJds().Size() == 5);
+
+	const ChangeSet changes = alignment.CommitEdit();
+	REQUIRE(changes.TouchedJds == std::vector<size_t>{1});
+	REQUIRE(changes.RemovedJds == 0);
+	REQUIRE(SameElements(alignment, expected));
+
+	REQUIRE_THROWS_AS(alignment.CommitEdit(), VizRailCoreException);
+	REQUIRE_THROWS_AS(alignment.CancelEdit(), VizRailCoreException);
+}
+
+TEST_CASE("FailedCommitShouldRestoreAlignment", "[HorizontalAlignment]")
+{
+	HorizontalAlignment alignment(SampleJds());
+	const HorizontalAlignment original(SampleJds());
+	const auto revision = alignment.Revision();
+
+	EditTransaction edit(alignment);
+	alignment.MoveJd(1, 50.0, 50.0);
+	Jd invalid = alignment.GetJds()[2];
+	invalid.R = -1.0;
+	alignment.UpdateJd(2, invalid);
+	REQUIRE_THROWS_AS(edit.Commit(), std::invalid_argument);
+
+	REQUIRE_FALSE(alignment.InEdit());
+	REQUIRE(alignment.Revision() == revision);
+	REQUIRE(alignment.GetJds()[1].N == original.GetJds()[1].N);
+	REQUIRE(alignment.GetJds()[2].R == original.GetJds()[2].R);
+	REQUIRE(SameElements(alignment, original));
+
+	REQUIRE_THROWS_AS(alignment.MoveJd(10, 1.0, 1.0), VizRailCoreException);
+	REQUIRE_FALSE(alignment.InEdit());
+}
+
+TEST_CASE("ChangeSetShouldDescribeChangedInterval", "[HorizontalAlignment]")
+{
+	HorizontalAlignment alignment(ZigzagJds(10));
+	const HorizontalAlignment before = alignment;
+
+	std::vector<ChangeSet> notified;
+	const size_t id = alignment.AddObserver([&notified](const HorizontalAlignment&, const ChangeSet& changes)
+	{
+		notified.push_back(changes);
+	});
+
+	SECTION("MoveMiddleJd")
+	{
+		// 移动交点5只影响曲线4~6及其两侧的夹直线
+		alignment.MoveJd(5, 300.0, 0.0);
+		REQUIRE(notified.size() == 1);
+		const ChangeSet& changes = notified.front();
+		REQUIRE(changes.TouchedJds == std::vector<size_t>{5});
+		REQUIRE(changes.AffectedElements == std::vector<std::wstring>{
+			L"夹直线4", L"曲线4", L"夹直线5", L"曲线5", L"夹直线6", L"曲线6", L"夹直线7"
+		});
+
+		REQUIRE(changes.StartMileage == alignment.GetXy(L"夹直线4")->StartMileage().Value());
+		REQUIRE(changes.EndMileage == alignment.GetXy(L"夹直线7")->EndMileage().Value());
+
+		// 下游线元形状不变，里程整体平移
+		const double shift = alignment.GetXy(L"曲线8")->StartMileage().Value() -
+			before.GetXy(L"曲线8")->StartMileage().Value();
+		REQUIRE(shift != 0.0);
+		REQUIRE(changes.MileageShift == Approx(shift));
+		REQUIRE(alignment.GetXy(L"夹直线9")->EndMileage().Value() - before.GetXy(L"夹直线9")->EndMileage().Value() ==
+			Approx(shift));
+	}
+
+	SECTION("InsertJd")
+	{
+		// 插入交点后下游线元重新编号，但形状不变的线元不计入变化
+		alignment.InsertJd(3, {99, 5000.0, 1500.0, 0, 800.0, 100.0, 0, 0, 0, 0, 0});
+		REQUIRE(notified.size() == 1);
+		const ChangeSet& changes = notified.front();
+		REQUIRE(changes.InsertedJds == 1);
+		// 新交点及其前后交点处的曲线，以及这三条曲线两侧的夹直线
+		REQUIRE(changes.AffectedElements.size() == 7);
+		REQUIRE(changes.AffectedElements.front() == L"夹直线2");
+		REQUIRE(changes.AffectedElements.back() == L"夹直线5");
+	}
+
+	SECTION("BatchEditNotifiesOnce")
+	{
+		alignment.BeginEdit();
+		alignment.MoveJd(2, 10.0, 0.0);
+		alignment.MoveJd(7, 10.0, 0.0);
+		REQUIRE(notified.empty());
+		alignment.CommitEdit();
+		REQUIRE(notified.size() == 1);
+		// 两处改动合并为一个覆盖二者的区间
+		REQUIRE(notified.front().AffectedElements.front() == L"夹直线1");
+		REQUIRE(notified.front().AffectedElements.back() == L"夹直线9");
+	}
+
+	SECTION("RemovedObserver")
+	{
+		alignment.RemoveObserver(id);
+		alignment.MoveJd(5, 0.0, 300.0);
+		REQUIRE(notified.empty());
+	}
+
+	SECTION("CopyDoesNotNotify")
+	{
+		HorizontalAlignment copy = alignment;
+		copy.MoveJd(5, 0.0, 300.0);
+		REQUIRE(notified.empty());
+	}
+}
+
+TEST_CASE("SchemeVariantShouldShareStorage", "[AlignmentScheme]")
+{
+	const AlignmentScheme base(L"方案1", HorizontalAlignment(ZigzagJds(1000)));
+	AlignmentScheme variant = base.CreateVariant(L"方案2");
+	REQUIRE(variant.Name() == L"方案2");
+	REQUIRE(variant.Alignment().SharesElementsWith(base.Alignment()));
+	REQUIRE(variant.Alignment().GetJds().SharesStorageWith(base.Alignment().GetJds()));
+
+	// 变体的修改不影响原方案，未变化的线元对象仍然共享
+	variant.Alignment().MoveJd(900, 200.0, 0.0);
+	REQUIRE_FALSE(variant.Alignment().SharesElementsWith(base.Alignment()));
+	REQUIRE(base.Alignment().GetJds()[900].N == 900 * 2000.0);
+	REQUIRE(variant.Alignment().GetJds()[900].N == 900 * 2000.0 + 200.0);
+	REQUIRE(variant.Alignment().GetXy(L"曲线100") == base.Alignment().GetXy(L"曲线100"));
+	REQUIRE(variant.Alignment().GetXy(L"曲线900") != base.Alignment().GetXy(L"曲线900"));
+}
+
+TEST_CASE("SchemeMemoryShouldScaleWithDifferences", "[AlignmentScheme]")
+{
+	const AlignmentScheme base(L"方案1", HorizontalAlignment(ZigzagJds(1000)));
+	std::unordered_set<const void*> visited;
+	const size_t baseBytes = base.Alignment().MemoryUsage(visited);
+
+	// 30个方案各自修改线路末端的几个交点，修改处下游的线元很少
+	std::vector<AlignmentScheme> variants;
+	size_t variantBytes = 0;
+	for (int i = 0; i < 30; ++i)
+	{
+		auto variant = base.CreateVariant(L"方案" + std::to_wstring(i + 2));
+		EditTransaction edit(variant.Alignment());
+		for (size_t jd = 990; jd < 993; ++jd)
+		{
+			variant.Alignment().MoveJd(jd, 10.0 * (i + 1), 0.0);
+		}
+		edit.Commit();
+		variantBytes += variant.Alignment().MemoryUsage(visited);
+		variants.push_back(std::move(variant));
+	}
+	// 新增内存只与改动量有关，30个方案合计仍远小于一份完整副本
+	REQUIRE(variantBytes * 2 < baseBytes);
+	REQUIRE(base.Alignment().GetXys()[1].Element == variants.back().Alignment().GetXys()[1].Element);
+}
+
+TEST_CASE("MemoryReportShouldBreakDownByCategory", "[HorizontalAlignment]")
+{
+	HorizontalAlignment alignment(ZigzagJds(1000));
+	const MemoryReport fresh = alignment.MemoryUsage();
+	REQUIRE(fresh.Inputs > 1000 * sizeof(Jd));
+	// 线元包括写入了里程的交点副本，一定多于输入的交点
+	REQUIRE(fresh.Elements > fresh.Inputs);
+	// 空间索引在首次查询时才建立
+	REQUIRE(fresh.Indices == 0);
+	REQUIRE(fresh.History == 0);
+	REQUIRE(fresh.DisplayCaches == 0);
+
+	(void)alignment.QueryElements(alignment.Extents());
+	alignment.MoveJd(500, 10.0, 0.0);
+	(void)alignment.QueryElements(alignment.Extents());
+	const MemoryReport edited = alignment.MemoryUsage();
+	REQUIRE(edited.Indices > 0);
+	REQUIRE(edited.History > 0);
+
+	std::unordered_set<const void*> visited;
+	REQUIRE(alignment.MemoryUsage(visited) == edited.Total());
+
+	// 撤销记录中缓存的修改前线元和空间索引计入历史记录，清空历史后释放
+	alignment.ClearHistory();
+	const MemoryReport cleared = alignment.MemoryUsage();
+	REQUIRE(cleared.History == 0);
+	REQUIRE(cleared.Elements == edited.Elements);
+
+	REQUIRE(StringHeapBytes(std::wstring(L"曲线1")) == 0);
+	REQUIRE(StringHeapBytes(std::wstring(100, L'x')) >= 101 * sizeof(wchar_t));
+}
+
+TEST_CASE("MemoryAccountingShouldCountSharedDataOnce", "[AlignmentScheme]")
+{
+	const AlignmentScheme base(L"方案1", HorizontalAlignment(ZigzagJds(1000)));
+	auto variant = base.CreateVariant(L"方案2");
+	variant.Alignment().MoveJd(990, 10.0, 0.0);
+
+	MemoryAccounting accounting;
+	const MemoryReport baseReport = accounting.Add(base);
+	const MemoryReport variantReport = accounting.Add(variant);
+	REQUIRE(baseReport.Total() == base.Alignment().MemoryUsage().Total());
+	// 变体只计入修改后复制的分块和线元
+	REQUIRE(variantReport.Elements * 20 < baseReport.Elements);
+	REQUIRE(variantReport.Inputs * 20 < baseReport.Inputs);
+	REQUIRE(accounting.Total().Total() == baseReport.Total() + variantReport.Total());
+
+	// 再次统计同一方案不增加
+	REQUIRE(accounting.Add(base).Total() == 0);
+}
+
+TEST_CASE("CoordinateToMileageShouldInvertMileageToCoordinate", "[HorizontalAlignment]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(20));
+	const auto& xys = alignment.GetXys();
+	for (size_t i = 0; i < xys.Size(); ++i)
+	{
+		const LineElement& element = *xys[i].Element;
+		for (const double ratio : {0.03, 0.1, 0.5, 0.9, 0.97})
+		{
+			const double station = element.StartMileage().Value() + element.Length() * ratio;
+			const Point2D center = element.MileageToCoordinate(Mileage(station));
+			const auto [dx, dy] = element.MileageToCoordinate(Mileage(station + 0.01)) -
+				element.MileageToCoordinate(Mileage(station - 0.01));
+			const double length = std::hypot(dx, dy);
+			for (const double offset : {-30.0, 0.0, 25.0})
+			{
+				INFO("element " << i << " station " << station << " offset " << offset);
+				// 前进方向右侧的法向为切线顺时针旋转90°
+				const Point2D point = {center.X() + dy / length * offset, center.Y() - dx / length * offset};
+				const StationOffset projection = alignment.CoordinateToMileage(point);
+				REQUIRE(projection.Element == i);
+				REQUIRE(projection.Station.Value() == Approx(station).margin(1e-6));
+				REQUIRE(projection.Offset == Approx(offset).margin(1e-6));
+			}
+		}
+	}
+
+	// 起点之前和终点之后的点没有垂足
+	const Point2D start = xys[1].Element->MileageToCoordinate(xys[1].Element->StartMileage());
+	REQUIRE_THROWS_AS(alignment.CoordinateToMileage({start.X() - 100.0, start.Y() - 100.0}), NotInLineException);
+	const auto& jds = alignment.GetJds();
+	REQUIRE_THROWS_AS(alignment.CoordinateToMileage({jds[19].E + 10.0, jds[19].N + 100.0}), NotInLineException);
+}
+
+TEST_CASE("MileageToFrameShouldMatchLinearSearch", "[HorizontalAlignment]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(20));
+	const auto& xys = alignment.GetXys();
+	const double end = xys[xys.Size() - 1].Element->EndMileage().Value();
+	for (double mileage = 0.0; mileage <= end; mileage += 37.5)
+	{
+		INFO("mileage " << mileage);
+		const StationFrame frame = alignment.MileageToFrame(Mileage(mileage));
+		const LineElement& element = *xys[frame.Element].Element;
+		REQUIRE(element.IsOnIt(Mileage(mileage)));
+		// 公共端点可能归属于相邻的任一线元，坐标相同
+		const auto expected = std::find_if(xys.begin(), xys.end(), [mileage](const XyEntry& xy)
+		{
+			return xy.Element->IsOnIt(Mileage(mileage));
+		})->Element->MileageToCoordinate(Mileage(mileage));
+		REQUIRE(frame.Point.X() == Approx(expected.X()).margin(1e-6));
+		REQUIRE(frame.Point.Y() == Approx(expected.Y()).margin(1e-6));
+		REQUIRE(frame.Azimuth.Radian() == element.MileageToAzimuthAngle(Mileage(mileage)).Radian());
+	}
+	const StationFrame last = alignment.MileageToFrame(Mileage(end));
+	REQUIRE(last.Element == xys.Size() - 1);
+	REQUIRE_THROWS_AS(alignment.MileageToFrame(Mileage(end + 1.0)), NotInLineException);
+}
+
+TEST_CASE("GetXyShouldFindElementByKey", "[HorizontalAlignment]")
+{
+	const HorizontalAlignment alignment(SampleJds());
+	const auto& xys = alignment.GetXys();
+	for (const auto& xy : xys)
+	{
+		REQUIRE(alignment.GetXy(xy.Key) == xy.Element);
+	}
+	REQUIRE_THROWS_AS(alignment.GetXy(L"曲线4"), VizRailCoreException);
+	REQUIRE_THROWS_AS(alignment.GetXy(L"夹直线5"), VizRailCoreException);
+	REQUIRE_THROWS_AS(alignment.GetXy(L"曲线"), VizRailCoreException);
+
+	const HorizontalAlignment line({SampleJds()[0], SampleJds()[1]});
+	REQUIRE(line.GetXy(L"夹直线1") == line.GetXys()[0].Element);
+}
+
+TEST_CASE("UndoRedoShouldRestoreCachedElements", "[HorizontalAlignment]")
+{
+	HorizontalAlignment alignment(ZigzagJds(20));
+	const HorizontalAlignment initial = alignment;
+	alignment.MoveJd(5, 100.0, 0.0);
+	const HorizontalAlignment first = alignment;
+	alignment.MoveJd(10, 0.0, 100.0);
+	const HorizontalAlignment second = alignment;
+	REQUIRE(alignment.UndoCount() == 2);
+
+	std::vector<ChangeSet> notified;
+	alignment.AddObserver([&notified](const HorizontalAlignment&, const ChangeSet& changes)
+	{
+		notified.push_back(changes);
+	});
+
+	// 撤销直接恢复缓存的线元，修订号与当时一致
+	REQUIRE(alignment.Undo());
+	REQUIRE(alignment.SharesElementsWith(first));
+	REQUIRE(alignment.Revision() == first.Revision());
+	REQUIRE(alignment.GetJds()[10].E == first.GetJds()[10].E);
+	REQUIRE(notified.back().TouchedJds == std::vector<size_t>{10});
+	REQUIRE(notified.back().Revision == first.Revision());
+
+	REQUIRE(alignment.Undo());
+	REQUIRE(alignment.SharesElementsWith(initial));
+	REQUIRE_FALSE(alignment.Undo());
+	REQUIRE(alignment.RedoCount() == 2);
+
+	REQUIRE(alignment.Redo());
+	REQUIRE(alignment.Redo());
+	REQUIRE(alignment.SharesElementsWith(second));
+	REQUIRE_FALSE(alignment.Redo());
+	REQUIRE(notified.size() == 4);
+
+	// 新的修改清空重做记录
+	REQUIRE(alignment.Undo());
+	alignment.RemoveJd(15);
+	REQUIRE(alignment.RedoCount() == 0);
+	REQUIRE(alignment.Undo());
+	REQUIRE(notified.back().InsertedJds == 1);
+	REQUIRE(notified.back().TouchedJds == std::vector<size_t>{15});
+	REQUIRE(SameElements(alignment, first));
+
+	alignment.BeginEdit();
+	REQUIRE_THROWS_AS(alignment.Undo(), VizRailCoreException);
+	alignment.CancelEdit();
+}
+
+TEST_CASE("UndoBeyondCacheShouldRecomputeElements", "[HorizontalAlignment]")
+{
+	HorizontalAlignment alignment(ZigzagJds(20));
+	alignment.SetHistoryLimit(4, 2);
+	std::vector<HorizontalAlignment> states{alignment};
+	for (size_t i = 1; i <= 6; ++i)
+	{
+		alignment.MoveJd(i, 50.0, 0.0);
+		states.push_back(alignment);
+	}
+	// 只保留最近4步
+	REQUIRE(alignment.UndoCount() == 4);
+
+	for (size_t step = 5; step >= 2; --step)
+	{
+		REQUIRE(alignment.Undo());
+		REQUIRE(SameElements(alignment, states[step]));
+		// 最近2步取自缓存，更早的步骤重新计算
+		REQUIRE(alignment.SharesElementsWith(states[step]) == step >= 4);
+	}
+	REQUIRE_FALSE(alignment.Undo());
+
+	while (alignment.Redo())
+	{
+	}
+	REQUIRE(SameElements(alignment, states.back()));
+	// 副本不继承历史记录
+	HorizontalAlignment copy = alignment;
+	REQUIRE(copy.RedoCount() == 0);
+	REQUIRE(copy.UndoCount() == 0);
+}
+
+TEST_CASE("UndoHistoryShouldShareJdStorage", "[HorizontalAlignment]")
+{
+	HorizontalAlignment alignment(ZigzagJds(1000));
+	alignment.SetHistoryLimit(5000, 8);
+	std::vector<HorizontalAlignment> states;
+
+	std::mt19937 random(42);
+	for (int step = 0; step < 1000; ++step)
+	{
+		if (step >= 980)
+		{
+			states.push_back(alignment);
+		}
+		alignment.MoveJd(1 + random() % 998, 0.0, random() % 2 == 0 ? 1.0 : -1.0);
+	}
+	REQUIRE(alignment.UndoCount() == 1000);
+
+	// 每步历史只多出一条交点分块路径，线元只缓存最近8步，千步历史仅数MB
+	std::unordered_set<const void*> visited;
+	REQUIRE(alignment.MemoryUsage(visited) < 6 * 1024 * 1024);
+
+	for (auto it = states.rbegin(); it != states.rend(); ++it)
+	{
+		REQUIRE(alignment.Undo());
+		REQUIRE(SameElements(alignment, *it));
+	}
+}
+
+TEST_CASE("ParallelRefreshShouldMatchSerial", "[HorizontalAlignment]")
+{
+	// 3000个交点走并行刷新，前400个交点单独构成的线路走串行刷新，二者的公共部分必须完全相同。
+	// 固定工作线程数，单核机器上也走并行路径
+	TaskScheduler::SetDefaultWorkerCount(3);
+	const std::vector<Jd> jds = ZigzagJds(3000);
+	const HorizontalAlignment parallel(jds);
+	const HorizontalAlignment serial(std::vector<Jd>(jds.begin(), jds.begin() + 400));
+
+	const auto& parallelXys = parallel.GetXys();
+	const auto& serialXys = serial.GetXys();
+	REQUIRE(parallelXys.Size() == 2 * 3000 - 3);
+	// 串行线路的最后一条夹直线终点不同，不比较
+	for (size_t i = 0; i + 1 < serialXys.Size(); ++i)
+	{
+		INFO(i);
+		REQUIRE(parallelXys[i].Key == serialXys[i].Key);
+		REQUIRE(parallelXys[i].Element->Equals(*serialXys[i].Element));
+	}
+	for (size_t i = 0; i + 1 < serial.GetJds().Size(); ++i)
+	{
+		INFO(i);
+		REQUIRE(parallel.GetJds()[i].StartMileage == serial.GetJds()[i].StartMileage);
+		REQUIRE(parallel.GetJds()[i].EndMileage == serial.GetJds()[i].EndMileage);
+		REQUIRE(parallel.GetJds()[i].TH == serial.GetJds()[i].TH);
+		REQUIRE(parallel.GetJds()[i].LH == serial.GetJds()[i].LH);
+	}
+
+	// 并行刷新中某条曲线出错时与串行一样整体失败，线路保持不变
+	HorizontalAlignment alignment(jds);
+	const auto revision = alignment.Revision();
+	Jd invalid = alignment.GetJds()[2000];
+	invalid.R = -1.0;
+	REQUIRE_THROWS_AS(alignment.UpdateJd(2000, invalid), std::invalid_argument);
+	REQUIRE(alignment.Revision() == revision);
+	REQUIRE(SameElements(alignment, parallel));
+}
@@ -0,0 +1,194 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Exceptions.h"
+#include "Ifc.h"
+#include "ZigzagJds.h"
+
+using namespace Catch;
+using namespace VizRailCore;
+
+namespace
+{
+	struct TemporaryFile
+	{
+		std::filesystem::path Path;
+
+		explicit TemporaryFile(const char* name) : Path(std::filesystem::temp_directory_path() / name)
+		{
+		}
+
+		~TemporaryFile()
+		{
+			std::error_code error;
+			std::filesystem::remove(Path, error);
+		}
+	};
+
+	/// STEP文件中的一个实体，参数按顶层逗号拆分
+	struct StepEntity
+	{
+		std::string Type;
+		std::vector<std::string> Arguments;
+	};
+
+	std::map<unsigned long long, StepEntity> ReadEntities(const std::filesystem::path& path)
+	{
+		std::ifstream stream(path, std::ios::binary);
+		std::map<unsigned long long, StepEntity> entities;
+		std::string line;
+		while (std::getline(stream, line))
+		{
+			if (!line.starts_with('#'))
+			{
+				continue;
+			}
+			const size_t equal = line.find('=');
+			const size_t open = line.find('(');
+			StepEntity entity{line.substr(equal + 1, open - equal - 1), {}};
+			int depth = 0;
+			bool quoted = false;
+			std::string argument;
+			for (size_t i = open + 1; i + 2 < line.size(); ++i)
+			{
+				const char c = line[i];
+				quoted = c == '\'' ? !quoted : quoted;
+				depth += quoted ? 0 : c == '(' ? 1 : c == ')' ? -1 : 0;
+				if (c == ',' && depth == 0 && !quoted)
+				{
+					entity.Arguments.push_back(argument);
+					argument.clear();
+				}
+				else
+				{
+					argument += c;
+				}
+			}
+			entity.Arguments.push_back(argument);
+			entities[std::stoull(line.substr(1, equal - 1))] = entity;
+		}
+		return entities;
+	}
+
+	unsigned long long RefId(const std::string& text)
+	{
+		return std::stoull(text.substr(1));
+	}
+}
+
+TEST_CASE("IfcShouldWriteHorizontalSegmentsAndCant", "[Ifc]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(5));
+	const TemporaryFile file("VizRailIfc.ifc");
+	const std::vector<IfcAlignmentSource> sources = {{L"方案'1", &alignment, {0.0, 0.1, 0.12, 0.1, 0.0}}};
+	SaveIfc(file.Path, sources);
+
+	const auto entities = ReadEntities(file.Path);
+	std::map<std::string, size_t> types;
+	for (const auto& [id, entity] : entities)
+	{
+		++types[entity.Type];
+		if (entity.Type == "IFCALIGNMENT")
+		{
+			REQUIRE(entity.Arguments[0].size() == 24);
+			REQUIRE(entity.Arguments[2] == "'\\X2\\65B96848\\X0\\''1'");
+		}
+	}
+	REQUIRE(types["IFCALIGNMENT"] == 1);
+	REQUIRE(types["IFCALIGNMENTHORIZONTAL"] == 1);
+	REQUIRE(types["IFCALIGNMENTCANT"] == 1);
+	// 3条曲线各3段、4条夹直线和结尾的零长度段
+	REQUIRE(types["IFCALIGNMENTHORIZONTALSEGMENT"] == 3 * 3 + 4 + 1);
+	REQUIRE(types["IFCALIGNMENTCANTSEGMENT"] == 3 * 3 + 4 + 1);
+	REQUIRE(types["IFCALIGNMENTSEGMENT"] == 2 * (3 * 3 + 4 + 1));
+
+	double length = 0.0;
+	double cantDistance = 0.0;
+	double maxCant = 0.0;
+	size_t clothoids = 0;
+	size_t arcs = 0;
+	for (const auto& [id, entity] : entities)
+	{
+		if (entity.Type == "IFCALIGNMENTHORIZONTALSEGMENT")
+		{
+			const auto& point = entities.at(RefId(entity.Arguments[2]));
+			const std::string coordinates = point.Arguments[0];
+			const double x = std::stod(coordinates.substr(1));
+			const double y = std::stod(coordinates.substr(coordinates.find(',') + 1));
+			// 各段起点都在线路上，起点方向与线路切线一致
+			const auto projection = alignment.CoordinateToMileage({x, y});
+			REQUIRE(std::abs(projection.Offset) < 1e-6);
+			if (std::stod(entity.Arguments[6]) > 0.0)
+			{
+				// 前方1m处偏离切线的距离约为1²/2R，另加曲线模型在特征点处不到1mm的错位
+				const Point2D ahead = alignment.MileageToCoordinate(Mileage(projection.Station.Value() + 1.0));
+				const double direction = std::stod(entity.Arguments[3]);
+				REQUIRE(std::abs(std::cos(direction) * (ahead.Y() - y) - std::sin(direction) * (ahead.X() - x)) <
+					2e-3);
+				REQUIRE(std::cos(direction) * (ahead.X() - x) + std::sin(direction) * (ahead.Y() - y) > 0.99);
+			}
+			const double start = std::stod(entity.Arguments[4]);
+			const double end = std::stod(entity.Arguments[5]);
+			const std::string& type = entity.Arguments[8];
+			if (type == ".CIRCULARARC.")
+			{
+				++arcs;
+				REQUIRE(std::abs(start) == 800.0);
+				REQUIRE(start == end);
+			}
+			else if (type == ".CLOTHOID.")
+			{
+				++clothoids;
+				REQUIRE(std::stod(entity.Arguments[6]) == Approx(100.0));
+				REQUIRE(std::abs(start + end) == 800.0);
+			}
+			else
+			{
+				REQUIRE(type == ".LINE.");
+				REQUIRE(start == 0.0);
+			}
+			length += std::stod(entity.Arguments[6]);
+		}
+		else if (entity.Type == "IFCALIGNMENTCANTSEGMENT")
+		{
+			REQUIRE(std::stod(entity.Arguments[2]) == Approx(cantDistance).margin(1e-6));
+			cantDistance += std::stod(entity.Arguments[3]);
+			for (size_t i = 4; i < 8; ++i)
+			{
+				maxCant = std::max(maxCant, std::stod(entity.Arguments[i]));
+			}
+		}
+	}
+	REQUIRE(arcs == 3);
+	REQUIRE(clothoids == 6);
+	REQUIRE(length == Approx(alignment.GetTotalMileage()));
+	REQUIRE(cantDistance == Approx(alignment.GetTotalMileage()));
+	REQUIRE(maxCant == 0.12);
+
+	// 每个引用的实体都已写出
+	for (const auto& [id, entity] : entities)
+	{
+		for (const auto& argument : entity.Arguments)
+		{
+			for (size_t i = argument.find('#'); i != std::string::npos; i = argument.find('#', i + 1))
+			{
+				REQUIRE(entities.contains(std::stoull(argument.substr(i + 1))));
+			}
+		}
+	}
+}
+
+TEST_CASE("IfcShouldRejectMismatchedCant", "[Ifc]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(4, {.Ls = 0.0}));
+	const TemporaryFile file("VizRailIfcCant.ifc");
+	const std::vector<IfcAlignmentSource> sources = {{L"方案", &alignment, {0.1}}};
+	REQUIRE_THROWS_AS(SaveIfc(file.Path, sources), VizRailCoreException);
+}
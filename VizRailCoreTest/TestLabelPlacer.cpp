@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <random>
+
+#include "LabelPlacer.h"
+
+using namespace VizRailCore;
+
+namespace
+{
+	// 以四个角点表示的文字框，用于暴力检验
+	std::vector<Point2D> Corners(const LabelRequest& label, const LabelCandidate& candidate)
+	{
+		const double ux = candidate.DirectionX;
+		const double uy = candidate.DirectionY;
+		const double x = candidate.Position.X();
+		const double y = candidate.Position.Y();
+		return {
+			{x, y},
+			{x + ux * label.Width, y + uy * label.Width},
+			{x + ux * label.Width - uy * label.Height, y + uy * label.Width + ux * label.Height},
+			{x - uy * label.Height, y + ux * label.Height},
+		};
+	}
+
+	bool Separated(const std::vector<Point2D>& a, const std::vector<Point2D>& b)
+	{
+		for (const auto* polygon : {&a, &b})
+		{
+			for (size_t i = 0; i < 4; ++i)
+			{
+				const Point2D& p = (*polygon)[i];
+				const Point2D& q = (*polygon)[(i + 1) % 4];
+				const double nx = q.Y() - p.Y();
+				const double ny = p.X() - q.X();
+				double minA = INFINITY, maxA = -INFINITY, minB = INFINITY, maxB = -INFINITY;
+				for (const auto& point : a)
+				{
+					minA = std::min(minA, point.X() * nx + point.Y() * ny);
+					maxA = std::max(maxA, point.X() * nx + point.Y() * ny);
+				}
+				for (const auto& point : b)
+				{
+					minB = std::min(minB, point.X() * nx + point.Y() * ny);
+					maxB = std::max(maxB, point.X() * nx + point.Y() * ny);
+				}
+				if (maxA <= minB + 1e-6 || maxB <= minA + 1e-6)
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+}
+
+TEST_CASE("LabelPlacerShouldRespectPriority", "[LabelPlacer]")
+{
+	const std::vector<LabelCandidate> sameSpot = {{{0.0, 0.0}, 1.0, 0.0}};
+	const std::vector<LabelRequest> labels = {
+		{LabelPriority::Hectometre, 10.0, 5.0, sameSpot},
+		{LabelPriority::SpecialPoint, 10.0, 5.0, sameSpot},
+		{LabelPriority::Kilometre, 10.0, 5.0, sameSpot},
+	};
+
+	LabelPlacer placer(20.0);
+	const auto result = placer.Place(labels);
+	REQUIRE(result == std::vector{-1, -1, 0});
+	REQUIRE(placer.Size() == 1);
+}
+
+TEST_CASE("LabelPlacerShouldUseAlternativeCandidates", "[LabelPlacer]")
+{
+	LabelPlacer placer(20.0);
+	const std::vector<LabelCandidate> candidates = {
+		{{0.0, 0.0}, 1.0, 0.0},
+		{{0.0, 5.0}, 1.0, 0.0},
+		{{0.0, 10.0}, 0.0, 1.0},
+	};
+	REQUIRE(placer.TryPlace(10.0, 5.0, candidates) == 0);
+	// 与第一个文字框相接不算重叠
+	REQUIRE(placer.TryPlace(10.0, 5.0, candidates) == 1);
+	// 竖排文字框向左展开，与前两个文字框都不相交
+	REQUIRE(placer.TryPlace(10.0, 5.0, candidates) == 2);
+	REQUIRE(placer.TryPlace(10.0, 5.0, candidates) == -1);
+
+	// 旋转45度的文字框与轴向文字框的角点相交
+	const double s = std::sqrt(0.5);
+	REQUIRE(placer.TryPlace(4.0, 1.0, {{{9.0, -2.0}, s, s}}) == -1);
+	REQUIRE(placer.TryPlace(4.0, 1.0, {{{11.0, -2.0}, s, s}}) == 0);
+}
+
+TEST_CASE("PlacedLabelsShouldNotOverlap", "[LabelPlacer]")
+{
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<double> position(0.0, 2000.0);
+	std::uniform_real_distribution<double> angle(0.0, 6.283185307179586);
+	std::uniform_int_distribution<int> priority(0, 3);
+
+	std::vector<LabelRequest> labels(3000);
+	for (auto& label : labels)
+	{
+		label.Priority = static_cast<LabelPriority>(priority(rng));
+		label.Width = 20.0;
+		label.Height = 7.0;
+		for (int i = 0; i < 4; ++i)
+		{
+			const double a = angle(rng);
+			label.Candidates.push_back({{position(rng), position(rng)}, std::cos(a), std::sin(a)});
+		}
+	}
+
+	LabelPlacer placer(28.0);
+	const auto result = placer.Place(labels);
+
+	std::vector<std::vector<Point2D>> placed;
+	for (size_t i = 0; i < labels.size(); ++i)
+	{
+		if (result[i] >= 0)
+		{
+			placed.push_back(Corners(labels[i], labels[i].Candidates[result[i]]));
+		}
+	}
+	REQUIRE(placed.size() == placer.Size());
+	REQUIRE(placed.size() > labels.size() / 4);
+
+	for (size_t i = 0; i < placed.size(); ++i)
+	{
+		for (size_t j = i + 1; j < placed.size(); ++j)
+		{
+			if (!Separated(placed[i], placed[j]))
+			{
+				FAIL("labels " << i << " and " << j << " overlap");
+			}
+		}
+	}
+}
@@ -0,0 +1,154 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Exceptions.h"
+#include "LandXml.h"
+#include "ZigzagJds.h"
+
+using namespace Catch;
+using namespace VizRailCore;
+
+namespace
+{
+	struct TemporaryFile
+	{
+		std::filesystem::path Path;
+
+		explicit TemporaryFile(const char* name) : Path(std::filesystem::temp_directory_path() / name)
+		{
+		}
+
+		~TemporaryFile()
+		{
+			std::error_code error;
+			std::filesystem::remove(Path, error);
+		}
+	};
+
+	void WriteText(const std::filesystem::path& path, const std::string& text)
+	{
+		std::ofstream stream(path, std::ios::binary);
+		stream << text;
+	}
+}
+
+TEST_CASE("LandXmlShouldRoundTripAlignments", "[LandXml]")
+{
+	const HorizontalAlignment first(ZigzagJds(7, {.N = 0.125, .StartMileage = 1234.5}));
+	// 没有缓和曲线时只有圆弧
+	const HorizontalAlignment second(ZigzagJds(4, {.N = 0.125, .E = 5000.0, .Ls = 0.0, .StartMileage = 1234.5}));
+	const TemporaryFile file("VizRailLandXmlRoundTrip.xml");
+	const std::vector<LandXmlAlignment> alignments = {{L"方案1", &first}, {L"比较<方案>&2", &second}};
+	SaveLandXml(file.Path, alignments);
+
+	const auto read = ReadLandXml(file.Path);
+	REQUIRE(read.size() == 2);
+	REQUIRE(read[0].Name == L"方案1");
+	REQUIRE(read[1].Name == L"比较<方案>&2");
+	for (size_t k = 0; k < 2; ++k)
+	{
+		const HorizontalAlignment& expected = k == 0 ? first : second;
+		const JdColumns& jds = read[k].Jds;
+		REQUIRE(jds.Size() == expected.GetJds().Size());
+		REQUIRE(jds.StartMileage == 1234.5);
+		for (size_t i = 0; i < jds.Size(); ++i)
+		{
+			// 曲线的交点由进出切线求交还原
+			const Jd& jd = expected.GetJds()[i];
+			REQUIRE(jds.JdH[i] == i);
+			REQUIRE(jds.N[i] == Approx(jd.N).margin(1e-6));
+			REQUIRE(jds.E[i] == Approx(jd.E).margin(1e-6));
+			REQUIRE(jds.R[i] == jd.R);
+			REQUIRE(jds.Ls[i] == Approx(jd.Ls).margin(1e-9));
+		}
+		const HorizontalAlignment restored(jds.ToJds());
+		REQUIRE(restored.GetTotalMileage() == Approx(expected.GetTotalMileage()).margin(1e-6));
+	}
+}
+
+TEST_CASE("LandXmlReaderShouldSkipUnrelatedElements", "[LandXml]")
+{
+	const TemporaryFile file("VizRailLandXmlSkip.xml");
+	// 圆弧直接与直线相接，点带高程，Profile和Feature被跳过，自闭合的空线路没有交点
+	WriteText(file.Path, R"(<?xml version="1.0" encoding="UTF-8"?>
+<!DOCTYPE LandXML [<!ENTITY unused "<x>">]>
+<LandXML xmlns:lx="http://www.landxml.org/schema/LandXML-1.2">
+<!-- <Alignment name="commented"/> -->
+<lx:Alignments>
+<lx:Alignment name="&#x7EBF;&amp;1" staStart="100">
+<lx:CoordGeom>
+<lx:Line><lx:Start>0 0 5</lx:Start><lx:End>1000 0</lx:End><Feature><Property label="a" value="&lt;b&gt;"/></Feature></lx:Line>
+<lx:Line><lx:Start>1000 0</lx:Start><lx:End>2000 0</lx:End></lx:Line>
+<lx:Curve rot="cw" radius="1000"><lx:Start>2000 0</lx:Start><lx:Center>2000 1000</lx:Center><lx:End>3000 1000</lx:End></lx:Curve>
+<lx:Line><lx:Start>3000 1000</lx:Start><lx:End>3000 2000</lx:End></lx:Line>
+</lx:CoordGeom>
+<lx:Profile><ProfAlign name="p"><PVI>0 0</PVI></ProfAlign></lx:Profile>
+</lx:Alignment>
+<lx:Alignment name="empty"/>
+</lx:Alignments>
+</LandXML>
+)");
+	const auto read = ReadLandXml(file.Path);
+	REQUIRE(read.size() == 2);
+	REQUIRE(read[0].Name == L"线&1");
+	const JdColumns& jds = read[0].Jds;
+	REQUIRE(jds.StartMileage == 100.0);
+	REQUIRE(jds.N == std::vector{0.0, 3000.0, 3000.0});
+	REQUIRE(jds.E == std::vector{0.0, 0.0, 2000.0});
+	REQUIRE(jds.R == std::vector{0.0, 1000.0, 0.0});
+	REQUIRE(jds.Ls == std::vector{0.0, 0.0, 0.0});
+	REQUIRE(read[1].Name == L"empty");
+	REQUIRE(read[1].Jds.Size() == 0);
+}
+
+TEST_CASE("LandXmlReaderShouldReportLine", "[LandXml]")
+{
+	const TemporaryFile file("VizRailLandXmlBad.xml");
+	const auto lineOfError = [&file](const std::string& text)
+	{
+		WriteText(file.Path, text);
+		try
+		{
+			(void)ReadLandXml(file.Path);
+		}
+		catch (const TextImportException& e)
+		{
+			return e.Line();
+		}
+		return size_t{0};
+	};
+
+	SECTION("不连续的几何元素")
+	{
+		REQUIRE(lineOfError("<LandXML><Alignment><CoordGeom>\n"
+			"<Line><Start>0 0</Start><End>100 0</End></Line>\n"
+			"<Line><Start>200 0</Start><End>300 0</End></Line>\n"
+			"</CoordGeom></Alignment></LandXML>") == 3);
+	}
+
+	SECTION("直线间的转折")
+	{
+		REQUIRE(lineOfError("<LandXML><Alignment><CoordGeom>\n"
+			"<Line><Start>0 0</Start><End>100 0</End></Line>\n"
+			"<Line><Start>100 0</Start><End>100 100</End></Line>\n"
+			"</CoordGeom></Alignment></LandXML>") == 3);
+	}
+
+	SECTION("标签不匹配")
+	{
+		REQUIRE(lineOfError("<LandXML>\n<Alignment>\n</LandXML>") == 3);
+	}
+
+	SECTION("坐标不是数值")
+	{
+		REQUIRE(lineOfError("<LandXML><Alignment><CoordGeom>\n\n"
+			"<Line><Start>0 x</Start><End>100 0</End></Line>\n"
+			"</CoordGeom></Alignment></LandXML>") == 3);
+	}
+}
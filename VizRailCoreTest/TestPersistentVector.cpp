@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <random>
+
+#include "PersistentVector.h"
+
+using namespace VizRailCore;
+
+TEST_CASE("PersistentVectorShouldMatchVector", "[PersistentVector]")
+{
+	std::mt19937 random(20240611);
+	std::vector<int> expected;
+	PersistentVector<int, 4> vector;
+	std::vector<std::pair<PersistentVector<int, 4>, std::vector<int>>> versions;
+
+	for (int step = 0; step < 5000; ++step)
+	{
+		const auto operation = random() % 10;
+		if (expected.empty() || operation < 5)
+		{
+			const size_t index = random() % (expected.size() + 1);
+			expected.insert(expected.begin() + static_cast<std::ptrdiff_t>(index), step);
+			vector = vector.Insert(index, step);
+		}
+		else if (operation < 8)
+		{
+			const size_t index = random() % expected.size();
+			expected[index] = -step;
+			vector = vector.Set(index, -step);
+		}
+		else
+		{
+			const size_t index = random() % expected.size();
+			expected.erase(expected.begin() + static_cast<std::ptrdiff_t>(index));
+			vector = vector.Erase(index);
+		}
+		REQUIRE(vector.Size() == expected.size());
+		if (step % 250 == 0)
+		{
+			versions.emplace_back(vector, expected);
+		}
+	}
+
+	REQUIRE(vector.ToVector() == expected);
+	for (size_t i = 0; i < expected.size(); ++i)
+	{
+		REQUIRE(vector[i] == expected[i]);
+	}
+	// 之后的修改不影响早先的版本
+	for (const auto& [version, items] : versions)
+	{
+		REQUIRE(version.ToVector() == items);
+	}
+	REQUIRE_THROWS_AS(vector.At(expected.size()), std::out_of_range);
+	REQUIRE_THROWS_AS(vector.Insert(expected.size() + 1, 0), std::out_of_range);
+}
+
+TEST_CASE("PersistentVectorShouldBuildFromVector", "[PersistentVector]")
+{
+	for (const size_t size : {0, 1, 8, 9, 64, 65, 1000})
+	{
+		std::vector<int> items(size);
+		for (size_t i = 0; i < size; ++i)
+		{
+			items[i] = static_cast<int>(i * 3);
+		}
+		const PersistentVector<int> vector(items);
+		REQUIRE(vector.Size() == size);
+		REQUIRE(vector.ToVector() == items);
+
+		// 逐个删除到空
+		PersistentVector<int> shrinking = vector;
+		while (!shrinking.IsEmpty())
+		{
+			shrinking = shrinking.Erase(shrinking.Size() / 2);
+		}
+		REQUIRE(vector.ToVector() == items);
+	}
+}
+
+TEST_CASE("PersistentVectorShouldShareUnchangedChunks", "[PersistentVector]")
+{
+	std::vector<int> items(1000);
+	for (int i = 0; i < 1000; ++i)
+	{
+		items[i] = i;
+	}
+	const PersistentVector<int> original(items);
+	const PersistentVector<int> copy = original;
+	REQUIRE(copy.SharesStorageWith(original));
+
+	std::unordered_set<const void*> visited;
+	const size_t full = original.MemoryUsage(visited);
+	REQUIRE(copy.MemoryUsage(visited) == 0);
+
+	// 修改一个元素只复制从根到叶的一条路径
+	const PersistentVector<int> modified = original.Set(500, -1);
+	REQUIRE_FALSE(modified.SharesStorageWith(original));
+	const size_t extra = modified.MemoryUsage(visited);
+	REQUIRE(extra > 0);
+	REQUIRE(extra * 10 < full);
+	REQUIRE(original[500] == 500);
+	REQUIRE(modified[500] == -1);
+}
@@ -0,0 +1,218 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+#include "Curve.h"
+#include "Exceptions.h"
+#include "ProjectCache.h"
+#include "ZigzagJds.h"
+
+using namespace Catch;
+using namespace VizRailCore;
+
+namespace
+{
+	/// 每个测试使用独立的空缓存目录，结束时删除
+	struct TemporaryDirectory
+	{
+		std::filesystem::path Path;
+
+		explicit TemporaryDirectory(const char* name) : Path(std::filesystem::temp_directory_path() / name)
+		{
+			std::filesystem::remove_all(Path);
+		}
+
+		~TemporaryDirectory()
+		{
+			std::error_code error;
+			std::filesystem::remove_all(Path, error);
+		}
+	};
+
+	std::vector<std::filesystem::path> CacheFiles(const std::filesystem::path& directory)
+	{
+		std::vector<std::filesystem::path> files;
+		for (const auto& entry : std::filesystem::directory_iterator(directory))
+		{
+			files.push_back(entry.path());
+		}
+		return files;
+	}
+}
+
+TEST_CASE("StationTableShouldContainIntervalsAndFeaturePoints", "[ProjectCache]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(6));
+	const auto table = BuildStationTable(alignment, 20.0);
+	const auto& xys = alignment.GetXys();
+	const auto order = ElementsByMileage(alignment);
+
+	REQUIRE(table.front().Point == StationPoint::Start);
+	REQUIRE(table.front().Mileage == xys[order.front()].Element->StartMileage().Value());
+	REQUIRE(table.back().Point == StationPoint::End);
+	REQUIRE(table.back().Mileage == Approx(xys[order.back()].Element->EndMileage().Value()));
+	size_t features = 0;
+	for (size_t i = 0; i < table.size(); ++i)
+	{
+		const StationRecord& station = table[i];
+		if (i > 0)
+		{
+			REQUIRE(station.Mileage - table[i - 1].Mileage >= StationTolerance);
+		}
+		if (station.Point == StationPoint::Interval)
+		{
+			REQUIRE(std::remainder(station.Mileage, 20.0) == Approx(0.0).margin(1e-6));
+		}
+		else if (station.Point != StationPoint::Start && station.Point != StationPoint::End)
+		{
+			++features;
+		}
+		const StationFrame frame = alignment.MileageToFrame(Mileage(station.Mileage));
+		REQUIRE(station.E == Approx(frame.Point.X()).margin(1e-6));
+		REQUIRE(station.N == Approx(frame.Point.Y()).margin(1e-6));
+		REQUIRE(station.Azimuth == Approx(frame.Azimuth.Radian()).margin(1e-9));
+	}
+	// 4条曲线各有ZH/HY/QZ/YH/HZ
+	REQUIRE(features == 4 * 5);
+	REQUIRE_THROWS_AS(BuildStationTable(alignment, 0.0), VizRailCoreException);
+}
+
+TEST_CASE("CenterlineShouldStayWithinChordTolerance", "[ProjectCache]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(6));
+	constexpr double tolerance = 0.01;
+	const auto points = BuildCenterline(alignment, tolerance);
+	REQUIRE(points.size() > 2);
+	for (size_t i = 1; i < points.size(); ++i)
+	{
+		const CenterlinePoint& a = points[i - 1];
+		const CenterlinePoint& b = points[i];
+		REQUIRE(b.Mileage > a.Mileage);
+		// 弦中点到中线的距离不超过容差
+		const Point2D middle = alignment.MileageToCoordinate(Mileage((a.Mileage + b.Mileage) / 2));
+		const double distance = std::abs((b.X - a.X) * (middle.Y() - a.Y) - (b.Y - a.Y) * (middle.X() - a.X)) /
+			std::hypot(b.X - a.X, b.Y - a.Y);
+		REQUIRE(distance <= tolerance * 1.01);
+	}
+}
+
+TEST_CASE("JdContentHashShouldDependOnlyOnJds", "[ProjectCache]")
+{
+	const auto jds = ZigzagJds(8);
+	const HorizontalAlignment first(jds);
+	const HorizontalAlignment second(jds);
+	REQUIRE(first.Revision() != second.Revision());
+	REQUIRE(JdContentHash(first) == JdContentHash(second));
+
+	auto moved = jds;
+	moved[3].E += 0.001;
+	REQUIRE(JdContentHash(HorizontalAlignment(moved)) != JdContentHash(first));
+	auto renumbered = jds;
+	renumbered[3].JdH = 99;
+	REQUIRE(JdContentHash(HorizontalAlignment(renumbered)) != JdContentHash(first));
+}
+
+TEST_CASE("ProjectCacheShouldReuseFilesAcrossInstances", "[ProjectCache]")
+{
+	const TemporaryDirectory directory("VizRailCoreTestCache");
+	const auto jds = ZigzagJds(10);
+	const HorizontalAlignment alignment(jds);
+	const auto expected = BuildStationTable(alignment, 20.0);
+	{
+		ProjectCache cache(directory.Path);
+		const auto stations = cache.Stations(alignment, 20.0);
+		REQUIRE(stations.Items.size() == expected.size());
+		const auto image = cache.Image(alignment);
+		REQUIRE(image.View.Elements().size() == alignment.GetXys().Size());
+		(void)cache.Centerline(alignment, 0.01);
+		REQUIRE(cache.Stats().Misses == 3);
+		REQUIRE(cache.Stats().Hits == 0);
+	}
+	REQUIRE(CacheFiles(directory.Path).size() == 3);
+
+	// 重新打开项目：新的线路对象修订号不同，交点表相同，全部命中
+	const HorizontalAlignment reopened(jds);
+	ProjectCache cache(directory.Path);
+	const auto stations = cache.Stations(reopened, 20.0);
+	REQUIRE(stations.Items.size() == expected.size());
+	for (size_t i = 0; i < expected.size(); ++i)
+	{
+		REQUIRE(stations.Items[i].Mileage == expected[i].Mileage);
+		REQUIRE(stations.Items[i].N == expected[i].N);
+		REQUIRE(stations.Items[i].E == expected[i].E);
+		REQUIRE(stations.Items[i].Point == expected[i].Point);
+	}
+	const auto image = cache.Image(reopened);
+	const StationFrame frame = image.View.MileageToFrame(Mileage(1234.5));
+	REQUIRE(frame.Point.X() == Approx(reopened.MileageToCoordinate(Mileage(1234.5)).X()).margin(1e-6));
+	REQUIRE(cache.Stats().Hits == 2);
+	REQUIRE(cache.Stats().Misses == 0);
+
+	// 坐标为-0.0的交点表与0.0的内容哈希相同，校验交点表时也视为相同
+	auto negativeZero = jds;
+	negativeZero[0].E = -0.0;
+	const HorizontalAlignment signedZero(negativeZero);
+	REQUIRE(std::signbit(signedZero.GetJds()[0].E));
+	(void)cache.Image(signedZero);
+	REQUIRE(cache.Stats().Hits == 3);
+	REQUIRE(cache.Stats().Rejected == 0);
+
+	// 参数不同是另一个缓存项
+	(void)cache.Stations(reopened, 50.0);
+	REQUIRE(cache.Stats().Misses == 1);
+
+	// 交点表改变后不使用旧缓存
+	auto edited = jds;
+	edited[4].E += 10.0;
+	const HorizontalAlignment changed(edited);
+	const auto changedStations = cache.Stations(changed, 20.0);
+	REQUIRE(cache.Stats().Misses == 2);
+	const auto rebuilt = BuildStationTable(changed, 20.0);
+	REQUIRE(changedStations.Items.size() == rebuilt.size());
+	REQUIRE(changedStations.Items.back().E == rebuilt.back().E);
+}
+
+TEST_CASE("ProjectCacheShouldRejectCorruptFiles", "[ProjectCache]")
+{
+	const TemporaryDirectory directory("VizRailCoreTestCacheCorrupt");
+	const HorizontalAlignment alignment(ZigzagJds(6));
+	const auto expected = BuildStationTable(alignment, 20.0);
+	{
+		ProjectCache cache(directory.Path);
+		(void)cache.Stations(alignment, 20.0);
+	}
+	const auto files = CacheFiles(directory.Path);
+	REQUIRE(files.size() == 1);
+
+	SECTION("Truncated")
+	{
+		std::filesystem::resize_file(files[0], 100);
+	}
+	SECTION("JdsModified")
+	{
+		// 交点表从第64字节开始，改写第一个交点的N坐标
+		std::fstream file(files[0], std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(64 + 8);
+		const double north = 12345.0;
+		file.write(reinterpret_cast<const char*>(&north), sizeof(north));
+	}
+	SECTION("NotCacheFile")
+	{
+		std::ofstream file(files[0], std::ios::binary | std::ios::trunc);
+		file << "not a cache file";
+	}
+
+	ProjectCache cache(directory.Path);
+	const auto stations = cache.Stations(alignment, 20.0);
+	REQUIRE(cache.Stats().Rejected == 1);
+	REQUIRE(stations.Items.size() == expected.size());
+	REQUIRE(stations.Items.back().Mileage == expected.back().Mileage);
+
+	// 重新计算的结果已替换损坏的文件
+	ProjectCache again(directory.Path);
+	(void)again.Stations(alignment, 20.0);
+	REQUIRE(again.Stats().Hits == 1);
+}
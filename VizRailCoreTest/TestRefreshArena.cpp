@@ -0,0 +1,94 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "AllocationTracker.h"
+#include "HorizontalAlignment.h"
+#include "RefreshArena.h"
+#include "ZigzagJds.h"
+
+using namespace VizRailCore;
+
+TEST_CASE("SteadyStateRefreshShouldNotAllocate", "[RefreshArena]")
+{
+	// 交点副本、里程、线元候选和排序缓冲来自分配区，未变的线元沿用原对象，
+	// 新的线元状态复用上次刷新释放的池块，稳定状态下刷新不访问堆
+	for (const size_t count : {100, 450})
+	{
+		HorizontalAlignment alignment(ZigzagJds(count));
+		alignment.Refresh();
+		alignment.Refresh();
+
+		const size_t capacity = RefreshArena::ForCurrentThread().Capacity();
+		const uint64_t revision = alignment.Revision();
+		REQUIRE_THAT([&] { alignment.Refresh(); }, AllocatesNothing());
+		REQUIRE(alignment.Revision() > revision);
+		REQUIRE(RefreshArena::ForCurrentThread().Capacity() == capacity);
+	}
+}
+
+TEST_CASE("UnchangedJdUpdateShouldOnlyAllocateChangeSet", "[RefreshArena]")
+{
+	// 提交交点修改时除刷新外只剩一次堆分配：返回给调用者的ChangeSet::TouchedJds。
+	// 值未变的交点不复制分块路径，关闭历史记录后也不产生撤销记录
+	for (const size_t count : {100, 450})
+	{
+		HorizontalAlignment alignment(ZigzagJds(count));
+		alignment.SetHistoryLimit(0, 0);
+		const Jd jd = alignment.GetJds()[count / 2];
+		alignment.UpdateJd(count / 2, jd);
+		alignment.UpdateJd(count / 2, jd);
+
+		const auto stats = MeasureAllocations([&]
+		{
+			alignment.UpdateJd(count / 2, jd);
+		});
+		if constexpr (ExactAllocationCounts)
+		{
+			REQUIRE(stats.Count == 1);
+			REQUIRE(stats.Bytes == sizeof(size_t));
+		}
+	}
+}
+
+TEST_CASE("RefreshShouldOnlyAllocateForChangedElements", "[RefreshArena]")
+{
+	// 移动最后一个交点只改变末尾的曲线和夹直线，堆分配次数只随树高略有增加
+	std::vector<size_t> counts;
+	for (const size_t count : {100, 450})
+	{
+		HorizontalAlignment alignment(ZigzagJds(count));
+		alignment.MoveJd(count - 1, 10.0, 0.0);
+		counts.push_back(MeasureAllocations([&]
+		{
+			alignment.MoveJd(count - 1, 10.0, 0.0);
+		}).Count);
+
+		size_t changed = 0;
+		for (const auto& xy : alignment.GetXys())
+		{
+			changed += xy.Revision == alignment.Revision() ? 1 : 0;
+		}
+		REQUIRE(changed == 3);
+	}
+	REQUIRE(counts[1] <= counts[0] + 16);
+	if constexpr (ExactAllocationCounts)
+	{
+		REQUIRE(counts[1] <= 64);
+	}
+}
+
+TEST_CASE("RefreshArenaShouldGrowToPeakUsage", "[RefreshArena]")
+{
+	HorizontalAlignment small(ZigzagJds(50));
+	HorizontalAlignment large(ZigzagJds(400));
+	large.MoveJd(200, 10.0, 0.0);
+	const size_t capacity = RefreshArena::ForCurrentThread().Capacity();
+	REQUIRE(capacity > 0);
+
+	// 之后规模不超过峰值的刷新都在原缓冲区内完成
+	for (int i = 0; i < 10; ++i)
+	{
+		small.MoveJd(25, 1.0, 0.0);
+		large.MoveJd(200, 1.0, 0.0);
+	}
+	REQUIRE(RefreshArena::ForCurrentThread().Capacity() == capacity);
+}
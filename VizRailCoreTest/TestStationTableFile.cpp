@@ -0,0 +1,221 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <bit>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#include "Curve.h"
+#include "Exceptions.h"
+#include "StationTableFile.h"
+#include "ZigzagJds.h"
+
+using namespace Catch;
+using namespace VizRailCore;
+
+namespace
+{
+	/// 投影坐标系中的交点，首个交点里程1000m
+	constexpr ZigzagShape Projected{.N = 3500000.0, .E = 500000.0, .StartMileage = 1000.0};
+
+	struct TemporaryFile
+	{
+		std::filesystem::path Path;
+
+		explicit TemporaryFile(const char* name) : Path(std::filesystem::temp_directory_path() / name)
+		{
+		}
+
+		~TemporaryFile()
+		{
+			std::error_code error;
+			std::filesystem::remove(Path, error);
+		}
+	};
+
+	std::vector<double> Elevations(const std::vector<StationRecord>& stations)
+	{
+		std::vector<double> z;
+		for (const StationRecord& station : stations)
+		{
+			z.push_back(100.0 + 0.004 * station.Mileage);
+		}
+		return z;
+	}
+}
+
+TEST_CASE("StationCurvatureShouldFollowElements", "[StationTableFile]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(3, Projected));
+	const auto stations = BuildStationTable(alignment, 10.0);
+	const auto& curve = dynamic_cast<const Curve&>(*alignment.GetXys()[0].Element);
+	const double sign = curve.IsRightTurn() ? 1.0 : -1.0;
+	for (const StationRecord& station : stations)
+	{
+		const double curvature = StationCurvature(alignment, station);
+		switch (station.Point)
+		{
+		case StationPoint::Start:
+		case StationPoint::End:
+		case StationPoint::ZH:
+		case StationPoint::HZ:
+			REQUIRE(curvature == Approx(0.0).margin(1e-12));
+			break;
+		case StationPoint::HY:
+		case StationPoint::QZ:
+		case StationPoint::YH:
+			REQUIRE(curvature == Approx(sign / 800.0));
+			break;
+		default:
+			break;
+		}
+	}
+	// 缓和曲线中点的曲率为1/2R
+	const StationRecord middle{curve.K(SpecialPoint::ZH).Value() + 50.0, 0, 0, 0, 0, StationPoint::Interval};
+	REQUIRE(StationCurvature(alignment, middle) == Approx(sign / 1600.0));
+}
+
+TEST_CASE("StationTableShouldRoundTripRaw", "[StationTableFile]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(6, Projected));
+	const auto stations = BuildStationTable(alignment, 20.0);
+	const auto z = Elevations(stations);
+	const TemporaryFile file("VizRailStationsRaw.vrst");
+	SaveStationTable(file.Path, alignment, stations, z, {StationTableFile::Encoding::Raw, 64});
+
+	const StationTableReader reader(file.Path);
+	REQUIRE(reader.HasZ());
+	REQUIRE(reader.GetHeader().RowCount == stations.size());
+	REQUIRE(reader.Chunks().size() == (stations.size() + 63) / 64);
+
+	const StationColumns all = reader.ReadAll();
+	REQUIRE(all.Size() == stations.size());
+	for (size_t i = 0; i < stations.size(); ++i)
+	{
+		REQUIRE(all.Mileage[i] == stations[i].Mileage);
+		REQUIRE(all.N[i] == stations[i].N);
+		REQUIRE(all.E[i] == stations[i].E);
+		REQUIRE(all.Azimuth[i] == stations[i].Azimuth);
+		REQUIRE(all.Curvature[i] == StationCurvature(alignment, stations[i]));
+		REQUIRE(all.Z[i] == z[i]);
+	}
+
+	// 映射的文件中每列是连续的double数组
+	const auto mileages = reader.RawColumn(1, StationTableFile::MileageColumn);
+	REQUIRE(mileages.size() == 64);
+	REQUIRE(mileages.front() == stations[64].Mileage);
+	REQUIRE(reader.RawColumn(1, StationTableFile::ZColumn).back() == z[127]);
+
+	// 跨块的里程范围，两端与桩重合
+	const double from = stations[50].Mileage;
+	const double to = stations[200].Mileage;
+	const StationColumns range = reader.ReadRange(from, to);
+	REQUIRE(range.Size() == 151);
+	REQUIRE(range.Mileage.front() == from);
+	REQUIRE(range.Mileage.back() == to);
+	REQUIRE(range.E[10] == stations[60].E);
+	REQUIRE(reader.ReadRange(-10.0, 0.0).Size() == 0);
+	REQUIRE(reader.ReadRange(to + 0.5, to + 1.0).Size() == 0);
+}
+
+TEST_CASE("StationTableShouldCompressWithinResolution", "[StationTableFile]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(6, Projected));
+	const auto stations = BuildStationTable(alignment, 5.0);
+	const TemporaryFile raw("VizRailStationsRaw2.vrst");
+	const TemporaryFile compressed("VizRailStationsCompressed.vrst");
+	SaveStationTable(raw.Path, alignment, stations, {}, {StationTableFile::Encoding::Raw, 1000});
+	SaveStationTable(compressed.Path, alignment, stations, {}, {StationTableFile::Encoding::Compressed, 1000});
+	REQUIRE(std::filesystem::file_size(compressed.Path) * 4 < std::filesystem::file_size(raw.Path));
+
+	const StationTableReader reader(compressed.Path);
+	REQUIRE_FALSE(reader.HasZ());
+	REQUIRE_THROWS_AS(reader.RawColumn(0, StationTableFile::MileageColumn), VizRailCoreException);
+	const auto& resolution = reader.GetHeader().Resolution;
+	const StationColumns all = reader.ReadAll();
+	REQUIRE(all.Size() == stations.size());
+	REQUIRE(all.Z.empty());
+	for (size_t i = 0; i < stations.size(); ++i)
+	{
+		REQUIRE(std::abs(all.Mileage[i] - stations[i].Mileage) <= resolution[StationTableFile::MileageColumn]);
+		REQUIRE(std::abs(all.N[i] - stations[i].N) <= resolution[StationTableFile::NColumn]);
+		REQUIRE(std::abs(all.E[i] - stations[i].E) <= resolution[StationTableFile::EColumn]);
+		REQUIRE(std::abs(all.Azimuth[i] - stations[i].Azimuth) <= resolution[StationTableFile::AzimuthColumn]);
+		REQUIRE(std::abs(all.Curvature[i] - StationCurvature(alignment, stations[i])) <=
+			resolution[StationTableFile::CurvatureColumn]);
+	}
+
+	const double from = stations[1500].Mileage;
+	const StationColumns range = reader.ReadRange(from - 0.5, from + 4.5);
+	REQUIRE(range.Size() == 1);
+	REQUIRE(range.N[0] == all.N[1500]);
+}
+
+TEST_CASE("StationTableShouldRoundTripXorExactly", "[StationTableFile]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(6, Projected));
+	const auto stations = BuildStationTable(alignment, 5.0);
+	auto z = Elevations(stations);
+	z[1] = -0.0;
+	z[2] = std::numeric_limits<double>::infinity();
+	z[3] = std::nan("");
+	const TemporaryFile raw("VizRailStationsRaw3.vrst");
+	const TemporaryFile xored("VizRailStationsXor.vrst");
+	SaveStationTable(raw.Path, alignment, stations, z, {StationTableFile::Encoding::Raw, 1000});
+	SaveStationTable(xored.Path, alignment, stations, z, {StationTableFile::Encoding::Xor, 1000});
+	REQUIRE(std::filesystem::file_size(xored.Path) < std::filesystem::file_size(raw.Path));
+
+	// 逐位相同，包括-0.0、无穷大和NaN
+	const auto bits = [](const double value)
+	{
+		return std::bit_cast<uint64_t>(value);
+	};
+	const StationColumns expected = StationTableReader(raw.Path).ReadAll();
+	const StationColumns all = StationTableReader(xored.Path).ReadAll();
+	REQUIRE(all.Size() == stations.size());
+	for (size_t i = 0; i < stations.size(); ++i)
+	{
+		REQUIRE(bits(all.Mileage[i]) == bits(expected.Mileage[i]));
+		REQUIRE(bits(all.N[i]) == bits(expected.N[i]));
+		REQUIRE(bits(all.E[i]) == bits(expected.E[i]));
+		REQUIRE(bits(all.Azimuth[i]) == bits(expected.Azimuth[i]));
+		REQUIRE(bits(all.Curvature[i]) == bits(expected.Curvature[i]));
+		REQUIRE(bits(all.Z[i]) == bits(z[i]));
+	}
+}
+
+TEST_CASE("StationTableShouldRejectInvalidInput", "[StationTableFile]")
+{
+	const HorizontalAlignment alignment(ZigzagJds(3, Projected));
+	auto stations = BuildStationTable(alignment, 100.0);
+	const TemporaryFile file("VizRailStationsInvalid.vrst");
+
+	SECTION("高程数与桩数不符")
+	{
+		const std::vector z(stations.size() - 1, 0.0);
+		REQUIRE_THROWS_AS(SaveStationTable(file.Path, alignment, stations, z), VizRailCoreException);
+	}
+
+	SECTION("桩未按里程排序")
+	{
+		std::swap(stations[0], stations[1]);
+		REQUIRE_THROWS_AS(SaveStationTable(file.Path, alignment, stations), VizRailCoreException);
+	}
+
+	SECTION("高程不是有限值")
+	{
+		std::vector z(stations.size(), 0.0);
+		z[1] = std::nan("");
+		REQUIRE_THROWS_AS(SaveStationTable(file.Path, alignment, stations, z, {StationTableFile::Encoding::Compressed}),
+		                  VizRailCoreException);
+	}
+
+	SECTION("不是逐桩表文件")
+	{
+		std::ofstream(file.Path, std::ios::binary) << std::string(200, 'x');
+		REQUIRE_THROWS_AS(StationTableReader(file.Path), VizRailCoreException);
+	}
+}
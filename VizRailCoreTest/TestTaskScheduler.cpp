@@ -0,0 +1,185 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <numeric>
+#include <set>
+#include <thread>
+
+#include "TaskScheduler.h"
+
+using namespace VizRailCore;
+
+TEST_CASE("ParallelForShouldVisitEveryIndexOnce", "[TaskScheduler]")
+{
+	for (const size_t workers : {0, 1, 4})
+	{
+		INFO("workers " << workers);
+		TaskScheduler scheduler(workers);
+		std::vector<int> visits(10000, 0);
+		ParallelFor(0, visits.size(), 64, [&](const size_t i)
+		{
+			++visits[i];
+		}, {}, scheduler);
+		REQUIRE(std::ranges::all_of(visits, [](const int count) { return count == 1; }));
+
+		// 空区间和不足一块的区间
+		ParallelFor(5, 5, 64, [&](size_t) { FAIL("empty range"); }, {}, scheduler);
+		ParallelFor(0, 3, 64, [&](const size_t i) { ++visits[i]; }, {}, scheduler);
+		REQUIRE(visits[2] == 2);
+	}
+}
+
+TEST_CASE("NestedParallelForShouldNotDeadlock", "[TaskScheduler]")
+{
+	// 外层任务数多于工作线程，每个外层任务内部再并行，等待中的线程必须帮忙执行内层任务
+	for (const size_t workers : {0, 1, 3})
+	{
+		INFO("workers " << workers);
+		TaskScheduler scheduler(workers);
+		std::vector<std::atomic<int>> sums(32);
+		ParallelFor(0, sums.size(), 1, [&](const size_t outer)
+		{
+			ParallelFor(0, 1000, 16, [&](const size_t inner)
+			{
+				sums[outer].fetch_add(static_cast<int>(inner), std::memory_order_relaxed);
+			}, {}, scheduler);
+		}, {}, scheduler);
+		for (const auto& sum : sums)
+		{
+			REQUIRE(sum.load() == 999 * 1000 / 2);
+		}
+	}
+}
+
+TEST_CASE("TaskGroupShouldRunNestedGroups", "[TaskScheduler]")
+{
+	TaskScheduler scheduler(2);
+	std::atomic<int> count = 0;
+	TaskGroup outer(scheduler);
+	for (int i = 0; i < 8; ++i)
+	{
+		outer.Run([&]
+		{
+			TaskGroup inner(scheduler);
+			for (int j = 0; j < 8; ++j)
+			{
+				inner.Run([&] { ++count; });
+			}
+			inner.Wait();
+		});
+	}
+	outer.Wait();
+	REQUIRE(count == 64);
+}
+
+TEST_CASE("WaitingThreadShouldWakeForNewTasks", "[TaskScheduler]")
+{
+	// 工作线程先取走外层任务，调用线程在Wait中阻塞；外层任务提交内层任务后一直等到它被其他线程执行，
+	// 只有阻塞的调用线程能执行它，提交任务时必须唤醒等待中的线程
+	TaskScheduler scheduler(1);
+	std::atomic<bool> ran = false;
+	std::thread::id outerThread;
+	std::thread::id innerThread;
+	TaskGroup group(scheduler);
+	group.Run([&]
+	{
+		outerThread = std::this_thread::get_id();
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		group.Run([&]
+		{
+			innerThread = std::this_thread::get_id();
+			ran.store(true);
+		});
+		while (!ran.load())
+		{
+			std::this_thread::yield();
+		}
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	group.Wait();
+	REQUIRE(innerThread != outerThread);
+}
+
+TEST_CASE("ParallelReduceShouldNotDependOnWorkerCount", "[TaskScheduler]")
+{
+	// 浮点求和的结果只取决于分块，与线程数无关
+	const auto term = [](const size_t i) { return 1.0 / static_cast<double>(i + 1); };
+	const auto plus = [](const double a, const double b) { return a + b; };
+
+	std::set<double> results;
+	for (const size_t workers : {0, 1, 3})
+	{
+		TaskScheduler scheduler(workers);
+		results.insert(ParallelReduce(0, 100000, 1000, 0.0, term, plus, {}, scheduler));
+	}
+	REQUIRE(results.size() == 1);
+
+	TaskScheduler scheduler(2);
+	REQUIRE(ParallelReduce(0, 0, 1000, 7.0, term, plus, {}, scheduler) == 7.0);
+	REQUIRE(ParallelReduce<size_t>(0, 1000, 7, 0, [](const size_t i) { return i; }, plus, {}, scheduler) ==
+		999 * 1000 / 2);
+}
+
+TEST_CASE("ParallelForShouldRethrowLowestIndexException", "[TaskScheduler]")
+{
+	for (const size_t workers : {0, 3})
+	{
+		INFO("workers " << workers);
+		TaskScheduler scheduler(workers);
+		try
+		{
+			ParallelFor(0, 10000, 32, [](const size_t i)
+			{
+				if (i == 700 || i == 9000)
+				{
+					throw std::out_of_range(std::to_string(i));
+				}
+			}, {}, scheduler);
+			FAIL("no exception");
+		}
+		catch (const std::out_of_range& e)
+		{
+			REQUIRE(std::string(e.what()) == "700");
+		}
+	}
+}
+
+TEST_CASE("CancelledParallelForShouldStopEarly", "[TaskScheduler]")
+{
+	for (const size_t workers : {0, 3})
+	{
+		INFO("workers " << workers);
+		TaskScheduler scheduler(workers);
+		const CancellationToken token;
+		std::atomic<size_t> visited = 0;
+		REQUIRE_THROWS_AS(ParallelFor(0, 100000, 16, [&](const size_t i)
+		{
+			++visited;
+			if (i == 100)
+			{
+				token.Cancel();
+			}
+		}, token, scheduler), OperationCancelledException);
+		REQUIRE(visited < 100000);
+
+		// 已取消的令牌不再执行任何块
+		visited = 0;
+		REQUIRE_THROWS_AS(ParallelFor(0, 1000, 16, [&](size_t) { ++visited; }, token, scheduler),
+		                  OperationCancelledException);
+		REQUIRE(visited == 0);
+	}
+}
+
+TEST_CASE("DefaultSchedulerShouldUseConfiguredWorkerCount", "[TaskScheduler]")
+{
+	TaskScheduler::SetDefaultWorkerCount(2);
+	REQUIRE(TaskScheduler::Default().WorkerCount() == 2);
+	REQUIRE(&TaskScheduler::Default() == &TaskScheduler::Default());
+
+	std::vector<int> values(5000);
+	ParallelFor(0, values.size(), 100, [&](const size_t i) { values[i] = static_cast<int>(i); });
+	REQUIRE(std::accumulate(values.begin(), values.end(), 0LL) == 4999LL * 5000 / 2);
+
+	TaskScheduler::ShutdownDefault();
+	REQUIRE(TaskScheduler::Default().WorkerCount() == 2);
+}
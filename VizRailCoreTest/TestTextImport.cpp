@@ -0,0 +1,173 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "Exceptions.h"
+#include "TextImport.h"
+#include "Utf8.h"
+
+using namespace Catch;
+using namespace VizRailCore;
+
+namespace
+{
+	/// 测试用的临时文件，结束时删除
+	struct TemporaryFile
+	{
+		std::filesystem::path Path;
+
+		TemporaryFile(const char* name, const std::string& content) : Path(
+			std::filesystem::temp_directory_path() / name)
+		{
+			std::ofstream stream(Path, std::ios::binary | std::ios::trunc);
+			stream << content;
+		}
+
+		~TemporaryFile()
+		{
+			std::error_code error;
+			std::filesystem::remove(Path, error);
+		}
+	};
+
+	/// 生成count行坐标点，第3行之后每隔几行插入空行
+	std::string PointLines(const size_t count)
+	{
+		std::string text;
+		for (size_t i = 0; i < count; ++i)
+		{
+			text += std::to_string(1000.5 + i) + "\t" + std::to_string(2000.25 - i) + "\t+" + std::to_string(i * 20.0) +
+				"\r\n";
+			if (i > 3 && i % 7 == 0)
+			{
+				text += "\r\n";
+			}
+		}
+		return text;
+	}
+}
+
+TEST_CASE("JdTableShouldBeImportedFromUtf8AndGbk", "[TextImport]")
+{
+	const std::string rows = "0,1000,2000,,,,125.5\n1,3000,2500,800,100\n2,5000,2000\n";
+	// UTF-8带BOM，GBK为Access导出的默认编码
+	const TemporaryFile utf8("VizRailTextImportUtf8.csv",
+	                         "\xEF\xBB\xBF交点号,坐标N,坐标E,曲线半径,前缓和曲线,切线长,起点里程\n" + rows);
+	const TemporaryFile gbk("VizRailTextImportGbk.csv",
+	                        "\xBD\xBB\xB5\xE3\xBA\xC5,\xD7\xF8\xB1\xEA\x4E,\xD7\xF8\xB1\xEA\x45,"
+	                        "\xC7\xFA\xCF\xDF\xB0\xEB\xBE\xB6,\xC7\xB0\xBB\xBA\xBA\xCD\xC7\xFA\xCF\xDF,"
+	                        "\xC7\xD0\xCF\xDF\xB3\xA4,\xC6\xF0\xB5\xE3\xC0\xEF\xB3\xCC\n" + rows);
+
+	for (const auto* file : {&utf8, &gbk})
+	{
+		const JdColumns jds = ImportJdTable(file->Path);
+		REQUIRE(jds.Size() == 3);
+		REQUIRE(jds.JdH == std::vector<unsigned>{0, 1, 2});
+		REQUIRE(jds.N == std::vector{1000.0, 3000.0, 5000.0});
+		REQUIRE(jds.E == std::vector{2000.0, 2500.0, 2000.0});
+		REQUIRE(jds.R == std::vector{0.0, 800.0, 0.0});
+		REQUIRE(jds.Ls == std::vector{0.0, 100.0, 0.0});
+		REQUIRE(jds.StartMileage == Approx(125.5));
+		const auto converted = jds.ToJds();
+		REQUIRE(converted.size() == 3);
+		REQUIRE(converted[0].StartMileage == Approx(125.5));
+		REQUIRE(converted[1].R == 800.0);
+	}
+
+	// 指定UTF-8时不识别GBK表头
+	REQUIRE_THROWS_AS(ImportJdTable(gbk.Path, {TextEncoding::Utf8}), TextImportException);
+}
+
+TEST_CASE("ChunkedImportShouldMatchSingleChunk", "[TextImport]")
+{
+	const TemporaryFile file("VizRailTextImportPoints.txt", "N\tE\tMileage\r\n" + PointLines(2000));
+	const PointColumns whole = ImportPoints(file.Path, {TextEncoding::Auto, size_t{1} << 30});
+	// 块大小从远小于一行到数千字节，块边界落在行中间、行尾和空行上
+	for (const size_t chunkSize : {1, 17, 64, 1000, 4096})
+	{
+		const PointColumns chunked = ImportPoints(file.Path, {TextEncoding::Auto, static_cast<size_t>(chunkSize)});
+		REQUIRE(chunked.N == whole.N);
+		REQUIRE(chunked.E == whole.E);
+		REQUIRE(chunked.Mileage == whole.Mileage);
+	}
+	REQUIRE(whole.Size() == 2000);
+	REQUIRE(whole.N[1999] == 2999.5);
+	REQUIRE(whole.E[10] == 1990.25);
+	REQUIRE(whole.Mileage[3] == 60.0);
+}
+
+TEST_CASE("ImportErrorsShouldReportLineAndColumn", "[TextImport]")
+{
+	// 表头第1行，数据从第2行起，每隔几行有空行，错误在第50个数据点
+	std::string lines = PointLines(60);
+	const std::string bad = std::to_string(1049.5) + "\t" + std::to_string(1951.25);
+	const size_t at = lines.find(bad);
+	REQUIRE(at != std::string::npos);
+	lines[at + bad.find('\t') + 3] = 'x';
+	const size_t expectedLine = 2 + static_cast<size_t>(std::count(lines.begin(), lines.begin() + at, '\n'));
+	const TemporaryFile file("VizRailTextImportBad.txt", "N\tE\tMileage\n" + lines);
+
+	for (const size_t chunkSize : {16, 4096})
+	{
+		try
+		{
+			(void)ImportPoints(file.Path, {TextEncoding::Auto, static_cast<size_t>(chunkSize)});
+			FAIL("应当抛出TextImportException");
+		}
+		catch (const TextImportException& e)
+		{
+			REQUIRE(e.Line() == expectedLine);
+			REQUIRE(e.Column() == 2);
+			REQUIRE(e.GetMsg().find(L"坐标E不是数值") != std::wstring::npos);
+		}
+	}
+
+	// 中间交点缺少曲线半径时报告所在行
+	const TemporaryFile jds("VizRailTextImportBadJd.csv", "N,E,R\n0,0\n\n1000,500\n2000,0\n");
+	try
+	{
+		(void)ImportJdTable(jds.Path);
+		FAIL("应当抛出TextImportException");
+	}
+	catch (const TextImportException& e)
+	{
+		REQUIRE(e.Line() == 4);
+		REQUIRE(e.Column() == 0);
+	}
+
+	const TemporaryFile noCoordinates("VizRailTextImportNoE.csv", "N,R\n0,0\n1,1\n");
+	REQUIRE_THROWS_AS(ImportJdTable(noCoordinates.Path), TextImportException);
+}
+
+TEST_CASE("PointsWithoutHeaderShouldBeImported", "[TextImport]")
+{
+	const TemporaryFile file("VizRailTextImportHeaderless.txt", "\n  3000.5   2000  \n3001.5 2001\n");
+	const PointColumns points = ImportPoints(file.Path);
+	REQUIRE(points.Size() == 2);
+	REQUIRE(points.N == std::vector{3000.5, 3001.5});
+	REQUIRE(points.E == std::vector{2000.0, 2001.0});
+	REQUIRE(points.Mileage.empty());
+}
+
+TEST_CASE("Utf8ShouldRejectOverlongAndSurrogateSequences", "[TextImport]")
+{
+	const std::wstring text = L"交点\U0001F686";
+	REQUIRE(FromUtf8(ToUtf8(text)) == text);
+	std::wstring decoded;
+	REQUIRE(TryFromUtf8(ToUtf8(text), decoded));
+	REQUIRE(decoded == text);
+
+	// 过长编码的'/'、编码为UTF-8的代理项和超出U+10FFFF的码点都不是合法的UTF-8
+	for (const std::string_view invalid : {"\xC0\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xE4\xBA"})
+	{
+		REQUIRE_FALSE(TryFromUtf8(invalid, decoded));
+		REQUIRE_THROWS_AS(DecodeText(invalid, TextEncoding::Utf8), VizRailCoreException);
+		REQUIRE(FromUtf8(invalid).find(static_cast<wchar_t>(ReplacementCharacter)) != std::wstring::npos);
+	}
+	// 孤立的代理项编码为U+FFFD
+	REQUIRE(ToUtf8(std::wstring(1, static_cast<wchar_t>(0xD800))) == "\xEF\xBF\xBD");
+}
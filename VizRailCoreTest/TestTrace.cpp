@@ -0,0 +1,94 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <sstream>
+#include <thread>
+
+#include "DisplayListBuilder.h"
+#include "HorizontalAlignment.h"
+#include "Trace.h"
+#include "ZigzagJds.h"
+
+using namespace VizRailCore;
+
+namespace
+{
+	uint64_t Counter(const TraceCounter counter)
+	{
+		return Trace::Counters()[static_cast<size_t>(counter)];
+	}
+}
+
+TEST_CASE("TraceCountersShouldTrackHotPaths", "[Trace]")
+{
+	Trace::ResetCounters();
+	HorizontalAlignment alignment(ZigzagJds(10));
+	Jd jd = alignment.GetJds()[9];
+	jd.E += 100;
+	alignment.UpdateJd(9, jd);
+	(void)alignment.MileageToCoordinate(Mileage(100.0));
+	(void)alignment.QueryElements(alignment.Extents());
+
+	DisplayListBuilder builder;
+	builder.Update(alignment);
+	jd.E += 100;
+	alignment.UpdateJd(9, jd);
+	builder.Update(alignment);
+
+	if (!Trace::IsCompiledIn())
+	{
+		REQUIRE(Trace::Counters() == TraceCounters{});
+		return;
+	}
+	REQUIRE(Counter(TraceCounter::Refreshes) == 3);
+	REQUIRE(Counter(TraceCounter::RefreshNanoseconds) > 0);
+	// 首次刷新构造全部17个线元，移动最后一个交点只重建最后一条曲线及其前后两条夹直线
+	REQUIRE(Counter(TraceCounter::ElementsRebuilt) == 17 + 3 + 3);
+	REQUIRE(Counter(TraceCounter::Queries) == 2);
+	REQUIRE(Counter(TraceCounter::CacheMisses) == 17 + 3);
+	REQUIRE(Counter(TraceCounter::CacheHits) == 14);
+	REQUIRE(Counter(TraceCounter::TessellatedVertices) > 0);
+
+	Trace::ResetCounters();
+	REQUIRE(Trace::Counters() == TraceCounters{});
+}
+
+TEST_CASE("TraceCountersShouldIncludeExitedThreads", "[Trace]")
+{
+	Trace::ResetCounters();
+	std::thread([]
+	{
+		Trace::Add(TraceCounter::Queries, 5);
+	}).join();
+	Trace::Add(TraceCounter::Queries, 1);
+	REQUIRE(Counter(TraceCounter::Queries) == (Trace::IsCompiledIn() ? 6 : 0));
+	Trace::ResetCounters();
+}
+
+TEST_CASE("ChromeTraceShouldContainRecordedScopes", "[Trace]")
+{
+	Trace::ClearEvents();
+	Trace::StartRecording();
+	HorizontalAlignment alignment(ZigzagJds(5));
+	Trace::StopRecording();
+	// 停止后不再记录
+	alignment.Refresh();
+
+	std::ostringstream stream;
+	Trace::WriteChromeTrace(stream);
+	const std::string json = stream.str();
+	REQUIRE(json.starts_with("{\"traceEvents\":["));
+	REQUIRE(json.find("\"name\":\"Refreshes\",\"ph\":\"C\"") != std::string::npos);
+	if (Trace::IsCompiledIn())
+	{
+		const auto first = json.find("\"name\":\"HorizontalAlignment::RefreshXys\"");
+		REQUIRE(first != std::string::npos);
+		REQUIRE(json.find("\"name\":\"HorizontalAlignment::RefreshXys\"", first + 1) == std::string::npos);
+		REQUIRE(json.find("\"name\":\"HorizontalAlignment::BuildXys\"") != std::string::npos);
+		REQUIRE(json.find("\"ph\":\"X\"") != std::string::npos);
+	}
+
+	Trace::ClearEvents();
+	std::ostringstream cleared;
+	Trace::WriteChromeTrace(cleared);
+	REQUIRE(cleared.str().find("\"ph\":\"X\"") == std::string::npos);
+}
@@ -0,0 +1,61 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "Validation.h"
+
+using namespace VizRailCore;
+
+namespace
+{
+	std::vector<Jd> SampleJds()
+	{
+		return {
+			{0, 507118.139447, 3342247.107195, 0, 0, 0, 0, 0, 0, 0, 0},
+			{1, 503688.185001, 3339134.96392, 0, 10000.0, 590.0, 0, 0, 0, 0, 0},
+			{2, 483014.208169, 3330609.751766, 0, 10000.0, 590.0, 0, 0, 0, 0, 0},
+			{3, 470764.921972, 3331514.645487, 0, 8000.0, 590.0, 0, 0, 0, 0, 0},
+			{4, 468474.95, 3335628.27, 0, 0, 0, 0, 0, 0, 0, 0},
+		};
+	}
+}
+
+TEST_CASE("ValidationShouldPassWithinRules", "[Validation]")
+{
+	const HorizontalAlignment alignment(SampleJds());
+	REQUIRE(Validate(alignment, {}).empty());
+	REQUIRE(Validate(alignment, {8000.0, 590.0, 100.0, 100.0}).empty());
+}
+
+TEST_CASE("ValidationShouldReportViolatedRules", "[Validation]")
+{
+	const HorizontalAlignment alignment(SampleJds());
+	const auto issues = Validate(alignment, {9000.0, 600.0, 0.0, 0.0});
+	// 三条曲线的缓和曲线都短于600m，曲线3的半径小于9000m，结果按线路顺序排列
+	REQUIRE(issues.size() == 4);
+	REQUIRE(issues[0].Element == L"曲线1");
+	REQUIRE(issues[1].Element == L"曲线2");
+	REQUIRE(issues[2].Element == L"曲线3");
+	REQUIRE(issues[2].Message.find(L"曲线半径") != std::wstring::npos);
+	REQUIRE(issues[3].Element == L"曲线3");
+	REQUIRE(issues[3].Message.find(L"缓和曲线长") != std::wstring::npos);
+
+	// 夹直线2最短，约11.5km
+	const auto tangents = Validate(alignment, {0.0, 0.0, 0.0, 20000.0});
+	REQUIRE(tangents.size() == 2);
+	REQUIRE(tangents[0].Element == L"夹直线2");
+	REQUIRE(tangents[1].Element == L"夹直线3");
+}
+
+TEST_CASE("ValidationShouldReportOverlappingCurves", "[Validation]")
+{
+	// 曲线1和曲线2的切线长约为2.5km和4.6km，之和大于两交点间距
+	const HorizontalAlignment alignment(std::vector<Jd>{
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+		{1, 5000, 0, 0, 50000, 100, 0, 0, 0, 0, 0},
+		{2, 10000, 500, 0, 45000, 100, 0, 0, 0, 0, 0},
+		{3, 15000, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+	});
+	const auto issues = Validate(alignment, {});
+	REQUIRE(issues.size() == 1);
+	REQUIRE(issues[0].Element == L"夹直线2");
+	REQUIRE(issues[0].Message.starts_with(L"前后曲线重叠"));
+}
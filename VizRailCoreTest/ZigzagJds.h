@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "Jd.h"
+
+/// 锯齿形交点表的参数
+struct ZigzagShape
+{
+	/// 首个交点的坐标，其后的交点N每个增加2000m，E在E与E+1000m之间交替
+	double N = 0.0;
+	double E = 0.0;
+	/// 首末以外各交点的曲线半径和缓和曲线长度
+	double R = 800.0;
+	double Ls = 100.0;
+	/// 首个交点的里程
+	double StartMileage = 0.0;
+	/// 首个交点的交点号，其后依次加1
+	unsigned FirstJdH = 0;
+};
+
+/// \brief 测试用的锯齿形交点表，各曲线偏角相同、转向交替
+inline std::vector<Jd> ZigzagJds(const size_t count, const ZigzagShape& shape = {})
+{
+	std::vector<Jd> jds;
+	jds.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const bool middle = i > 0 && i + 1 < count;
+		jds.push_back({
+			shape.FirstJdH + static_cast<unsigned>(i), shape.N + i * 2000.0, shape.E + (i % 2) * 1000.0, 0,
+			middle ? shape.R : 0.0, middle ? shape.Ls : 0.0, 0, 0, 0, i == 0 ? shape.StartMileage : 0.0, 0
+		});
+	}
+	return jds;
+}
@@ -1,20 +1,31 @@
 #include "stdafx.h"
 #include "HorizontalAlignmentEntity.h"
 
-#include <format>
+#include <cmath>
+#include <numeric>
 
-#include "../VizRailCore/includes/Curve.h"
+#include "ProjectService.h"
 #include "../VizRailCore/includes/Exceptions.h"
-#include "../VizRailCore/includes/IntermediateLine.h"
 
 
+namespace
+{
+	// 文字插入点在视口外但文字仍可能伸入视口的最大距离
+	constexpr double LabelMargin = 200.0;
+}
+
 ACRX_DXF_DEFINE_MEMBERS(HorizontalAlignmentEntity, AcDbEntity,
                         AcDb::kDHL_CURRENT, AcDb::kMReleaseCurrent, 0, HORIZONTAL, /*MSG0*/"AutoCAD")
 
 HorizontalAlignmentEntity::HorizontalAlignmentEntity(const AcString& name, const std::vector<Jd>& jds)
+	: _horizontalAlignment(jds), _name(name)
+{
+}
+
+HorizontalAlignmentEntity::HorizontalAlignmentEntity(const AcString& name,
+                                                     const VizRailCore::HorizontalAlignment& alignment)
+	: _horizontalAlignment(alignment), _name(name)
 {
-	_name = name;
-	_horizontalAlignment.AddJd(jds);
 }
 
 Acad::ErrorStatus HorizontalAlignmentEntity::dwgInFields(AcDbDwgFiler* filer)
@@ -36,7 +47,8 @@ Acad::ErrorStatus HorizontalAlignmentEntity::dwgInFields(AcDbDwgFiler* filer)
 	filer->readItem(&size);
 	std::vector<Jd> jds(size);
 	filer->readItem(jds.data(), size * sizeof(Jd));
-	_horizontalAlignment.AddJd(jds);
+	// 读入的交点替换现有交点，撤销历史也从读入的状态重新开始
+	_horizontalAlignment = VizRailCore::HorizontalAlignment(jds);
 
 	return filer->filerStatus();
 }
@@ -54,7 +66,7 @@ Acad::ErrorStatus HorizontalAlignmentEntity::dwgOutFields(AcDbDwgFiler* filer) c
 	}
 
 	filer->writeItem(_name);
-	const std::vector<Jd> jds = _horizontalAlignment.GetJds();
+	const std::vector<Jd> jds = _horizontalAlignment.GetJds().ToVector();
 	filer->writeItem(static_cast<int>(jds.size()));
 	filer->writeItem(jds.data(), jds.size() * sizeof(Jd));
 
@@ -74,43 +86,27 @@ Acad::ErrorStatus HorizontalAlignmentEntity::dxfOutFields(AcDbDxfFiler* filer) c
 
 Adesk::Boolean HorizontalAlignmentEntity::subWorldDraw(AcGiWorldDraw* pWorldDraw)
 {
+	// 正常显示时返回false，交由subViewportDraw按视口比例尺绘制；分解、代理图形等不经过视口的场合按完整细节绘制
+	const AcGiRegenType regenType = pWorldDraw->regenType();
+	if (regenType != kAcGiForExplode && regenType != kAcGiSaveWorldDrawForProxy)
+	{
+		return Adesk::kFalse;
+	}
 	try
 	{
-		const auto xys = _horizontalAlignment.GetXys();
-		bool ret = false;
-
-		const AcGeVector3d normal(0, 0, 1);
-		for (const auto& [xyName,xy] : xys)
+		// 代理图形只在未加载本程序时示意线位，重新打开项目后直接映射缓存的中线，不生成完整细节的显示列表
+		if (regenType == kAcGiSaveWorldDrawForProxy && DrawProxyFromCache(pWorldDraw))
 		{
-			if (xyName.find(L"夹直线") != -1)
-			{
-				const auto jzx = std::dynamic_pointer_cast<VizRailCore::IntermediateLine>(xy);
-				ret = DrawIntermediateLine(pWorldDraw, jzx);
-			}
-			else if (xyName.find(L"曲线") != -1)
-			{
-				const auto qx = std::dynamic_pointer_cast<VizRailCore::Curve>(xy);
-				ret = DrawCurve(pWorldDraw, qx);
-				ret = DrawJdMark(pWorldDraw, qx);
-			}
+			return true;
 		}
-
-		pWorldDraw->subEntityTraits().setColor(3);
-		pWorldDraw->subEntityTraits().setLineWeight(AcDb::kLnWt025);
-		const auto jds = _horizontalAlignment.GetJds();
-		const int jdSize = static_cast<int>(jds.size());
-		AcGePoint3dArray jdPoints(jdSize);
-		for (int i = 0; i < jdSize; ++i)
+		// 只有线路修订号变化的线元才会重新生成显示列表
+		_displayList.Update(_horizontalAlignment);
+		bool ret = true;
+		for (const auto& fragment : _displayList.Fragments())
 		{
-			AcGePoint3d point(jds[i].E, jds[i].N, 0);
-			AcGeVector3d direction(1, 0, 0);
-			ret = pWorldDraw->geometry().circle(point, 2, normal);
-			ret = pWorldDraw->geometry().text(point, normal, direction, 7.0, 1, 0,
-			                                  std::format(L"  JD{}", i).c_str());
-			jdPoints.append({jds[i].E, jds[i].N, 0});
+			ret = DrawDisplayList(pWorldDraw->geometry(), pWorldDraw->subEntityTraits(), *fragment) && ret;
 		}
-
-		ret = pWorldDraw->geometry().polyline(jdPoints.length(), jdPoints.asArrayPtr());
+		ret = DrawDisplayList(pWorldDraw->geometry(), pWorldDraw->subEntityTraits(), *_displayList.Labels()) && ret;
 		return ret;
 	}
 	catch (const std::invalid_argument& e)
@@ -140,6 +136,79 @@ Adesk::Boolean HorizontalAlignmentEntity::subWorldDraw(AcGiWorldDraw* pWorldDraw
 	}
 }
 
+void HorizontalAlignmentEntity::subViewportDraw(AcGiViewportDraw* pViewportDraw)
+{
+	try
+	{
+		const VizRailCore::BoundingBox& extents = _horizontalAlignment.Extents();
+		if (extents.IsEmpty())
+		{
+			return;
+		}
+
+		// 以线路中心处的像素密度作为比例尺，同一层级内平移缩放直接回放缓存
+		AcGePoint2d pixelArea;
+		const auto center = extents.Center();
+		pViewportDraw->viewport().getNumPixelsInUnitSquare({center.X(), center.Y(), 0}, pixelArea);
+		const double unitsPerPixel = pixelArea.x > 0 ? 1.0 / pixelArea.x : 0.0;
+		_displayList.Update(_horizontalAlignment, unitsPerPixel);
+
+		// 只绘制与视口相交的线元，最后一个片段（交点连线）始终绘制
+		const auto& fragments = _displayList.Fragments();
+		const VizRailCore::BoundingBox view = ViewportExtents(pViewportDraw);
+		std::vector<size_t> visible;
+		if (view.IsEmpty())
+		{
+			visible.resize(fragments.size() - 1);
+			std::iota(visible.begin(), visible.end(), size_t{0});
+		}
+		else
+		{
+			visible = _horizontalAlignment.QueryElements(view);
+		}
+		visible.push_back(fragments.size() - 1);
+
+		for (const auto index : visible)
+		{
+			if (pViewportDraw->regenAbort())
+			{
+				return;
+			}
+			DrawDisplayList(pViewportDraw->geometry(), pViewportDraw->subEntityTraits(), *fragments[index]);
+		}
+
+		// 标注已在核心中统一避让，这里只需剔除视口外的文字
+		DrawDisplayList(pViewportDraw->geometry(), pViewportDraw->subEntityTraits(), *_displayList.Labels(),
+		                view.IsEmpty() ? view : view.Inflated(LabelMargin));
+	}
+	catch (const std::invalid_argument& e)
+	{
+		acutPrintf(L"%s", e.what());
+	}
+	catch (NotInLineException& e)
+	{
+		acutPrintf(L"%s", e.GetMsg().c_str());
+	}
+	catch (VizRailCoreException& e)
+	{
+		acutPrintf(L"%s", e.GetMsg().c_str());
+	}
+	catch (std::exception& e)
+	{
+		acutPrintf(L"%s", e.what());
+	}
+	catch (...)
+	{
+		acutPrintf(L"未知错误");
+	}
+}
+
+Adesk::UInt32 HorizontalAlignmentEntity::subSetAttributes(AcGiDrawableTraits* pTraits)
+{
+	// 显示内容随视口比例尺变化，缩放时需要重新调用subViewportDraw
+	return AcDbEntity::subSetAttributes(pTraits) | kDrawableViewDependentViewportDraw;
+}
+
 Acad::ErrorStatus HorizontalAlignmentEntity::subTransformBy(const AcGeMatrix3d& xform)
 {
 	return Acad::eOk;
@@ -153,12 +222,12 @@ Acad::ErrorStatus HorizontalAlignmentEntity::subGetTransformedCopy(const AcGeMat
 Acad::ErrorStatus HorizontalAlignmentEntity::subGetGripPoints(AcGePoint3dArray& gripPoints, AcDbIntArray& osnapModes,
                                                               AcDbIntArray& geomIds) const
 {
-	const auto jds = _horizontalAlignment.GetJds();
-	for (size_t i = 0; i < jds.size(); i++)
+	int i = 0;
+	for (const auto& jd : _horizontalAlignment.GetJds())
 	{
-		gripPoints.append(AcGePoint3d(jds[i].E, jds[i].N, 0));
+		gripPoints.append(AcGePoint3d(jd.E, jd.N, 0));
 		osnapModes.append(0);
-		geomIds.append(static_cast<int>(i));
+		geomIds.append(i++);
 	}
 	return Acad::eOk;
 }
@@ -166,13 +235,16 @@ Acad::ErrorStatus HorizontalAlignmentEntity::subGetGripPoints(AcGePoint3dArray&
 Acad::ErrorStatus HorizontalAlignmentEntity::subMoveGripPointsAt(const AcDbIntArray& indices,
                                                                  const AcGeVector3d& offset)
 {
-	const auto jds = _horizontalAlignment.GetJds();
+	assertWriteEnabled();
 	try
 	{
+		// 多个夹点一起拖动时只刷新一次线元，刷新失败时交点恢复原状
+		VizRailCore::EditTransaction edit(_horizontalAlignment);
 		for (const auto& i : indices)
 		{
 			_horizontalAlignment.MoveJd(i, offset.y, offset.x);
 		}
+		edit.Commit();
 	}
 	catch (const VizRailCoreException& e)
 	{
@@ -191,157 +263,126 @@ Acad::ErrorStatus HorizontalAlignmentEntity::subMoveGripPointsAt(const AcDbIntAr
 	return Acad::eOk;
 }
 
-Acad::ErrorStatus HorizontalAlignmentEntity::subGetGeomExtents(AcDbExtents& extents) const
+bool HorizontalAlignmentEntity::UndoJdEdit()
 {
-	return Acad::eOk;
+	assertWriteEnabled();
+	return _horizontalAlignment.Undo();
 }
 
-bool HorizontalAlignmentEntity::DrawHectoMeter(const AcGiWorldDraw* pWorldDraw,
-                                               const std::shared_ptr<VizRailCore::LineElement>& line,
-                                               const double startMileage, const double endMileage)
+bool HorizontalAlignmentEntity::RedoJdEdit()
 {
-	bool ret = false;
-	pWorldDraw->subEntityTraits().setColor(3);
-	pWorldDraw->subEntityTraits().setLineWeight(AcDb::kLnWt015);
-	const AcGeVector3d normal(0, 0, 1);
-	for (int i = (static_cast<int>(startMileage) / 100 + 1) * 100; i < endMileage; i += 100)
-	{
-		const auto coordinate = line->MileageToCoordinate(i);
-		const auto azimuthAngle = line->MileageToAzimuthAngle(i);
-		AcGePoint3dArray tmp1(2);
-		const double dx = 10 * VizRailCore::Angle::Cos(azimuthAngle - VizRailCore::Angle::HalfPi());
-		const double dy = 10 * VizRailCore::Angle::Sin(azimuthAngle - VizRailCore::Angle::HalfPi());
-		tmp1[0] = {coordinate.X(), coordinate.Y(), 0};
-		tmp1[1] = {coordinate.X() + dx, coordinate.Y() + dy, 0};
-		ret = pWorldDraw->geometry().polyline(2, tmp1.asArrayPtr());
-		AcGeVector3d direction(dx, dy, 0);
-		if (i % 1000 == 0)
-		{
-			VizRailCore::Mileage mileage(i);
-			auto prefix = mileage.Prefix();
-			auto km = i / 1000;
-			ret = pWorldDraw->geometry().text(tmp1[1], normal, direction, 7.0, 1,
-			                                  0, std::format(L"  {} {}", prefix, km).c_str());
-		}
-		else
-		{
-			int m = (i / 100) % 10;
-			ret = pWorldDraw->geometry().text(tmp1[1], normal, direction, 7.0, 1,
-			                                  0, std::format(L"  {}", m).c_str());
-		}
-	}
-	return ret;
+	assertWriteEnabled();
+	return _horizontalAlignment.Redo();
 }
 
-bool HorizontalAlignmentEntity::DrawIntermediateLine(const AcGiWorldDraw* pWorldDraw,
-                                                     const std::shared_ptr<VizRailCore::IntermediateLine>& jzx)
+void HorizontalAlignmentEntity::MemoryUsage(VizRailCore::MemoryReport& report,
+                                            std::unordered_set<const void*>& visited) const
 {
-	bool ret = false;
-	const auto startPoint = jzx->StartPoint();
-	const auto endPoint = jzx->EndPoint();
-	AcGePoint3dArray tmp(2);
-	tmp.append({startPoint.X(), startPoint.Y(), 0});
-	tmp.append({endPoint.X(), endPoint.Y(), 0});
-
-	pWorldDraw->subEntityTraits().setLineWeight(AcDb::kLnWt050);
-	pWorldDraw->subEntityTraits().setColor(3);
-	ret = pWorldDraw->geometry().polyline(2, tmp.asArrayPtr());
-	DrawHectoMeter(pWorldDraw, jzx, jzx->StartMileage().Value(), jzx->EndMileage().Value());
-	return ret;
+	assertReadEnabled();
+	report.Inputs += (static_cast<size_t>(_name.length()) + 1) * sizeof(wchar_t);
+	_horizontalAlignment.MemoryUsage(report, visited);
+	_displayList.MemoryUsage(report, visited);
 }
 
-bool HorizontalAlignmentEntity::MileageMark(const AcGiWorldDraw* pWorldDraw, const AcGePoint3d& pt,
-                                            const VizRailCore::Angle& azimuthAngle, const AcString& str)
+Acad::ErrorStatus HorizontalAlignmentEntity::subGetGeomExtents(AcDbExtents& extents) const
 {
-	AcGePoint3dArray tmp1(2);
-	const double dx = 10 * VizRailCore::Angle::Cos(azimuthAngle - VizRailCore::Angle::HalfPi());
-	const double dy = 10 * VizRailCore::Angle::Sin(azimuthAngle - VizRailCore::Angle::HalfPi());
-	tmp1[0] = pt;
-	tmp1[1] = {pt.x + dx, pt.y + dy, 0};
-	bool ret = pWorldDraw->geometry().polyline(2, tmp1.asArrayPtr());
-	const AcGeVector3d normal(0, 0, 1);
-	const AcGeVector3d direction(dx, dy, 0);
-	ret = pWorldDraw->geometry().text(tmp1[1], normal, direction, 7.0, 1,
-	                                  0, str);
-	return ret;
+	assertReadEnabled();
+	const auto& bounds = _horizontalAlignment.Extents();
+	if (bounds.IsEmpty())
+	{
+		return Acad::eInvalidExtents;
+	}
+	extents.set(AcGePoint3d(bounds.Min().X(), bounds.Min().Y(), 0), AcGePoint3d(bounds.Max().X(), bounds.Max().Y(), 0));
+	return Acad::eOk;
 }
 
-bool HorizontalAlignmentEntity::DrawCurve(const AcGiWorldDraw* pWorldDraw,
-                                          const std::shared_ptr<VizRailCore::Curve>& qx)
+VizRailCore::BoundingBox HorizontalAlignmentEntity::ViewportExtents(AcGiViewportDraw* pViewportDraw)
 {
-	bool ret = false;
-	const auto& mileageZH = qx->K(VizRailCore::SpecialPoint::ZH);
-	const auto& mileageHY = qx->K(VizRailCore::SpecialPoint::HY);
-	const auto& mileageYH = qx->K(VizRailCore::SpecialPoint::YH);
-	const auto& mileageHZ = qx->K(VizRailCore::SpecialPoint::HZ);
-	AcGePoint3dArray transitionTmp1;
-	AcGePoint3dArray transitionTmp2;
-	AcGePoint3dArray curveTmp;
-	const auto ZH = qx->MileageToCoordinate(mileageZH);
-	const auto aZH = qx->MileageToAzimuthAngle(mileageZH);
-	const auto HY = qx->MileageToCoordinate(mileageHY);
-	const auto aHY = qx->MileageToAzimuthAngle(mileageHY);
-	const auto YH = qx->MileageToCoordinate(mileageYH);
-	const auto aYH = qx->MileageToAzimuthAngle(mileageYH);
-	const auto HZ = qx->MileageToCoordinate(mileageHZ);
-	const auto aHZ = qx->MileageToAzimuthAngle(mileageHZ);
-
-	pWorldDraw->subEntityTraits().setLineWeight(AcDb::kLnWt050);
-	// 前缓和曲线
-	for (double j = mileageZH.Value(); j < mileageHY.Value(); ++j)
+	const AcGiViewport& viewport = pViewportDraw->viewport();
+	VizRailCore::BoundingBox view;
+	if (viewport.isPerspective())
 	{
-		const auto coordinate = qx->MileageToCoordinate(j);
-		transitionTmp1.append({coordinate.X(), coordinate.Y(), 0});
+		// 透视视图下视口范围不是矩形，不做裁剪
+		return view;
 	}
-	transitionTmp1.append({HY.X(), HY.Y(), 0});
-	pWorldDraw->subEntityTraits().setColor(2);
-	ret = pWorldDraw->geometry().polyline(transitionTmp1.length(), transitionTmp1.asArrayPtr());
 
-	// 圆曲线部分
-	for (double j = mileageHY.Value(); j < mileageYH.Value(); ++j)
+	AcGePoint2d lowerLeft;
+	AcGePoint2d upperRight;
+	viewport.getViewportDcCorners(lowerLeft, upperRight);
+	AcGeMatrix3d eyeToWorld;
+	viewport.getEyeToWorldTransform(eyeToWorld);
+	for (const auto& corner : {
+		     AcGePoint3d(lowerLeft.x, lowerLeft.y, 0), AcGePoint3d(upperRight.x, lowerLeft.y, 0),
+		     AcGePoint3d(upperRight.x, upperRight.y, 0), AcGePoint3d(lowerLeft.x, upperRight.y, 0)
+	     })
 	{
-		const auto coordinate = qx->MileageToCoordinate(j);
-		curveTmp.append({coordinate.X(), coordinate.Y(), 0});
+		const AcGePoint3d world = eyeToWorld * corner;
+		view.Extend(VizRailCore::Point2D{world.x, world.y});
 	}
-	curveTmp.append({YH.X(), YH.Y(), 0});
-	pWorldDraw->subEntityTraits().setColor(1);
-	ret = pWorldDraw->geometry().polyline(curveTmp.length(), curveTmp.asArrayPtr());
+	return view;
+}
 
-	// 后缓和曲线
-	for (double j = mileageYH.Value(); j < mileageHZ.Value(); ++j)
+bool HorizontalAlignmentEntity::DrawProxyFromCache(AcGiWorldDraw* pWorldDraw) const
+{
+	VizRailCore::ProjectCache* cache = ProjectService::GetCache();
+	if (cache == nullptr)
 	{
-		const auto coordinate = qx->MileageToCoordinate(j);
-		transitionTmp2.append({coordinate.X(), coordinate.Y(), 0});
+		return false;
 	}
-	transitionTmp2.append({HZ.X(), HZ.Y(), 0});
-	pWorldDraw->subEntityTraits().setColor(2);
-	ret = pWorldDraw->geometry().polyline(transitionTmp2.length(), transitionTmp2.asArrayPtr());
-
-	ret = DrawHectoMeter(pWorldDraw, qx, mileageZH.Value(), mileageHZ.Value());
-	ret = MileageMark(pWorldDraw, {ZH.X(), ZH.Y(), 0}, aZH, AcString(std::format(L" ZH {}", mileageZH.GetString())));
-	ret = MileageMark(pWorldDraw, {HY.X(), HY.Y(), 0}, aHY, AcString(std::format(L" HY {}", mileageHY.GetString())));
-	ret = MileageMark(pWorldDraw, {YH.X(), YH.Y(), 0}, aYH, AcString(std::format(L" YH {}", mileageYH.GetString())));
-	ret = MileageMark(pWorldDraw, {HZ.X(), HZ.Y(), 0}, aHZ, AcString(std::format(L" HZ {}", mileageHZ.GetString())));
-	return ret;
+	const auto centerline = cache->Centerline(_horizontalAlignment, ProxyChordTolerance);
+	AcGiGeometry& geometry = pWorldDraw->geometry();
+	AcGiSubEntityTraits& traits = pWorldDraw->subEntityTraits();
+	const auto jds = VizRailCore::DisplayListBuilder::BuildJds(_horizontalAlignment.GetJds());
+	return DrawDisplayList(geometry, traits, *VizRailCore::DisplayListBuilder::BuildCenterline(centerline.Items)) &&
+		DrawDisplayList(geometry, traits, *jds);
 }
 
-bool HorizontalAlignmentEntity::DrawJdMark(AcGiWorldDraw* pWorldDraw, const std::shared_ptr<VizRailCore::Curve>& qx)
+bool HorizontalAlignmentEntity::DrawDisplayList(AcGiGeometry& geometry, AcGiSubEntityTraits& traits,
+                                                const VizRailCore::DisplayList& list,
+                                                const VizRailCore::BoundingBox& view)
 {
-	pWorldDraw->subEntityTraits().setLineWeight(AcDb::kLnWt025);
-	pWorldDraw->subEntityTraits().setColor(0);
-	const auto mileageQZ = qx->K(VizRailCore::SpecialPoint::QZ);
-	const auto QZ = qx->MileageToCoordinate(mileageQZ);
-	const auto aQZ = qx->MileageToAzimuthAngle(mileageQZ);
-	const auto jd = qx->Jd2();
-	const double dx = 80 * VizRailCore::Angle::Cos(aQZ - VizRailCore::Angle::HalfPi());
-	const double dy = 80 * VizRailCore::Angle::Sin(aQZ - VizRailCore::Angle::HalfPi());
-	const AcGePoint3d point(jd.X() + dx, jd.Y() + dy, 0);
 	const AcGeVector3d normal(0, 0, 1);
-	const double dx1 = 80 * VizRailCore::Angle::Cos(aQZ + VizRailCore::Angle::Pi());
-	const double dy1 = 80 * VizRailCore::Angle::Sin(aQZ + VizRailCore::Angle::Pi());
-	const AcGeVector3d direction(dx1,dy1,0);
-	AcString str;
-	str.format(L"R=%f \tLs=%f \r\nL=%f \tT=%f\r\n", qx->R(), qx->Ls(), qx->L_H(), qx->T_H());
-	return pWorldDraw->geometry().text(point, normal, direction, 7.0, 1,
-	                                   0, str);
+	const auto applyStyle = [&traits](const VizRailCore::DisplayStyle& style)
+	{
+		traits.setColor(style.Color);
+		traits.setLineWeight(static_cast<AcDb::LineWeight>(style.LineWeight));
+	};
+
+	bool ret = true;
+	AcGePoint3dArray points;
+	for (const auto& polyline : list.Polylines)
+	{
+		applyStyle(polyline.Style);
+		points.setLogicalLength(0);
+		for (const auto& point : polyline.Points)
+		{
+			points.append({point.X(), point.Y(), 0});
+		}
+		// AcGiGeometry的绘制函数返回true表示应中止绘制
+		ret = !geometry.polyline(points.length(), points.asArrayPtr()) && ret;
+	}
+	for (const auto& arc : list.Arcs)
+	{
+		applyStyle(arc.Style);
+		const AcGeVector3d startVector(std::cos(arc.StartAngle), std::sin(arc.StartAngle), 0);
+		ret = !geometry.circularArc({arc.Center.X(), arc.Center.Y(), 0}, arc.Radius, normal, startVector,
+		                            arc.Sweep) && ret;
+	}
+	for (const auto& circle : list.Circles)
+	{
+		applyStyle(circle.Style);
+		ret = !geometry.circle({circle.Center.X(), circle.Center.Y(), 0}, circle.Radius, normal) && ret;
+	}
+	for (const auto& text : list.Texts)
+	{
+		if (!view.IsEmpty() && !view.Contains(text.Position))
+		{
+			continue;
+		}
+		applyStyle(text.Style);
+		const AcGeVector3d direction(text.DirectionX, text.DirectionY, 0);
+		ret = !geometry.text({text.Position.X(), text.Position.Y(), 0}, normal, direction, text.Height, 1, 0,
+		                     text.Text.c_str()) && ret;
+	}
+	return ret;
 }
@@ -1,19 +1,18 @@
 #pragma once
+#include "../VizRailCore/includes/DisplayListBuilder.h"
 #include "../VizRailCore/includes/HorizontalAlignment.h"
 
-
-namespace VizRailCore
-{
-	class Curve;
-	class IntermediateLine;
-}
-
 class HorizontalAlignmentEntity final : public AcDbEntity
 {
 public:
 	ACRX_DECLARE_MEMBERS(HorizontalAlignmentEntity)
+	// 代理图形中线折线的弦高容差（m），导入时按此容差预先生成项目缓存
+	static constexpr double ProxyChordTolerance = 0.01;
+
 	HorizontalAlignmentEntity() = default;
 	explicit HorizontalAlignmentEntity(const AcString& name, const std::vector<Jd>& jds);
+	// 与alignment共享交点和线元，用于O(1)创建方案变体
+	HorizontalAlignmentEntity(const AcString& name, const VizRailCore::HorizontalAlignment& alignment);
 	~HorizontalAlignmentEntity() override = default;
 
 
@@ -24,6 +23,8 @@ public:
 
 protected:
 	Adesk::Boolean subWorldDraw(AcGiWorldDraw* pWorldDraw) override;
+	void subViewportDraw(AcGiViewportDraw* pViewportDraw) override;
+	Adesk::UInt32 subSetAttributes(AcGiDrawableTraits* pTraits) override;
 	Acad::ErrorStatus subTransformBy(const AcGeMatrix3d& xform) override;
 	Acad::ErrorStatus subGetTransformedCopy(const AcGeMatrix3d& xform, AcDbEntity*& pEnt) const override;
 	Acad::ErrorStatus subGetGripPoints(AcGePoint3dArray& gripPoints, AcDbIntArray& osnapModes,
@@ -32,7 +33,7 @@ protected:
 	Acad::ErrorStatus subGetGeomExtents(AcDbExtents& extents) const override;
 
 public:
-	[[nodiscard]] VizRailCore::HorizontalAlignment HorizontalAlignment() const
+	[[nodiscard]] const VizRailCore::HorizontalAlignment& HorizontalAlignment() const
 	{
 		return _horizontalAlignment;
 	}
@@ -42,17 +43,21 @@ public:
 		return _name;
 	}
 
+	// 撤销或重做交点修改，没有可撤销（重做）的修改时返回false
+	bool UndoJdEdit();
+	bool RedoJdEdit();
+
+	// 按类别统计线路和显示列表缓存占用的内存，已在visited中的对象不重复计算
+	void MemoryUsage(VizRailCore::MemoryReport& report, std::unordered_set<const void*>& visited) const;
+
 private:
 	VizRailCore::HorizontalAlignment _horizontalAlignment;
-	static bool DrawHectoMeter(const AcGiWorldDraw* pWorldDraw,
-	                           const std::shared_ptr<VizRailCore::LineElement>& line,
-	                           const double startMileage, const double endMileage);
-	static bool DrawIntermediateLine(const AcGiWorldDraw* pWorldDraw,
-	                                 const std::shared_ptr<VizRailCore::IntermediateLine>& jzx);
-	static bool MileageMark(const AcGiWorldDraw* pWorldDraw, const AcGePoint3d& pt,
-	                        const VizRailCore::Angle& azimuthAngle, const AcString& str);
-	static bool DrawCurve(const AcGiWorldDraw* pWorldDraw, const std::shared_ptr<VizRailCore::Curve>& qx);
-
-	static bool DrawJdMark(AcGiWorldDraw* pWorldDraw, const std::shared_ptr<VizRailCore::Curve>& qx);
+	VizRailCore::DisplayListBuilder _displayList;
+
+	static VizRailCore::BoundingBox ViewportExtents(AcGiViewportDraw* pViewportDraw);
+	static bool DrawDisplayList(AcGiGeometry& geometry, AcGiSubEntityTraits& traits,
+	                            const VizRailCore::DisplayList& list, const VizRailCore::BoundingBox& view = {});
+	// 由项目缓存中的中线折线绘制代理图形，未打开项目时返回false，由调用方按完整细节绘制
+	bool DrawProxyFromCache(AcGiWorldDraw* pWorldDraw) const;
 	AcString _name;
 };
@@ -25,10 +25,16 @@ AcString ProjectService::GetMdbFilePath()
 		.DoModal() == IDOK)
 	{
 		const CString path = dlg.GetPathName();
-		if (const int index = path.Find(L"DATA"); index == -1)
+		const int index = path.Find(L"DATA");
+		if (index == -1)
 		{
 			throw ProjectDirException(L"请选择处于正确项目路径下的方案MDB");
 		}
+		// 方案MDB位于项目的DATA目录下，尚未打开项目时以此确定项目目录
+		if (_projectDir.isEmpty())
+		{
+			_projectDir = path.Left(index - 1);
+		}
 		return path;
 	}
 	return L"";
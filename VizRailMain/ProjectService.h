@@ -1,5 +1,8 @@
 #pragma once
+#include <memory>
+
 #include "Exception.h"
+#include "../VizRailCore/includes/ProjectCache.h"
 
 
 class ProjectService
@@ -18,6 +21,23 @@ public:
 
 	static AcString GetMdbFilePath();
 
+	/// 项目目录下Cache子目录中的派生数据缓存，重新打开同一项目时直接映射上次计算的结果。
+	/// 尚未打开项目时返回nullptr，不弹出选择项目的对话框，由调用方直接计算
+	static VizRailCore::ProjectCache* GetCache()
+	{
+		if (_projectDir.isEmpty())
+		{
+			return nullptr;
+		}
+		const std::filesystem::path directory = std::filesystem::path(_projectDir.constPtr()) / L"Cache";
+		if (_cache == nullptr || _cache->Directory() != directory)
+		{
+			_cache = std::make_unique<VizRailCore::ProjectCache>(directory);
+		}
+		return _cache.get();
+	}
+
 private:
 	inline static AcString _projectDir = L"";
+	inline static std::unique_ptr<VizRailCore::ProjectCache> _cache;
 };
@@ -31,8 +31,11 @@
 #include "resource.h"
 #include "Utils.h"
 #include "../VizRailCore/includes/DatabaseUtils.h"
+#include "../VizRailCore/includes/DerivedData.h"
 #include "../VizRailCore/includes/Exceptions.h"
 #include "../VizRailCore/includes/Jd.h"
+#include "../VizRailCore/includes/TaskScheduler.h"
+#include "../VizRailCore/includes/Trace.h"
 
 //-----------------------------------------------------------------------------
 #define szRDS _RXST("ADSK")
@@ -54,6 +57,11 @@ public:
 		AcRx::AppRetCode retCode = AcRxArxApp::On_kInitAppMsg(pkt);
 
 		// TODO: Add your initialization code here
+		// AutoCAD自身也有后台线程，并行计算只使用一半的硬件线程
+		VizRailCore::TaskScheduler::SetDefaultWorkerCount(std::max(1u, std::thread::hardware_concurrency() / 2));
+		// 图中线路实体较多时，查询索引和显示缓存合计不超过256MB，超出时淘汰最久未使用的
+		VizRailCore::DerivedDataManager::Instance().SetBudget(256u << 20);
+
 		HorizontalAlignmentEntity::rxInit();
 
 		if (!acrxServiceIsRegistered(L"HorizontalAlignmentEntity"))
@@ -74,6 +82,9 @@ public:
 		AcRx::AppRetCode retCode = AcRxArxApp::On_kUnloadAppMsg(pkt);
 
 		// TODO: Unload dependencies here
+		// 在DLL卸载前停止工作线程，不能留到静态析构时在加载器锁内等待线程退出
+		VizRailCore::TaskScheduler::ShutdownDefault();
+
 		AcRxObject* obj = acrxServiceDictionary->remove(L"HorizontalAlignmentEntity");
 		if (obj != nullptr)
 			delete obj;
@@ -125,6 +136,11 @@ public:
 			{
 				return;
 			}
+			ACHAR name[133] = {};
+			if (acedGetString(1, L"\n输入方案名<方案1>:", name) != RTNORM)
+			{
+				return;
+			}
 			AccessConnection conn(path.constPtr());
 			auto pRecordSet = conn.Execute(L"SELECT * FROM 曲线表");
 			jds.clear();
@@ -156,7 +172,16 @@ public:
 				);
 				pRecordSet.MoveNext();
 			}
-			const auto pEntity = new HorizontalAlignmentEntity(L"方案1", jds);
+			const auto pEntity = new HorizontalAlignmentEntity(name[0] == L'\0' ? L"方案1" : name, jds);
+			// 以线路映像中全部线元的包围盒确定视图，重新导入相同的交点表时直接映射项目缓存中的映像。
+			// 同时生成代理图形所用的中线缓存，保存图形时不再离散中线
+			VizRailCore::BoundingBox extents = pEntity->HorizontalAlignment().Extents();
+			if (VizRailCore::ProjectCache* cache = ProjectService::GetCache())
+			{
+				const auto image = cache->Image(pEntity->HorizontalAlignment());
+				extents = image.View.Extents();
+				(void)cache->Centerline(pEntity->HorizontalAlignment(), HorizontalAlignmentEntity::ProxyChordTolerance);
+			}
 			AcDbObjectId id;
 			AcDbBlockTable* pBlockTable;
 			acdbHostApplicationServices()->workingDatabase()->getSymbolTable(pBlockTable, AcDb::kForRead);
@@ -165,7 +190,10 @@ public:
 			pBlockTable->close();
 			const auto ret = pBlockTableRecord->appendAcDbEntity(id, pEntity);
 			pBlockTableRecord->close();
-			SetView({jds[0].E, jds[0].N}, {jds[jds.size() - 1].E, jds[jds.size() - 1].N}, 1);
+			if (!extents.IsEmpty())
+			{
+				SetView({extents.Min().X(), extents.Max().Y()}, {extents.Max().X(), extents.Min().Y()}, 1);
+			}
 			pEntity->close();
 		}
 		catch (AccessDatabaseException& e)
@@ -214,7 +242,7 @@ public:
 			const AcString path = ProjectService::GetMdbFilePath();
 			AccessConnection conn(path.constPtr());
 			const auto pHAEntity = static_cast<HorizontalAlignmentEntity*>(pEntity);
-			const auto jds = pHAEntity->HorizontalAlignment().GetJds();
+			const auto& jds = pHAEntity->HorizontalAlignment().GetJds();
 			conn.Execute(L"DELETE * FROM 曲线表");
 			for (const auto& jd : jds)
 			{
@@ -241,6 +269,206 @@ public:
 		pEntity->close();
 	}
 
+	static void ADSKVizRailGroupCreateScheme()
+	{
+		// 选择作为基础的平面实体
+		ads_name en;
+		ads_point pt;
+		AcDbObjectId objId;
+		AcDbEntity* pEntity;
+		if (acedEntSel(L"\n选择基础方案:", en, pt) != RTNORM)
+		{
+			return;
+		}
+		if (acdbGetObjectId(objId, en) != Acad::eOk)
+		{
+			return;
+		}
+		if (acdbOpenAcDbEntity(pEntity, objId, AcDb::kForRead) != Acad::eOk)
+		{
+			return;
+		}
+		if (pEntity->isKindOf(HorizontalAlignmentEntity::desc()) == false)
+		{
+			acutPrintf(L"请选择平面实体");
+			pEntity->close();
+			return;
+		}
+
+		ACHAR name[133] = {};
+		if (acedGetString(1, L"\n输入新方案名:", name) != RTNORM || name[0] == L'\0')
+		{
+			pEntity->close();
+			return;
+		}
+
+		// 新方案与基础方案共享交点和线元，之后各自修改互不影响
+		const auto pBase = static_cast<HorizontalAlignmentEntity*>(pEntity);
+		const auto pVariant = new HorizontalAlignmentEntity(name, pBase->HorizontalAlignment());
+		pEntity->close();
+
+		AcDbObjectId id;
+		AcDbBlockTable* pBlockTable;
+		acdbHostApplicationServices()->workingDatabase()->getSymbolTable(pBlockTable, AcDb::kForRead);
+		AcDbBlockTableRecord* pBlockTableRecord;
+		pBlockTable->getAt(ACDB_MODEL_SPACE, pBlockTableRecord, AcDb::kForWrite);
+		pBlockTable->close();
+		if (pBlockTableRecord->appendAcDbEntity(id, pVariant) != Acad::eOk)
+		{
+			delete pVariant;
+			pBlockTableRecord->close();
+			return;
+		}
+		pBlockTableRecord->close();
+		pVariant->close();
+	}
+
+	static void ADSKVizRailGroupUndoJd()
+	{
+		EditHistory(true);
+	}
+
+	static void ADSKVizRailGroupRedoJd()
+	{
+		EditHistory(false);
+	}
+
+	static void EditHistory(const bool undo)
+	{
+		ads_name en;
+		ads_point pt;
+		AcDbObjectId objId;
+		AcDbEntity* pEntity;
+		if (acedEntSel(L"\n选择平面实体:", en, pt) != RTNORM)
+		{
+			return;
+		}
+		if (acdbGetObjectId(objId, en) != Acad::eOk)
+		{
+			return;
+		}
+		if (acdbOpenAcDbEntity(pEntity, objId, AcDb::kForWrite) != Acad::eOk)
+		{
+			return;
+		}
+		if (pEntity->isKindOf(HorizontalAlignmentEntity::desc()) == false)
+		{
+			acutPrintf(L"请选择平面实体");
+			pEntity->close();
+			return;
+		}
+
+		const auto pHAEntity = static_cast<HorizontalAlignmentEntity*>(pEntity);
+		const bool done = undo ? pHAEntity->UndoJdEdit() : pHAEntity->RedoJdEdit();
+		if (!done)
+		{
+			acutPrintf(undo ? L"\n没有可撤销的交点修改" : L"\n没有可重做的交点修改");
+		}
+		pEntity->close();
+	}
+
+	// 输出VizRailCore的性能计数器，输入R清零
+	static void ADSKVizRailGroupTraceStats()
+	{
+		if (!VizRailCore::Trace::IsCompiledIn())
+		{
+			acutPrintf(L"\n未启用性能跟踪，需定义VIZRAIL_ENABLE_TRACING重新编译VizRailCore");
+			return;
+		}
+		const auto counters = VizRailCore::Trace::Counters();
+		for (size_t i = 0; i < counters.size(); ++i)
+		{
+			acutPrintf(L"\n%hs: %llu", VizRailCore::Trace::CounterName(static_cast<VizRailCore::TraceCounter>(i)),
+			           counters[i]);
+		}
+		ACHAR option[8] = {};
+		if (acedGetString(0, L"\n输入R清零计数器<不清零>:", option) == RTNORM && (option[0] == L'R' || option[0] == L'r'))
+		{
+			VizRailCore::Trace::ResetCounters();
+		}
+	}
+
+	// 开始记录计时事件，之后用TraceSave保存
+	static void ADSKVizRailGroupTraceStart()
+	{
+		if (!VizRailCore::Trace::IsCompiledIn())
+		{
+			acutPrintf(L"\n未启用性能跟踪，需定义VIZRAIL_ENABLE_TRACING重新编译VizRailCore");
+			return;
+		}
+		VizRailCore::Trace::ClearEvents();
+		VizRailCore::Trace::StartRecording();
+		acutPrintf(L"\n开始记录，执行需要分析的操作后用TraceSave保存");
+	}
+
+	// 停止记录并保存为Chrome跟踪文件，可在chrome://tracing或Perfetto中打开
+	static void ADSKVizRailGroupTraceSave()
+	{
+		VizRailCore::Trace::StopRecording();
+		ACHAR path[260] = {};
+		if (acedGetString(1, L"\n输入跟踪文件路径(.json):", path) != RTNORM || path[0] == L'\0')
+		{
+			return;
+		}
+		try
+		{
+			VizRailCore::Trace::SaveChromeTrace(path);
+			VizRailCore::Trace::ClearEvents();
+			acutPrintf(L"\n已保存到%s", path);
+		}
+		catch (VizRailCoreException& e)
+		{
+			acutPrintf(L"\n%s", e.GetMsg().c_str());
+		}
+	}
+
+	// 按类别输出图中每个平面实体及全部实体合计占用的内存，方案之间共享的部分只计入先统计到的实体
+	static void ADSKVizRailGroupMemoryStats()
+	{
+		AcDbBlockTable* pBlockTable;
+		if (acdbHostApplicationServices()->workingDatabase()->getSymbolTable(pBlockTable, AcDb::kForRead) !=
+			Acad::eOk)
+		{
+			return;
+		}
+		AcDbBlockTableRecord* pBlockTableRecord;
+		const auto es = pBlockTable->getAt(ACDB_MODEL_SPACE, pBlockTableRecord, AcDb::kForRead);
+		pBlockTable->close();
+		if (es != Acad::eOk)
+		{
+			return;
+		}
+
+		const auto print = [](const wchar_t* name, const VizRailCore::MemoryReport& report)
+		{
+			acutPrintf(L"\n%s: 合计%.1fKB（交点%.1fKB，线元%.1fKB，索引%.1fKB，历史%.1fKB，显示缓存%.1fKB）", name,
+			           report.Total() / 1024.0, report.Inputs / 1024.0, report.Elements / 1024.0,
+			           report.Indices / 1024.0, report.History / 1024.0, report.DisplayCaches / 1024.0);
+		};
+		VizRailCore::MemoryAccounting accounting;
+		AcDbBlockTableRecordIterator* pIterator;
+		pBlockTableRecord->newIterator(pIterator);
+		for (; !pIterator->done(); pIterator->step())
+		{
+			AcDbEntity* pEntity;
+			if (pIterator->getEntity(pEntity, AcDb::kForRead) != Acad::eOk)
+			{
+				continue;
+			}
+			if (const auto pHAEntity = HorizontalAlignmentEntity::cast(pEntity))
+			{
+				print(pHAEntity->Name().constPtr(), accounting.Add(*pHAEntity));
+			}
+			pEntity->close();
+		}
+		delete pIterator;
+		pBlockTableRecord->close();
+		print(L"全部平面实体", accounting.Total());
+		const auto derived = VizRailCore::DerivedDataManager::Instance().Stats();
+		acutPrintf(L"\n派生数据: 驻留%zu项%.1fKB（预算%.1fKB），命中率%.1f%%，淘汰%zu次", derived.Entries,
+		           derived.Bytes / 1024.0, derived.Budget / 1024.0, derived.HitRate() * 100.0, derived.Evictions);
+	}
+
 	static void ADSKVizRailGroupAddJd()
 	{
 	}
@@ -257,3 +485,10 @@ ACED_ARXCOMMAND_ENTRY_AUTO(CVizRailMainApp, ADSKMyGroup, Hello, Hello, ACRX_CMD_
 ACED_ARXCOMMAND_ENTRY_AUTO(CVizRailMainApp, ADSKVizRailGroup, OpenProject, OpenProject, ACRX_CMD_MODAL, NULL)
 ACED_ARXCOMMAND_ENTRY_AUTO(CVizRailMainApp, ADSKVizRailGroup, ImportHorizontal, ImportHorizontal, ACRX_CMD_MODAL, NULL)
 ACED_ARXCOMMAND_ENTRY_AUTO(CVizRailMainApp, ADSKVizRailGroup, SaveHorizontal, SaveHorizontal, ACRX_CMD_MODAL, NULL)
+ACED_ARXCOMMAND_ENTRY_AUTO(CVizRailMainApp, ADSKVizRailGroup, CreateScheme, CreateScheme, ACRX_CMD_MODAL, NULL)
+ACED_ARXCOMMAND_ENTRY_AUTO(CVizRailMainApp, ADSKVizRailGroup, UndoJd, UndoJd, ACRX_CMD_MODAL, NULL)
+ACED_ARXCOMMAND_ENTRY_AUTO(CVizRailMainApp, ADSKVizRailGroup, RedoJd, RedoJd, ACRX_CMD_MODAL, NULL)
+ACED_ARXCOMMAND_ENTRY_AUTO(CVizRailMainApp, ADSKVizRailGroup, TraceStats, TraceStats, ACRX_CMD_MODAL, NULL)
+ACED_ARXCOMMAND_ENTRY_AUTO(CVizRailMainApp, ADSKVizRailGroup, TraceStart, TraceStart, ACRX_CMD_MODAL, NULL)
+ACED_ARXCOMMAND_ENTRY_AUTO(CVizRailMainApp, ADSKVizRailGroup, TraceSave, TraceSave, ACRX_CMD_MODAL, NULL)
+ACED_ARXCOMMAND_ENTRY_AUTO(CVizRailMainApp, ADSKVizRailGroup, MemoryStats, MemoryStats, ACRX_CMD_MODAL, NULL)